@@ -18,8 +18,11 @@
 #include <mlir/Support/MlirOptMain.h>
 
 #include <ir/include/DialectRegistry.h>
+#include <transforms/include/AcceraCompiler.h>
 #include <transforms/include/AcceraPasses.h>
 
+#include <vector>
+
 static llvm::cl::opt<std::string> input_filename(llvm::cl::Positional,
                                                  llvm::cl::desc("<input file>"),
                                                  llvm::cl::init("-"));
@@ -49,6 +52,12 @@ static llvm::cl::opt<bool> allowUnregisteredDialects(
     llvm::cl::desc("Allow operation with no registered dialects"),
     llvm::cl::init(false));
 
+static llvm::cl::opt<std::string> passTimingFilename(
+    "acc-pass-timing-file",
+    llvm::cl::desc("Write the wall-clock time and peak resident set size after every pass run to this file, as JSON"),
+    llvm::cl::value_desc("filename"),
+    llvm::cl::init(""));
+
 static llvm::cl::opt<bool>
     showDialects("show-dialects",
                  llvm::cl::desc("Print the list of registered dialects"),
@@ -102,13 +111,45 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    return failed(mlir::MlirOptMain(
+    std::unique_ptr<llvm::ToolOutputFile> passTimingOutput;
+    if (!passTimingFilename.empty())
+    {
+        passTimingOutput = mlir::openOutputFile(passTimingFilename, &error_message);
+        if (!passTimingOutput)
+        {
+            llvm::errs() << error_message << "\n";
+            return 1;
+        }
+    }
+
+    std::vector<accera::transforms::PassTiming> passTimings;
+    auto setUpPassManager = [&](mlir::PassManager& pm) {
+        if (passTimingOutput)
+        {
+            pm.addInstrumentation(accera::transforms::CreatePassTimingInstrumentation(passTimings));
+        }
+        auto errorHandler = [&](const llvm::Twine& msg) {
+            mlir::emitError(mlir::UnknownLoc::get(pm.getContext())) << msg;
+            return mlir::failure();
+        };
+        return passPipeline.addToPipeline(pm, errorHandler);
+    };
+
+    auto result = mlir::MlirOptMain(
         output->os(),
         std::move(file),
-        passPipeline,
+        setUpPassManager,
         accera::ir::GetDialectRegistry(),
         split_input_file,
         verify_diagnostics,
         verify_passes,
-        allowUnregisteredDialects));
+        allowUnregisteredDialects);
+
+    if (passTimingOutput)
+    {
+        accera::transforms::WritePassTimings(passTimings, passTimingOutput->os());
+        passTimingOutput->keep();
+    }
+
+    return failed(result);
 }
@@ -0,0 +1,89 @@
+// RUN: acc-opt --plan-scratch-memory -split-input-file %s | FileCheck %s
+
+// The two buffers are never live at the same time, so they share a single arena at offset 0
+// CHECK-LABEL: module @test_disjoint_buffers
+// CHECK: "accv.global"() {accv.scratch_buffer
+// CHECK-SAME: sym_name = "disjoint_scratch_arena
+// CHECK-SAME: type = memref<64xi8>
+// CHECK: accv.func @disjoint() attributes {accv.scratch_footprint = 64 : i64
+// CHECK-NOT: "accv.alloc"
+// CHECK: %[[ARENA0:.*]] = "accv.ref_global"() {global_name = @disjoint_scratch_arena
+// CHECK: %[[OFFSET0:.*]] = constant 0 : index
+// CHECK: %[[VIEW0:.*]] = memref.view %[[ARENA0]][%[[OFFSET0]]][] : memref<64xi8> to memref<16xf32>
+// CHECK: %[[ARENA1:.*]] = "accv.ref_global"() {global_name = @disjoint_scratch_arena
+// CHECK: %[[OFFSET1:.*]] = constant 0 : index
+// CHECK: %[[VIEW1:.*]] = memref.view %[[ARENA1]][%[[OFFSET1]]][] : memref<64xi8> to memref<16xf32>
+// CHECK: affine.for
+// CHECK: affine.store %{{.*}}, %[[VIEW0]]
+// CHECK: affine.for
+// CHECK: affine.store %{{.*}}, %[[VIEW1]]
+module @test_disjoint_buffers {
+  "accv.module"() ( {
+    "accv.func"() ( {
+      %0 = "accv.alloc"() : () -> memref<16xf32>
+      %1 = "accv.alloc"() : () -> memref<16xf32>
+      %cst = constant 1.000000e+00 : f32
+      affine.for %i = 0 to 16 {
+        affine.store %cst, %0[%i] : memref<16xf32>
+      }
+      affine.for %i = 0 to 16 {
+        affine.store %cst, %1[%i] : memref<16xf32>
+      }
+      accv.return
+    }) {exec_target = 0 : i64, sym_name = "disjoint", type = () -> ()} : () -> ()
+    "accv.module_terminator"() : () -> ()
+  }) {sym_name = "accera_test"} : () -> ()
+}
+
+// -----
+
+// The two buffers are live at the same time, so they keep their own storage
+// CHECK-LABEL: module @test_overlapping_buffers
+// CHECK-NOT: scratch_arena
+// CHECK: accv.func @overlapping() attributes {accv.scratch_footprint = 128 : i64
+// CHECK: "accv.alloc"() : () -> memref<16xf32>
+// CHECK: "accv.alloc"() : () -> memref<16xf32>
+module @test_overlapping_buffers {
+  "accv.module"() ( {
+    "accv.func"() ( {
+      %0 = "accv.alloc"() : () -> memref<16xf32>
+      %1 = "accv.alloc"() : () -> memref<16xf32>
+      %cst = constant 1.000000e+00 : f32
+      affine.for %i = 0 to 16 {
+        affine.store %cst, %0[%i] : memref<16xf32>
+        affine.store %cst, %1[%i] : memref<16xf32>
+      }
+      accv.return
+    }) {exec_target = 0 : i64, sym_name = "overlapping", type = () -> ()} : () -> ()
+    "accv.module_terminator"() : () -> ()
+  }) {sym_name = "accera_test"} : () -> ()
+}
+
+// -----
+
+// A function needs the scratch buffers of the functions it calls on top of its own
+// CHECK-LABEL: module @test_callee_footprint
+// CHECK: accv.func @caller() attributes {accv.scratch_footprint = 128 : i64
+// CHECK: accv.func private @callee() attributes {accv.scratch_footprint = 64 : i64
+module @test_callee_footprint {
+  "accv.module"() ( {
+    "accv.func"() ( {
+      %0 = "accv.alloc"() : () -> memref<16xf32>
+      %cst = constant 1.000000e+00 : f32
+      affine.for %i = 0 to 16 {
+        affine.store %cst, %0[%i] : memref<16xf32>
+      }
+      accv.call @callee() : () -> ()
+      accv.return
+    }) {exec_target = 0 : i64, sym_name = "caller", type = () -> ()} : () -> ()
+    "accv.func"() ( {
+      %0 = "accv.alloc"() : () -> memref<16xf32>
+      %cst = constant 1.000000e+00 : f32
+      affine.for %i = 0 to 16 {
+        affine.store %cst, %0[%i] : memref<16xf32>
+      }
+      accv.return
+    }) {exec_target = 0 : i64, sym_name = "callee", sym_visibility = "private", type = () -> ()} : () -> ()
+    "accv.module_terminator"() : () -> ()
+  }) {sym_name = "accera_test"} : () -> ()
+}
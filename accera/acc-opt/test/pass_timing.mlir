@@ -0,0 +1,15 @@
+// RUN: acc-opt --acc-pass-timing-file=%t.json --canonicalize %s -o /dev/null
+// RUN: FileCheck %s < %t.json
+
+// CHECK: "pass": "Canonicalizer",
+// CHECK-NEXT: "op": "{{.*}}module",
+// CHECK-NEXT: "seconds":
+// CHECK-NEXT: "peak_rss_bytes":
+
+module {
+  func @add_zero(%arg0: i32) -> i32 {
+    %c0 = constant 0 : i32
+    %0 = addi %arg0, %c0 : i32
+    return %0 : i32
+  }
+}
@@ -1983,6 +1983,64 @@ TEST_CASE("jit_int8_cached_matrix_multiply_test")
     SUCCEED();
 }
 
+// CHECK-LABEL: module @jit_cache_prefetch_matrix_multiply_test {
+// CHECK-NEXT: accv.module "jit_cache_prefetch_matrix_multiply_test" {
+// JIT-LABEL: @jit_cache_prefetch_matrix_multiply_test
+TEST_CASE("jit_cache_prefetch_matrix_multiply_test")
+{
+    const int M = 4;
+    const int N = 8;
+    const int K = 8;
+
+    DeclareFunction("main")
+        .Public(true)
+        .Decorated(false)
+        .Define([=]() {
+            Matrix A = MakeMatrix<int32_t>(M, K);
+            Matrix B = MakeMatrix<int32_t>(K, N);
+            Matrix C = MakeMatrix<int32_t>(M, N);
+
+            Nest fillNest(MemoryShape{ M, N, K });
+            auto [ii, jj, kk] = fillNest.GetIndices<3>();
+            fillNest.Set([&, ii = ii, jj = jj, kk = kk]() {
+                auto iVal = Scalar(Cast(ii, ValueType::Int32));
+                auto jVal = Scalar(Cast(jj, ValueType::Int32));
+                auto kVal = Scalar(Cast(kk, ValueType::Int32));
+
+                A(ii, kk) = iVal + kVal;
+                B(kk, jj) = (kVal * 2) + jVal;
+                C(ii, jj) = Scalar(0);
+            });
+            fillNest.CreateSchedule();
+
+            Nest matMulNest(MemoryShape{ M, N, K });
+            auto [i, j, k] = matMulNest.GetIndices<3>();
+            matMulNest.Set([&, i = i, j = j, k = k]() {
+                C(i, j) += A(i, k) * B(k, j);
+            });
+
+            auto schedule = matMulNest.CreateSchedule();
+            auto [jOuter, jInner] = schedule.Split(j, 4);
+            auto [kOuter, kInner] = schedule.Split(k, 2);
+            schedule.SetOrder({ jOuter, kOuter, i, kInner, jInner });
+            auto plan = schedule.CreatePlan();
+
+            // The B block doesn't move with i, so the block of the next kOuter iteration is prefetched
+            // CHECK: accxp.begin_create_cache
+            // CHECK-SAME: prefetchDistance = 1 : i64
+            plan.AddCache(B, kInner, false, false, std::nullopt, CacheIndexing::GlobalToPhysical, CacheAllocation::Automatic, MemorySpace::None, MemorySpace::None, std::nullopt, 1);
+
+            // JIT-LABEL: A*B:
+            Print("A*B:\n"s);
+            // JIT:280 308 336 364 392 420 448 476
+            // JIT-NEXT:336 372 408 444 480 516 552 588
+            // JIT-NEXT:392 436 480 524 568 612 656 700
+            // JIT-NEXT:448 500 552 604 656 708 760 812
+            Print(C);
+        });
+    SUCCEED();
+}
+
 // CHECK-LABEL: module @jit_int8_expvec_matrix_multiply_test {
 // CHECK-NEXT: accv.module "jit_int8_expvec_matrix_multiply_test" {
 // JIT-LABEL: @jit_int8_expvec_matrix_multiply_test
@@ -3511,6 +3569,53 @@ TEST_CASE("jit_reduce_test")
     SUCCEED();
 }
 
+// CHECK-LABEL: module @jit_reduce_multi_accumulator_test {
+// JIT-LABEL: @jit_reduce_multi_accumulator_test
+TEST_CASE("jit_reduce_multi_accumulator_test")
+{
+    // Large enough to use several vector accumulators, with leftover elements
+    const int N = 100;
+
+    DeclareFunction("main")
+        .Public(true)
+        .Decorated(false)
+        .Define([=]() {
+            auto A = MakeArray({ N }, ValueType::Int32);
+            Nest fillNest(A.Shape());
+            Scalar i = fillNest.GetIndices()[0];
+            fillNest.Set([&]() {
+                auto iVal = Scalar(Cast(i, ValueType::Int32));
+                A(i) = iVal;
+            });
+            fillNest.CreateSchedule();
+
+            auto x = Reduce(A, Scalar(0), [&](Scalar a, Scalar p) { return a + p; });
+            Print(x);
+            // JIT: 4950
+
+            // The partial sums must be added, not squared again
+            auto y = Reduce(A, Scalar(0), [&](Scalar a, Scalar p) { return p + a * a; });
+            Print(y);
+            // JIT: 328350
+
+            // All the values are negative, so the extra accumulators can't start from 0
+            auto z = Reduce(A, Scalar(-1000), [&](Scalar a, Scalar p) { return Max(Scalar(-1) - a, p); });
+            Print(z);
+            // JIT: -1
+
+            // Compute sum-of-squares
+            auto w = MapReduce(
+                A,
+                Scalar(0),
+                [&](Scalar a) { return a * a; },
+                [&](Scalar a, Scalar p) { return a + p; });
+            Print(w);
+            // JIT: 328350
+        });
+
+    SUCCEED();
+}
+
 
 // COM: CHECK-LABEL: module @jit_profile_region_test {
 // COM: JIT-LABEL: @jit_profile_region_test
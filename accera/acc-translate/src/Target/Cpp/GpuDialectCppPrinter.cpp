@@ -552,6 +552,8 @@ namespace cpp_printer
                 [[fallthrough]];
             case vir::ExecutionRuntime::OPENMP:
                 [[fallthrough]];
+            case vir::ExecutionRuntime::THREAD_POOL:
+                [[fallthrough]];
             case vir::ExecutionRuntime::VULKAN:
                 [[fallthrough]];
             case vir::ExecutionRuntime::DEFAULT:
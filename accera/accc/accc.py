@@ -5,9 +5,14 @@
 # Requires: Python 3.7+
 ####################################################################################################
 
+import hashlib
 import os
 import shutil
+import subprocess
+import threading
+from concurrent.futures import ThreadPoolExecutor
 from enum import Enum, auto
+from functools import lru_cache
 
 from .utilities import *
 from .parameters import *
@@ -37,6 +42,7 @@ class Runtime(Enum):
     ROCM = "rocm"
     VULKAN = "vulkan"
     OPENMP = "openmp"
+    THREAD_POOL = "thread_pool"
     DEFAULT = "default"
 
 
@@ -71,25 +77,64 @@ OS_OPTS = {
 }
 
 
-def DEFAULT_RC_MLIR_LOWERING_PASSES(
+def get_acc_to_llvm_options(
     dump=False,
     dump_intrapass_ir=False,
     system_target=SystemTarget.HOST.value,
     profile=False,
     runtime=Runtime.DEFAULT.value,
-    gpu_only=False
+    gpu_only=False,
+    profile_counters="",
+    instrument=False,
+    trace=False,
+    timer="clock"
 ):
     def bstr(val):
         return "true" if val else "false"
 
-    acc_to_llvm_str = " ".join([
+    options = [
         f'dump-passes={bstr(dump)}',
         f'dump-intra-pass-ir={bstr(dump_intrapass_ir)}',
         f'runtime={str(runtime).lower()}',
         f'target={system_target}',
         f'enable-profiling={bstr(profile)}',
         f'gpu-only={bstr(gpu_only)}',
-    ])
+    ]
+    if profile_counters:
+        options.append(f'profile-counters={profile_counters}')
+    if instrument:
+        options.append(f'instrument-profile-regions={bstr(instrument)}')
+    if trace:
+        options.append(f'profile-trace={bstr(trace)}')
+    if timer != "clock":
+        options.append(f'timer={timer}')
+    return " ".join(options)
+
+
+def DEFAULT_RC_MLIR_LOWERING_PASSES(
+    dump=False,
+    dump_intrapass_ir=False,
+    system_target=SystemTarget.HOST.value,
+    profile=False,
+    runtime=Runtime.DEFAULT.value,
+    gpu_only=False,
+    profile_counters="",
+    instrument=False,
+    trace=False,
+    timer="clock"
+):
+    acc_to_llvm_str = get_acc_to_llvm_options(
+        dump=dump,
+        dump_intrapass_ir=dump_intrapass_ir,
+        system_target=system_target,
+        profile=profile,
+        runtime=runtime,
+        gpu_only=gpu_only,
+        profile_counters=profile_counters,
+        instrument=instrument,
+        trace=trace,
+        timer=timer
+    )
 
     return [f'--acc-to-llvm="{acc_to_llvm_str}"']
 
@@ -124,6 +169,9 @@ DEFAULT_OPT_ARGS = []
 
 DEFAULT_LLC_ARGS = ["-relocation-model=pic"]
 
+# Setting this environment variable to a directory enables the compilation cache for every AcceraProject
+CACHE_DIR_ENV_VAR = "ACCERA_CACHE_DIR"
+
 
 def get_default_deploy_shared_libraries(target=CPU_TARGET):
     if target == GPU_TARGET:
@@ -501,6 +549,98 @@ class ModuleFileSet:
         return s
 
 
+@lru_cache(maxsize=None)
+def get_tool_fingerprint():
+    """Identifies the tools used for lowering and code generation, so that cached outputs are not reused
+    across rebuilds or upgrades of the tools. llc's version string also names the host CPU that
+    `-mcpu=native` resolves to."""
+    fingerprint = []
+    for tool in [ACCCConfig.rc_opt, ACCCConfig.acc_translate, ACCCConfig.mlir_translate, ACCCConfig.llvm_opt, ACCCConfig.llc]:
+        for tool_path in [tool, tool + BuildConfig.exe_extension]:
+            if os.path.isfile(tool_path):
+                stat = os.stat(tool_path)
+                fingerprint.append(f"{os.path.basename(tool_path)}:{stat.st_size}:{stat.st_mtime_ns}")
+                break
+    try:
+        fingerprint.append(
+            subprocess.run([os.path.abspath(ACCCConfig.llc), "--version"], stdout=subprocess.PIPE,
+                           universal_newlines=True).stdout
+        )
+    except OSError:
+        pass
+    return "\n".join(fingerprint)
+
+
+class CompilationCache:
+    """An on-disk store of the files produced by lowering and compiling a module, addressed by a hash
+    of the module's MLIR, the tool arguments and the tools themselves"""
+
+    def __init__(self, cache_dir):
+        self.cache_dir = os.path.abspath(cache_dir)
+
+    @staticmethod
+    def _output_filepaths(module_file_set):
+        if module_file_set.output_type == ModuleOutputType.OBJECT:
+            return [
+                module_file_set.lowered_mlir_filepath,
+                module_file_set.translated_ll_filepath,
+                module_file_set.optimized_ll_filepath,
+                module_file_set.object_filepath,
+                module_file_set.asm_filepath,
+            ]
+        else:
+            return [module_file_set.lowered_mlir_filepath, module_file_set.translated_source_filepath]
+
+    @staticmethod
+    def _entry_filename(filepath):
+        # Every output of a module has a distinct extension, and the module name is already part of the key
+        return "module" + os.path.splitext(filepath)[1]
+
+    def _entry_dir(self, key):
+        return os.path.join(self.cache_dir, key[:2], key)
+
+    def key(self, module_file_set, tool_args):
+        h = hashlib.sha256()
+        with open(module_file_set.generated_mlir_filepath, "rb") as f:
+            h.update(f.read())
+        for arg in [module_file_set.output_type.name] + tool_args + [get_tool_fingerprint()]:
+            h.update(arg.encode())
+            h.update(b"\0")
+        return h.hexdigest()
+
+    def restore(self, key, module_file_set, quiet=True):
+        """Copies the cached outputs for the key into the module's file set. Returns False on a cache miss."""
+        entry_dir = self._entry_dir(key)
+        if not os.path.isdir(entry_dir):
+            return False
+
+        if not quiet:
+            print(f"Using cached outputs for {module_file_set.module_name} from {entry_dir}")
+
+        makedir(module_file_set.module_dir, quiet=quiet)
+        for filepath in self._output_filepaths(module_file_set):
+            shutil.copyfile(os.path.join(entry_dir, self._entry_filename(filepath)), filepath)
+        return True
+
+    def store(self, key, module_file_set):
+        entry_dir = self._entry_dir(key)
+        filepaths = self._output_filepaths(module_file_set)
+        if os.path.isdir(entry_dir) or not all(map(os.path.isfile, filepaths)):
+            return
+
+        # Fill a private directory first and then move it into place, so that concurrent builds never
+        # see a partially written entry
+        staging_dir = f"{entry_dir}.{os.getpid()}.{threading.get_ident()}"
+        makedir(staging_dir)
+        for filepath in filepaths:
+            shutil.copyfile(filepath, os.path.join(staging_dir, self._entry_filename(filepath)))
+        try:
+            os.rename(staging_dir, entry_dir)
+        except OSError:
+            # Another build stored the same entry first
+            shutil.rmtree(staging_dir, ignore_errors=True)
+
+
 class AcceraProject:
     stdout_key = "stdout"
     stderr_key = "stderr"
@@ -524,7 +664,9 @@ class AcceraProject:
         output_type=ModuleOutputType.OBJECT,
         print_subprocess_output=False,
         pretend=False,
-        quiet=True
+        quiet=True,
+        num_workers=1,
+        cache_dir=None
     ):
 
         self.library_name = library_name
@@ -539,6 +681,10 @@ class AcceraProject:
         self.print_subprocess_output = print_subprocess_output
         self.pretend = pretend
         self.quiet = quiet
+        self.num_workers = num_workers
+
+        cache_dir = cache_dir or os.environ.get(CACHE_DIR_ENV_VAR)
+        self.cache = CompilationCache(cache_dir) if cache_dir else None
 
         # Create the logs directory
         self.log_dir = os.path.join(self.output_dir, "logs")
@@ -718,7 +864,12 @@ class AcceraProject:
         runtime=Runtime.DEFAULT.value,
         profile=False,
         quiet=None,
-        gpu_only=False
+        gpu_only=False,
+        module_file_sets=None,
+        profile_counters="",
+        instrument=False,
+        trace=False,
+        timer="clock"
     ):
 
         quiet = quiet if quiet is not None else self.quiet
@@ -729,7 +880,11 @@ class AcceraProject:
             system_target=system_target,
             runtime=runtime,
             profile=profile,
-            gpu_only=gpu_only
+            gpu_only=gpu_only,
+            profile_counters=profile_counters,
+            instrument=instrument,
+            trace=trace,
+            timer=timer
         )
 
         if self.print_subprocess_output:
@@ -738,7 +893,7 @@ class AcceraProject:
         rc_opt_exe = os.path.abspath(ACCCConfig.rc_opt)
         rc_opt_base_args = rc_opt_args or DEFAULT_RC_OPT_ARGS
 
-        for module_file_set in self.module_file_sets:
+        for module_file_set in module_file_sets or self.module_file_sets:
             current_output_path = module_file_set.module_dir
 
             makedir(current_output_path, pretend=pretend, quiet=quiet)
@@ -772,7 +927,8 @@ class AcceraProject:
         stderr=None,
         pretend=False,
         system_target=SystemTarget.HOST.value,
-        quiet=None
+        quiet=None,
+        module_file_sets=None
     ):
 
         quiet = quiet if quiet is not None else self.quiet
@@ -780,7 +936,7 @@ class AcceraProject:
         if self.print_subprocess_output:
             stdout = None
             stderr = None
-        for module_file_set in self.module_file_sets:
+        for module_file_set in module_file_sets or self.module_file_sets:
 
             output_type_args = {
                 ModuleOutputType.CUDA: ["-print-cpp"],
@@ -809,7 +965,8 @@ class AcceraProject:
         stderr=None,
         pretend=False,
         system_target=SystemTarget.HOST.value,
-        quiet=None
+        quiet=None,
+        module_file_sets=None
     ):
 
         quiet = quiet if quiet is not None else self.quiet
@@ -817,7 +974,7 @@ class AcceraProject:
         if self.print_subprocess_output:
             stdout = None
             stderr = None
-        for module_file_set in self.module_file_sets:
+        for module_file_set in module_file_sets or self.module_file_sets:
             mlir_translate_exe = os.path.abspath(ACCCConfig.mlir_translate)
             full_mlir_translate_args = []    # empty list every iteration
             full_mlir_translate_args += mlir_translate_args or DEFAULT_MLIR_TRANSLATE_ARGS
@@ -840,7 +997,8 @@ class AcceraProject:
         stderr=None,
         pretend=False,
         system_target=SystemTarget.HOST.value,
-        quiet=None
+        quiet=None,
+        module_file_sets=None
     ):
 
         quiet = quiet if quiet is not None else self.quiet
@@ -848,7 +1006,7 @@ class AcceraProject:
         if self.print_subprocess_output:
             stdout = None
             stderr = None
-        for module_file_set in self.module_file_sets:
+        for module_file_set in module_file_sets or self.module_file_sets:
             llvm_opt_exe = os.path.abspath(ACCCConfig.llvm_opt)
             full_llvm_opt_args = []    # empty list every iteration
             full_llvm_opt_args += llvm_opt_args or (LLVM_TOOLING_OPTS[system_target] + DEFAULT_OPT_ARGS)
@@ -871,7 +1029,8 @@ class AcceraProject:
         stderr=None,
         pretend=False,
         system_target=SystemTarget.HOST.value,
-        quiet=None
+        quiet=None,
+        module_file_sets=None
     ):
 
         quiet = quiet if quiet is not None else self.quiet
@@ -879,7 +1038,7 @@ class AcceraProject:
         if self.print_subprocess_output:
             stdout = None
             stderr = None
-        for module_file_set in self.module_file_sets:
+        for module_file_set in module_file_sets or self.module_file_sets:
             llc_exe = os.path.abspath(ACCCConfig.llc)
             full_llc_args = []    # empty list every iteration
             full_llc_args += llc_args or (LLVM_TOOLING_OPTS[system_target] + DEFAULT_LLC_ARGS)
@@ -903,7 +1062,8 @@ class AcceraProject:
         stderr=None,
         pretend=False,
         system_target=SystemTarget.HOST.value,
-        quiet=None
+        quiet=None,
+        module_file_sets=None
     ):
 
         quiet = quiet if quiet is not None else self.quiet
@@ -911,7 +1071,7 @@ class AcceraProject:
         if self.print_subprocess_output:
             stdout = None
             stderr = None
-        for module_file_set in self.module_file_sets:
+        for module_file_set in module_file_sets or self.module_file_sets:
             llc_exe = os.path.abspath(ACCCConfig.llc)
             full_llc_args = []    # empty list every iteration
             full_llc_args += llc_args or (LLVM_TOOLING_OPTS[system_target] + DEFAULT_LLC_ARGS)
@@ -968,19 +1128,19 @@ class AcceraProject:
         system_target=SystemTarget.HOST.value,
         runtime=Runtime.DEFAULT.value,
         quiet=None,
-        gpu_only=False
+        gpu_only=False,
+        num_workers=None,
+        profile_counters="",
+        instrument=False,
+        trace=False,
+        timer="clock"
     ):
         # By default, save stdout and stderr for each phase to separate files
 
         quiet = quiet if quiet is not None else self.quiet
+        num_workers = num_workers or self.num_workers
 
         emit_files = self.make_log_filepaths("emit")
-        mlir_lowering_files = self.make_log_filepaths("mlir_lowering")
-        translate_files = self.make_log_filepaths("translate_mlir")
-        opt_files = self.make_log_filepaths("opt")
-        llc_files = self.make_log_filepaths("llc")
-        llc_asm_files = self.make_log_filepaths("llc_asm")
-        emitted_lib_files = self.make_log_filepaths("emitted_library")
 
         if generator_parameters:
             with OpenFile(emit_files[self.stdout_key], "w", pretend=pretend) as stdout_file:
@@ -994,6 +1154,113 @@ class AcceraProject:
                         quiet=quiet
                     )
 
+        # Restore the modules whose outputs are already in the cache, and only lower and compile the rest.
+        # Pass dumps are only written by a real run, so they bypass the cache.
+        module_file_sets = self.module_file_sets
+        cache_keys = {}
+        if self.cache and not (pretend or dump_all_passes or dump_intrapass_ir):
+            tool_args = self.get_tool_args(
+                system_target=system_target,
+                runtime=runtime,
+                profile=profile,
+                gpu_only=gpu_only,
+                profile_counters=profile_counters,
+                instrument=instrument,
+                trace=trace,
+                timer=timer
+            )
+            module_file_sets = []
+            for module_file_set in self.module_file_sets:
+                key = self.cache.key(module_file_set, tool_args)
+                if not self.cache.restore(key, module_file_set, quiet=quiet):
+                    cache_keys[module_file_set.module_name] = key
+                    module_file_sets.append(module_file_set)
+
+        emit_args = dict(
+            profile=profile,
+            profile_counters=profile_counters,
+            instrument=instrument,
+            trace=trace,
+            timer=timer,
+            dump_all_passes=dump_all_passes,
+            dump_intrapass_ir=dump_intrapass_ir,
+            pretend=pretend,
+            system_target=system_target,
+            runtime=runtime,
+            quiet=quiet,
+            gpu_only=gpu_only
+        )
+
+        if num_workers > 1 and len(module_file_sets) > 1:
+            # Modules are lowered and compiled independently of each other, so each worker takes one module
+            # through the whole tool chain. The heavy lifting happens in the tool processes, so threads suffice
+            # to keep them all busy.
+            with ThreadPoolExecutor(max_workers=num_workers) as executor:
+                futures = [
+                    executor.submit(
+                        self.emit_module_file_sets, [module_file_set],
+                        log_suffix=f"_{module_file_set.module_name}",
+                        **emit_args
+                    ) for module_file_set in module_file_sets
+                ]
+                for future in futures:
+                    future.result()
+        elif module_file_sets:
+            self.emit_module_file_sets(module_file_sets, **emit_args)
+
+        for module_file_set in module_file_sets:
+            if module_file_set.module_name in cache_keys:
+                self.cache.store(cache_keys[module_file_set.module_name], module_file_set)
+
+    def get_tool_args(
+        self,
+        system_target=SystemTarget.HOST.value,
+        runtime=Runtime.DEFAULT.value,
+        profile=False,
+        gpu_only=False,
+        profile_counters="",
+        instrument=False,
+        trace=False,
+        timer="clock"
+    ):
+        """Returns every argument the default tool chain passes to acc-opt, acc-translate, mlir-translate, opt and llc"""
+        return (
+            [system_target] + DEFAULT_RC_OPT_ARGS + DEFAULT_RC_MLIR_LOWERING_PASSES(
+                system_target=system_target,
+                runtime=runtime,
+                profile=profile,
+                gpu_only=gpu_only,
+                profile_counters=profile_counters,
+                instrument=instrument,
+                trace=trace,
+                timer=timer
+            ) + DEFAULT_ACC_TRANSLATE_ARGS + DEFAULT_MLIR_TRANSLATE_ARGS +
+            LLVM_TOOLING_OPTS.get(system_target, []) + DEFAULT_OPT_ARGS + DEFAULT_LLC_ARGS
+        )
+
+    def emit_module_file_sets(
+        self,
+        module_file_sets,
+        log_suffix="",
+        profile=False,
+        dump_all_passes=False,
+        dump_intrapass_ir=False,
+        pretend=False,
+        system_target=SystemTarget.HOST.value,
+        runtime=Runtime.DEFAULT.value,
+        quiet=None,
+        gpu_only=False,
+        profile_counters="",
+        instrument=False,
+        trace=False,
+        timer="clock"
+    ):
+        mlir_lowering_files = self.make_log_filepaths("mlir_lowering" + log_suffix)
+        translate_files = self.make_log_filepaths("translate_mlir" + log_suffix)
+        opt_files = self.make_log_filepaths("opt" + log_suffix)
+        llc_files = self.make_log_filepaths("llc" + log_suffix)
+        llc_asm_files = self.make_log_filepaths("llc_asm" + log_suffix)
+
         # Note: mlir-opt doesn't appear to support the -o option correctly, so all output goes to stdout
         #       therefore we can't capture and log stdout separately as we need it for the lowering pipeling
         with OpenFile(mlir_lowering_files[self.stderr_key], "w", pretend=pretend) as stderr_file:
@@ -1006,7 +1273,12 @@ class AcceraProject:
                 runtime=runtime,
                 profile=profile,
                 quiet=quiet,
-                gpu_only=gpu_only
+                gpu_only=gpu_only,
+                module_file_sets=module_file_sets,
+                profile_counters=profile_counters,
+                instrument=instrument,
+                trace=trace,
+                timer=timer
             )
 
         if self.output_type == ModuleOutputType.OBJECT:
@@ -1018,7 +1290,8 @@ class AcceraProject:
                         stderr=stderr_file,
                         pretend=pretend,
                         system_target=system_target,
-                        quiet=quiet
+                        quiet=quiet,
+                        module_file_sets=module_file_sets
                     )
 
             with OpenFile(opt_files[self.stdout_key], "w", pretend=pretend) as stdout_file:
@@ -1028,7 +1301,8 @@ class AcceraProject:
                         stderr=stderr_file,
                         pretend=pretend,
                         system_target=system_target,
-                        quiet=quiet
+                        quiet=quiet,
+                        module_file_sets=module_file_sets
                     )
 
             with OpenFile(llc_files[self.stdout_key], "w", pretend=pretend) as stdout_file:
@@ -1038,7 +1312,8 @@ class AcceraProject:
                         stderr=stderr_file,
                         pretend=pretend,
                         system_target=system_target,
-                        quiet=quiet
+                        quiet=quiet,
+                        module_file_sets=module_file_sets
                     )
 
             with OpenFile(llc_asm_files[self.stdout_key], "w", pretend=pretend) as stdout_file:
@@ -1048,7 +1323,8 @@ class AcceraProject:
                         stderr=stderr_file,
                         pretend=pretend,
                         system_target=system_target,
-                        quiet=quiet
+                        quiet=quiet,
+                        module_file_sets=module_file_sets
                     )
 
         elif self.output_type in [ModuleOutputType.CPP, ModuleOutputType.CUDA]:
@@ -1060,7 +1336,8 @@ class AcceraProject:
                         stderr=stderr_file,
                         pretend=pretend,
                         system_target=system_target,
-                        quiet=quiet
+                        quiet=quiet,
+                        module_file_sets=module_file_sets
                     )
 
 
@@ -1082,7 +1359,9 @@ def accc(
     print_subprocess_output=False,
     pretend=False,
     system_target=SystemTarget.HOST.value,
-    runtime=Runtime.DEFAULT.value
+    runtime=Runtime.DEFAULT.value,
+    num_workers=1,
+    cache_dir=None
 ):
     if pretend:
         print()
@@ -1102,7 +1381,9 @@ def accc(
         input_path,
         main_cpp_path,
         print_subprocess_output=print_subprocess_output,
-        pretend=pretend
+        pretend=pretend,
+        num_workers=num_workers,
+        cache_dir=cache_dir
     )
 
     generator_cmake_build_log_files = project.make_log_filepaths("generator")
@@ -240,6 +240,9 @@ namespace util
 
     ir::value::GlobalOp CreateGlobalBufferOp(mlir::OpBuilder& builder, mlir::Operation* anchorOp, mlir::MemRefType bufferType, std::string globalName, bool constant = false, Attribute attr = {}, bool isExternal = false, bool appendUniqueSuffix = true);
 
+    /// <summary> Returns the declaration of an external (e.g. runtime library) function in the module containing anchorOp, declaring it if necessary </summary>
+    ir::value::ValueFuncOp GetOrCreateExternalFunctionDeclaration(mlir::OpBuilder& builder, mlir::Operation* anchorOp, const std::string& name, mlir::FunctionType type);
+
     mlir::Value CreateStackBuffer(mlir::OpBuilder& builder, mlir::Operation* anchorOp, mlir::MemRefType bufferType, int64_t alignment);
     mlir::Value CreateGlobalBuffer(mlir::OpBuilder& builder, mlir::MemRefType bufferType, const std::string& namePrefix, bool constant = false, Attribute attr = {}, bool isExternal = false, bool appendUniqueSuffix = true);
     mlir::Value CreateGlobalBuffer(mlir::OpBuilder& builder, mlir::Operation* anchorOp, mlir::MemRefType bufferType, const std::string& namePrefix, bool constant = false, Attribute attr = {}, bool isExternal = false, bool appendUniqueSuffix = true);
@@ -248,6 +251,13 @@ namespace util
     mlir::Value CreatePrivateBuffer(mlir::OpBuilder& builder, mlir::MemRefType bufferType, const std::string& namePrefix);
     mlir::Value CreatePrivateBuffer(mlir::OpBuilder& builder, mlir::Operation* anchorOp, mlir::MemRefType bufferType, const std::string& namePrefix);
 
+    /// <summary> Returns the number of bytes a statically-shaped memref occupies when stored densely </summary>
+    int64_t GetBufferByteSize(mlir::MemRefType bufferType);
+
+    /// <summary> Creates a view with the given (strided) memref type starting at a byte offset into a 1-D i8 buffer </summary>
+    mlir::Value CreateByteBufferView(mlir::OpBuilder& builder, mlir::Location loc, mlir::Value byteBuffer, int64_t byteOffset, mlir::MemRefType bufferType);
+    mlir::Value CreateByteBufferView(mlir::OpBuilder& builder, mlir::Location loc, mlir::Value byteBuffer, mlir::Value byteOffset, mlir::MemRefType bufferType);
+
     mlir::Location GetLocation(mlir::OpBuilder& builder, std::string tag);
     mlir::Location GetLocation(mlir::OpBuilder& builder, std::string tag, mlir::Location opLocation);
     mlir::Location GetLocation(mlir::OpBuilder& builder, std::string filename, int64_t lineNumber);
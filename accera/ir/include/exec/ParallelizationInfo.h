@@ -6,21 +6,34 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 namespace accera::ir
 {
 namespace executionPlan
 {
+    // Thread placement policies for parallelized loops
+    // Note: the integer values are part of the accera runtime ABI (see runtime/include/ThreadAffinity.h)
+    enum class ParallelizationAffinity : int
+    {
+        Close = 0, // Threads are packed onto consecutive cores (OpenMP proc_bind(close))
+        Spread = 1, // Threads are spread evenly across the available cores (OpenMP proc_bind(spread))
+        Socket = 2, // Threads are grouped into contiguous blocks, one block per socket, each bound to the cores of its socket
+        Explicit = 3, // Thread i is bound to cores[i % cores.size()]
+    };
+
     struct ParallelizationInfo
     {
         int64_t numThreads = 4;
         bool isDynamicPolicy = false;
-        // TODO: pinning
+        ParallelizationAffinity affinity = ParallelizationAffinity::Close;
+        bool numaFirstTouch = false;
+        std::vector<int64_t> cores; // Only used with ParallelizationAffinity::Explicit
 
     private:
         friend inline bool operator==(const ParallelizationInfo& p1, const ParallelizationInfo& p2)
         {
-            return (p1.numThreads == p2.numThreads) && (p1.isDynamicPolicy == p2.isDynamicPolicy);
+            return (p1.numThreads == p2.numThreads) && (p1.isDynamicPolicy == p2.isDynamicPolicy) && (p1.affinity == p2.affinity) && (p1.numaFirstTouch == p2.numaFirstTouch) && (p1.cores == p2.cores);
         }
         friend inline bool operator!=(const ParallelizationInfo& p1, const ParallelizationInfo& p2)
         {
@@ -17,10 +17,13 @@ namespace executionPlan
         int64_t vectorUnitCount = 0;
         bool unrollOnly = false;
 
+        // Run remainder loops that are shorter than the vector width as masked vector ops instead of unrolled scalar code
+        bool maskedTail = false;
+
     private:
         friend inline bool operator==(const VectorizationInfo& v1, const VectorizationInfo& v2)
         {
-            return (v1.vectorBytes == v2.vectorBytes) && (v1.vectorUnitCount == v2.vectorUnitCount) && (v1.unrollOnly == v2.unrollOnly);
+            return (v1.vectorBytes == v2.vectorBytes) && (v1.vectorUnitCount == v2.vectorUnitCount) && (v1.unrollOnly == v2.unrollOnly) && (v1.maskedTail == v2.maskedTail);
         }
         friend inline bool operator!=(const VectorizationInfo& v1, const VectorizationInfo& v2)
         {
@@ -29,5 +32,8 @@ namespace executionPlan
     };
 
     const int64_t AVX2Alignment = 32;
+
+    // Prefetches touch one element per cache line of this size
+    const int64_t CacheLineBytes = 64;
 } // namespace executionPlan
 } // namespace accera::ir
@@ -101,6 +101,12 @@ const mlir::StringRef HeaderDeclAttrName = "accv.emit_header_decl";
 const mlir::StringRef FunctionTagsAttrName = "accv.function_tags";
 const mlir::StringRef NoInlineAttrName = "accv.no_inline";
 const mlir::StringRef BaseNameAttrName = "accv.base_name";
+const mlir::StringRef WorkspaceAttrName = "accv.workspace";
+const mlir::StringRef WorkspaceSizeAttrName = "accv.workspace_size_of";
+const mlir::StringRef ScratchBufferAttrName = "accv.scratch_buffer";
+const mlir::StringRef ScratchFootprintAttrName = "accv.scratch_footprint";
+const mlir::StringRef ProfileModeAttrName = "accv.profile";
+const mlir::StringRef ProfileTraceModeAttrName = "accv.profile_trace";
 
 } // namespace accera::ir
 
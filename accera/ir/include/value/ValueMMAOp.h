@@ -45,7 +45,19 @@ enum class MMAShape
     M16xN16xK16_B1,
 
     M32xN8xK16_B1,
-    M8xN32xK16_B1
+    M8xN32xK16_B1,
+
+    // CPU shapes: one row of int8 A against N columns of int8 B, with 4-way
+    // int8 dot products accumulated into N int32 lanes of C (256-bit and 512-bit)
+    M1xN8xK4_B1,
+    M1xN16xK4_B1,
+
+    // CPU shapes: broadcast-FMA register tiles of floating point vectors with
+    // N lanes (128-bit, 256-bit and 512-bit). The number of rows and vectors
+    // per row of the tile come from the tensorized loops
+    M1xN4xK1_B1,
+    M1xN8xK1_B1,
+    M1xN16xK1_B1
 };
 
 enum class MMAOperandType
@@ -61,6 +73,33 @@ enum class MMASchedulingPolicy
     PassOrder
 };
 
+enum class MMAInstructionSet
+{
+    // Portable vector code, left to the LLVM backend to select instructions for
+    Generic,
+    // vpmaddubsw + vpmaddwd (AVX2 / AVX-512BW)
+    AVX2,
+    // vpdpbusd (AVX512-VNNI / AVX-VNNI)
+    VNNI,
+    // Fused multiply-add of floating point vectors (x86 FMA3 / AArch64 NEON)
+    FMA
+};
+
+inline bool IsCPUMMAShape(MMAShape shape)
+{
+    switch (shape)
+    {
+    case MMAShape::M1xN8xK4_B1:
+    case MMAShape::M1xN16xK4_B1:
+    case MMAShape::M1xN4xK1_B1:
+    case MMAShape::M1xN8xK1_B1:
+    case MMAShape::M1xN16xK1_B1:
+        return true;
+    default:
+        return false;
+    }
+}
+
 class MMAOp
 {
 public:
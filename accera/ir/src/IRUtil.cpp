@@ -28,6 +28,7 @@
 
 #include <llvm/ADT/StringRef.h>
 #include <llvm/ADT/TypeSwitch.h>
+#include <llvm/Support/MathExtras.h>
 
 #include <atomic>
 #include <mutex>
@@ -170,6 +171,29 @@ namespace util
         return builder.create<accera::ir::value::GlobalOp>(loc, bufferType, constant, globalName, attr, /*addrSpace*/ 0, isExternal);
     }
 
+    ir::value::ValueFuncOp GetOrCreateExternalFunctionDeclaration(mlir::OpBuilder& builder, mlir::Operation* anchorOp, const std::string& name, mlir::FunctionType type)
+    {
+        auto loc = anchorOp->getLoc();
+        auto moduleValue = util::CastOrGetParentOfType<ir::value::ValueModuleOp>(anchorOp);
+        assert(moduleValue && "Expected to be inside a ValueModuleOp");
+
+        mlir::OpBuilder::InsertionGuard guard(builder);
+
+        // Lock before accessing the global scope, as multiple functions may be lowered in parallel
+        std::lock_guard<std::mutex> lock(_globalInsertMutex);
+        if (auto fnOp = moduleValue.lookupSymbol<ir::value::ValueFuncOp>(name))
+        {
+            assert(fnOp.getType() == type && "Conflicting declarations of an external function");
+            return fnOp;
+        }
+
+        auto body = moduleValue.getBody();
+        builder.setInsertionPoint(body, body->begin());
+        auto fnOp = builder.create<ir::value::ValueFuncOp>(loc, name, type, ir::value::ExecutionTarget::CPU, ir::value::ValueFuncOp::ExternalFuncTag{});
+        fnOp.setPrivate();
+        return fnOp;
+    }
+
     mlir::Value CreateGlobalBuffer(mlir::OpBuilder& builder, mlir::Operation* anchorOp, mlir::MemRefType bufferType, const std::string& namePrefix, const bool constant, Attribute attr, bool isExternal, bool appendUniqueSuffix)
     {
         auto globalOp = CreateGlobalBufferOp(builder, anchorOp, bufferType, namePrefix, constant, attr, isExternal, appendUniqueSuffix);
@@ -230,6 +254,43 @@ namespace util
         return CreateGlobalBuffer(builder, anchorOp, bufferType, namePrefix);
     }
 
+    int64_t GetBufferByteSize(mlir::MemRefType bufferType)
+    {
+        auto elementType = bufferType.getElementType();
+        auto numElements = bufferType.getNumElements();
+        if (auto vectorType = elementType.dyn_cast<mlir::VectorType>())
+        {
+            numElements *= vectorType.getNumElements();
+            elementType = vectorType.getElementType();
+        }
+        int64_t elementBytes = elementType.isIndex() ? 8 : llvm::divideCeil(elementType.getIntOrFloatBitWidth(), 8);
+        return numElements * elementBytes;
+    }
+
+    mlir::Value CreateByteBufferView(mlir::OpBuilder& builder, mlir::Location loc, mlir::Value byteBuffer, int64_t byteOffset, mlir::MemRefType bufferType)
+    {
+        mlir::Value byteShift = builder.create<mlir::ConstantIndexOp>(loc, byteOffset);
+        return CreateByteBufferView(builder, loc, byteBuffer, byteShift, bufferType);
+    }
+
+    mlir::Value CreateByteBufferView(mlir::OpBuilder& builder, mlir::Location loc, mlir::Value byteBuffer, mlir::Value byteShift, mlir::MemRefType bufferType)
+    {
+        auto viewType = mlir::MemRefType::Builder{ bufferType }.setAffineMaps({});
+        mlir::Value view = builder.create<mlir::memref::ViewOp>(loc, viewType, byteBuffer, byteShift, mlir::ValueRange{});
+
+        auto maps = bufferType.getAffineMaps();
+        if (!maps.empty() && !maps.front().isIdentity())
+        {
+            // Non-identity layouts index into the same dense buffer, so reinterpret the view with them
+            int64_t offset = 0;
+            llvm::SmallVector<int64_t, 4> strides;
+            [[maybe_unused]] auto result = mlir::getStridesAndOffset(bufferType, strides, offset);
+            assert(mlir::succeeded(result) && "Expected a strided layout");
+            view = builder.create<mlir::memref::ReinterpretCastOp>(loc, bufferType, view, offset, bufferType.getShape(), strides);
+        }
+        return view;
+    }
+
     mlir::Location GetLocation(mlir::OpBuilder& builder, std::string tag)
     {
         return mlir::FileLineColLoc::get(mlir::Identifier::get(tag, builder.getContext()), 0, 0);
@@ -160,6 +160,36 @@ namespace ir
             });
         }
 
+        std::string GetProfilePrologue()
+        {
+            std::ostringstream os;
+
+            // The record that <package>_get_profile_counters copies each profile region's totals into
+            os << "#ifndef ACCERA_PROFILE_COUNTER_DEFINED_\n";
+            os << "#define ACCERA_PROFILE_COUNTER_DEFINED_\n";
+            os << "typedef struct AcceraProfileCounter\n";
+            os << "{\n";
+            os << "    const char* name;\n";
+            os << "    int64_t count;\n";
+            os << "    double seconds;\n";
+            os << "    int64_t cycles;\n";
+            os << "    int64_t instructions;\n";
+            os << "    int64_t l1d_misses;\n";
+            os << "    int64_t llc_misses;\n";
+            os << "    int64_t dtlb_misses;\n";
+            os << "} AcceraProfileCounter;\n";
+            os << "#endif // ACCERA_PROFILE_COUNTER_DEFINED_\n\n";
+
+            return os.str();
+        }
+
+        bool ProfileMode(std::vector<value::ValueModuleOp> valueModuleOps)
+        {
+            return std::any_of(valueModuleOps.begin(), valueModuleOps.end(), [](auto m) {
+                return m->getAttr(accera::ir::ProfileModeAttrName);
+            });
+        }
+
         struct LLVMType
         {
             mlir::Type type;
@@ -533,6 +563,11 @@ namespace ir
                 os << GetDebugPrologue();
             }
 
+            if (ProfileMode(valueModuleOps))
+            {
+                os << GetProfilePrologue();
+            }
+
             for (auto& module : valueModuleOps)
             {
                 WriteModuleHeader(os, module, useBarePtrCallConv);
@@ -653,6 +688,7 @@ namespace ir
                         function->CallingConvention(hat::CallingConventionType::CDecl); // TODO : plumb this through
 
                         auto numInputs = fnType.getNumInputs();
+                        auto hasWorkspace = fn->hasAttr(ir::WorkspaceAttrName);
                         for (unsigned i = 0; i < numInputs; ++i)
                         {
                             // TODO : plumb name / description / usage / etc through
@@ -661,9 +697,33 @@ namespace ir
                             // as the LLVM converted version will lose shape and signness information
                             const auto llvmArgType = llvmTypeConverter.convertType(llvmType.getParamType(i));
                             const auto mlirArgType = fnType.getInput(i);
-                            std::unique_ptr<hat::Parameter> arg = ConvertToIncompleteHATParameter(mlirArgType); // TODO : plumb through size string
-                            arg->Name(""); // TODO : plumb parameter name through
-                            arg->Description(""); // TODO : plumb parameter description
+                            std::unique_ptr<hat::Parameter> arg;
+                            if (hasWorkspace && i == numInputs - 1)
+                            {
+                                // The trailing workspace buffer is sized by the companion query function
+                                arg = ConvertToIncompleteHATParameter(mlirArgType, fnName + "_workspace_size()");
+                                arg->Name("workspace");
+                                arg->Description("Caller-supplied scratch memory for this call");
+                            }
+                            else if (fn->hasAttr(ir::ProfileModeAttrName) && i == 0)
+                            {
+                                // The profile counter query copies its records into a caller-supplied array
+                                arg = ConvertToIncompleteHATParameter(mlirArgType, "capacity * sizeof(AcceraProfileCounter)");
+                                arg->Name("counters");
+                                arg->Description("Caller-supplied array of AcceraProfileCounter records");
+                            }
+                            else if (fn->hasAttr(ir::ProfileTraceModeAttrName) && i == 0)
+                            {
+                                arg = ConvertToIncompleteHATParameter(mlirArgType, "strlen(path) + 1");
+                                arg->Name("path");
+                                arg->Description("NUL-terminated path of the trace file to write");
+                            }
+                            else
+                            {
+                                arg = ConvertToIncompleteHATParameter(mlirArgType); // TODO : plumb through size string
+                                arg->Name(""); // TODO : plumb parameter name through
+                                arg->Description(""); // TODO : plumb parameter description
+                            }
                             arg->Usage(hat::UsageType::InputOutput); // TODO : plumb usage through
 
                             auto declaredType = GetLLVMTypeString({ llvmArgType, mlirArgType }); // TODO : support for const
@@ -738,6 +798,11 @@ namespace ir
                 package.DebugCode(GetDebugCode());
             }
 
+            if (ProfileMode(valueModuleOps))
+            {
+                package.CodePrologue(package.CodePrologue() + GetProfilePrologue());
+            }
+
             os << package.Serialize();
 
             return mlir::success();
@@ -23,19 +23,35 @@ namespace executionPlan
     //
     mlir::DialectAsmPrinter& operator<<(mlir::DialectAsmPrinter& printer, VectorizationInfo vectorizationInfo)
     {
-        printer << "{" << vectorizationInfo.vectorBytes << "," << vectorizationInfo.vectorUnitCount << "," << (vectorizationInfo.unrollOnly ? 1 : 0) << '}';
+        printer << "{" << vectorizationInfo.vectorBytes << "," << vectorizationInfo.vectorUnitCount << "," << (vectorizationInfo.unrollOnly ? 1 : 0);
+        if (vectorizationInfo.maskedTail)
+        {
+            printer << ",1";
+        }
+        printer << '}';
         return printer;
     }
 
     mlir::DialectAsmPrinter& operator<<(mlir::DialectAsmPrinter& printer, ParallelizationInfo parallelizationInfo)
     {
-        printer << "{" << (parallelizationInfo.isDynamicPolicy ? 1 : 0) << "," << parallelizationInfo.numThreads << '}';
+        printer << "{" << (parallelizationInfo.isDynamicPolicy ? 1 : 0) << "," << parallelizationInfo.numThreads;
+        if (parallelizationInfo.affinity != ParallelizationAffinity::Close || parallelizationInfo.numaFirstTouch)
+        {
+            printer << "," << static_cast<int>(parallelizationInfo.affinity) << "," << (parallelizationInfo.numaFirstTouch ? 1 : 0);
+            if (!parallelizationInfo.cores.empty())
+            {
+                printer << ",[";
+                llvm::interleaveComma(parallelizationInfo.cores, printer);
+                printer << "]";
+            }
+        }
+        printer << '}';
         return printer;
     }
 
     mlir::DialectAsmPrinter& operator<<(mlir::DialectAsmPrinter& printer, TensorizationInfo tensorizationInfo)
     {
-        printer << "{{" << (int)tensorizationInfo.dim << "}," << tensorizationInfo.numTotalPasses << "," << tensorizationInfo.useStaticOffsets << "," << tensorizationInfo.numFusedPasses << "," << (int)tensorizationInfo.schedulingPolicy << "," << tensorizationInfo._useRocWMMA << "}";
+        printer << "{{" << (int)tensorizationInfo.dim << "}," << tensorizationInfo.numTotalPasses << "," << tensorizationInfo.useStaticOffsets << "," << tensorizationInfo.numFusedPasses << "," << (int)tensorizationInfo.schedulingPolicy << "," << tensorizationInfo._useRocWMMA << "," << (int)tensorizationInfo.instructionSet << "}";
         return printer;
     }
 
@@ -83,15 +99,22 @@ namespace executionPlan
             return {};
 
         int unrollOnly = 0;
+        int maskedTail = 0;
         if (succeeded(parser.parseOptionalComma()))
         {
             if (failed(parser.parseInteger(unrollOnly)))
                 return {};
+
+            if (succeeded(parser.parseOptionalComma()))
+            {
+                if (failed(parser.parseInteger(maskedTail)))
+                    return {};
+            }
         }
         if (failed(parser.parseRBrace()))
             return {};
 
-        return VectorizationInfoAttr::get(VectorizationInfo{ vectorBytes, vectorUnitCount, static_cast<bool>(unrollOnly) }, parser.getBuilder().getContext());
+        return VectorizationInfoAttr::get(VectorizationInfo{ vectorBytes, vectorUnitCount, static_cast<bool>(unrollOnly), static_cast<bool>(maskedTail) }, parser.getBuilder().getContext());
     }
 
     void print(VectorizationInfoAttr attr, mlir::DialectAsmPrinter& printer)
@@ -117,7 +140,7 @@ namespace executionPlan
     ParallelizationInfoAttr parseParallelizationInfo(mlir::DialectAsmParser& parser)
     {
         // Parse a parallelization info attribute in the following form:
-        //   parallelization-info-attr ::= `{` isDynamicPolicy `,` numThreads `}`
+        //   parallelization-info-attr ::= `{` isDynamicPolicy `,` numThreads (`,` affinity `,` numaFirstTouch (`,` `[` core (`,` core)* `]`)?)? `}`
 
         if (failed(parser.parseLBrace()))
             return {};
@@ -133,10 +156,43 @@ namespace executionPlan
         if (failed(parser.parseInteger(numThreads)))
             return {};
 
+        int affinity = static_cast<int>(ParallelizationAffinity::Close);
+        int numaFirstTouch = 0;
+        std::vector<int64_t> cores;
+        if (succeeded(parser.parseOptionalComma()))
+        {
+            if (failed(parser.parseInteger(affinity)))
+                return {};
+
+            if (failed(parser.parseComma()))
+                return {};
+
+            if (failed(parser.parseInteger(numaFirstTouch)))
+                return {};
+
+            if (succeeded(parser.parseOptionalComma()))
+            {
+                if (failed(parser.parseLSquare()))
+                    return {};
+
+                do
+                {
+                    int64_t core;
+                    if (failed(parser.parseInteger(core)))
+                        return {};
+                    cores.push_back(core);
+                } while (succeeded(parser.parseOptionalComma()));
+
+                if (failed(parser.parseRSquare()))
+                    return {};
+            }
+        }
+
         if (failed(parser.parseRBrace()))
             return {};
 
-        return ParallelizationInfoAttr::get(ParallelizationInfo{ static_cast<int64_t>(numThreads), static_cast<bool>(isDynamicPolicy) }, parser.getBuilder().getContext());
+        ParallelizationInfo info{ static_cast<int64_t>(numThreads), static_cast<bool>(isDynamicPolicy), static_cast<ParallelizationAffinity>(affinity), static_cast<bool>(numaFirstTouch), cores };
+        return ParallelizationInfoAttr::get(info, parser.getBuilder().getContext());
     }
 
     void print(ParallelizationInfoAttr attr, mlir::DialectAsmPrinter& printer)
@@ -167,6 +223,7 @@ namespace executionPlan
         int numTotalPasses;
         int schedulingPolicy;
         bool _useRocWMMA;
+        int instructionSet;
         if (failed(parser.parseLBrace()))
             return {};
         if (failed(parser.parseLBrace()))
@@ -195,11 +252,15 @@ namespace executionPlan
             return {};
         if (failed(parser.parseInteger(_useRocWMMA)))
             return {};
+        if (failed(parser.parseComma()))
+            return {};
+        if (failed(parser.parseInteger(instructionSet)))
+            return {};
         if (failed(parser.parseRBrace()))
             return {};
         if (useStaticOffsets != 0 && useStaticOffsets != 1)
             return {};
-        return TensorizationInfoAttr::get(TensorizationInfo{ accera::ir::value::MMAShape{ dim }, numTotalPasses, useStaticOffsets, numFusedPasses, accera::ir::value::MMASchedulingPolicy{ schedulingPolicy }, _useRocWMMA }, parser.getBuilder().getContext());
+        return TensorizationInfoAttr::get(TensorizationInfo{ accera::ir::value::MMAShape{ dim }, numTotalPasses, useStaticOffsets, numFusedPasses, accera::ir::value::MMASchedulingPolicy{ schedulingPolicy }, _useRocWMMA, accera::ir::value::MMAInstructionSet{ instructionSet } }, parser.getBuilder().getContext());
     }
 
     void print(TensorizationInfoAttr attr, mlir::DialectAsmPrinter& printer)
@@ -252,17 +313,21 @@ namespace executionPlan
     //
     llvm::hash_code hash_value(const VectorizationInfo& vectorizationInfo)
     {
-        return llvm::hash_combine(vectorizationInfo.vectorBytes, vectorizationInfo.vectorUnitCount);
+        return llvm::hash_combine(vectorizationInfo.vectorBytes, vectorizationInfo.vectorUnitCount, vectorizationInfo.unrollOnly, vectorizationInfo.maskedTail);
     }
 
     llvm::hash_code hash_value(const ParallelizationInfo& parallelizationInfo)
     {
-        return llvm::hash_combine(parallelizationInfo.numThreads, parallelizationInfo.isDynamicPolicy);
+        return llvm::hash_combine(parallelizationInfo.numThreads,
+                                  parallelizationInfo.isDynamicPolicy,
+                                  parallelizationInfo.affinity,
+                                  parallelizationInfo.numaFirstTouch,
+                                  llvm::hash_combine_range(parallelizationInfo.cores.begin(), parallelizationInfo.cores.end()));
     }
 
     llvm::hash_code hash_value(const TensorizationInfo& tensorizationInfo)
     {
-        return llvm::hash_combine(tensorizationInfo.dim, tensorizationInfo.numTotalPasses, tensorizationInfo.useStaticOffsets, tensorizationInfo.numFusedPasses, tensorizationInfo.schedulingPolicy, tensorizationInfo._useRocWMMA);
+        return llvm::hash_combine(tensorizationInfo.dim, tensorizationInfo.numTotalPasses, tensorizationInfo.useStaticOffsets, tensorizationInfo.numFusedPasses, tensorizationInfo.schedulingPolicy, tensorizationInfo._useRocWMMA, tensorizationInfo.instructionSet);
     }
 
     llvm::hash_code hash_value(const InPlaceUnrollInfo& inPlaceUnrollInfo)
@@ -490,6 +490,36 @@ MMAOp::MMAOp(MMAShape shape_) :
         k = 16;
         blocks = 1;
         break;
+    case MMAShape::M1xN8xK4_B1:
+        m = 1;
+        n = 8;
+        k = 4;
+        blocks = 1;
+        break;
+    case MMAShape::M1xN16xK4_B1:
+        m = 1;
+        n = 16;
+        k = 4;
+        blocks = 1;
+        break;
+    case MMAShape::M1xN4xK1_B1:
+        m = 1;
+        n = 4;
+        k = 1;
+        blocks = 1;
+        break;
+    case MMAShape::M1xN8xK1_B1:
+        m = 1;
+        n = 8;
+        k = 1;
+        blocks = 1;
+        break;
+    case MMAShape::M1xN16xK1_B1:
+        m = 1;
+        n = 16;
+        k = 1;
+        blocks = 1;
+        break;
     default:
         assert(false && "Invalid MMA shape.");
         break;
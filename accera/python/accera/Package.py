@@ -9,7 +9,9 @@ import logging
 import os
 import re
 import shutil
+import time
 from collections import OrderedDict
+from concurrent.futures import ThreadPoolExecutor
 from enum import Enum, Flag, auto
 from functools import wraps, singledispatch
 from hashlib import md5
@@ -20,10 +22,11 @@ from . import _lang_python, lang, algorithms
 from .Targets import Target, Runtime
 from .Parameter import *
 from .Constants import inf
-from .Platforms import Platform, get_library_reference
+from .Platforms import LibraryDependency, Platform, get_library_reference
 
 _R_DIM3 = r"dim3\((\d+),\s*(\d+),\s*(\d+)\)"
 _R_GPU_LAUNCH = f"<<<{_R_DIM3},\s*{_R_DIM3}>>>"
+_R_SCRATCH_FOOTPRINT = r"llvm\.func @(\w+)\(.*\battributes \{.*\baccv\.scratch_footprint = (\d+) : i64"
 del _R_DIM3
 
 
@@ -88,13 +91,13 @@ def _(source, arr: lang.Array):
     _resolve_array_shape(source._sched._nest, arr)
 
 
-def _emit_module(module_to_emit, target, mode, output_dir, name):
+def _emit_module(module_to_emit, target, mode, output_dir, name, cache_dir=None):
     from . import accc
 
     assert target._device_name, "Target is unknown"
     working_dir = os.path.join(output_dir, "_tmp")
 
-    proj = accc.AcceraProject(output_dir=working_dir, library_name=name)
+    proj = accc.AcceraProject(output_dir=working_dir, library_name=name, cache_dir=cache_dir)
     proj.module_file_sets = [
         accc.ModuleFileSet(name=name, common_module_dir=working_dir)
     ]
@@ -122,6 +125,134 @@ def _emit_module(module_to_emit, target, mode, output_dir, name):
     return header_path
 
 
+def _summarize_pass_timings(pass_timings):
+    summary = {}
+    for pass_name, _, seconds in pass_timings:
+        entry = summary.setdefault(pass_name, {"pass": pass_name, "count": 0, "seconds": 0.0})
+        entry["count"] += 1
+        entry["seconds"] += seconds
+    return sorted(summary.values(), key=lambda entry: entry["seconds"], reverse=True)
+
+
+def _summarize_time_trace(time_trace):
+    # Complete ("X") events are timed in microseconds. LLVM appends a "Total <name>" event for each event name,
+    # which would double count the events it totals.
+    summary = {}
+    for event in time_trace.get("traceEvents", []):
+        if event.get("ph") != "X" or event["name"].startswith("Total "):
+            continue
+        detail = event.get("args", {}).get("detail", "")
+        entry = summary.setdefault(
+            (event["name"], detail), {"event": event["name"], "detail": detail, "count": 0, "seconds": 0.0}
+        )
+        entry["count"] += 1
+        entry["seconds"] += event["dur"] / 1e6
+    return sorted(summary.values(), key=lambda entry: entry["seconds"], reverse=True)
+
+
+def _merge_summaries(summaries, key_fields):
+    merged = {}
+    for summary in summaries:
+        for entry in summary:
+            key = tuple(entry[field] for field in key_fields)
+            merged_entry = merged.setdefault(key, {**entry, "count": 0, "seconds": 0.0})
+            merged_entry["count"] += entry["count"]
+            merged_entry["seconds"] += entry["seconds"]
+    return sorted(merged.values(), key=lambda entry: entry["seconds"], reverse=True)
+
+
+def _write_compile_profile(profile_path, name, module_profiles):
+    profile = {
+        "package": name,
+        "total_seconds": sum(p["emit_seconds"] + p["compile_seconds"] for p in module_profiles),
+        "modules": module_profiles,
+        "mlir_passes": _merge_summaries([p["mlir_passes"] for p in module_profiles], ["pass"]),
+        "llvm": _merge_summaries([p["llvm"] for p in module_profiles], ["event", "detail"]),
+    }
+    with open(profile_path, "w") as f:
+        json.dump(profile, f, indent=2)
+
+
+def _compile_modules_in_process(
+    modules,
+    module_file_sets,
+    target_device,
+    target,
+    num_workers,
+    profile=False,
+    profile_regions=False,
+    profile_counters="",
+    instrument=False,
+    trace=False,
+    timer="clock",
+):
+    from . import accc
+
+    pipeline_options = accc.get_acc_to_llvm_options(
+        system_target=target._device_name,
+        runtime=target.runtime.name,
+        profile=profile_regions,
+        profile_counters=profile_counters,
+        instrument=instrument,
+        trace=trace,
+        timer=timer,
+    )
+    size_level = 2 if "-Oz" in accc.LLVM_TOOLING_OPTS.get(target._device_name, []) else 0
+
+    def compile_module(module, module_file_set):
+        os.makedirs(module_file_set.module_dir, exist_ok=True)
+        time_trace_path = (
+            os.path.join(module_file_set.module_dir, module_file_set.module_name + "_time_trace.json")
+            if profile
+            else None
+        )
+
+        start = time.perf_counter()
+        pass_timings, scratch_footprints = _lang_python._CompileModule(
+            module,
+            target_device,
+            pipeline_options,
+            module_file_set.object_filepath,
+            asm_path=module_file_set.asm_filepath,
+            size_level=size_level,
+            time_trace_path=time_trace_path,
+        )
+        if not profile:
+            return None, scratch_footprints
+
+        compile_seconds = time.perf_counter() - start
+        with open(time_trace_path) as f:
+            time_trace = json.load(f)
+        module_profile = {
+            "compile_seconds": compile_seconds,
+            "mlir_passes": _summarize_pass_timings(pass_timings),
+            "llvm": _summarize_time_trace(time_trace),
+        }
+        return module_profile, scratch_footprints
+
+    # Every module owns its MLIR context and compiling releases the GIL, so the modules compile concurrently
+    with ThreadPoolExecutor(max_workers=num_workers) as executor:
+        results = list(executor.map(compile_module, modules, module_file_sets))
+
+    module_profiles = [module_profile for module_profile, _ in results]
+    scratch_footprints = {}
+    for _, module_footprints in results:
+        scratch_footprints.update(module_footprints)
+    return module_profiles, scratch_footprints
+
+
+def _read_scratch_footprints(lowered_mlir_filepath):
+    "Returns the planned scratch footprint in bytes of each function in a lowered MLIR file, keyed by name"
+    footprints = {}
+    if os.path.isfile(lowered_mlir_filepath):
+        with open(lowered_mlir_filepath) as f:
+            for line in f:
+                m = re.search(_R_SCRATCH_FOOTPRINT, line)
+                if m:
+                    footprints[m[1]] = int(m[2])
+    return footprints
+
+
 class SetActiveModule:
     def __init__(self, module):
         self.module = module
@@ -165,6 +296,20 @@ class Package:
         RELEASE = "Release"  #: Release (maximally optimized).
         DEBUG = "Debug"  #: Debug mode (automatically tests logical equivalence).
 
+    class ProfileCounters(Flag):
+        "Hardware performance counters that a profiled package reads in each profile region (Linux only)"
+        CYCLES = auto()
+        INSTRUCTIONS = auto()
+        L1D_MISSES = auto()  #: L1 data cache read misses.
+        LLC_MISSES = auto()  #: Last level cache misses.
+        DTLB_MISSES = auto()  #: Data TLB read misses.
+        ALL = CYCLES | INSTRUCTIONS | L1D_MISSES | LLC_MISSES | DTLB_MISSES
+
+    class Timer(Enum):
+        "The time source of the profile regions and of GetTime()"
+        CLOCK = "clock"  #: The operating system's clock.
+        CYCLE_COUNTER = "cycle-counter"  #: The CPU's cycle counter on x86-64 and AArch64, the clock elsewhere.
+
     Platform = Platform
 
     # class attribute to track the default module
@@ -410,10 +555,11 @@ class Package:
         else:
             raise ValueError("Invalid type for source")
 
-    def _add_functions_to_module(self, module, fail_on_error=False):
+    def _add_functions_to_module(self, module, fail_on_error=False, fn_names=None):
         with SetActiveModule(module):
             to_pop = []
-            for name, wrapped_func in self._fns.items():
+            for name in fn_names if fn_names is not None else list(self._fns):
+                wrapped_func = self._fns[name]
                 try:
                     wrapped_func._emit()
                 except Exception as e:
@@ -491,9 +637,13 @@ class Package:
                 target_device.device_name = "avx512"
                 target_device.cpu = "skylake-avx512"
                 # TODO: make this functionality less hidden
-                avx512_feat_str = ",".join(
-                    [f"+{feature.lower()}" for feature in target.extensions]
-                )
+                # Some extensions have different LLVM feature names
+                llvm_feature_names = {"AVX512": "avx512f", "AVX-VNNI": "avxvnni"}
+                avx512_features = [llvm_feature_names.get(feature, feature.lower()) for feature in target.extensions]
+                if "AVX-VNNI" in target.extensions:
+                    # AVX-512 CPUs provide the EVEX encoded vpdpbusd as well, which the 512-bit int8 kernels need
+                    avx512_features.append("avx512vnni")
+                avx512_feat_str = ",".join([f"+{feature}" for feature in avx512_features])
 
                 target_device.features = avx512_feat_str
 
@@ -531,6 +681,14 @@ class Package:
         tolerance: float = 1e-5,
         output_dir: str = None,
         fail_on_error: bool = False,
+        workspace: bool = False,
+        num_workers: int = 1,
+        cache_dir: str = None,
+        compile_profile: bool = False,
+        profile: Union[bool, "Package.ProfileCounters"] = False,
+        instrument: bool = False,
+        trace: bool = False,
+        timer: Timer = Timer.CLOCK,
         _quiet=True,
     ):
         """Builds a HAT package.
@@ -542,6 +700,29 @@ class Package:
             platform: The platform where the package runs.
             tolerance: The tolerance for correctness checking when `mode = Package.Mode.DEBUG`.
             output_dir: The path to an output directory. Defaults to the current directory if unspecified.
+            workspace: If True, each function takes a trailing caller-supplied workspace buffer that holds all of its
+                cache and temporary arrays, and a `<function>_workspace_size()` query is emitted for it.
+            num_workers: The number of modules to split the functions across. Each module is lowered and compiled
+                by its own worker, in parallel, and the results are linked into a single HAT package.
+            cache_dir: The path to a directory that caches the lowered and compiled modules across builds. Defaults to
+                the `ACCERA_CACHE_DIR` environment variable. The cache is not used if neither is set.
+            compile_profile: If True, each function is compiled in a module of its own and the time spent emitting
+                it, in each MLIR lowering pass and in each LLVM pass is written to `<name>.compile_profile.json` next
+                to the HAT file. Profiled builds don't use the compilation cache. Not supported with `Package.Mode.DEBUG`
+                or with `profile`, `instrument` or `trace`, which keep every function in a single module.
+            profile: If True, the profile regions in the functions are timed, and the package exports
+                `<name>_get_profile_counters` and `<name>_reset_profile_counters` to read and clear the totals.
+                Profiled packages keep all of their functions in a single module, so that they share the counters.
+                A combination of `Package.ProfileCounters` also reads those hardware counters around each region,
+                through Linux perf_event. Counters that can't be read at runtime are reported as 0. Only supported
+                on 64-bit targets.
+            instrument: If True, each kernel, cache copy and parallel region is wrapped in a profile region of its
+                own while the functions are lowered, named `<function>/<kind>_<n>`. Implies `profile=True`.
+            trace: If True, every thread records when it enters and exits each profile region, and the package exports
+                `<name>_write_profile_trace(path)` to write the events to a Chrome trace JSON file that Perfetto
+                opens, and `<name>_reset_profile_trace()` to discard them. Implies `profile=True`.
+            timer: The time source of the profile regions and of GetTime(). `Package.Timer.CYCLE_COUNTER` reads the
+                CPU's cycle counter, which is much cheaper than the clock, on x86-64 and AArch64 CPU targets.
         """
 
         from . import accc
@@ -558,6 +739,56 @@ class Package:
                 raise ValueError("GPU targets must specify a runtime")
             if mode == Package.Mode.DEBUG:
                 raise ValueError("GPU targets do not support Package.Mode.DEBUG")
+            if workspace:
+                raise ValueError("GPU targets do not support workspace packages")
+            if profile or instrument or trace:
+                raise ValueError("GPU targets do not support profiled packages")
+            if timer != Package.Timer.CLOCK:
+                raise ValueError("GPU targets only support Package.Timer.CLOCK")
+
+        profile_counters = profile if isinstance(profile, Package.ProfileCounters) else Package.ProfileCounters(0)
+        profile = bool(profile) or instrument or trace
+        if profile and target_device.num_bits != 64:
+            # The AcceraProfileCounter records that the package exports are laid out with 64-bit pointers
+            raise ValueError("Profiled packages are only supported on 64-bit targets")
+        if profile_counters or trace or timer == Package.Timer.CYCLE_COUNTER:
+            # The counters are read, the trace is kept and the cycle counter is calibrated by the CPU runtime library
+            runtime_library = get_library_reference(LibraryDependency.RUNTIME, platform)
+            if not runtime_library:
+                raise ValueError(
+                    f"The {LibraryDependency.RUNTIME.value} library for {platform.value} was not found, it is needed for "
+                    "hardware profile counters, profile traces and Package.Timer.CYCLE_COUNTER"
+                )
+            if all(dep.name != runtime_library.name for dep in dynamic_dependencies):
+                dynamic_dependencies.append(runtime_library)
+        profile_counter_names = ",".join(
+            counter.name.lower() for counter in [
+                Package.ProfileCounters.CYCLES,
+                Package.ProfileCounters.INSTRUCTIONS,
+                Package.ProfileCounters.L1D_MISSES,
+                Package.ProfileCounters.LLC_MISSES,
+                Package.ProfileCounters.DTLB_MISSES,
+            ] if counter in profile_counters
+        )
+
+        if workspace and mode == Package.Mode.DEBUG:
+            raise ValueError("Workspace packages do not support Package.Mode.DEBUG")
+
+        if num_workers < 1:
+            raise ValueError("num_workers must be at least 1")
+
+        # Compile profiles are collected by the in-process compiler, which only generates CPU object files
+        dump_ir = bool(format & (Package.Format.MLIR | Package.Format.MLIR_VERBOSE))
+        dump_ir_verbose = bool(format & Package.Format.MLIR_VERBOSE)
+        if compile_profile and (
+            target.category != Target.Category.CPU
+            or dump_ir
+            or format & Package.Format.SOURCE
+        ):
+            raise ValueError("compile_profile is only supported for CPU packages without the MLIR or source formats")
+        if compile_profile and (mode == Package.Mode.DEBUG or profile):
+            # Debug and profiled packages keep every function in a single module, so they can't be profiled per function
+            raise ValueError("compile_profile is not supported with Package.Mode.DEBUG or profiled packages")
 
         cross_compile = platform != Platform.HOST
 
@@ -593,11 +824,12 @@ class Package:
             for fn_name, utilities in debug_utilities.items():
                 self._fns[fn_name].output_verifiers = utilities
 
-        # Create the package module
-        package_module = _lang_python._Module(name=name, options=compiler_options)
-        self._add_functions_to_module(package_module, fail_on_error)
+        for fn in self._fns.values():
+            fn.workspace = workspace
+
+        compiler_options.profile = profile
+        compiler_options.profile_trace = trace
 
-        # Emit the package module
         if format & Package.Format.SOURCE:
             output_type = (
                 accc.ModuleOutputType.CUDA
@@ -607,6 +839,38 @@ class Package:
         else:
             output_type = accc.ModuleOutputType.OBJECT
 
+        # Create the package modules. Functions are dealt round-robin into shards that are compiled independently.
+        # With a compilation cache, each function gets a module of its own instead, so that a rebuild only
+        # recompiles the functions that changed. Compile profiles are per function for the same reason. Debug
+        # utilities call the functions they verify, source output is a single translation unit and the functions of
+        # a profiled package share its profile counters, so those keep every function in one module.
+        cache_dir = None if compile_profile else cache_dir or os.environ.get(accc.CACHE_DIR_ENV_VAR)
+        per_function_modules = bool(cache_dir) or compile_profile
+        fn_names = list(self._fns)
+        shards = [fn_names]
+        if mode != Package.Mode.DEBUG and output_type == accc.ModuleOutputType.OBJECT and not profile:
+            if per_function_modules:
+                shards = [[fn_name] for fn_name in fn_names]
+            else:
+                num_shards = max(1, min(num_workers, len(fn_names)))
+                shards = [fn_names[i::num_shards] for i in range(num_shards)]
+
+        if len(shards) == 1:
+            shard_names = [name]
+        elif per_function_modules:
+            shard_names = [f"{name}_{shard[0]}" for shard in shards]
+        else:
+            shard_names = [f"{name}_shard{i}" for i in range(len(shards))]
+
+        package_modules = []
+        emit_seconds = []
+        for shard, shard_name in zip(shards, shard_names):
+            start = time.perf_counter()
+            package_module = _lang_python._Module(name=shard_name, options=compiler_options)
+            self._add_functions_to_module(package_module, fail_on_error, shard)
+            package_modules.append(package_module)
+            emit_seconds.append(time.perf_counter() - start)
+
         # Emit the supporting modules
         supporting_hats = []
         if (
@@ -615,7 +879,7 @@ class Package:
         ):
             supporting_hats.append(
                 Package._emit_default_module(
-                    compiler_options, target, mode, output_dir, f"{name}_Globals"
+                    compiler_options, target, mode, output_dir, f"{name}_Globals", cache_dir
                 )
             )
             if any(
@@ -630,27 +894,72 @@ class Package:
                 )
 
         proj = accc.AcceraProject(
-            output_dir=working_dir, library_name=name, output_type=output_type
+            output_dir=working_dir,
+            library_name=name,
+            output_type=output_type,
+            num_workers=num_workers,
+            cache_dir=cache_dir,
         )
         proj.module_file_sets = [
             accc.ModuleFileSet(
-                name=name, common_module_dir=working_dir, output_type=output_type
+                name=shard_name, common_module_dir=working_dir, output_type=output_type
             )
+            for shard_name in shard_names
         ]
-        package_module.Save(proj.module_file_sets[0].generated_mlir_filepath)
 
-        # Enable dumping of IR passes based on build format
-        dump_ir = bool(format & (Package.Format.MLIR | Package.Format.MLIR_VERBOSE))
-        dump_ir_verbose = bool(format & Package.Format.MLIR_VERBOSE)
-        proj.generate_and_emit(
-            build_config=mode.value,
-            system_target=target._device_name,
-            runtime=target.runtime.name,
-            dump_all_passes=dump_ir,
-            dump_intrapass_ir=dump_ir_verbose,
-            gpu_only=compiler_options.gpu_only,
-            quiet=_quiet,
-        )
+        # CPU object files are generated without leaving the process, which saves printing and re-parsing the IR
+        # between every tool. The MLIR formats need the textual IR dumps and the compilation cache is keyed on the
+        # textual IR, so those builds go through the accc tools instead.
+        if (
+            output_type == accc.ModuleOutputType.OBJECT
+            and target.category == Target.Category.CPU
+            and not (dump_ir or cache_dir)
+        ):
+            module_profiles, scratch_footprints = _compile_modules_in_process(
+                package_modules,
+                proj.module_file_sets,
+                target_device,
+                target,
+                num_workers,
+                compile_profile,
+                profile,
+                profile_counter_names,
+                instrument,
+                trace,
+                timer.value,
+            )
+            if compile_profile:
+                module_profiles = [
+                    {"module": shard_name, "functions": shard, "emit_seconds": seconds, **module_profile}
+                    for module_profile, shard, shard_name, seconds in zip(
+                        module_profiles, shards, shard_names, emit_seconds
+                    )
+                ]
+                _write_compile_profile(
+                    os.path.join(output_dir, name + ".compile_profile.json"), name, module_profiles
+                )
+        else:
+            for package_module, module_file_set in zip(package_modules, proj.module_file_sets):
+                package_module.Save(module_file_set.generated_mlir_filepath)
+
+            proj.generate_and_emit(
+                build_config=mode.value,
+                system_target=target._device_name,
+                runtime=target.runtime.name,
+                profile=profile,
+                profile_counters=profile_counter_names,
+                instrument=instrument,
+                trace=trace,
+                timer=timer.value,
+                dump_all_passes=dump_ir,
+                dump_intrapass_ir=dump_ir_verbose,
+                gpu_only=compiler_options.gpu_only,
+                quiet=_quiet,
+            )
+
+            scratch_footprints = {}
+            for module_file_set in proj.module_file_sets:
+                scratch_footprints.update(_read_scratch_footprints(module_file_set.lowered_mlir_filepath))
 
         path_root = os.path.join(output_dir, name)
         extension = ".hat"
@@ -659,22 +968,33 @@ class Package:
             shutil.copy(proj.module_file_sets[0].translated_source_filepath, output_dir)
 
         if format & (Package.Format.DYNAMIC_LIBRARY | Package.Format.STATIC_LIBRARY):
-            shutil.copy(proj.module_file_sets[0].object_filepath, output_dir)
+            for module_file_set in proj.module_file_sets:
+                shutil.copy(module_file_set.object_filepath, output_dir)
 
         if format & Package.Format.HAT_PACKAGE:
             # Create initial HAT file containing shape and type metadata that the C++ layer has access to
             header_path = path_root + extension
-            package_module.WriteHeader(header_path)
+            _lang_python._WriteHeaderForModules(header_path, name, package_modules)
 
             # Complete the HAT file with information we have stored at this layer
             hat_file: hat.HATFile = hat.HATFile.Deserialize(header_path)
 
+            # The first shard is the link target, the objects of any other shards are linked in alongside it
+            shard_objs = []
             if format & (
                 Package.Format.DYNAMIC_LIBRARY | Package.Format.STATIC_LIBRARY
             ):
                 hat_file.dependencies.link_target = os.path.basename(
                     proj.module_file_sets[0].object_filepath
                 )
+                shard_objs = [
+                    hat.LibraryReference(
+                        target_file=os.path.abspath(
+                            os.path.join(output_dir, os.path.basename(module_file_set.object_filepath))
+                        )
+                    )
+                    for module_file_set in proj.module_file_sets[1:]
+                ]
 
             supporting_hats = map(hat.HATFile.Deserialize, supporting_hats)
             supporting_objs = []
@@ -699,7 +1019,7 @@ class Package:
                 )
 
             decl_code = hat_file.declaration.code
-            hat_file.dependencies.dynamic = dynamic_dependencies + supporting_objs
+            hat_file.dependencies.dynamic = dynamic_dependencies + shard_objs + supporting_objs
             hat_file.declaration.code = decl_code._new(
                 "\n".join(map(str, ["", decl_code] + supporting_decls))
             )
@@ -716,6 +1036,10 @@ class Package:
                         )
 
                     hat_func.auxiliary = fn.auxiliary
+                    if fn_name in scratch_footprints:
+                        # The bytes of cache and temporary arrays that a call uses, after buffer reuse
+                        accera_metadata = {**fn.auxiliary.get("accera", {}), "scratch_footprint": scratch_footprints[fn_name]}
+                        hat_func.auxiliary = {**fn.auxiliary, "accera": accera_metadata}
 
                     if (
                         fn.target.category == Target.Category.GPU
@@ -832,7 +1156,7 @@ class Package:
         _lang_python._SetActiveModule(cls._default_module)
 
     @classmethod
-    def _emit_default_module(cls, compiler_options, target, mode, output_dir, name):
+    def _emit_default_module(cls, compiler_options, target, mode, output_dir, name, cache_dir=None):
         # Specializes and then emits the default module
         cls._default_module.SetDataLayout(compiler_options)
-        return _emit_module(cls._default_module, target, mode, output_dir, name)
+        return _emit_module(cls._default_module, target, mode, output_dir, name, cache_dir)
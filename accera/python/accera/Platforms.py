@@ -27,9 +27,10 @@ class Platform(Enum):
 class LibraryDependency(Enum):
     OPENMP = "openmp"
     VULKAN = "vulkan"
+    RUNTIME = "runtime"
 
 
-def find_vulkan_wrapper(file_name):
+def find_runtime_library(file_name):
     try:
         from ._version import __version__
     except:
@@ -50,9 +51,15 @@ def find_vulkan_wrapper(file_name):
 # TODO: rename and export so that it is updatable
 platform_libraries = {
     LibraryDependency.VULKAN: {
-        Platform.LINUX: find_vulkan_wrapper("libacc-vulkan-runtime-wrappers.so"),
-        Platform.MACOS: find_vulkan_wrapper("libacc-vulkan-runtime-wrappers.dylib"),
-        Platform.WINDOWS: find_vulkan_wrapper("acc-vulkan-runtime-wrappers.lib")
+        Platform.LINUX: find_runtime_library("libacc-vulkan-runtime-wrappers.so"),
+        Platform.MACOS: find_runtime_library("libacc-vulkan-runtime-wrappers.dylib"),
+        Platform.WINDOWS: find_runtime_library("acc-vulkan-runtime-wrappers.lib")
+    },
+    LibraryDependency.RUNTIME: {
+        Platform.LINUX: find_runtime_library("libacc-cpu-runtime.so"),
+        Platform.MACOS: find_runtime_library("libacc-cpu-runtime.dylib"),
+        Platform.MACOS_ARM64: find_runtime_library("libacc-cpu-runtime.dylib"),
+        Platform.WINDOWS: find_runtime_library("acc-cpu-runtime.lib")
     },
     LibraryDependency.OPENMP: {
         Platform.LINUX: {
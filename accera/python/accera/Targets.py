@@ -12,7 +12,8 @@ from enum import Enum, auto
 
 from ._lang_python import ScalarType, _GetKnownDeviceNames
 from ._lang_python._lang import (
-    BLOCK_X, BLOCK_Y, BLOCK_Z, THREAD_X, THREAD_Y, THREAD_Z, _MemorySpace, _MMAShape, _ExecutionRuntime as Runtime
+    BLOCK_X, BLOCK_Y, BLOCK_Z, THREAD_X, THREAD_Y, THREAD_Z, _MemorySpace, _MMAShape, _MMAInstructionSet,
+    _ExecutionRuntime as Runtime
 )
 
 
@@ -775,7 +776,12 @@ class TensorCoreInformation:
             _MMAShape.M32xN32xK4_B1: (32, 32, 4),
             _MMAShape.M16xN16xK8_B1: (16, 16, 8),
             _MMAShape.M32xN8xK16_B1: (32, 8, 16),
-            _MMAShape.M8xN32xK16_B1: (8, 32, 16)
+            _MMAShape.M8xN32xK16_B1: (8, 32, 16),
+            _MMAShape.M1xN8xK4_B1: (1, 8, 4),
+            _MMAShape.M1xN16xK4_B1: (1, 16, 4),
+            _MMAShape.M1xN4xK1_B1: (1, 4, 1),
+            _MMAShape.M1xN8xK1_B1: (1, 8, 1),
+            _MMAShape.M1xN16xK1_B1: (1, 16, 1)
         }[mma_shape]
 
     def compute_tensor_splits(self, mma_shape: _MMAShape, num_total_passes: int = 1):
@@ -1148,6 +1154,60 @@ For more details please refer to this link: https://microsoft.github.io/Accera/R
             other._max_vector_registers == 0 or self.vector_registers <= other._max_vector_registers,
         ])
 
+    def get_microkernel_tile(self, element_bytes: int = 4):
+        """Returns the (rows, columns) of the largest register-blocked outer-product tile for this CPU target.
+
+        Each row of the tile accumulates into two vector registers, and the tile leaves one register for the
+        broadcast row element and two for the column vectors, e.g. 6x16 for AVX2 and 14x32 for AVX-512 float32.
+        """
+        if self.category != Target.Category.CPU:
+            raise ValueError("Micro-kernel tiles are only available for CPU targets")
+        # NEON has 32 128-bit registers, which is also the fallback for ARM targets without vector information
+        vector_bytes = self.vector_bytes or 16
+        vector_registers = self.vector_registers or 32
+        lanes = max(1, vector_bytes // element_bytes)
+        rows = max(1, (vector_registers - 3) // 2)
+        return rows, 2 * lanes
+
+    def _get_cpu_mma_instruction_set(self, mma_shape: _MMAShape) -> _MMAInstructionSet:
+        "Selects the int8 dot-product or fused multiply-add instructions for a CPU MMA shape from the extensions of this target"
+        if mma_shape in [_MMAShape.M1xN4xK1_B1, _MMAShape.M1xN8xK1_B1, _MMAShape.M1xN16xK1_B1]:
+            return self._get_cpu_fma_instruction_set()
+
+        if self.architecture not in [Target.Architecture.HOST, Target.Architecture.X86_64, Target.Architecture.X86]:
+            return _MMAInstructionSet.GENERIC
+
+        extensions = set(self.extensions)
+        if self.architecture == Target.Architecture.HOST:
+            # the default HOST extensions are conservative, so check what the host actually supports
+            flags = cpuinfo.get_cpu_info().get("flags", [])
+            if "avx512bw" in flags:
+                extensions.add("AVX512")
+            if "avx512_vnni" in flags or "avx512vnni" in flags or "avx_vnni" in flags:
+                extensions.add("AVX-VNNI")
+
+        if mma_shape == _MMAShape.M1xN16xK4_B1:
+            if "AVX512" not in extensions:
+                return _MMAInstructionSet.GENERIC
+            return _MMAInstructionSet.VNNI if "AVX-VNNI" in extensions else _MMAInstructionSet.AVX2
+
+        if "AVX-VNNI" in extensions:
+            return _MMAInstructionSet.VNNI
+        return _MMAInstructionSet.AVX2 if "AVX2" in extensions else _MMAInstructionSet.GENERIC
+
+    def _get_cpu_fma_instruction_set(self) -> _MMAInstructionSet:
+        "Selects fused multiply-adds for the float register tiles if this target supports them"
+        if self.architecture == Target.Architecture.AARCH64:
+            return _MMAInstructionSet.FMA    # NEON fmla is part of the base ARMv8 ISA
+        if self.architecture == Target.Architecture.HOST:
+            flags = cpuinfo.get_cpu_info().get("flags", [])
+            return _MMAInstructionSet.FMA if "fma" in flags or "asimd" in flags else _MMAInstructionSet.GENERIC
+        if self.architecture in [Target.Architecture.X86_64, Target.Architecture.X86]:
+            # every x86 core with AVX2 also has FMA3
+            if any(e in self.extensions for e in ["FMA3", "AVX2", "AVX512"]):
+                return _MMAInstructionSet.FMA
+        return _MMAInstructionSet.GENERIC
+
 
 # for convenience
 Target.HOST = Target()
@@ -32,6 +32,8 @@ class Cache:
     location: _MemorySpace = _MemorySpace.NONE
     indexing: CacheIndexing = CacheIndexing.GLOBAL_TO_PHYSICAL
     allocation: _CacheAllocation = _CacheAllocation.AUTO
+    element_type: Any = None
+    prefetch_distance: int = None
 
     @property
     def target_shape(self):
@@ -88,5 +90,7 @@ class DelayedCache(Cache):
         self.location = cache.location
         self.indexing = cache.indexing
         self.allocation = cache.allocation
+        self.element_type = cache.element_type
+        self.prefetch_distance = cache.prefetch_distance
 
         self.completed = True
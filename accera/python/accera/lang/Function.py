@@ -65,6 +65,7 @@ class Function:
     param_overrides: dict = field(default_factory=dict)    # overrides for constants
     definition: Callable = None
     no_inline: bool = False
+    workspace: bool = False    # scratch memory is supplied by the caller
     auxiliary: dict = field(default_factory=dict)
     target: Target = Target.HOST
     output_verifiers: list = field(default_factory=list)
@@ -115,7 +116,9 @@ class Function:
                 api_decl.parameters(self.args, usages)
             if self.base_name:
                 api_decl.baseName(self.base_name)
-            api_decl.public(True).decorated(False).headerDecl(True).rawPointerAPI(True).define(self._native_fn)
+            api_decl.public(True).decorated(False).headerDecl(True).rawPointerAPI(True).workspace(self.workspace).define(
+                self._native_fn
+            )
 
     def __call__(self, *args):
         self._emit()
@@ -104,22 +104,30 @@ class Plan:
         # TODO: Move to final location depending on where unroll should be
         context.schedule.unroll(native_index)
 
-    def vectorize(self, index: Union[LoopIndex, DelayedParameter]):
+    def vectorize(self, index: Union[LoopIndex, DelayedParameter], masked_tail: Union[bool, DelayedParameter] = False):
         """Only available for targets that have SIMD registers and support vector instructions. Marks a dimension of the iteration-space for vectorization.
         Args:
             index: The index to vectorize
+            masked_tail: Whether to run the boundary block of the index (when its size does not divide the
+                split size) with masked vector loads and stores, instead of unrolled scalar code.
         """
-        if isinstance(index, DelayedParameter):
-            self._delayed_calls[partial(self.vectorize)] = index
+        if any([isinstance(arg, DelayedParameter) for arg in [index, masked_tail]]):
+            self._delayed_calls[partial(self.vectorize)] = {
+                "index": index,
+                "masked_tail": masked_tail,
+            }
             return None
 
-        if not self._target.vectorization_info:
+        vectorization_info = self._target.vectorization_info
+        if not vectorization_info:
             raise RuntimeError("The target does not support vectorization")
 
+        vectorization_info.masked_tail = masked_tail
+
         self._add_index_attr(index, "vectorized")
 
         self._commands.append(
-            partial(self._vectorize, index, self._target.vectorization_info)
+            partial(self._vectorize, index, vectorization_info)
         )
 
     def _vectorize(self, index, vectorization_info, context: NativeLoopNestContext):
@@ -128,8 +136,10 @@ class Plan:
     def parallelize(
         self,
         indices: Union[LoopIndex, Tuple[LoopIndex], DelayedParameter],
-        pin: Union[Tuple[Any], DelayedParameter] = None,
+        pin: Union[Tuple[int], DelayedParameter] = None,
         policy: Union[str, DelayedParameter] = "static",
+        affinity: Union[str, DelayedParameter] = "close",
+        numa_first_touch: Union[bool, DelayedParameter] = False,
     ):
         """Executes one or more loops in parallel on multiple cores or processors.
         Only available for targets with multiple cores or processors.
@@ -142,20 +152,49 @@ class Plan:
                 Unsplit indices will be assigned one thread each, split indices
                 will be assigned threads based on the number of split blocks.
                 This is limited by the number of threads supported by the target.
-            pin: Pin the computation to a subset of cores or processors.
+
+                An index that the iteration logic reduces over (for example, `k` in `C[i, j] += A[i, k] * B[k, j]`)
+                can be parallelized too. Each thread then accumulates into private copies of the reduced arrays,
+                which are combined once the parallel loop is done.
+            pin: Pin the computation to a subset of cores or processors, specified as a tuple of
+                logical core ids. Thread i is pinned to core `pin[i % len(pin)]`. Overrides `affinity`.
             policy: The scheduling policy to apply ("dynamic" or "static").
+            affinity: How threads are placed on the cores ("close", "spread" or "socket").
+                "close" packs the threads onto consecutive cores, "spread" distributes them evenly
+                across the cores, and "socket" divides the threads into contiguous groups, one per socket,
+                and binds each group to the cores of its socket.
+            numa_first_touch: Whether to first touch the cache buffers used by the parallelized loops from
+                the threads that use them, so that their memory is placed on the NUMA nodes of those threads.
         """
-        if self._target.category == Target.Category.CPU:
-            self._dynamic_dependencies.add(LibraryDependency.OPENMP)
-
-        if any([isinstance(arg, DelayedParameter) for arg in [indices, pin, policy]]):
+        if any([isinstance(arg, DelayedParameter) for arg in [indices, pin, policy, affinity, numa_first_touch]]):
             self._delayed_calls[partial(self.parallelize)] = {
                 "indices": indices,
                 "pin": pin,
                 "policy": policy,
+                "affinity": affinity,
+                "numa_first_touch": numa_first_touch,
             }
             return None
 
+        if affinity not in ["close", "spread", "socket"]:
+            raise ValueError("affinity must be one of 'close', 'spread' or 'socket'")
+
+        if pin is not None:
+            pin = [pin] if isinstance(pin, int) else list(pin)
+            if not pin or any([not isinstance(core, int) or core < 0 for core in pin]):
+                raise ValueError("pin must be a non-empty tuple of core ids")
+            affinity = "explicit"
+
+        if self._target.category == Target.Category.CPU:
+            if self._target.runtime == Target.Runtime.THREAD_POOL:
+                # the parallel loops run on the thread pool of the Accera runtime library instead of OpenMP
+                self._dynamic_dependencies.add(LibraryDependency.RUNTIME)
+            else:
+                self._dynamic_dependencies.add(LibraryDependency.OPENMP)
+            if affinity in ["socket", "explicit"] or numa_first_touch:
+                # thread binding is implemented in the Accera runtime library
+                self._dynamic_dependencies.add(LibraryDependency.RUNTIME)
+
         indices = [indices] if isinstance(indices, LoopIndex) else list(indices)
 
         # ensure the indices are contiguous and follow the Schedule ordering
@@ -172,10 +211,10 @@ class Plan:
         for index in indices:
             self._add_index_attr(index, "parallelized")
 
-        self._commands.append(partial(self._parallelize, indices, policy))
+        self._commands.append(partial(self._parallelize, indices, policy, affinity, pin, numa_first_touch))
 
-    def _parallelize(self, indices, policy, context: NativeLoopNestContext):
-        from .._lang_python._lang import _ParallelizationPolicy
+    def _parallelize(self, indices, policy, affinity, pin, numa_first_touch, context: NativeLoopNestContext):
+        from .._lang_python._lang import _ParallelizationPolicy, _ParallelizationAffinity
 
         # num_threads = number of split blocks, clamped by the number of threads supported by this target
         num_threads = min(
@@ -191,6 +230,14 @@ class Plan:
             _ParallelizationPolicy.DYNAMIC
             if policy == "dynamic"
             else _ParallelizationPolicy.STATIC,
+            {
+                "close": _ParallelizationAffinity.CLOSE,
+                "spread": _ParallelizationAffinity.SPREAD,
+                "socket": _ParallelizationAffinity.SOCKET,
+                "explicit": _ParallelizationAffinity.EXPLICIT,
+            }[affinity],
+            pin or [],
+            numa_first_touch,
         )
 
     def tensorize(
@@ -203,7 +250,8 @@ class Plan:
         scheduling_policy: _MMASchedulingPolicy = _MMASchedulingPolicy.PASS_ORDER,
         _use_rocWMMA: bool = False,
     ):
-        """Only available for targets with native matrix multiplication instruction (tensor core) support.
+        """Only available for targets with native matrix multiplication instruction (tensor core) support,
+        and for int8 matrix multiplication on CPU targets.
         Marks the dimensions of the iteration-space for tensorization.
         Only perfectly nested loops of the following form can be tensorized:
 
@@ -212,6 +260,14 @@ class Plan:
                 for j in range(K):
                     C[i, j] += A[i, k] * B[k, j]
 
+        On CPU targets with the int8 shapes M1xN8xK4_B1 or M1xN16xK4_B1, A and B must be 8-bit integer arrays that are cast
+        to int32 and C must be an int32 array. The j index must then have 8 (or 16) iterations and the k index a multiple of 4.
+        The dot products use vpdpbusd on targets with the AVX-VNNI extension, vpmaddubsw and vpmaddwd on targets with AVX2
+        (or AVX512 for M1xN16xK4_B1), and portable vector code otherwise. The x86 instructions require one of A and B to be
+        uint8 and the other int8, and the vpmaddubsw path saturates when a pair of products overflows int16.
+        The floating point shapes M1xN4xK1_B1, M1xN8xK1_B1 and M1xN16xK1_B1 generate a register-blocked outer product instead,
+        see `Plan.microkernel`.
+
         Args:
             indices: The iteration space dimensions to tensorize.
             mma_shape: The MMA op type to use for tensorization.
@@ -220,11 +276,26 @@ class Plan:
             num_fused_passes: This controls the number of passes for which register allocation is done, higher the value more the number of registers that are allocated.
             scheduling_policy: For multi-block MMA operations, this controls whether matrix multiplication is done block-by-block or pass-by-pass (affects register usage).
         """
-        if self._target.category != Target.Category.GPU:
-            raise ValueError("tensorization currently only supported on GPU targets")
-
         indices = [indices] if isinstance(indices, LoopIndex) else list(indices)
 
+        if self._target.category == Target.Category.CPU:
+            if mma_shape not in [
+                _MMAShape.M1xN8xK4_B1, _MMAShape.M1xN16xK4_B1, _MMAShape.M1xN4xK1_B1, _MMAShape.M1xN8xK1_B1,
+                _MMAShape.M1xN16xK1_B1
+            ]:
+                raise ValueError("CPU tensorization requires one of the M1xN*xK4_B1 or M1xN*xK1_B1 MMA shapes")
+            if len(indices) != 3:
+                raise ValueError("CPU tensorization requires three input indices")
+
+            for index in indices:
+                self._add_index_attr(index, "tensorized")
+
+            self._commands.append(partial(self._tensorize_cpu, indices, mma_shape))
+            return
+
+        if self._target.category != Target.Category.GPU:
+            raise ValueError("tensorization currently only supported on CPU and GPU targets")
+
         if len(indices) < 3:
             raise ValueError("tensorization requires at least three input indices")
 
@@ -244,6 +315,56 @@ class Plan:
             )
         )
 
+    def microkernel(self, indices: Tuple[LoopIndex]):
+        """Only available for CPU targets.
+        Generates a register-blocked outer-product micro-kernel for the innermost (i, j, k) loops of a floating point
+        matrix multiplication:
+
+        for i in range(MR):
+            for j in range(NR):
+                for k in range(K):
+                    C[i, j] += A[i, k] * B[k, j]
+
+        The MR x NR tile of C is held in vector registers for the whole k loop. Each k step loads NR / N vectors of B,
+        broadcasts each of the MR elements of A and multiply-accumulates them with the B vectors, using fused multiply-adds
+        on targets that support them. N is the number of float32 lanes of the target's vector registers, and NR must be a
+        multiple of N. `Target.get_microkernel_tile` returns the largest (MR, NR) that fits in the target's registers.
+        A and B may be narrower floating point arrays that are cast to the element type of C.
+
+        Args:
+            indices: The (i, j, k) iteration space dimensions of the micro-kernel.
+        """
+        if self._target.category != Target.Category.CPU:
+            raise ValueError("microkernel is only supported on CPU targets")
+        indices = list(indices)
+        if len(indices) != 3:
+            raise ValueError("microkernel requires three input indices")
+
+        lanes = (self._target.vector_bytes or 16) // 4
+        mma_shape = {
+            4: _MMAShape.M1xN4xK1_B1,
+            8: _MMAShape.M1xN8xK1_B1,
+            16: _MMAShape.M1xN16xK1_B1
+        }.get(lanes)
+        if mma_shape is None:
+            raise ValueError(f"microkernel does not support targets with {self._target.vector_bytes}-byte vector registers")
+
+        for index in indices:
+            self._add_index_attr(index, "tensorized")
+
+        self._commands.append(partial(self._tensorize_cpu, indices, mma_shape))
+
+    def _tensorize_cpu(self, indices, mma_shape, context: NativeLoopNestContext):
+        for index in list(map(self._sched._resolve_index, indices)):
+            start, _, _ = self._sched.get_index_range(index)
+            if start != 0:
+                raise ValueError("The tensorization index must start at 0")
+
+        idxs = [context.mapping[id(index)] for index in indices]
+        context.plan.tensorize(
+            indices=idxs, dims=mma_shape, instruction_set=self._target._get_cpu_mma_instruction_set(mma_shape)
+        )
+
     def _tensorize(
         self,
         indices,
@@ -357,6 +478,8 @@ class Plan:
         double_buffer: Union[bool, DelayedParameter] = False,
         double_buffer_location: Union[object, _MemorySpace, DelayedParameter] = AUTO,
         vectorize: Union[bool, DelayedParameter, object] = AUTO,
+        element_type: "accera.ScalarType" = None,
+        prefetch_distance: int = None,
         _delayed_cache: DelayedCache = None,
     ):
         """Adds a cache for a view target
@@ -369,7 +492,7 @@ class Plan:
             level: The key-slice level to cache (the number of wildcard dimensions in a key-slice). Specify one and only one of `index`, `level`, `max_elements`.
             trigger_level: The key-slice level to fill the cache at. `trigger_level` can't be smaller than `level`, and will default to `level` if not specified. Specify at most one of `trigger_index` or `trigger_level`.
             max_elements: The maximum elements to include in the cached region. Specify one and only one of `index`, `level`, `max_elements`.
-            thrifty: Use thrifty caching (copy data into a cache only if the cached data differs from the original active block). This defaults to False as it slows down compilation speed so it is intended as an opt-in feature.
+            thrifty: Use thrifty caching (copy data into a cache only if the cached data differs from the original active block). This defaults to False.
             double_buffer: Make this a double buffer cache by copying data one iteration ahead and using private memory on GPU for this procedure.
             vectorize: Whether to vectorize the cache operations. Defaults to AUTO, which will behave like `vectorize=True` if the loopnest has a vectorized loop or `vectorize=False` if the loopnest has no vectorized loops.
             double_buffer_location: The memory space used for storing iteration data for the double buffer cache. Requires that double_buffer is set to True. Defaults to AUTO.
@@ -378,6 +501,8 @@ class Plan:
                 | ------------------- | ------------- | ------------------------------- |
                 | MemorySpace.SHARED  | True          | MemorySpace.PRIVATE             |
                 | !MemorySpace.SHARED | True          | Same value as location          |
+            element_type: The element type to store the cached data as, if different from the source element type. The data is converted when the cache is filled, e.g. a `bfloat16` or `float16` input can be cached as `float32` so the inner loops compute in single precision. Only supported for caches of CONST and INPUT arrays.
+            prefetch_distance: Prefetch the source data of the active block that is filled this many iterations ahead of the current one (of the loop enclosing the cache's trigger index), so that it is in flight while the current active block is computed. Only supported on CPU targets and for caches that are not double-buffered.
         """
         if (
             any(
@@ -411,6 +536,8 @@ class Plan:
                     source=source,
                     max_elements=max_elements,
                     location=location,
+                    element_type=element_type,
+                    prefetch_distance=prefetch_distance,
                     _delayed_cache=delayed_cache,
                 )
             ] = {
@@ -441,6 +568,26 @@ class Plan:
         elif isinstance(source, Cache):
             array_role = source.target_role
 
+        if element_type is not None:
+            if array_role not in [Array.Role.CONST, Array.Role.INPUT]:
+                raise ValueError(
+                    "Caching with a converted element type is only supported for CONST and INPUT arrays"
+                )
+            if thrifty or double_buffer:
+                raise ValueError(
+                    "Caching with a converted element type is not supported for thrifty or double-buffered caches"
+                )
+            if self._target.category != Target.Category.CPU:
+                raise ValueError("Caching with a converted element type is only supported on CPU targets")
+
+        if prefetch_distance is not None:
+            if not isinstance(prefetch_distance, int) or prefetch_distance <= 0:
+                raise ValueError("prefetch_distance must be a positive integer")
+            if self._target.category != Target.Category.CPU:
+                raise ValueError("Cache prefetching is only supported on CPU targets")
+            if double_buffer:
+                raise ValueError("Cache prefetching is not supported for double-buffered caches")
+
         if double_buffer and array_role not in [Array.Role.CONST, Array.Role.INPUT]:
             raise ValueError(
                 "Double-buffering is only supported for CONST and INPUT arrays"
@@ -574,6 +721,8 @@ class Plan:
             double_buffer=double_buffer,
             double_buffer_location=double_buffer_location,
             vectorize=vectorize,
+            element_type=element_type,
+            prefetch_distance=prefetch_distance,
         )
 
         if _delayed_cache:
@@ -648,6 +797,8 @@ class Plan:
                 double_buffer=cache.double_buffer,
                 double_buffer_location=cache.double_buffer_location,
                 vectorization_info=vectorization_info,
+                element_type=cache.element_type,
+                prefetch_distance=cache.prefetch_distance,
             )
 
     def pack_and_embed_buffer(
@@ -707,6 +858,42 @@ class Plan:
             )
         )
 
+    def emit_runtime_memoized_pack(
+        self,
+        target,
+        wrapper_fn_name,
+        max_cache_bytes=64 * 1024 * 1024,
+        indexing=CacheIndexing.GLOBAL_TO_PHYSICAL,
+    ):
+        """Emits a wrapping function that packs the given target on the first call for a given buffer and version tag,
+        and reuses the packed copy on later calls. The loopnest is rewritten to assume the given input is packed
+
+        Args:
+            target: The target being cached (e.g Array, Matrix, etc)
+            wrapper_fn_name: The name to give the wrapping function. It takes the arguments of the function
+                followed by an int64 version tag, which the caller changes whenever the contents of the target change
+            max_cache_bytes: The budget for the packed copies kept by the wrapping function. When it is full,
+                the least recently used copy is evicted
+            indexing: The cache indexing
+        """
+        # TODO: Make this work with multiple kernels, fused schedules
+
+        if self._target.category != Target.Category.CPU:
+            raise ValueError("Runtime memoized packing is only supported for CPU targets")
+
+        if max_cache_bytes <= 0:
+            raise ValueError("max_cache_bytes must be positive")
+
+        self._commands.append(
+            partial(
+                self._emit_runtime_memoized_packing,
+                target,
+                wrapper_fn_name,
+                max_cache_bytes,
+                indexing,
+            )
+        )
+
     def _pack_and_embed_buffer(
         self,
         target,
@@ -738,6 +925,17 @@ class Plan:
             target, packing_func_name, packed_buf_size_func_name, indexing
         )
 
+    def _emit_runtime_memoized_packing(
+        self,
+        target,
+        wrapper_fn_name,
+        max_cache_bytes,
+        indexing,
+        context: NativeLoopNestContext,
+    ):
+        target = context.mapping[id(target)]
+        context.plan.emit_runtime_memoized_packing(target, wrapper_fn_name, max_cache_bytes, indexing)
+
     def bind(self, mapping: Mapping[Union[LoopIndex, Tuple[LoopIndex], DelayedParameter], Union[GridUnits, DelayedParameter]]):
         """Binds iteration space dimensions to GPU execution units
 
@@ -8,11 +8,14 @@
 # python -m unittest discover -k "test_input_array" path_to_accera/test dsl_tests.py
 # python -m unittest discover -k "DSLTest_01" path_to_accera/test dsl_tests.py
 
+import ctypes
+import json
 import logging
 import sys
 import unittest
 import os
 import pathlib
+import shutil
 import numpy as np
 from enum import Enum
 from typing import Callable, Tuple
@@ -390,6 +393,79 @@ class DSLTest_01Arrays(unittest.TestCase):
                 output_dir=TEST_PACKAGE_DIR,
             )
 
+    def test_temp_array_memory_planning(self) -> None:
+        # Two TEMP arrays whose lifetimes don't overlap share the same scratch storage
+
+        package = Package()
+        A = Array(shape=(256, 32), role=Array.Role.INPUT)
+        B = Array(shape=(256, 32), role=Array.Role.INPUT_OUTPUT)
+
+        def make_init_function(package, A):
+            nest = Nest(A.shape)
+            i, j = nest.get_indices()
+
+            @nest.iteration_logic
+            def _():
+                A[i, j] = 3.0
+
+            return package.add(nest, args=(A, ))
+
+        def make_copy_function(package, A, B):
+            nest = Nest(A.shape)
+            i, j = nest.get_indices()
+
+            @nest.iteration_logic
+            def _():
+                B[i, j] = A[i, j]
+
+            return package.add(nest, args=(A, B))
+
+        def make_accumulate_function(package, A, B):
+            nest = Nest(A.shape)
+            i, j = nest.get_indices()
+
+            @nest.iteration_logic
+            def _():
+                B[i, j] += A[i, j] * 2.0
+
+            return package.add(nest, args=(A, B))
+
+        init_fn = make_init_function(package, B)
+        copy_fn = make_copy_function(package, A, B)
+        accumulate_fn = make_accumulate_function(package, A, B)
+
+        def test_fn(A, B):
+            T0 = Array(role=Array.Role.TEMP, element_type=A.element_type, shape=A.shape)
+            init_fn(T0)
+            accumulate_fn(T0, B)
+
+            T1 = Array(role=Array.Role.TEMP, element_type=A.element_type, shape=A.shape)
+            copy_fn(A, T1)
+            accumulate_fn(T1, B)
+
+        function = package.add(test_fn, args=(A, B))
+
+        package_name = "test_temp_array_memory_planning"
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / package_name
+        with verifiers.VerifyPackage(self, package_name, output_dir) as v:
+            package.build(package_name, format=TEST_FORMAT | Package.Format.MLIR, mode=TEST_MODE, output_dir=output_dir)
+
+            checker = v.file_checker("*_MemoryPlanning.mlir")
+            checker.check('"accv.global"() {accv.scratch_buffer')
+            checker.check_same("_scratch_arena")
+            checker.check_same("type = memref<32768xi8")
+            checker.run()
+
+            A_test = np.random.random(A.shape).astype(np.float32)
+            B_test = np.random.random(B.shape).astype(np.float32)
+            v.check_correctness(function.name, before=[A_test, B_test], after=[A_test, B_test + 6.0 + 2.0 * A_test])
+
+        # The HAT metadata reports the storage of one of the arrays rather than both
+        import hatlib as hat
+
+        hat_file = hat.HATFile.Deserialize(str(output_dir / f"{package_name}.hat"))
+        self.assertEqual(hat_file.function_map[function.name].auxiliary["accera"]["scratch_footprint"], 256 * 32 * 4)
+
     def test_first_major_array_access(self) -> None:
         A = Array(
             shape=(256, 32), role=Array.Role.INPUT, layout=Array.Layout.FIRST_MAJOR
@@ -2277,6 +2353,37 @@ class DSLTest_06PlansCaching(unittest.TestCase):
 
         self._verify_plan(plan, [A, B, C], "test_thrifty_caching")
 
+    def test_thrifty_caching_large_active_block(self) -> None:
+        # The active blocks cover all of A and B, which is too many elements to check one at a time
+        plan, args, indices = self._create_plan((512, 4, 512))
+        A, B, C = args
+        i, _, _ = indices
+
+        # A is row-major, thrifty mode should skip caching
+        AA = plan.cache(A, thrifty=True, index=i)
+        self.assertIsNotNone(AA)
+
+        # B is column-major, thrifty mode should cache
+        BB = plan.cache(B, thrifty=True, index=i)
+        self.assertIsNotNone(BB)
+
+        # The element-by-element simulation visited each of these, which took minutes for an active block of A
+        self.assertGreaterEqual(A.shape[0] * A.shape[1], 256 * 1024)
+
+        package = Package()
+        package.add(plan, args=(A, B, C), base_name="caching_test")
+        package_name = "test_thrifty_caching_large_active_block"
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / package_name
+        with verifiers.VerifyPackage(self, package_name, output_dir) as v:
+            package.build(package_name, format=TEST_FORMAT | Package.Format.MLIR, mode=TEST_MODE, output_dir=output_dir)
+
+            # Only the cache of B remains, A is read in place
+            checker = v.file_checker("*_LoopNestToValueFunc.mlir")
+            checker.check_not('global_name = @cache_{{[0-9]+}}} : () -> memref<512x512xf32')
+            checker.check('global_name = @cache_{{[0-9]+}}} : () -> memref<512x4xf32')
+            checker.check_not('global_name = @cache_{{[0-9]+}}} : () -> memref<512x512xf32')
+            checker.run()
+
     @expectedFailure(FailedReason.NOT_IN_PY, "Various target memory identifiers")
     def test_cache_mapping(self) -> None:
         A = Array(role=Array.Role.INPUT, shape=(1024,))
@@ -2362,6 +2469,161 @@ class DSLTest_06PlansCaching(unittest.TestCase):
             correctness_check_values=correctness_check_values,
         )
 
+    def test_cache_element_type_conversion(self) -> None:
+        M = 64
+        N = 64
+        S = 64
+
+        A = Array(role=Array.Role.INPUT, element_type=ScalarType.float16, shape=(M, S))
+        B = Array(role=Array.Role.INPUT, element_type=ScalarType.float16, shape=(S, N))
+        C = Array(role=Array.Role.INPUT_OUTPUT, element_type=ScalarType.float32, shape=(M, N))
+
+        nest = Nest(shape=(M, N, S))
+        i, j, k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] += cast(A[i, k], ScalarType.float32) * cast(B[k, j], ScalarType.float32)
+
+        schedule = nest.create_schedule()
+
+        jj = schedule.split(j, 32)
+        kk = schedule.split(k, 16)
+        jjj = schedule.split(jj, 8)
+        ii = schedule.split(i, 4)
+
+        schedule.reorder(j, k, i, jj, kk, ii, jjj)
+        plan = schedule.create_plan()
+
+        # Store the float16 inputs as float32 in the caches so the kernel computes in single precision
+        plan.cache(A, index=ii, element_type=ScalarType.float32)
+        plan.cache(B, index=kk, layout=Array.Layout.FIRST_MAJOR, element_type=ScalarType.float32)
+
+        with self.assertRaises(ValueError):
+            plan.cache(C, index=ii, element_type=ScalarType.float16)
+
+        A_test = np.random.random(A.shape).astype(np.float16)
+        B_test = np.random.random(B.shape).astype(np.float16)
+        C_test = np.random.random(C.shape).astype(np.float32)
+        correctness_check_values = {
+            "pre": [A_test, B_test, C_test],
+            "post": [A_test, B_test, C_test + A_test.astype(np.float32) @ B_test.astype(np.float32)],
+        }
+
+        self._verify_plan(
+            plan,
+            [A, B, C],
+            "test_cache_element_type_conversion",
+            correctness_check_values=correctness_check_values,
+        )
+
+    def test_cache_bfloat16_round_trip(self) -> None:
+        M = 16
+        N = 64
+
+        A = Array(role=Array.Role.INPUT, element_type=ScalarType.float32, shape=(M, N))
+        C = Array(role=Array.Role.INPUT_OUTPUT, element_type=ScalarType.float32, shape=(M, N))
+
+        nest = Nest(shape=(M, N))
+        i, j = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] = A[i, j]
+
+        schedule = nest.create_schedule()
+        jj = schedule.split(j, 16)
+        plan = schedule.create_plan()
+
+        # The float32 input is narrowed to bfloat16 when the cache is filled and widened again when it is read
+        plan.cache(A, index=jj, element_type=ScalarType.bfloat16)
+
+        A_test = np.random.uniform(-100.0, 100.0, A.shape).astype(np.float32)
+        A_bits = A_test.view(np.uint32)
+        A_bits[0, 0:4] = [0x7F800000, 0xFF800000, 0x7FC00000, 0xFFC00000]    # +-inf, +-quiet NaN
+        A_bits[0, 4:8] = [0x7F800001, 0xFF80FFFF, 0x7FBFFFFF, 0x7F7FFFFF]    # NaNs with a low payload, float32 max
+        A_bits[0, 8:10] = [0x3F808000, 0x3F818000]    # halfway cases, rounded to even
+
+        # Round to nearest even, except that NaNs are truncated and made quiet
+        upper_bits = A_bits >> 16
+        rounded_bits = (A_bits + 0x7FFF + (upper_bits & 1)) >> 16
+        C_bits = np.where(np.isnan(A_test), upper_bits | 0x40, rounded_bits).astype(np.uint32) << 16
+        C_ref = C_bits.view(np.float32)
+        self.assertTrue(np.isnan(C_ref[0, 2:7]).all())
+        self.assertTrue(np.isinf(C_ref[0, 7]))    # float32 max rounds up to infinity
+
+        C_test = np.random.random(C.shape).astype(np.float32)
+        correctness_check_values = {
+            "pre": [A_test, C_test],
+            "post": [A_test, C_ref],
+        }
+        self._verify_plan(plan, [A, C], "test_cache_bfloat16_round_trip", correctness_check_values)
+
+    def test_cache_prefetch(self) -> None:
+        M = 64
+        N = 64
+        S = 64
+
+        A = Array(role=Array.Role.INPUT, element_type=ScalarType.float32, shape=(M, S))
+        B = Array(role=Array.Role.INPUT, element_type=ScalarType.float32, shape=(S, N))
+        C = Array(role=Array.Role.INPUT_OUTPUT, element_type=ScalarType.float32, shape=(M, N))
+
+        nest = Nest(shape=(M, N, S))
+        i, j, k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] += A[i, k] * B[k, j]
+
+        schedule = nest.create_schedule()
+
+        jj = schedule.split(j, 32)
+        kk = schedule.split(k, 16)
+        ii = schedule.split(i, 4)
+
+        schedule.reorder(j, k, i, jj, kk, ii)
+        plan = schedule.create_plan()
+
+        # The B block only moves with j and k, so the cache filled inside the i loop prefetches the block of the
+        # next k iteration while the current one is used
+        plan.cache(B, index=jj, layout=Array.Layout.FIRST_MAJOR, prefetch_distance=1)
+
+        with self.assertRaises(ValueError):
+            plan.cache(A, index=ii, prefetch_distance=0)
+
+        A_test = np.random.random(A.shape).astype(np.float32)
+        B_test = np.random.random(B.shape).astype(np.float32)
+        C_test = np.random.random(C.shape).astype(np.float32)
+        correctness_check_values = {
+            "pre": [A_test, B_test, C_test],
+            "post": [A_test, B_test, C_test + A_test @ B_test],
+        }
+
+        package = Package()
+        function = package.add(plan, args=(A, B, C), base_name="caching_test")
+        package_name = "test_cache_prefetch"
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / package_name
+        with verifiers.VerifyPackage(self, package_name, output_dir) as v:
+            package.build(package_name, format=TEST_FORMAT | Package.Format.MLIR, mode=TEST_MODE, output_dir=output_dir)
+
+            # the prefetch is guarded on the k loop (the last k block is at 48, so k + 16 <= 48) rather than on the
+            # i loop it is nested in, and only touches B, one element per 64-byte line (16 x float32)
+            checker = v.file_checker("*_LoopNestToValueFunc.mlir")
+            checker.check("#[[IN_BOUNDS:set[0-9]*]] = affine_set<(d0) : (-d0 + 32 >= 0)>")
+            checker.check("affine.for %[[J:[a-z0-9]+]] = 0 to 64 step 32")
+            checker.check("affine.for %[[K:[a-z0-9]+]] = 0 to 64 step 16")
+            checker.check("affine.for %[[I:[a-z0-9]+]] = 0 to 64 step 4")
+            checker.check("affine.if #[[IN_BOUNDS]](%[[K]])")
+            checker.check("affine.for %{{.+}} = {{.+}} step 16")
+            checker.check("memref.prefetch %{{.+}}[%{{.+}}, %{{.+}}], read, locality<3>, data : memref<64x64xf32")
+            checker.run()
+
+            v.check_correctness(
+                function.name,
+                before=correctness_check_values["pre"],
+                after=correctness_check_values["post"],
+            )
+
     def test_hierachical_caching(self) -> None:
         M = 1024
         N = 1024
@@ -2478,142 +2740,393 @@ class DSLTest_07PlansVectorizationParallelization(unittest.TestCase):
         plan.vectorize(index=i)
         self._verify_plan(plan, [A, B, C], "test_vectorize")
 
-    def test_kernelize(self) -> None:
+    def test_vectorize_masked_tail(self) -> None:
         from accera import Target, Nest
 
-        A = Array(role=Array.Role.INPUT, shape=(16, 11))
-        B = Array(role=Array.Role.INPUT, shape=(11, 10))
-        C = Array(role=Array.Role.INPUT_OUTPUT, shape=(16, 10))
+        A = Array(role=Array.Role.INPUT, shape=(61, ))
+        B = Array(role=Array.Role.INPUT, shape=(61, ))
+        C = Array(role=Array.Role.INPUT_OUTPUT, shape=(61, ))
 
-        nest = Nest(shape=(16, 10, 11))
-        i, j, k = nest.get_indices()
+        my_target = Target(category=Target.Category.CPU, vector_bytes=32, vector_registers=16)
+
+        nest = Nest(shape=(61, ))
+        i = nest.get_indices()
 
         @nest.iteration_logic
         def _():
-            C[i, j] += A[i, k] * B[k, j]
+            C[i] = A[i] * B[i]
 
-        my_target = Target(
-            category=Target.Category.CPU, vector_bytes=16, vector_registers=2
-        )
-        plan = nest.create_plan(my_target)
+        schedule = nest.create_schedule()
+        ii = schedule.split(i, 8)
 
-        # Shorthand for:
-        # plan.unroll(i)
-        # plan.unroll(j)
-        # plan.vectorize(k)
-        plan.kernelize(unroll_indices=(i, j), vectorize_indices=k)
-        self._verify_plan(plan, [A, B, C], "test_kernelize")
+        # the last block of ii has 5 elements, which are run as masked 8-element vector ops
+        plan = schedule.create_plan(my_target)
+        plan.vectorize(index=ii, masked_tail=True)
+        self._verify_plan(plan, [A, B, C], "test_vectorize_masked_tail")
 
-    def test_kernelize_2(self) -> None:
+    def test_vectorize_masked_tail_integer_division(self) -> None:
         from accera import Target, Nest
 
-        A = Array(role=Array.Role.INPUT, shape=(16, 16))
-        B = Array(role=Array.Role.INPUT, shape=(16, 16))
-        C = Array(role=Array.Role.INPUT_OUTPUT, shape=(16, 16))
+        A = Array(role=Array.Role.INPUT, element_type=ScalarType.int32, shape=(61, ))
+        B = Array(role=Array.Role.INPUT, element_type=ScalarType.int32, shape=(61, ))
+        C = Array(role=Array.Role.INPUT_OUTPUT, element_type=ScalarType.int32, shape=(61, ))
 
-        nest = Nest(shape=(16, 16, 16))
-        i, j, k = nest.get_indices()
+        my_target = Target(category=Target.Category.CPU, vector_bytes=32, vector_registers=16)
+
+        nest = Nest(shape=(61, ))
+        i = nest.get_indices()
 
         @nest.iteration_logic
         def _():
-            C[i, j] += A[i, k] * B[k, j]
-
-        my_target = Target(
-            category=Target.Category.CPU, vector_bytes=16, vector_registers=2
-        )
-        plan = nest.create_plan(my_target)
-
-        # Shorthand for:
-        # plan.unroll(i)
-        # plan.vectorize(j)
-        # plan.vectorize(k)
-        plan.kernelize(unroll_indices=(i,), vectorize_indices=(j, k))
-        self._verify_plan(plan, [A, B, C], "test_kernelize_2")
+            C[i] = A[i] // B[i] + A[i] % B[i]
 
-    @expectedFailure(FailedReason.NOT_IN_PY, "pinning parallelization to CPU cores")
-    def test_cpu_bind(self) -> None:
-        A = Array(role=Array.Role.INPUT, shape=(16, 11))
-        B = Array(role=Array.Role.INPUT, shape=(11, 10))
-        C = Array(role=Array.Role.INPUT_OUTPUT, shape=(16, 10))
+        schedule = nest.create_schedule()
+        ii = schedule.split(i, 8)
 
-        nest = Nest(shape=(16, 10, 11))
-        i, j, k = nest.get_indices()
+        # the masked-off lanes of the last block would divide by zero, so that block stays a scalar loop
+        plan = schedule.create_plan(my_target)
+        plan.vectorize(index=ii, masked_tail=True)
 
-        @nest.iteration_logic
-        def _():
-            C[i, j] += A[i, k] * B[k, j]
+        # non-negative dividends, for which truncating and flooring division agree
+        A_test = np.random.randint(0, 1000, size=A.shape).astype(np.int32)
+        B_test = np.random.randint(1, 100, size=B.shape).astype(np.int32)
+        C_test = np.random.randint(-1000, 1000, size=C.shape).astype(np.int32)
+        C_ref = (A_test // B_test + A_test % B_test).astype(np.int32)
+        self._verify_plan(
+            plan, [A, B, C],
+            "test_vectorize_masked_tail_integer_division",
+            correctness_check_values={
+                "pre": [A_test, B_test, C_test],
+                "post": [A_test, B_test, C_ref]
+            }
+        )
 
-        target = Target("HOST", num_threads=16)
-        plan = nest.create_plan(target)
+    def test_vectorize_elementwise_math(self) -> None:
+        from accera import Target, Nest, max, sqrt, tanh, log
 
-        plan.parallelize(
-            indices=(i, j, k), pin=(target.cores[0], target.cores[1])
-        )  # TODO: confirm syntax
-        self._verify_plan(plan, [A, B, C], "test_cpu_bind")
+        A = Array(role=Array.Role.INPUT, shape=(64, ))
+        B = Array(role=Array.Role.INPUT, shape=(64, ))
+        C = Array(role=Array.Role.INPUT_OUTPUT, shape=(64, ))
 
-    def test_gpu_bind(self) -> None:
-        M = 128
-        N = 256
-        K = 256
-        A = Array(role=Array.Role.INPUT, shape=(M, K))
-        B = Array(role=Array.Role.INPUT, shape=(K, N))
-        C = Array(role=Array.Role.INPUT_OUTPUT, shape=(M, N))
+        my_target = Target(category=Target.Category.CPU, vector_bytes=32, vector_registers=16)
 
-        nest = Nest(shape=(M, N, K))
-        i, j, k = nest.get_indices()
+        nest = Nest(shape=(64,))
+        i = nest.get_indices()
 
         @nest.iteration_logic
         def _():
-            C[i, j] += A[i, k] * B[k, j]
+            C[i] = tanh(A[i]) + sqrt(B[i]) + log(max(A[i], B[i]))
 
-        v100 = Target(Target.Model.NVIDIA_V100, category=Target.Category.GPU)
-        plan = nest.create_plan(v100)
+        schedule = nest.create_schedule()
+        ii = schedule.split(i, 8)
 
-        plan.bind(
-            mapping={
-                i: v100.GridUnit.BLOCK_X,
-                j: v100.GridUnit.THREAD_X,
-                k: v100.GridUnit.THREAD_Y,
-            }
-        )
+        plan = schedule.create_plan(my_target)
+        plan.vectorize(index=ii)
 
-        test_name = "test_gpu_bind"
-        package = Package()
-        function = package.add(plan, args=(A, B, C), base_name=test_name)
+        A_test = np.random.uniform(low=1.0, high=4.0, size=A.shape).astype(np.float32)
+        B_test = np.random.uniform(low=1.0, high=4.0, size=B.shape).astype(np.float32)
+        C_test = np.random.random(C.shape).astype(np.float32)
+        C_ref = np.tanh(A_test) + np.sqrt(B_test) + np.log(np.maximum(A_test, B_test))
 
-        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / test_name
+        correctness_check_values = {
+            "pre": [A_test, B_test, C_test],
+            "post": [A_test, B_test, C_ref],
+        }
+        self._verify_plan(plan, [A, B, C], "test_vectorize_elementwise_math", correctness_check_values)
 
-        with verifiers.VerifyPackage(
-            self,
-            test_name,
-            output_dir,
-            file_list=[f"{test_name}.cu", f"{test_name}.hat"],
-        ) as v:
-            package.build(
-                name=test_name,
-                format=Package.Format.MLIR | Package.Format.DEFAULT,
-                mode=Package.Mode.RELEASE,
-                output_dir=output_dir
-            )
+    def test_vectorize_strided_access(self) -> None:
+        from accera import Target, Nest
 
-    def test_gpu_multi_index_bind(self) -> None:
-        M = 128
-        N = 256
-        K = 256
+        M, N, K = 16, 16, 32
         A = Array(role=Array.Role.INPUT, shape=(M, K))
-        B = Array(role=Array.Role.INPUT, shape=(K, N))
+        B = Array(role=Array.Role.INPUT, shape=(N, K))    # transposed layout
+        D = Array(role=Array.Role.INPUT, shape=(M, N, 2))
         C = Array(role=Array.Role.INPUT_OUTPUT, shape=(M, N))
 
+        my_target = Target(category=Target.Category.CPU, vector_bytes=32, vector_registers=16)
+
         nest = Nest(shape=(M, N, K))
         i, j, k = nest.get_indices()
 
         @nest.iteration_logic
         def _():
-            C[i, j] += A[i, k] * B[k, j]
+            # B is read with a stride of K elements (gather), D with a stride of 2 elements (load + shuffle)
+            C[i, j] += A[i, k] * B[j, k] + D[i, j, 0]
 
         schedule = nest.create_schedule()
-        ii, jj = schedule.tile({
-            i: 32,
+        jj = schedule.split(j, 8)
+        schedule.reorder(i, j, k, jj)
+
+        plan = schedule.create_plan(my_target)
+        plan.vectorize(index=jj)
+
+        A_test = np.random.random(A.shape).astype(np.float32)
+        B_test = np.random.random(B.shape).astype(np.float32)
+        D_test = np.random.random(D.shape).astype(np.float32)
+        C_test = np.random.random(C.shape).astype(np.float32)
+        C_ref = C_test + A_test @ B_test.T + K * D_test[:, :, 0]
+
+        correctness_check_values = {
+            "pre": [A_test, B_test, D_test, C_test],
+            "post": [A_test, B_test, D_test, C_ref],
+        }
+        self._verify_plan(plan, [A, B, D, C], "test_vectorize_strided_access", correctness_check_values)
+
+    def test_tensorize_int8_matmul_cpu(self) -> None:
+        from accera import Target, Nest, cast
+        from accera._lang_python._lang import _MMAShape
+
+        M, N, K = 16, 32, 64
+        A = Array(role=Array.Role.INPUT, element_type=ScalarType.uint8, shape=(M, K))
+        B = Array(role=Array.Role.INPUT, element_type=ScalarType.int8, shape=(K, N))
+        C = Array(role=Array.Role.INPUT_OUTPUT, element_type=ScalarType.int32, shape=(M, N))
+
+        nest = Nest(shape=(M, N, K))
+        i, j, k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] += cast(A[i, k], ScalarType.int32) * cast(B[k, j], ScalarType.int32)
+
+        schedule = nest.create_schedule()
+        ii = schedule.split(i, 4)
+        jj = schedule.split(j, 8)
+        kk = schedule.split(k, 16)
+        schedule.reorder(i, j, k, ii, jj, kk)
+
+        plan = schedule.create_plan(Target.HOST)
+        plan.tensorize(indices=(ii, jj, kk), mma_shape=_MMAShape.M1xN8xK4_B1)
+
+        # Keep A below 128 so that the pairwise int16 sums of the AVX2 path do not saturate
+        A_test = np.random.randint(0, 128, A.shape).astype(np.uint8)
+        B_test = np.random.randint(-128, 128, B.shape).astype(np.int8)
+        C_test = np.random.randint(-1000, 1000, C.shape).astype(np.int32)
+        C_ref = C_test + A_test.astype(np.int32) @ B_test.astype(np.int32)
+
+        correctness_check_values = {
+            "pre": [A_test, B_test, C_test],
+            "post": [A_test, B_test, C_ref],
+        }
+        self._verify_plan(plan, [A, B, C], "test_tensorize_int8_matmul_cpu", correctness_check_values)
+
+    def test_tensorize_int8_matmul_cpu_large_k(self) -> None:
+        from accera import Target, Nest, cast
+        from accera._lang_python._lang import _MMAShape
+
+        # The whole reduction is tensorized, which is emitted as a loop rather than unrolled
+        M, N, K = 4, 8, 4096
+        A = Array(role=Array.Role.INPUT, element_type=ScalarType.uint8, shape=(M, K))
+        B = Array(role=Array.Role.INPUT, element_type=ScalarType.int8, shape=(K, N))
+        C = Array(role=Array.Role.INPUT_OUTPUT, element_type=ScalarType.int32, shape=(M, N))
+
+        nest = Nest(shape=(M, N, K))
+        i, j, k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] += cast(A[i, k], ScalarType.int32) * cast(B[k, j], ScalarType.int32)
+
+        plan = nest.create_schedule().create_plan(Target.HOST)
+        plan.tensorize(indices=(i, j, k), mma_shape=_MMAShape.M1xN8xK4_B1)
+
+        A_test = np.random.randint(0, 128, A.shape).astype(np.uint8)
+        B_test = np.random.randint(-128, 128, B.shape).astype(np.int8)
+        C_test = np.random.randint(-1000, 1000, C.shape).astype(np.int32)
+        C_ref = C_test + A_test.astype(np.int32) @ B_test.astype(np.int32)
+
+        package = Package()
+        function = package.add(plan, args=(A, B, C), base_name="test_tensorize_int8_matmul_cpu_large_k")
+        package_name = "test_tensorize_int8_matmul_cpu_large_k"
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / package_name
+        with verifiers.VerifyPackage(self, package_name, output_dir) as v:
+            package.build(package_name, format=TEST_FORMAT | Package.Format.MLIR, mode=TEST_MODE, output_dir=output_dir)
+
+            # each group of 4 k iterations loads 4 rows of B as whole vectors and interleaves them with shuffles,
+            # rather than inserting 32 separately loaded bytes
+            checker = v.file_checker("*_LoopNestToValueFunc.mlir")
+            checker.check("affine.for %{{.+}} = 0 to 4096 step 4")
+            checker.check_count("affine.vector_load %{{.+}} : memref<4096x8x{{.+}}>, vector<8x{{.+}}>", 4)
+            checker.check("vector.shuffle {{.+}} : vector<8xi8>, vector<8xi8>")
+            checker.check("vector.shuffle {{.+}} : vector<8xi8>, vector<8xi8>")
+            checker.check("vector.shuffle {{.+}} : vector<16xi8>, vector<16xi8>")
+            checker.check_not("vector.insert")
+            checker.check("affine.yield")
+            checker.run()
+
+            v.check_correctness(function.name, before=[A_test, B_test, C_test], after=[A_test, B_test, C_ref])
+
+    def test_microkernel_matmul_cpu(self) -> None:
+        from accera import Target, Nest
+
+        MR, NR = Target.HOST.get_microkernel_tile()
+        M, N, K = 2 * MR, 2 * NR, 64
+        A = Array(role=Array.Role.INPUT, element_type=ScalarType.float32, shape=(M, K))
+        B = Array(role=Array.Role.INPUT, element_type=ScalarType.float32, shape=(K, N))
+        C = Array(role=Array.Role.INPUT_OUTPUT, element_type=ScalarType.float32, shape=(M, N))
+
+        nest = Nest(shape=(M, N, K))
+        i, j, k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] += A[i, k] * B[k, j]
+
+        schedule = nest.create_schedule()
+        ii = schedule.split(i, MR)
+        jj = schedule.split(j, NR)
+        kk = schedule.split(k, 32)
+        schedule.reorder(i, j, k, ii, jj, kk)
+
+        plan = schedule.create_plan(Target.HOST)
+        plan.microkernel(indices=(ii, jj, kk))
+
+        A_test = np.random.random(A.shape).astype(np.float32)
+        B_test = np.random.random(B.shape).astype(np.float32)
+        C_test = np.random.random(C.shape).astype(np.float32)
+        C_ref = C_test + A_test @ B_test
+
+        correctness_check_values = {
+            "pre": [A_test, B_test, C_test],
+            "post": [A_test, B_test, C_ref],
+        }
+        self._verify_plan(plan, [A, B, C], "test_microkernel_matmul_cpu", correctness_check_values)
+
+    def test_kernelize(self) -> None:
+        from accera import Target, Nest
+
+        A = Array(role=Array.Role.INPUT, shape=(16, 11))
+        B = Array(role=Array.Role.INPUT, shape=(11, 10))
+        C = Array(role=Array.Role.INPUT_OUTPUT, shape=(16, 10))
+
+        nest = Nest(shape=(16, 10, 11))
+        i, j, k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] += A[i, k] * B[k, j]
+
+        my_target = Target(
+            category=Target.Category.CPU, vector_bytes=16, vector_registers=2
+        )
+        plan = nest.create_plan(my_target)
+
+        # Shorthand for:
+        # plan.unroll(i)
+        # plan.unroll(j)
+        # plan.vectorize(k)
+        plan.kernelize(unroll_indices=(i, j), vectorize_indices=k)
+        self._verify_plan(plan, [A, B, C], "test_kernelize")
+
+    def test_kernelize_2(self) -> None:
+        from accera import Target, Nest
+
+        A = Array(role=Array.Role.INPUT, shape=(16, 16))
+        B = Array(role=Array.Role.INPUT, shape=(16, 16))
+        C = Array(role=Array.Role.INPUT_OUTPUT, shape=(16, 16))
+
+        nest = Nest(shape=(16, 16, 16))
+        i, j, k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] += A[i, k] * B[k, j]
+
+        my_target = Target(
+            category=Target.Category.CPU, vector_bytes=16, vector_registers=2
+        )
+        plan = nest.create_plan(my_target)
+
+        # Shorthand for:
+        # plan.unroll(i)
+        # plan.vectorize(j)
+        # plan.vectorize(k)
+        plan.kernelize(unroll_indices=(i,), vectorize_indices=(j, k))
+        self._verify_plan(plan, [A, B, C], "test_kernelize_2")
+
+    @expectedFailure(FailedReason.NOT_IN_PY, "pinning parallelization to CPU cores")
+    def test_cpu_bind(self) -> None:
+        A = Array(role=Array.Role.INPUT, shape=(16, 11))
+        B = Array(role=Array.Role.INPUT, shape=(11, 10))
+        C = Array(role=Array.Role.INPUT_OUTPUT, shape=(16, 10))
+
+        nest = Nest(shape=(16, 10, 11))
+        i, j, k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] += A[i, k] * B[k, j]
+
+        target = Target("HOST", num_threads=16)
+        plan = nest.create_plan(target)
+
+        plan.parallelize(
+            indices=(i, j, k), pin=(target.cores[0], target.cores[1])
+        )  # TODO: confirm syntax
+        self._verify_plan(plan, [A, B, C], "test_cpu_bind")
+
+    def test_gpu_bind(self) -> None:
+        M = 128
+        N = 256
+        K = 256
+        A = Array(role=Array.Role.INPUT, shape=(M, K))
+        B = Array(role=Array.Role.INPUT, shape=(K, N))
+        C = Array(role=Array.Role.INPUT_OUTPUT, shape=(M, N))
+
+        nest = Nest(shape=(M, N, K))
+        i, j, k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] += A[i, k] * B[k, j]
+
+        v100 = Target(Target.Model.NVIDIA_V100, category=Target.Category.GPU)
+        plan = nest.create_plan(v100)
+
+        plan.bind(
+            mapping={
+                i: v100.GridUnit.BLOCK_X,
+                j: v100.GridUnit.THREAD_X,
+                k: v100.GridUnit.THREAD_Y,
+            }
+        )
+
+        test_name = "test_gpu_bind"
+        package = Package()
+        function = package.add(plan, args=(A, B, C), base_name=test_name)
+
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / test_name
+
+        with verifiers.VerifyPackage(
+            self,
+            test_name,
+            output_dir,
+            file_list=[f"{test_name}.cu", f"{test_name}.hat"],
+        ) as v:
+            package.build(
+                name=test_name,
+                format=Package.Format.MLIR | Package.Format.DEFAULT,
+                mode=Package.Mode.RELEASE,
+                output_dir=output_dir
+            )
+
+    def test_gpu_multi_index_bind(self) -> None:
+        M = 128
+        N = 256
+        K = 256
+        A = Array(role=Array.Role.INPUT, shape=(M, K))
+        B = Array(role=Array.Role.INPUT, shape=(K, N))
+        C = Array(role=Array.Role.INPUT_OUTPUT, shape=(M, N))
+
+        nest = Nest(shape=(M, N, K))
+        i, j, k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] += A[i, k] * B[k, j]
+
+        schedule = nest.create_schedule()
+        ii, jj = schedule.tile({
+            i: 32,
             j: 32
         })
         
@@ -2721,18 +3234,326 @@ class DSLTest_07PlansVectorizationParallelization(unittest.TestCase):
                 correctness_check_values,
             )
 
-            # partial collapsed inner indices
-            plan_partial_inner = schedule.create_plan(target)
-            plan_partial_inner.parallelize(indices=(ii, j), policy=policy)
+            # partial collapsed inner indices
+            plan_partial_inner = schedule.create_plan(target)
+            plan_partial_inner.parallelize(indices=(ii, j), policy=policy)
+            self._verify_plan(
+                plan_partial_inner,
+                [A, B, C],
+                f"test_parallelize_ii_j_{policy}",
+                correctness_check_values,
+            )
+
+            # fully collapsed will result in correctness issues because parallelizing k can stomp on the C matrix
+            # where multiple threads try to update C[i, j] for different values of k
+
+    def test_parallelize_reduction_index(self) -> None:
+        # tall-skinny GEMM: the output is too small to keep the cores busy, so parallelize over k (split-K)
+        M, N, K = 16, 16, 4096
+        A = Array(role=Array.Role.INPUT, shape=(M, K))
+        B = Array(role=Array.Role.INPUT, shape=(K, N))
+        C = Array(role=Array.Role.INPUT_OUTPUT, shape=(M, N))
+
+        nest = Nest(shape=(M, N, K))
+        i, j, k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] += A[i, k] * B[k, j]
+
+        target = Target("HOST", num_threads=4)
+
+        # disable correctness checking on windows because the
+        # install location of libomp.dll is non-standard as of now
+        if sys.platform.startswith("win"):
+            correctness_check_values = None
+        else:
+            A_test = np.random.random(A.shape).astype(np.float32)
+            B_test = np.random.random(B.shape).astype(np.float32)
+            C_test = np.random.random(C.shape).astype(np.float32)
+            correctness_check_values = {
+                "pre": [A_test, B_test, C_test],
+                "post": [A_test, B_test, C_test + A_test @ B_test],
+            }
+
+        schedule = nest.create_schedule()
+        kk = schedule.split(k, K // target.num_threads)
+        schedule.reorder(k, i, j, kk)
+
+        for policy in ["static", "dynamic"]:
+            plan = schedule.create_plan(target)
+            plan.parallelize(indices=k, policy=policy)
+            self._verify_plan(
+                plan,
+                [A, B, C],
+                f"test_parallelize_reduction_index_{policy}",
+                correctness_check_values,
+            )
+
+        # column sums, parallelized over the rows
+        X = Array(role=Array.Role.INPUT, shape=(1024, 64))
+        S = Array(role=Array.Role.INPUT_OUTPUT, shape=(64, ))
+
+        nest = Nest(shape=(1024, 64))
+        i, j = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            S[j] += X[i, j]
+
+        if sys.platform.startswith("win"):
+            correctness_check_values = None
+        else:
+            X_test = np.random.random(X.shape).astype(np.float32)
+            S_test = np.random.random(S.shape).astype(np.float32)
+            correctness_check_values = {
+                "pre": [X_test, S_test],
+                "post": [X_test, S_test + np.sum(X_test, axis=0)],
+            }
+
+        schedule = nest.create_schedule()
+        ii = schedule.split(i, 256)
+        plan = schedule.create_plan(target)
+        plan.parallelize(indices=i)
+        self._verify_plan(
+            plan,
+            [X, S],
+            "test_parallelize_reduction_index_column_sum",
+            correctness_check_values,
+        )
+
+    def test_parallelize_reduction_index_accumulator_size(self) -> None:
+        # each parallel region accumulates into a single element of C, so the private accumulators only hold that element
+        M, N, K = 8, 8, 1024
+        A = Array(role=Array.Role.INPUT, shape=(M, K))
+        B = Array(role=Array.Role.INPUT, shape=(K, N))
+        C = Array(role=Array.Role.INPUT_OUTPUT, shape=(M, N))
+
+        nest = Nest(shape=(M, N, K))
+        i, j, k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] += A[i, k] * B[k, j]
+
+        target = Target("HOST", num_threads=4)
+        schedule = nest.create_schedule()
+        kk = schedule.split(k, K // target.num_threads)
+        schedule.reorder(i, j, k, kk)
+
+        plan = schedule.create_plan(target)
+        plan.parallelize(indices=k)
+
+        package = Package()
+        function = package.add(plan, args=(A, B, C), base_name="reduction_accumulator_size")
+        package_name = "test_parallelize_reduction_index_accumulator_size"
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / package_name
+        with verifiers.VerifyPackage(self, package_name, output_dir) as v:
+            package.build(package_name, format=TEST_FORMAT | Package.Format.MLIR, mode=TEST_MODE, output_dir=output_dir)
+
+            # allocated per call with one element per thread, rather than as a [threads x M x N] global
+            checker = v.file_checker("*_LoopNestToValueFunc.mlir")
+            checker.check_not("parallel_reduction_accumulator")
+            checker.check("memref.alloca() {alignment = 32 : i64} : memref<4x1x1xf32>")
+            checker.check_not("parallel_reduction_accumulator")
+            checker.run()
+
+            if not sys.platform.startswith("win"):
+                A_test = np.random.random(A.shape).astype(np.float32)
+                B_test = np.random.random(B.shape).astype(np.float32)
+                C_test = np.random.random(C.shape).astype(np.float32)
+                v.check_correctness(
+                    function.name,
+                    before=[A_test, B_test, C_test],
+                    after=[A_test, B_test, C_test + A_test @ B_test],
+                )
+
+    def test_parallelize_reduction_reads_other_element(self) -> None:
+        # S[0] accumulates the value of S[1], which a private accumulator would replace with the identity value,
+        # so the loop must not be privatized
+        K = 64
+        S = Array(role=Array.Role.INPUT_OUTPUT, shape=(2, ))
+
+        nest = Nest(shape=(K, ))
+        k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            S[0] = S[0] + S[1]
+
+        target = Target("HOST", num_threads=4)
+        schedule = nest.create_schedule()
+        kk = schedule.split(k, K // target.num_threads)
+
+        plan = schedule.create_plan(target)
+        plan.parallelize(indices=k)
+
+        package = Package()
+        package.add(plan, args=(S, ), base_name="reduction_reads_other_element")
+        package_name = "test_parallelize_reduction_reads_other_element"
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / package_name
+        with verifiers.VerifyPackage(self, package_name, output_dir) as v:
+            package.build(package_name, format=TEST_FORMAT | Package.Format.MLIR, mode=TEST_MODE, output_dir=output_dir)
+
+            # no [threads x 2] private accumulators, the loop keeps the shared array
+            checker = v.file_checker("*_LoopNestToValueFunc.mlir")
+            checker.check_not("memref<4x2xf32>")
+            checker.check("affine.parallel")
+            checker.check_not("memref<4x2xf32>")
+            checker.run()
+
+    def test_thread_affinity(self) -> None:
+        A = Array(role=Array.Role.INPUT, shape=(256, 256))
+        B = Array(role=Array.Role.INPUT, shape=(256, 256))
+        C = Array(role=Array.Role.INPUT_OUTPUT, shape=(256, 256))
+
+        nest = Nest(shape=(256, 256, 256))
+        i, j, k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] += A[i, k] * B[k, j]
+
+        target = Target("HOST", num_threads=4)
+
+        # disable correctness checking on windows because the
+        # install location of libomp.dll is non-standard as of now
+        if sys.platform.startswith("win"):
+            correctness_check_values = None
+        else:
+            A_test = np.random.random(A.shape).astype(np.float32)
+            B_test = np.random.random(B.shape).astype(np.float32)
+            C_test = np.random.random(C.shape).astype(np.float32)
+            correctness_check_values = {
+                "pre": [A_test, B_test, C_test],
+                "post": [A_test, B_test, C_test + A_test @ B_test],
+            }
+
+        schedule = nest.create_schedule()
+        ii = schedule.split(i, 64)
+        jj = schedule.split(j, 64)
+        schedule.reorder(i, j, ii, k, jj)
+
+        plan = schedule.create_plan(target)
+        with self.assertRaises(ValueError):
+            plan.parallelize(indices=i, affinity="nearby")
+
+        with self.assertRaises(ValueError):
+            plan.parallelize(indices=i, pin=())
+
+        for affinity in ["close", "spread", "socket"]:
+            plan = schedule.create_plan(target)
+            plan.parallelize(indices=(i, j), affinity=affinity)
+            self._verify_plan(
+                plan,
+                [A, B, C],
+                f"test_parallelize_affinity_{affinity}",
+                correctness_check_values,
+            )
+
+        plan = schedule.create_plan(target)
+        plan.parallelize(indices=(i, j), pin=(0, 1))
+        self._verify_plan(
+            plan,
+            [A, B, C],
+            "test_parallelize_pin",
+            correctness_check_values,
+        )
+
+        plan = schedule.create_plan(target)
+        # the cache of B is filled outside of the parallelized loop and shared by the threads
+        plan.cache(B, index=i)
+        plan.parallelize(indices=j, affinity="socket", numa_first_touch=True)
+        self._verify_plan(
+            plan,
+            [A, B, C],
+            "test_parallelize_numa_first_touch",
+            correctness_check_values,
+        )
+
+    def test_parallelize_thread_pool(self) -> None:
+        A = Array(role=Array.Role.INPUT, shape=(256, 256))
+        B = Array(role=Array.Role.INPUT, shape=(256, 256))
+        C = Array(role=Array.Role.INPUT_OUTPUT, shape=(256, 256))
+
+        nest = Nest(shape=(256, 256, 256))
+        i, j, k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] += A[i, k] * B[k, j]
+
+        target = Target("HOST", num_threads=4, runtime=Target.Runtime.THREAD_POOL)
+
+        A_test = np.random.random(A.shape).astype(np.float32)
+        B_test = np.random.random(B.shape).astype(np.float32)
+        C_test = np.random.random(C.shape).astype(np.float32)
+        correctness_check_values = {
+            "pre": [A_test, B_test, C_test],
+            "post": [A_test, B_test, C_test + A_test @ B_test],
+        }
+
+        schedule = nest.create_schedule()
+        ii = schedule.split(i, 64)
+        jj = schedule.split(j, 64)
+        schedule.reorder(i, j, ii, k, jj)
+
+        for policy in ["static", "dynamic"]:
+            plan = schedule.create_plan(target)
+            plan.parallelize(indices=(i, j), policy=policy)
             self._verify_plan(
-                plan_partial_inner,
+                plan,
                 [A, B, C],
-                f"test_parallelize_ii_j_{policy}",
+                f"test_parallelize_thread_pool_{policy}",
                 correctness_check_values,
             )
 
-            # fully collapsed will result in correctness issues because parallelizing k can stomp on the C matrix
-            # where multiple threads try to update C[i, j] for different values of k
+        # thread placement uses the thread indices of the pool
+        plan = schedule.create_plan(target)
+        plan.parallelize(indices=i, pin=(0, 1))
+        self._verify_plan(
+            plan,
+            [A, B, C],
+            "test_parallelize_thread_pool_pin",
+            correctness_check_values,
+        )
+
+    def test_parallelize_thread_pool_nested(self) -> None:
+        M, N = 64, 256
+        A = Array(role=Array.Role.INPUT, shape=(M, N))
+        B = Array(role=Array.Role.INPUT_OUTPUT, shape=(M, N))
+
+        nest = Nest(shape=(M, N))
+        i, j = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            B[i, j] += A[i, j] * 2.0
+
+        target = Target("HOST", num_threads=4, runtime=Target.Runtime.THREAD_POOL)
+
+        schedule = nest.create_schedule()
+        ii = schedule.split(i, 16)
+        jj = schedule.split(j, 64)
+        schedule.reorder(i, ii, j, jj)
+
+        # The inner parallel loop captures the outer loop's indices, which differ between the threads of the outer loop
+        plan = schedule.create_plan(target)
+        plan.parallelize(indices=i)
+        plan.parallelize(indices=j)
+
+        A_test = np.random.random(A.shape).astype(np.float32)
+        B_test = np.random.random(B.shape).astype(np.float32)
+        correctness_check_values = {
+            "pre": [A_test, B_test],
+            "post": [A_test, B_test + A_test * 2.0],
+        }
+        self._verify_plan(
+            plan,
+            [A, B],
+            "test_parallelize_thread_pool_nested",
+            correctness_check_values,
+        )
 
 
 class DSLTest_08DeferredLayout(unittest.TestCase):
@@ -4006,6 +4827,606 @@ class DSLTest_10Packages(unittest.TestCase):
         with verifiers.VerifyPackage(self, package_name):
             package.build(package_name, format=TEST_FORMAT, mode=TEST_MODE)
 
+    def test_workspace_package(self) -> None:
+        M = N = K = 64
+        A = Array(role=Array.Role.INPUT, element_type=ScalarType.float32, shape=(M, K))
+        B = Array(role=Array.Role.INPUT, element_type=ScalarType.float32, shape=(K, N))
+        C = Array(role=Array.Role.INPUT_OUTPUT, element_type=ScalarType.float32, shape=(M, N))
+
+        nest = Nest(shape=(M, N, K))
+        i, j, k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] += A[i, k] * B[k, j]
+
+        schedule = nest.create_schedule()
+        ii, jj = schedule.tile({i: 16, j: 16})
+        schedule.reorder(i, j, k, ii, jj)
+        plan = schedule.create_plan()
+        plan.cache(B, index=k)
+        plan.cache(C, index=ii)
+
+        package = Package()
+        package_name = "test_workspace_package"
+        package.add(plan, args=(A, B, C), base_name=package_name)
+
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / package_name
+        with verifiers.VerifyPackage(self, package_name, output_dir) as v:
+            package.build(package_name, format=TEST_FORMAT, mode=Package.Mode.RELEASE, output_dir=output_dir, workspace=True)
+
+            checker = v.file_checker(f"{package_name}.hat")
+            checker.check(f"int64_t {package_name}_{{{{.+}}}}_workspace_size()")
+            checker.check(f"void {package_name}_{{{{.+}}}}(float*, float*, float*, int8_t*)")
+            checker.run()
+
+        with self.assertRaises(ValueError):
+            package.build(package_name, mode=Package.Mode.DEBUG, output_dir=output_dir, workspace=True)
+
+    def test_workspace_package_runtime(self) -> None:
+        import hatlib as hat
+
+        M = N = K = 64
+        A = Array(role=Array.Role.INPUT, element_type=ScalarType.float32, shape=(M, K))
+        B = Array(role=Array.Role.INPUT, element_type=ScalarType.float32, shape=(K, N))
+        C = Array(role=Array.Role.INPUT_OUTPUT, element_type=ScalarType.float32, shape=(M, N))
+
+        nest = Nest(shape=(M, N, K))
+        i, j, k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] += A[i, k] * B[k, j]
+
+        schedule = nest.create_schedule()
+        ii, jj = schedule.tile({i: 16, j: 16})
+        schedule.reorder(i, j, k, ii, jj)
+        plan = schedule.create_plan()
+        plan.cache(B, index=k)
+        plan.cache(C, index=ii)
+
+        package = Package()
+        package_name = "test_workspace_package_runtime"
+        function = package.add(plan, args=(A, B, C), base_name=package_name)
+
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / package_name
+        shutil.rmtree(output_dir, ignore_errors=True)
+        package.build(package_name, format=Package.Format.HAT_DYNAMIC, mode=Package.Mode.RELEASE, output_dir=output_dir, workspace=True)
+
+        hat_file = hat.HATFile.Deserialize(str(output_dir / f"{package_name}.hat"))
+        lib = ctypes.CDLL(str(output_dir / hat_file.dependencies.link_target))
+        workspace_size = getattr(lib, f"{function.name}_workspace_size")
+        workspace_size.restype = ctypes.c_int64
+        fn = getattr(lib, function.name)
+        fn.argtypes = [ctypes.c_void_p] * 4
+        fn.restype = None
+
+        # The caches live in the caller's workspace, which is filled with garbage to catch reads of uninitialized data
+        size = workspace_size()
+        self.assertGreaterEqual(size, (K * 16 + 16 * 16) * 4)
+        buffer = np.full(size + 64, 0x7F, dtype=np.int8)
+        offset = -buffer.ctypes.data % 64
+        workspace = buffer[offset:offset + size]
+        A_test = np.random.random(A.shape).astype(np.float32)
+        B_test = np.random.random(B.shape).astype(np.float32)
+        C_test = np.random.random(C.shape).astype(np.float32)
+
+        # A second call reuses the workspace left over by the first one
+        C_ref = C_test + 2 * (A_test @ B_test)
+        for _ in range(2):
+            fn(A_test.ctypes.data, B_test.ctypes.data, C_test.ctypes.data, workspace.ctypes.data)
+        np.testing.assert_allclose(C_test, C_ref, rtol=1e-5)
+
+    def test_workspace_package_persistent_globals(self) -> None:
+        M = N = K = 64
+        A = Array(role=Array.Role.INPUT, element_type=ScalarType.float32, shape=(M, K))
+        B = Array(role=Array.Role.INPUT, element_type=ScalarType.float32, shape=(K, N))
+        C = Array(role=Array.Role.INPUT_OUTPUT, element_type=ScalarType.float32, shape=(M, N))
+
+        nest = Nest(shape=(M, N, K))
+        i, j, k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] += A[i, k] * B[k, j]
+
+        schedule = nest.create_schedule()
+        ii, jj = schedule.tile({i: 16, j: 16})
+        schedule.reorder(i, j, k, ii, jj)
+        plan = schedule.create_plan(Target("HOST", num_threads=4))
+        plan.cache(B, index=j)
+        plan.cache(C, index=ii)
+        plan.parallelize(indices=j, numa_first_touch=True)
+
+        package = Package()
+        package_name = "test_workspace_package_persistent_globals"
+        package.add(plan, args=(A, B, C), base_name=package_name)
+
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / package_name
+        with verifiers.VerifyPackage(self, package_name, output_dir) as v:
+            package.build(package_name, format=TEST_FORMAT | Package.Format.MLIR, mode=Package.Mode.RELEASE, output_dir=output_dir, workspace=True)
+
+            # The first-touched cache and its flag keep their contents across calls, so they stay globals
+            # rather than becoming views of the caller's workspace
+            checker = v.file_checker("*_WorkspaceAllocation.mlir")
+            checker.check_dag('"accv.ref_global"() {global_name = @cache_{{[0-9]+}}_first_touched}')
+            checker.check_dag('"accv.ref_global"() {global_name = @cache_{{[0-9]+}}}')
+            checker.run()
+
+    def test_parallel_package(self) -> None:
+        plan, A = self._create_plan()
+
+        package = Package()
+        package_name = "test_parallel_package"
+        functions = [package.add(plan, args=(A,), base_name=f"func{n}") for n in range(3)]
+
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / package_name
+        with verifiers.VerifyPackage(self, package_name, output_dir) as v:
+            module_file_sets = package.build(package_name, format=TEST_FORMAT, mode=Package.Mode.RELEASE, output_dir=output_dir, num_workers=2)
+            self.assertEqual(len(module_file_sets), 2)
+
+            # Every function is declared in the single header, whichever module it was compiled in
+            checker = v.file_checker(f"{package_name}.hat")
+            for n in range(3):
+                checker.check(f"void func{n}_{{{{.+}}}}(float*)")
+            checker.run()
+
+            # The functions of every shard, not just the first, are linked into the package and callable
+            A_test = np.random.random(A.shape).astype(np.float32)
+            for function in functions:
+                v.check_correctness(function.name, before=[A_test], after=[A_test + 2.0])
+
+        with self.assertRaises(ValueError):
+            package.build(package_name, output_dir=output_dir, num_workers=0)
+
+    def test_in_process_build(self) -> None:
+        plan, A = self._create_plan()
+
+        package = Package()
+        package_name = "test_in_process_build"
+        package.add(plan, args=(A,), base_name="func1")
+
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / package_name
+        with verifiers.VerifyPackage(self, package_name, output_dir):
+            module_file_sets = package.build(package_name, format=Package.Format.HAT_DYNAMIC, output_dir=output_dir)
+
+        # The package module is compiled straight from memory, so its IR is never written out as text
+        module_file_set = module_file_sets[0]
+        self.assertTrue(os.path.isfile(module_file_set.object_filepath))
+        self.assertFalse(os.path.exists(module_file_set.generated_mlir_filepath))
+
+    def test_compile_profile(self) -> None:
+        plan, A = self._create_plan()
+
+        package = Package()
+        package_name = "test_compile_profile"
+        for n in range(2):
+            package.add(plan, args=(A,), base_name=f"func{n}")
+
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / package_name
+        with verifiers.VerifyPackage(self, package_name, output_dir):
+            package.build(
+                package_name,
+                format=Package.Format.HAT_DYNAMIC,
+                mode=Package.Mode.RELEASE,
+                output_dir=output_dir,
+                compile_profile=True
+            )
+
+        # Each function is profiled in its own module
+        with open(output_dir / f"{package_name}.compile_profile.json") as f:
+            profile = json.load(f)
+        self.assertEqual(profile["package"], package_name)
+        self.assertEqual(len(profile["modules"]), 2)
+        for module in profile["modules"]:
+            self.assertEqual(len(module["functions"]), 1)
+            self.assertTrue(module["mlir_passes"])
+            # Nested pass managers would double-count the passes they run
+            self.assertFalse(any("PassAdaptor" in entry["pass"] for entry in module["mlir_passes"]))
+            self.assertTrue(module["llvm"])
+        self.assertTrue(any(entry["event"] == "RunPass" for entry in profile["llvm"]))
+
+        with self.assertRaises(ValueError):
+            package.build(package_name, format=Package.Format.MLIR_DYNAMIC, output_dir=output_dir, compile_profile=True)
+
+        with self.assertRaises(ValueError):
+            package.build(package_name, mode=Package.Mode.DEBUG, output_dir=output_dir, compile_profile=True)
+
+    class AcceraProfileCounter(ctypes.Structure):
+        _fields_ = [("name", ctypes.c_char_p), ("count", ctypes.c_int64), ("seconds", ctypes.c_double),
+                    ("cycles", ctypes.c_int64), ("instructions", ctypes.c_int64), ("l1d_misses", ctypes.c_int64),
+                    ("llc_misses", ctypes.c_int64), ("dtlb_misses", ctypes.c_int64)]
+
+    def _load_profile_counters(self, package_name, output_dir):
+        import hatlib as hat
+
+        hat_file = hat.HATFile.Deserialize(str(output_dir / f"{package_name}.hat"))
+        self.assertIn("AcceraProfileCounter", str(hat_file.declaration.code))
+        lib = ctypes.CDLL(str(output_dir / hat_file.dependencies.link_target))
+
+        get_counters = getattr(lib, f"{package_name}_get_profile_counters")
+        get_counters.argtypes = [ctypes.c_void_p, ctypes.c_int64]
+        get_counters.restype = ctypes.c_int64
+        reset_counters = getattr(lib, f"{package_name}_reset_profile_counters")
+        return get_counters, reset_counters
+
+    def _build_profiled_package(self, package_name, profile, format=Package.Format.HAT_DYNAMIC, **build_args):
+        from accera import _lang_python
+
+        A = Array(role=Array.Role.INPUT_OUTPUT, element_type=ScalarType.float32, shape=(64, 64))
+
+        nest = Nest(shape=A.shape)
+        i, j = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            A[i, j] += 1.0
+
+        package = Package()
+        add_fn = package.add(nest, args=(A, ), base_name="add_one")
+
+        def main(A):
+            _lang_python.EnterProfileRegion("add_one")
+            add_fn(A)
+            _lang_python.ExitProfileRegion("add_one")
+
+        main_fn = package.add(main, args=(A, ), base_name="profiled_add_one")
+
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / package_name
+        with verifiers.VerifyPackage(self, package_name, output_dir) as v:
+            package.build(
+                package_name,
+                format=format,
+                mode=Package.Mode.RELEASE,
+                output_dir=output_dir,
+                profile=profile,
+                **build_args
+            )
+
+            A_test = np.random.random(A.shape).astype(np.float32)
+            v.check_correctness(main_fn.name, before=[A_test], after=[A_test + 1.0])
+
+        get_counters, reset_counters = self._load_profile_counters(package_name, output_dir)
+
+        # The library is already loaded by the correctness check, which ran the region once
+        counters = (self.AcceraProfileCounter * 4)()
+        self.assertEqual(get_counters(counters, len(counters)), 1)
+        self.assertEqual(counters[0].name, b"add_one")
+        self.assertEqual(counters[0].count, 1)
+        self.assertGreater(counters[0].seconds, 0.0)
+        return counters, get_counters, reset_counters
+
+    def test_profile_counters(self) -> None:
+        counters, get_counters, reset_counters = self._build_profiled_package("test_profile_counters", profile=True)
+        self.assertEqual(counters[0].cycles, 0)
+
+        # Only the number of regions is returned if the buffer is too small
+        self.assertEqual(get_counters(None, 0), 1)
+
+        reset_counters()
+        get_counters(counters, len(counters))
+        self.assertEqual(counters[0].count, 0)
+        self.assertEqual(counters[0].seconds, 0.0)
+
+        # The counter records are laid out for 64-bit pointers
+        pi3 = Target(Target.Model.RASPBERRY_PI_3B, category=Target.Category.CPU)
+        A = Array(role=Array.Role.INPUT_OUTPUT, element_type=ScalarType.float32, shape=(64, ))
+        nest = Nest(shape=A.shape)
+        i = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            A[i] += 1.0
+
+        package = Package()
+        package.add(nest.create_plan(pi3), args=(A, ), base_name="add_one")
+        with self.assertRaises(ValueError):
+            package.build("test_profile_counters_32_bit", format=Package.Format.HAT_STATIC, platform=Package.Platform.RASPBIAN, profile=True)
+
+    def test_profile_counters_parallel(self) -> None:
+        from accera import _lang_python
+
+        M, N = 256, 64
+        A = Array(role=Array.Role.INPUT_OUTPUT, element_type=ScalarType.float32, shape=(M, N))
+
+        nest = Nest(shape=A.shape)
+        i, j = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            _lang_python.EnterProfileRegion("add_one")
+            A[i, j] += 1.0
+            _lang_python.ExitProfileRegion("add_one")
+
+        plan = nest.create_schedule().create_plan(Target("HOST", num_threads=4))
+        plan.parallelize(indices=i)
+
+        package = Package()
+        package_name = "test_profile_counters_parallel"
+        function = package.add(plan, args=(A, ), base_name=package_name)
+
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / package_name
+        with verifiers.VerifyPackage(self, package_name, output_dir) as v:
+            package.build(package_name, format=Package.Format.HAT_DYNAMIC, mode=Package.Mode.RELEASE, output_dir=output_dir, profile=True)
+
+            A_test = np.random.random(A.shape).astype(np.float32)
+            v.check_correctness(function.name, before=[A_test], after=[A_test + 1.0])
+
+        # Every iteration of the nest is counted, whichever thread ran it
+        get_counters, reset_counters = self._load_profile_counters(package_name, output_dir)
+        counters = (self.AcceraProfileCounter * 1)()
+        self.assertEqual(get_counters(counters, len(counters)), 1)
+        self.assertEqual(counters[0].count, M * N)
+        self.assertGreater(counters[0].seconds, 0.0)
+
+        reset_counters()
+        get_counters(counters, len(counters))
+        self.assertEqual(counters[0].count, 0)
+
+    def test_profile_hardware_counters(self) -> None:
+        from accera.Platforms import LibraryDependency, get_library_reference
+
+        runtime_library = get_library_reference(LibraryDependency.RUNTIME, Package.Platform.HOST)
+        if not runtime_library:
+            self.skipTest("The CPU runtime library is not installed")
+
+        counters, get_counters, reset_counters = self._build_profiled_package(
+            "test_profile_hardware_counters",
+            profile=Package.ProfileCounters.CYCLES | Package.ProfileCounters.INSTRUCTIONS
+        )
+
+        # Without perf_event access (for example in most containers), the counters read as 0 instead of failing
+        runtime = ctypes.CDLL(runtime_library.target_file)
+        runtime.AcceraGetAvailableHardwareCounters.argtypes = [ctypes.c_int32]
+        runtime.AcceraGetAvailableHardwareCounters.restype = ctypes.c_int32
+        available = runtime.AcceraGetAvailableHardwareCounters(0b11)
+        for bit, events in enumerate([counters[0].cycles, counters[0].instructions]):
+            if available & (1 << bit):
+                self.assertGreater(events, 0)
+            else:
+                self.assertEqual(events, 0)
+
+        # Counters that weren't requested are always 0
+        self.assertEqual(counters[0].l1d_misses, 0)
+        self.assertEqual(counters[0].llc_misses, 0)
+        self.assertEqual(counters[0].dtlb_misses, 0)
+
+        reset_counters()
+        get_counters(counters, len(counters))
+        self.assertEqual(counters[0].cycles, 0)
+        self.assertEqual(counters[0].instructions, 0)
+
+    def test_profile_cycle_counter(self) -> None:
+        import platform
+        from accera.Platforms import LibraryDependency, get_library_reference
+
+        if not get_library_reference(LibraryDependency.RUNTIME, Package.Platform.HOST):
+            self.skipTest("The CPU runtime library is not installed")
+        if platform.machine().lower() not in ["x86_64", "amd64", "aarch64", "arm64"]:
+            self.skipTest("The host CPU has no supported cycle counter")
+
+        package_name = "test_profile_cycle_counter"
+        counters, get_counters, reset_counters = self._build_profiled_package(
+            package_name,
+            profile=True,
+            format=Package.Format.HAT_DYNAMIC | Package.Format.MLIR,
+            timer=Package.Timer.CYCLE_COUNTER
+        )
+        clock_counters, _, _ = self._build_profiled_package("test_profile_cycle_counter_clock", profile=True)
+
+        # The period is read once, by a constructor of the module, and the timed regions read the counter itself
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / package_name
+        lowered_files = list(output_dir.glob("**/*_llvm.mlir"))
+        self.assertTrue(lowered_files)
+        checker = verifiers.FileChecker(lowered_files[0])
+        checker.check("llvm.mlir.global internal @__accera_cycle_counter_period(")
+        checker.check("llvm.func internal @__accera_init_cycle_counter()")
+        checker.check("llvm.call @AcceraGetCycleCounterPeriod()")
+        checker.check("llvm.mlir.global appending @llvm.global_ctors()")
+        checker.check("llvm.mlir.addressof @__accera_init_cycle_counter")
+        checker.check_not("llvm.call @AcceraGetCycleCounterPeriod()")
+        checker.check("llvm.mlir.addressof @__accera_cycle_counter_period")
+        if platform.machine().lower() in ["x86_64", "amd64"]:
+            checker.check("llvm.call @llvm.x86.rdtscp()")
+        else:
+            checker.check("cntvct_el0")
+        checker.check_not("llvm.call @AcceraGetCycleCounterPeriod()")
+        checker.run()
+
+        # The ticks are converted to seconds. Adding one to a 64x64 array takes microseconds, so the first timed region
+        # doesn't include the ~10 ms calibration of the counter, and it agrees with the clock-timed build.
+        self.assertLess(counters[0].seconds, 0.005)
+        self.assertLess(counters[0].seconds, clock_counters[0].seconds + 0.001)
+
+        reset_counters()
+        get_counters(counters, len(counters))
+        self.assertEqual(counters[0].seconds, 0.0)
+
+    def _build_instrumented_matmul(self, package_name, M, N, K, cache_at_top_level=False, **build_args):
+        A = Array(role=Array.Role.INPUT, element_type=ScalarType.float32, shape=(M, K))
+        B = Array(role=Array.Role.INPUT, element_type=ScalarType.float32, shape=(K, N))
+        C = Array(role=Array.Role.INPUT_OUTPUT, element_type=ScalarType.float32, shape=(M, N))
+
+        nest = Nest(shape=(M, N, K))
+        i, j, k = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            C[i, j] += A[i, k] * B[k, j]
+
+        schedule = nest.create_schedule()
+        ii = schedule.split(i, 16)
+        schedule.reorder(i, j, k, ii)
+
+        plan = schedule.create_plan()
+        plan.cache(B, index=i if cache_at_top_level else k)
+        plan.parallelize(indices=i)
+
+        package = Package()
+        function = package.add(plan, args=(A, B, C), base_name="matmul")
+
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / package_name
+        with verifiers.VerifyPackage(self, package_name, output_dir) as v:
+            package.build(
+                package_name,
+                format=Package.Format.HAT_DYNAMIC,
+                mode=Package.Mode.RELEASE,
+                output_dir=output_dir,
+                instrument=True,
+                **build_args
+            )
+
+            A_test = np.random.random(A.shape).astype(np.float32)
+            B_test = np.random.random(B.shape).astype(np.float32)
+            C_test = np.random.random(C.shape).astype(np.float32)
+            C_ref = C_test + A_test @ B_test
+            v.check_correctness(function.name, before=[A_test, B_test, C_test], after=[A_test, B_test, C_ref])
+
+        return output_dir
+
+    def test_profile_instrumentation(self) -> None:
+        M, N, K = 64, 64, 64
+        package_name = "test_profile_instrumentation"
+        output_dir = self._build_instrumented_matmul(package_name, M, N, K)
+
+        get_counters, _ = self._load_profile_counters(package_name, output_dir)
+        num_regions = get_counters(None, 0)
+        counters = (self.AcceraProfileCounter * num_regions)()
+        get_counters(counters, num_regions)
+        regions = {counter.name.decode().split("/")[-1]: counter for counter in counters}
+
+        # The kernel and the parallel loop run once per call, the cache is filled each time the k loop starts
+        for name in ["kernel_0", "parallel_0", "cache_fill_0"]:
+            self.assertIn(name, regions)
+            self.assertGreater(regions[name].seconds, 0.0)
+        self.assertEqual(regions["kernel_0"].count, 1)
+        self.assertEqual(regions["parallel_0"].count, 1)
+        self.assertEqual(regions["cache_fill_0"].count, (M // 16) * N)
+
+    def test_profile_instrumentation_top_level_cache(self) -> None:
+        M, N, K = 64, 64, 64
+        package_name = "test_profile_instrumentation_top_level_cache"
+        output_dir = self._build_instrumented_matmul(package_name, M, N, K, cache_at_top_level=True)
+
+        get_counters, _ = self._load_profile_counters(package_name, output_dir)
+        num_regions = get_counters(None, 0)
+        counters = (self.AcceraProfileCounter * num_regions)()
+        get_counters(counters, num_regions)
+        regions = {counter.name.decode().split("/")[-1]: counter for counter in counters}
+
+        # The copy into the cache is lowered to a nest of its own at the top level of the function, which is
+        # reported as the cache fill rather than as a second kernel
+        self.assertEqual(sorted(regions), ["cache_fill_0", "kernel_0", "parallel_0"])
+        self.assertEqual(regions["kernel_0"].count, 1)
+        self.assertEqual(regions["cache_fill_0"].count, 1)
+
+    def test_profile_trace(self) -> None:
+        from accera.Platforms import LibraryDependency, get_library_reference
+
+        if not get_library_reference(LibraryDependency.RUNTIME, Package.Platform.HOST):
+            self.skipTest("The CPU runtime library is not installed")
+
+        M, N, K = 64, 64, 64
+        package_name = "test_profile_trace"
+        output_dir = self._build_instrumented_matmul(package_name, M, N, K, trace=True)
+
+        import hatlib as hat
+
+        hat_file = hat.HATFile.Deserialize(str(output_dir / f"{package_name}.hat"))
+        lib = ctypes.CDLL(str(output_dir / hat_file.dependencies.link_target))
+        write_trace = getattr(lib, f"{package_name}_write_profile_trace")
+        write_trace.argtypes = [ctypes.c_char_p]
+        write_trace.restype = ctypes.c_int64
+        reset_trace = getattr(lib, f"{package_name}_reset_profile_trace")
+
+        # The correctness check ran the function once
+        trace_path = output_dir / f"{package_name}.trace.json"
+        num_events = write_trace(str(trace_path).encode())
+        with open(trace_path) as f:
+            events = [event for event in json.load(f)["traceEvents"] if event["ph"] in "BE"]
+        self.assertEqual(num_events, len(events))
+
+        # Every thread enters and exits its regions in order, the cache is filled by the threads running the
+        # parallel loop
+        stacks = {}
+        for event in events:
+            stack = stacks.setdefault(event["tid"], [])
+            if event["ph"] == "B":
+                stack.append(event["name"])
+            else:
+                self.assertEqual(stack.pop(), event["name"])
+        self.assertTrue(all(not stack for stack in stacks.values()))
+
+        names = [event["name"].split("/")[-1] for event in events if event["ph"] == "B"]
+        self.assertEqual(names.count("kernel_0"), 1)
+        self.assertEqual(names.count("parallel_0"), 1)
+        self.assertEqual(names.count("cache_fill_0"), (M // 16) * N)
+
+        reset_trace()
+        self.assertEqual(write_trace(str(trace_path).encode()), 0)
+        self.assertEqual(write_trace(str(output_dir / "no_such_dir" / "trace.json").encode()), -1)
+
+    def test_compilation_cache(self) -> None:
+        from unittest import mock
+        from accera import accc
+
+        plan, A = self._create_plan()
+
+        package = Package()
+        package_name = "test_compilation_cache"
+        for n in range(2):
+            package.add(plan, args=(A,), base_name=f"func{n}")
+
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / package_name
+        cache_dir = output_dir / "cache"
+        shutil.rmtree(cache_dir, ignore_errors=True)
+
+        def cache_entries():
+            return sorted(entry.name for entry in cache_dir.glob("*/*") if entry.is_dir())
+
+        # Record the modules that are taken through the tool chain rather than restored from the cache
+        compiled_modules = []
+        emit_module_file_sets = accc.AcceraProject.emit_module_file_sets
+
+        def counting_emit_module_file_sets(project, module_file_sets, *args, **kwargs):
+            compiled_modules.extend(module_file_set.module_name for module_file_set in module_file_sets)
+            return emit_module_file_sets(project, module_file_sets, *args, **kwargs)
+
+        def build(package, build_dir):
+            compiled_modules.clear()
+            with mock.patch.object(accc.AcceraProject, "emit_module_file_sets", counting_emit_module_file_sets):
+                with verifiers.VerifyPackage(self, package_name, build_dir):
+                    package.build(package_name, format=TEST_FORMAT, mode=Package.Mode.RELEASE, output_dir=build_dir, cache_dir=cache_dir)
+            return list(compiled_modules)
+
+        # One entry per function, plus one for the package globals
+        self.assertEqual(len(build(package, output_dir)), 3)
+        entries = cache_entries()
+        self.assertEqual(len(entries), 3)
+
+        # A rebuild of the same functions is served entirely from the cache, without running the tools
+        self.assertEqual(build(package, output_dir / "rebuild"), [])
+        self.assertEqual(cache_entries(), entries)
+
+        # Changing the plan of one function only compiles that function again
+        nest = Nest(shape=(64,))
+        i = nest.get_indices()
+
+        @nest.iteration_logic
+        def _():
+            A[i] += 2.0
+
+        schedule = nest.create_schedule()
+        schedule.split(i, 8)
+        changed_package = Package()
+        changed_package.add(plan, args=(A,), base_name="func0")
+        changed_package.add(schedule.create_plan(), args=(A,), base_name="func1")
+
+        self.assertEqual(len(build(changed_package, output_dir / "changed")), 1)
+        changed_entries = cache_entries()
+        self.assertEqual(len(changed_entries), 4)
+        self.assertTrue(set(entries).issubset(changed_entries))
+
     def test_debug_mode_1(self) -> None:
         M = N = K = 16
         A = Array(role=Array.Role.INPUT, element_type=ScalarType.float32, shape=(M, K))
@@ -574,6 +574,73 @@ class SmokeTest(unittest.TestCase):
         with verifiers.VerifyPackage(self, package_name, TEST_PACKAGE_DIR):
             package.build(package_name, format=self.PACKAGE_FORMAT, mode=self.PACKAGE_MODE, output_dir=TEST_PACKAGE_DIR)
 
+    def test_runtime_memoized_cache_mlas_matmul(self) -> None:
+        from accera.samples.OfflineCacheMatrixMultiplication import RuntimeMemoizedCacheMLAS
+
+        import ctypes
+        import hatlib as hat
+
+        package = Package()
+
+        M, N, K = [31, 63, 127]
+        A = Array(role=Array.Role.INPUT, element_type=ScalarType.float32, shape=(M, K))
+        B = Array(role=Array.Role.INPUT, element_type=ScalarType.float32, shape=(K, N))
+        C = Array(role=Array.Role.INPUT_OUTPUT, element_type=ScalarType.float32, shape=(M, N))
+        package.add(
+            *RuntimeMemoizedCacheMLAS(A, B, C, wrapper_fn_name="memoized_mlas", max_cache_bytes=1024 * 1024),
+            base_name=f"mlas_py_{M}_{N}_{K}"
+        )
+
+        # A budget smaller than one packed copy keeps a single slot
+        package.add(
+            *RuntimeMemoizedCacheMLAS(A, B, C, wrapper_fn_name="memoized_mlas_one_slot", max_cache_bytes=1),
+            base_name=f"mlas_py_one_slot_{M}_{N}_{K}"
+        )
+
+        package_name = "runtime_memoized_cache_mlas"
+        output_dir = pathlib.Path(TEST_PACKAGE_DIR) / package_name
+        with verifiers.VerifyPackage(self, package_name, output_dir) as v:
+            package.build(package_name, format=self.PACKAGE_FORMAT, mode=self.PACKAGE_MODE, output_dir=output_dir)
+
+            # The wrapper takes the function arguments followed by the version tag of B
+            checker = v.file_checker(f"{package_name}.hat")
+            checker.check("void memoized_mlas({{.+}}, int64_t)")
+            checker.check("void memoized_mlas_one_slot({{.+}}, int64_t)")
+            checker.run()
+
+        hat_file = hat.HATFile.Deserialize(str(output_dir / f"{package_name}.hat"))
+        lib = ctypes.CDLL(str(output_dir / hat_file.dependencies.link_target))
+
+        def call(fn_name, A_test, B_test, version):
+            fn = getattr(lib, fn_name)
+            fn.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int64]
+            fn.restype = None
+            C_test = np.zeros((M, N), dtype=np.float32)
+            fn(A_test.ctypes.data, B_test.ctypes.data, C_test.ctypes.data, version)
+            return C_test
+
+        def assert_used(C_test, A_test, B_test):
+            np.testing.assert_allclose(C_test, A_test @ B_test, rtol=1e-4)
+
+        A_test = np.random.random((M, K)).astype(np.float32)
+        B_test = np.random.random((K, N)).astype(np.float32)
+        B_original = B_test.copy()
+
+        # A repeated call with the same buffer and version hits the cache, so it keeps using the packed copy
+        assert_used(call("memoized_mlas", A_test, B_test, 1), A_test, B_original)
+        B_test += 1.0
+        assert_used(call("memoized_mlas", A_test, B_test, 1), A_test, B_original)
+
+        # Bumping the version repacks the buffer
+        assert_used(call("memoized_mlas", A_test, B_test, 2), A_test, B_test)
+
+        # With a single slot, packing another buffer evicts the first, which is then repacked on its next call
+        B_other = np.random.random((K, N)).astype(np.float32)
+        assert_used(call("memoized_mlas_one_slot", A_test, B_test, 1), A_test, B_test)
+        assert_used(call("memoized_mlas_one_slot", A_test, B_other, 1), A_test, B_other)
+        B_test += 1.0
+        assert_used(call("memoized_mlas_one_slot", A_test, B_test, 1), A_test, B_test)
+
     def test_const_array_shared_across_functions(self) -> None:
         # In this scenario we use a single CONST data matrix in two Accera functions,
         # the first will perform matmul and the second will perform elementwise add
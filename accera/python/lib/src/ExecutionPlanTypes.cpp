@@ -55,12 +55,19 @@ namespace
             .value("STATIC", value::ParallelizationPolicy::Static)
             .value("DYNAMIC", value::ParallelizationPolicy::Dynamic);
 
+        py::enum_<value::ParallelizationAffinity>(module, "_ParallelizationAffinity", "Used for configuring how threads are placed on cores")
+            .value("CLOSE", value::ParallelizationAffinity::Close)
+            .value("SPREAD", value::ParallelizationAffinity::Spread)
+            .value("SOCKET", value::ParallelizationAffinity::Socket)
+            .value("EXPLICIT", value::ParallelizationAffinity::Explicit);
+
         py::enum_<value::ExecutionRuntime>(module, "_ExecutionRuntime", "Used for specifying the execution runtime of the module")
             .value("DEFAULT", value::ExecutionRuntime::DEFAULT)
             .value("VULKAN", value::ExecutionRuntime::VULKAN)
             .value("ROCM", value::ExecutionRuntime::ROCM)
             .value("CUDA", value::ExecutionRuntime::CUDA)
             .value("OPENMP", value::ExecutionRuntime::OPENMP)
+            .value("THREAD_POOL", value::ExecutionRuntime::THREAD_POOL)
             .value("NONE", value::ExecutionRuntime::NONE);
 
         py::enum_<value::GPU::BarrierScope>(module, "BarrierScope", "An enumeration of barrier scopes")
@@ -82,20 +89,32 @@ namespace
             .value("M32xN32xK8_B1", ir::value::MMAShape::M32xN32xK8_B1)
             .value("M16xN16xK16_B1", ir::value::MMAShape::M16xN16xK16_B1)
             .value("M32xN8xK16_B1", ir::value::MMAShape::M32xN8xK16_B1)
-            .value("M8xN32xK16_B1", ir::value::MMAShape::M8xN32xK16_B1);
+            .value("M8xN32xK16_B1", ir::value::MMAShape::M8xN32xK16_B1)
+            .value("M1xN8xK4_B1", ir::value::MMAShape::M1xN8xK4_B1)
+            .value("M1xN16xK4_B1", ir::value::MMAShape::M1xN16xK4_B1)
+            .value("M1xN4xK1_B1", ir::value::MMAShape::M1xN4xK1_B1)
+            .value("M1xN8xK1_B1", ir::value::MMAShape::M1xN8xK1_B1)
+            .value("M1xN16xK1_B1", ir::value::MMAShape::M1xN16xK1_B1);
 
         py::enum_<ir::value::MMASchedulingPolicy>(module, "_MMASchedulingPolicy", "Used for configuring scheduling policy of MMA ops")
             .value("PASS_ORDER", ir::value::MMASchedulingPolicy::PassOrder)
             .value("BLOCK_ORDER", ir::value::MMASchedulingPolicy::BlockOrder);
+
+        py::enum_<ir::value::MMAInstructionSet>(module, "_MMAInstructionSet", "Selects the instructions used by CPU MMA ops")
+            .value("GENERIC", ir::value::MMAInstructionSet::Generic)
+            .value("AVX2", ir::value::MMAInstructionSet::AVX2)
+            .value("VNNI", ir::value::MMAInstructionSet::VNNI)
+            .value("FMA", ir::value::MMAInstructionSet::FMA);
     }
 
     void DefineExecutionPlanStructs(py::module& module)
     {
         py::class_<value::VectorizationInformation>(module, "_VectorizationInfo", "Used for configuring loop vectorization")
-            .def(py::init<int, int, bool>(), "vector_bytes"_a = 0, "vector_units"_a = 0, "unroll_only"_a = false)
+            .def(py::init<int, int, bool, bool>(), "vector_bytes"_a = 0, "vector_units"_a = 0, "unroll_only"_a = false, "masked_tail"_a = false)
             .def_readwrite("vector_bytes", &value::VectorizationInformation::vectorBytes)
             .def_readwrite("vector_units", &value::VectorizationInformation::vectorUnitCount)
-            .def_readwrite("unroll_only", &value::VectorizationInformation::unrollOnly);
+            .def_readwrite("unroll_only", &value::VectorizationInformation::unrollOnly)
+            .def_readwrite("masked_tail", &value::VectorizationInformation::maskedTail);
 
         py::class_<value::targets::Dim3>(module, "_Dim3", "Used for configuring the x, y, and z indices for a GPU processor")
             .def(py::init<int, int, int>(), "x"_a = 0, "y"_a = 0, "z"_a = 0)
@@ -139,36 +158,38 @@ namespace
                    bool thrifty,
                    bool doubleBuffer,
                    value::MemorySpace doubleBufferMemorySpace,
-                   const std::optional<value::VectorizationInformation>& vectorizationInfo) {
+                   const std::optional<value::VectorizationInformation>& vectorizationInfo,
+                   const std::optional<value::ValueType>& elementType,
+                   const std::optional<int64_t>& prefetchDistance) {
                     if (outermostIncludedSplitIndex.has_value())
                     {
                         value::ScalarIndex resolvedTriggerIndex = triggerIndex.has_value() ? *triggerIndex : *outermostIncludedSplitIndex;
                         if (memoryMap.has_value())
                         {
-                            return plan.AddCache(target, *outermostIncludedSplitIndex, resolvedTriggerIndex, *memoryMap, thrifty, doubleBuffer, vectorizationInfo, indexing, allocation, memorySpace, doubleBufferMemorySpace);
+                            return plan.AddCache(target, *outermostIncludedSplitIndex, resolvedTriggerIndex, *memoryMap, thrifty, doubleBuffer, vectorizationInfo, indexing, allocation, memorySpace, doubleBufferMemorySpace, elementType, prefetchDistance);
                         }
                         else if (dimOrder.has_value())
                         {
-                            return plan.AddCache(target, *outermostIncludedSplitIndex, resolvedTriggerIndex, *dimOrder, thrifty, doubleBuffer, vectorizationInfo, indexing, allocation, memorySpace, doubleBufferMemorySpace);
+                            return plan.AddCache(target, *outermostIncludedSplitIndex, resolvedTriggerIndex, *dimOrder, thrifty, doubleBuffer, vectorizationInfo, indexing, allocation, memorySpace, doubleBufferMemorySpace, elementType, prefetchDistance);
                         }
                         else
                         {
-                            return plan.AddCache(target, *outermostIncludedSplitIndex, thrifty, doubleBuffer, vectorizationInfo, indexing, allocation, memorySpace, doubleBufferMemorySpace);
+                            return plan.AddCache(target, *outermostIncludedSplitIndex, thrifty, doubleBuffer, vectorizationInfo, indexing, allocation, memorySpace, doubleBufferMemorySpace, elementType, prefetchDistance);
                         }
                     }
                     else
                     {
                         if (memoryMap.has_value())
                         {
-                            return plan.AddCache(target, *maxElements, *memoryMap, thrifty, doubleBuffer, vectorizationInfo, indexing, allocation, memorySpace, doubleBufferMemorySpace);
+                            return plan.AddCache(target, *maxElements, *memoryMap, thrifty, doubleBuffer, vectorizationInfo, indexing, allocation, memorySpace, doubleBufferMemorySpace, elementType, prefetchDistance);
                         }
                         else if (dimOrder.has_value())
                         {
-                            return plan.AddCache(target, *maxElements, *dimOrder, thrifty, doubleBuffer, vectorizationInfo, indexing, allocation, memorySpace, doubleBufferMemorySpace);
+                            return plan.AddCache(target, *maxElements, *dimOrder, thrifty, doubleBuffer, vectorizationInfo, indexing, allocation, memorySpace, doubleBufferMemorySpace, elementType, prefetchDistance);
                         }
                         else
                         {
-                            return plan.AddCache(target, *maxElements, thrifty, doubleBuffer, vectorizationInfo, indexing, allocation, memorySpace, doubleBufferMemorySpace);
+                            return plan.AddCache(target, *maxElements, thrifty, doubleBuffer, vectorizationInfo, indexing, allocation, memorySpace, doubleBufferMemorySpace, elementType, prefetchDistance);
                         }
                     }
                 },
@@ -184,11 +205,15 @@ namespace
                 "thrifty"_a,
                 "double_buffer"_a,
                 "double_buffer_location"_a,
-                "vectorization_info"_a)
+                "vectorization_info"_a,
+                "element_type"_a = std::nullopt,
+                "prefetch_distance"_a = std::nullopt)
             .def("emit_runtime_init_packing", py::overload_cast<value::ViewAdapter, const std::string&, const std::string&, value::CacheIndexing>(&value::Plan::EmitRuntimeInitPacking), "target"_a, "packing_func_name"_a, "packed_buf_size_func_name"_a, "indexing"_a = value::CacheIndexing::GlobalToPhysical)
+            .def("emit_runtime_memoized_packing", &value::Plan::EmitRuntimeMemoizedPacking, "target"_a, "wrapper_fn_name"_a, "max_cache_bytes"_a, "indexing"_a = value::CacheIndexing::GlobalToPhysical)
             .def("pack_and_embed_buffer", py::overload_cast<value::ViewAdapter, value::ViewAdapter, const std::string&, const std::string&, value::CacheIndexing>(&value::Plan::PackAndEmbedBuffer), "target"_a, "constant_data_buffer"_a, "wrapper_fn_name"_a, "packed_buffer_name"_a, "indexing"_a = value::CacheIndexing::GlobalToPhysical)
             .def("vectorize", &value::Plan::Vectorize, "i"_a, "vectorization_info"_a)
-            .def("parallelize", &value::Plan::Parallelize, "indices"_a, "num_threads"_a, "policy"_a);
+            .def("parallelize", &value::Plan::Parallelize, "indices"_a, "num_threads"_a, "policy"_a, "affinity"_a = value::ParallelizationAffinity::Close, "cores"_a = std::vector<int64_t>{}, "numa_first_touch"_a = false)
+            .def("tensorize", &value::Plan::Tensorize, "indices"_a, "dims"_a, "instruction_set"_a = ir::value::MMAInstructionSet::Generic);
 
         py::class_<value::GPUPlan>(module, "_GPUExecutionPlan")
             .def(py::init([](value::GPUPlan& plan) {
@@ -5,6 +5,7 @@
 
 #include "AcceraTypes.h"
 #include <value/include/Debugging.h>
+#include <value/include/Profiling.h>
 
 namespace py = pybind11;
 namespace util = accera::utilities;
@@ -85,7 +86,10 @@ void DefineOperations(py::module& module)
             "reduce_fn"_a)
         .def("CheckAllClose", &value::CheckAllClose)
         .def("Return", py::overload_cast<value::ViewAdapter>(&value::Return), "view"_a = value::ViewAdapter{})
-        .def("GetTime", &value::GetTime);
+        .def("GetTime", &value::GetTime)
+        .def("EnterProfileRegion", &value::EnterProfileRegion, "region_name"_a)
+        .def("ExitProfileRegion", &value::ExitProfileRegion, "region_name"_a)
+        .def("PrintProfileResults", &value::PrintProfileResults);
 
     auto getFromGPUIndex = [](value::GPUIndex idx, std::string pos) -> value::Scalar {
         if (pos == "x")
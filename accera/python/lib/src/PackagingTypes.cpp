@@ -5,7 +5,10 @@
 
 #include "AcceraTypes.h"
 
+#include <transforms/include/AcceraCompiler.h>
+
 namespace py = pybind11;
+namespace transforms = accera::transforms;
 namespace value = accera::value;
 namespace util = accera::utilities;
 
@@ -59,6 +62,7 @@ ARM: fp16, neon, vfp3, d16, vfp4, hwdiv-arm, hwdiv
             .def_readwrite("optimize", &value::CompilerOptions::optimize, "Optimize output code using LLVM. Defaults to True.")
             .def_readwrite("position_independent_code", &value::CompilerOptions::positionIndependentCode, "Generate position independent code (equivalent to -fPIC).")
             .def_readwrite("profile", &value::CompilerOptions::profile, "Emit profiling code.")
+            .def_readwrite("profile_trace", &value::CompilerOptions::profileTrace, "Record a per-thread timeline of the profile regions.")
             .def_readwrite("use_fast_math", &value::CompilerOptions::useFastMath, "Allow emitting more efficient code that isn't necessarily IEEE-754 compatible. Defaults to True")
             .def_readwrite("include_diagnostic_info", &value::CompilerOptions::includeDiagnosticInfo, "Allow printing of diagnostic messages from the compiled model.")
             .def_readwrite("target_device", &value::CompilerOptions::targetDevice, "Name of the target device. Defaults to 'host'.")
@@ -94,6 +98,64 @@ ARM: fp16, neon, vfp3, d16, vfp4, hwdiv-arm, hwdiv
             "_ClearActiveModule", [] {
                 value::ClearContext();
             });
+        module.def("_WriteHeaderForModules", &value::WriteHeaderForModules, "filename"_a, "library_name"_a, "modules"_a);
+        module.def(
+            "_CompileModule",
+            [](value::MLIRContext& context,
+               const value::TargetDevice& targetDevice,
+               const std::string& pipelineOptions,
+               const std::string& objectPath,
+               std::optional<std::string> asmPath,
+               unsigned optimizationLevel,
+               unsigned sizeLevel,
+               std::optional<std::string> timeTracePath) {
+                transforms::AcceraPassPipelineOptions options;
+                if (mlir::failed(options.parseFromString(pipelineOptions)))
+                {
+                    throw std::invalid_argument("Invalid lowering pipeline options: " + pipelineOptions);
+                }
+
+                // Profiling collects the MLIR pass timings along with LLVM's time trace
+                std::vector<transforms::PassTiming> passTimings;
+                auto moduleCopy = context.cloneModule();
+                if (mlir::failed(transforms::LowerToLLVMDialect(*moduleCopy, options, timeTracePath ? &passTimings : nullptr)))
+                {
+                    throw std::runtime_error("Failed to lower the module to the LLVM dialect");
+                }
+
+                transforms::CodeGenerationOptions codegenOptions;
+                codegenOptions.optimizationLevel = optimizationLevel;
+                codegenOptions.sizeLevel = sizeLevel;
+                codegenOptions.timeTraceFilePath = timeTracePath;
+                if (mlir::failed(transforms::EmitObjectFile(*moduleCopy, targetDevice, codegenOptions, objectPath, asmPath)))
+                {
+                    throw std::runtime_error("Failed to generate an object file for the module");
+                }
+
+                std::vector<std::tuple<std::string, std::string, double>> timings;
+                timings.reserve(passTimings.size());
+                for (auto& timing : passTimings)
+                {
+                    timings.emplace_back(timing.passName, timing.opName, timing.seconds);
+                }
+                return std::make_pair(timings, transforms::GetScratchFootprints(*moduleCopy));
+            },
+            "module"_a,
+            "target_device"_a,
+            "pipeline_options"_a,
+            "object_path"_a,
+            "asm_path"_a = std::nullopt,
+            "optimization_level"_a = 3,
+            "size_level"_a = 0,
+            "time_trace_path"_a = std::nullopt,
+            py::call_guard<py::gil_scoped_release>(),
+            R"pbdoc(
+Lowers the module and generates an object file for it without serializing the IR or leaving the process.
+
+Returns the (pass, operation, seconds) timings of the MLIR lowering passes, which are only collected if
+time_trace_path is given, and a dictionary of the planned scratch footprint in bytes of each function.
+If time_trace_path is given, LLVM's time trace of code generation is written to it.
+)pbdoc");
 
         subModule.def("GetTargetDevice", &value::GetContextTargetDevice);
         subModule.def("GetCompilerOptions", &value::GetContextCompilerOptions);
@@ -151,6 +213,7 @@ Args:
             .def("cWrapper", &value::FunctionDeclaration::CWrapper, "cWrapper"_a, py::return_value_policy::reference_internal, "Sets whether an MLIR C wrapper function should be emitted for this function")
             .def("headerDecl", &value::FunctionDeclaration::HeaderDecl, "headerDecl"_a, py::return_value_policy::reference_internal, "Sets whether the function should be part of the generated header file.")
             .def("rawPointerAPI", &value::FunctionDeclaration::RawPointerAPI, "rawPointerAPI"_a, py::return_value_policy::reference_internal, "Sets whether the function should provide a raw pointer API.")
+            .def("workspace", &value::FunctionDeclaration::Workspace, "workspace"_a, py::return_value_policy::reference_internal, "Sets whether the function takes a caller-supplied workspace buffer for its scratch memory.")
             .def(
                 "inlinable", [](value::FunctionDeclaration& fn, bool inlinable) {
                     (void)fn.Inlined(inlinable ? value::FunctionInlining::always : value::FunctionInlining::never);
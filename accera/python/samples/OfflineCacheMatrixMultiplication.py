@@ -3,8 +3,8 @@
 # Licensed under the MIT License. See LICENSE in the project root for license information.
 ####################################################################################################
 
-from typing import Sequence, NamedTuple
-from accera import Array, Target
+from typing import Callable, Sequence, NamedTuple
+from accera import Array, Plan, Target
 
 
 class Options(NamedTuple):
@@ -25,6 +25,26 @@ def RuntimeInitCacheMLAS(
     opts=Options(),
     target=Target.HOST
 ):
+    return _RuntimePackedMLAS(
+        A, B, C, lambda plan: plan.emit_runtime_init_pack(B, pack_fn_name, packed_buffer_size_fn_name), opts, target
+    )
+
+
+def RuntimeMemoizedCacheMLAS(
+    A: Array,
+    B: Array,
+    C: Array,
+    wrapper_fn_name: str,
+    max_cache_bytes: int = 64 * 1024 * 1024,
+    opts=Options(),
+    target=Target.HOST
+):
+    return _RuntimePackedMLAS(
+        A, B, C, lambda plan: plan.emit_runtime_memoized_pack(B, wrapper_fn_name, max_cache_bytes), opts, target
+    )
+
+
+def _RuntimePackedMLAS(A: Array, B: Array, C: Array, pack_B: Callable[[Plan], None], opts=Options(), target=Target.HOST):
     from accera import Nest
 
     if not all([len(array.shape) == 2 for array in [A, B, C]]):
@@ -104,7 +124,7 @@ def RuntimeInitCacheMLAS(
 
     plan = schedule.create_plan()
 
-    plan.emit_runtime_init_pack(B, pack_fn_name, packed_buffer_size_fn_name)
+    pack_B(plan)
     plan.cache(C, ii)
 
     plan.unroll(jjj)
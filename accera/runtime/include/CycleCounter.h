@@ -0,0 +1,29 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) Microsoft Corporation. All rights reserved.
+//  Licensed under the MIT License. See LICENSE in the project root for license information.
+//
+//  The cycle counter that packages built with Package.build(timer=Package.Timer.CYCLE_COUNTER) time their
+//  profile regions and GetTime() calls with
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // defined(__cplusplus)
+
+// Returns the current value of the cycle counter that the emitted code reads: the time stamp counter, read with
+// rdtscp, on x86-64 and the virtual counter (cntvct_el0) on AArch64. Returns 0 on other architectures.
+int64_t AcceraReadCycleCounter();
+
+// Returns the length of a cycle counter tick in seconds, or 0 on architectures without a supported counter.
+// On AArch64 it's read from cntfrq_el0. On x86-64 the counter is calibrated against the steady clock on the first
+// call, which takes about 10 milliseconds, and the result is reused from then on. Packages built with the cycle
+// counter make that call from a constructor when they're loaded, so that no timed region absorbs the calibration.
+double AcceraGetCycleCounterPeriod();
+
+#if defined(__cplusplus)
+} // extern "C"
+#endif // defined(__cplusplus)
@@ -0,0 +1,39 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) Microsoft Corporation. All rights reserved.
+//  Licensed under the MIT License. See LICENSE in the project root for license information.
+//
+//  Hardware performance counters read by the profile regions of packages built with Package.build(profile=...)
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // defined(__cplusplus)
+
+// Matches the HardwareCounter enum of the value-to-std lowering. The values are indices into the arrays that
+// AcceraReadHardwareCounters fills in, and bit positions in the counter masks.
+enum AcceraHardwareCounter
+{
+    AcceraHardwareCounterCycles = 0,
+    AcceraHardwareCounterInstructions = 1,
+    AcceraHardwareCounterL1DMisses = 2,
+    AcceraHardwareCounterLLCMisses = 3,
+    AcceraHardwareCounterDTLBMisses = 4,
+    AcceraHardwareCounterCount = 5,
+};
+
+// Writes the current value of each counter in `counterMask` (a bit per AcceraHardwareCounter) for the calling thread
+// to values[counter]. `values` must have room for AcceraHardwareCounterCount values, the others are left alone.
+// Only differences between two reads on the same thread are meaningful. Counters that can't be opened, for example
+// without perf_event access or on platforms other than Linux, read as 0.
+void AcceraReadHardwareCounters(int32_t counterMask, int64_t* values);
+
+// Returns the subset of `counterMask` that can be read on the calling thread
+int32_t AcceraGetAvailableHardwareCounters(int32_t counterMask);
+
+#if defined(__cplusplus)
+} // extern "C"
+#endif // defined(__cplusplus)
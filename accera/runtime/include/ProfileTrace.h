@@ -0,0 +1,34 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) Microsoft Corporation. All rights reserved.
+//  Licensed under the MIT License. See LICENSE in the project root for license information.
+//
+//  Timelines of the profile regions of packages built with Package.build(trace=True)
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // defined(__cplusplus)
+
+// Records that the calling thread entered (begin != 0) or exited (begin == 0) the profile region `name`, with the
+// current time. Each thread records into a ring buffer of its own, without taking locks, and once the buffer is
+// full the oldest events are overwritten. The buffers hold on to `name`, which must outlive the next trace flush.
+// The number of events each buffer holds is read from the ACCERA_PROFILE_TRACE_CAPACITY environment variable
+// when a thread records its first event, and defaults to 65536.
+void AcceraTraceProfileEvent(const char* name, int32_t begin);
+
+// Writes the events recorded by every thread to `path` in the Chrome trace event format, which Perfetto and
+// chrome://tracing open, and returns the number of events written, or -1 if the file can't be written. Exits
+// whose entries were overwritten are left out. The buffers are read without stopping the threads recording into
+// them, so no traced region should be running while the trace is written.
+int64_t AcceraWriteProfileTrace(const char* path);
+
+// Discards the events recorded so far by every thread
+void AcceraResetProfileTrace();
+
+#if defined(__cplusplus)
+} // extern "C"
+#endif // defined(__cplusplus)
@@ -0,0 +1,39 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) Microsoft Corporation. All rights reserved.
+//  Licensed under the MIT License. See LICENSE in the project root for license information.
+//
+//  Thread placement functions called by code emitted for Plan.parallelize
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // defined(__cplusplus)
+
+// Matches accera::ir::executionPlan::ParallelizationAffinity
+enum AcceraThreadAffinity
+{
+    AcceraThreadAffinityClose = 0,
+    AcceraThreadAffinitySpread = 1,
+    AcceraThreadAffinitySocket = 2,
+    AcceraThreadAffinityExplicit = 3,
+};
+
+// Binds the calling thread, which is thread `threadIndex` of `numThreads`, according to `affinity`:
+//   Close: to logical CPU (threadIndex % numCPUs)
+//   Spread: to logical CPU (threadIndex * numCPUs / numThreads)
+//   Socket: to all the logical CPUs of socket (threadIndex * numSockets / numThreads)
+//   Explicit: the core list is only known to the emitted code, which calls AcceraBindThreadToCore instead, so this
+//             binds like Close
+// Binding is a no-op on platforms that do not support it. Repeated calls with the same binding are cheap.
+void AcceraBindThread(int32_t threadIndex, int32_t numThreads, int32_t affinity);
+
+// Binds the calling thread to the given logical CPU
+void AcceraBindThreadToCore(int64_t core);
+
+#if defined(__cplusplus)
+} // extern "C"
+#endif // defined(__cplusplus)
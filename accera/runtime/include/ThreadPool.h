@@ -0,0 +1,31 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) Microsoft Corporation. All rights reserved.
+//  Licensed under the MIT License. See LICENSE in the project root for license information.
+//
+//  Persistent thread pool used by code emitted for the THREAD_POOL runtime
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // defined(__cplusplus)
+
+// Runs the iterations [begin, end) of a parallel loop. `context` holds the values captured by the loop body.
+typedef void (*AcceraParallelForBody)(void* context, int64_t begin, int64_t end);
+
+// Runs `body` over the iterations [0, numIterations) on up to `numThreads` threads of a persistent pool,
+// returning once all the iterations are done. The calling thread participates as thread 0.
+// If `dynamic` is zero, each thread runs one contiguous range of iterations. Otherwise, threads repeatedly
+// claim small ranges of iterations until none are left.
+// `numThreads` <= 0 uses one thread per logical CPU. Nested calls run serially on the calling thread.
+void AcceraParallelFor(int64_t numIterations, int32_t numThreads, int32_t dynamic, AcceraParallelForBody body, void* context);
+
+// Returns the index of the calling thread within the innermost running AcceraParallelFor, or 0 outside of one
+int32_t AcceraGetThreadNum();
+
+#if defined(__cplusplus)
+} // extern "C"
+#endif // defined(__cplusplus)
@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) Microsoft Corporation. All rights reserved.
+//  Licensed under the MIT License. See LICENSE in the project root for license information.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "CycleCounter.h"
+
+#include <chrono>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define ACCERA_X86_64_CYCLE_COUNTER
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif // defined(_MSC_VER)
+#elif defined(__aarch64__)
+#define ACCERA_AARCH64_CYCLE_COUNTER
+#endif
+
+namespace
+{
+#if defined(ACCERA_X86_64_CYCLE_COUNTER)
+constexpr auto CalibrationTime = std::chrono::milliseconds(10);
+
+double CalibrateCycleCounter()
+{
+    // Busy-waits rather than sleeping, so that the core doesn't drop into a power state that slows the counter on
+    // the (old) CPUs whose time stamp counter isn't invariant
+    auto startTime = std::chrono::steady_clock::now();
+    auto startTicks = AcceraReadCycleCounter();
+    auto endTime = startTime;
+    while (endTime - startTime < CalibrationTime)
+    {
+        endTime = std::chrono::steady_clock::now();
+    }
+    auto endTicks = AcceraReadCycleCounter();
+
+    auto seconds = std::chrono::duration<double>(endTime - startTime).count();
+    return endTicks > startTicks ? seconds / static_cast<double>(endTicks - startTicks) : 0.0;
+}
+#endif // defined(ACCERA_X86_64_CYCLE_COUNTER)
+} // namespace
+
+extern "C" {
+
+int64_t AcceraReadCycleCounter()
+{
+#if defined(ACCERA_X86_64_CYCLE_COUNTER)
+    unsigned int aux;
+    return static_cast<int64_t>(__rdtscp(&aux));
+#elif defined(ACCERA_AARCH64_CYCLE_COUNTER)
+    uint64_t ticks;
+    asm volatile("isb\n\tmrs %0, cntvct_el0"
+                 : "=r"(ticks)
+                 :
+                 : "memory");
+    return static_cast<int64_t>(ticks);
+#else
+    return 0;
+#endif
+}
+
+double AcceraGetCycleCounterPeriod()
+{
+#if defined(ACCERA_X86_64_CYCLE_COUNTER)
+    static const double period = CalibrateCycleCounter();
+    return period;
+#elif defined(ACCERA_AARCH64_CYCLE_COUNTER)
+    static const double period = [] {
+        uint64_t frequency;
+        asm volatile("mrs %0, cntfrq_el0"
+                     : "=r"(frequency));
+        return frequency ? 1.0 / static_cast<double>(frequency) : 0.0;
+    }();
+    return period;
+#else
+    return 0.0;
+#endif
+}
+
+} // extern "C"
@@ -0,0 +1,198 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) Microsoft Corporation. All rights reserved.
+//  Licensed under the MIT License. See LICENSE in the project root for license information.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ProfileCounters.h"
+
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif // defined(__linux__)
+
+namespace
+{
+#if defined(__linux__)
+perf_event_attr GetCounterAttributes(int counter)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+
+    auto cacheReadMiss = [](uint64_t cache) {
+        return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    };
+
+    switch (counter)
+    {
+    case AcceraHardwareCounterCycles:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case AcceraHardwareCounterInstructions:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case AcceraHardwareCounterL1DMisses:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = cacheReadMiss(PERF_COUNT_HW_CACHE_L1D);
+        break;
+    case AcceraHardwareCounterLLCMisses:
+        // The generic cache miss event, which the kernel maps to last level cache misses on most CPUs that have one.
+        // The PERF_COUNT_HW_CACHE_LL event is missing on more of them.
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        break;
+    case AcceraHardwareCounterDTLBMisses:
+    default:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = cacheReadMiss(PERF_COUNT_HW_CACHE_DTLB);
+        break;
+    }
+    return attr;
+}
+
+// The counters of a mask, opened as a single perf_event group on the calling thread so that they're all read
+// with one system call. Counters that fail to open (no perf_event access, no such event on this CPU, or no room
+// left in the PMU) are left out of the group and read as 0.
+class CounterGroup
+{
+public:
+    CounterGroup(int32_t counterMask)
+    {
+        for (int counter = 0; counter < AcceraHardwareCounterCount; ++counter)
+        {
+            if ((counterMask & (1 << counter)) == 0)
+            {
+                continue;
+            }
+
+            auto attr = GetCounterAttributes(counter);
+            auto groupFd = _fds.empty() ? -1 : _fds.front();
+            auto fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1, groupFd, /*flags=*/0));
+            if (fd >= 0)
+            {
+                _fds.push_back(fd);
+                _counters.push_back(counter);
+            }
+        }
+        _buffer.resize(_fds.size() + 1);
+    }
+
+    ~CounterGroup()
+    {
+        for (auto fd : _fds)
+        {
+            close(fd);
+        }
+    }
+
+    CounterGroup(const CounterGroup&) = delete;
+    CounterGroup& operator=(const CounterGroup&) = delete;
+
+    int32_t AvailableMask() const
+    {
+        int32_t mask = 0;
+        for (auto counter : _counters)
+        {
+            mask |= 1 << counter;
+        }
+        return mask;
+    }
+
+    void Read(int32_t counterMask, int64_t* values)
+    {
+        for (int counter = 0; counter < AcceraHardwareCounterCount; ++counter)
+        {
+            if (counterMask & (1 << counter))
+            {
+                values[counter] = 0;
+            }
+        }
+
+        // With PERF_FORMAT_GROUP, the leader reads as { u64 nr; u64 values[nr]; } in the order the counters were opened
+        auto size = static_cast<ssize_t>(_buffer.size() * sizeof(uint64_t));
+        if (_fds.empty() || read(_fds.front(), _buffer.data(), size) != size)
+        {
+            return;
+        }
+        for (size_t i = 0; i < _counters.size() && i < _buffer[0]; ++i)
+        {
+            values[_counters[i]] = static_cast<int64_t>(_buffer[i + 1]);
+        }
+    }
+
+private:
+    std::vector<int> _fds; // the group leader comes first
+    std::vector<int> _counters;
+    std::vector<uint64_t> _buffer;
+};
+
+CounterGroup& GetCounterGroup(int32_t counterMask)
+{
+    // perf_event counters opened with pid 0 only count the thread that opened them, so every thread opens its own.
+    // Packages only ever read the one mask they were built with, so the map stays tiny.
+    thread_local std::map<int32_t, CounterGroup> groups;
+    auto it = groups.find(counterMask);
+    if (it == groups.end())
+    {
+        it = groups.emplace(std::piecewise_construct, std::forward_as_tuple(counterMask), std::forward_as_tuple(counterMask)).first;
+    }
+    return it->second;
+}
+#endif // defined(__linux__)
+
+int32_t ValidMask(int32_t counterMask)
+{
+    return counterMask & ((1 << AcceraHardwareCounterCount) - 1);
+}
+} // namespace
+
+extern "C" {
+
+void AcceraReadHardwareCounters(int32_t counterMask, int64_t* values)
+{
+    counterMask = ValidMask(counterMask);
+    if (counterMask == 0 || values == nullptr)
+    {
+        return;
+    }
+#if defined(__linux__)
+    GetCounterGroup(counterMask).Read(counterMask, values);
+#else
+    for (int counter = 0; counter < AcceraHardwareCounterCount; ++counter)
+    {
+        if (counterMask & (1 << counter))
+        {
+            values[counter] = 0;
+        }
+    }
+#endif // defined(__linux__)
+}
+
+int32_t AcceraGetAvailableHardwareCounters(int32_t counterMask)
+{
+    counterMask = ValidMask(counterMask);
+    if (counterMask == 0)
+    {
+        return 0;
+    }
+#if defined(__linux__)
+    return GetCounterGroup(counterMask).AvailableMask();
+#else
+    return 0;
+#endif // defined(__linux__)
+}
+
+} // extern "C"
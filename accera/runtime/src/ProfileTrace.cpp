@@ -0,0 +1,208 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) Microsoft Corporation. All rights reserved.
+//  Licensed under the MIT License. See LICENSE in the project root for license information.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ProfileTrace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif // defined(_WIN32)
+
+namespace
+{
+constexpr uint64_t DefaultCapacity = 1 << 16;
+
+struct TraceEvent
+{
+    const char* name;
+    int64_t timestamp; // in nanoseconds since the first event of the process
+    bool begin;
+};
+
+std::chrono::steady_clock::time_point TraceEpoch()
+{
+    static const auto epoch = std::chrono::steady_clock::now();
+    return epoch;
+}
+
+uint64_t GetCapacity()
+{
+    // Rounded up to a power of 2, so that positions map to slots with a mask
+    static const uint64_t capacity = [] {
+        uint64_t requested = DefaultCapacity;
+        if (auto value = std::getenv("ACCERA_PROFILE_TRACE_CAPACITY"))
+        {
+            requested = std::max<uint64_t>(std::strtoull(value, nullptr, 10), 1);
+        }
+        uint64_t capacity = 1;
+        while (capacity < requested)
+        {
+            capacity <<= 1;
+        }
+        return capacity;
+    }();
+    return capacity;
+}
+
+// The events of one thread. Only the owning thread writes events, and it publishes each one by advancing `head`,
+// so recording never waits on the threads that read or reset the buffer.
+class ThreadTraceBuffer
+{
+public:
+    ThreadTraceBuffer(int32_t threadId) :
+        threadId(threadId),
+        _events(GetCapacity())
+    {}
+
+    void Record(const char* name, bool begin)
+    {
+        auto epoch = TraceEpoch(); // before reading the clock, so that the first event isn't earlier than the epoch
+        auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+        auto head = _head.load(std::memory_order_relaxed);
+        _events[head & (_events.size() - 1)] = { name, timestamp, begin };
+        _head.store(head + 1, std::memory_order_release);
+    }
+
+    // Returns the events since the last reset that haven't been overwritten yet, oldest first
+    std::vector<TraceEvent> Events() const
+    {
+        auto head = _head.load(std::memory_order_acquire);
+        auto tail = std::max(_tail.load(std::memory_order_relaxed), head > _events.size() ? head - _events.size() : 0);
+        std::vector<TraceEvent> events;
+        events.reserve(head - tail);
+        for (auto position = tail; position < head; ++position)
+        {
+            events.push_back(_events[position & (_events.size() - 1)]);
+        }
+        return events;
+    }
+
+    void Reset()
+    {
+        _tail.store(_head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+
+    const int32_t threadId;
+    ThreadTraceBuffer* next = nullptr;
+
+private:
+    std::vector<TraceEvent> _events;
+    std::atomic<uint64_t> _head{ 0 };
+    std::atomic<uint64_t> _tail{ 0 };
+};
+
+// Every thread's buffer, pushed onto the front as threads record their first event. The buffers are never freed,
+// so that the events of threads that have exited can still be written out.
+std::atomic<ThreadTraceBuffer*> threadBuffers{ nullptr };
+std::atomic<int32_t> numThreadBuffers{ 0 };
+
+ThreadTraceBuffer& GetThreadBuffer()
+{
+    thread_local ThreadTraceBuffer* buffer = [] {
+        auto buffer = new ThreadTraceBuffer(numThreadBuffers.fetch_add(1, std::memory_order_relaxed));
+        buffer->next = threadBuffers.load(std::memory_order_relaxed);
+        while (!threadBuffers.compare_exchange_weak(buffer->next, buffer, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+        return buffer;
+    }();
+    return *buffer;
+}
+
+void WriteJsonString(FILE* file, const char* str)
+{
+    std::fputc('"', file);
+    for (auto c = str; *c; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            std::fputc('\\', file);
+            std::fputc(*c, file);
+        }
+        else if (static_cast<unsigned char>(*c) < 0x20)
+        {
+            std::fprintf(file, "\\u%04x", static_cast<unsigned>(*c));
+        }
+        else
+        {
+            std::fputc(*c, file);
+        }
+    }
+    std::fputc('"', file);
+}
+
+int GetProcessId()
+{
+#if defined(_WIN32)
+    return _getpid();
+#else
+    return static_cast<int>(getpid());
+#endif // defined(_WIN32)
+}
+} // namespace
+
+extern "C" {
+
+void AcceraTraceProfileEvent(const char* name, int32_t begin)
+{
+    GetThreadBuffer().Record(name, begin != 0);
+}
+
+int64_t AcceraWriteProfileTrace(const char* path)
+{
+    FILE* file = path ? std::fopen(path, "w") : nullptr;
+    if (!file)
+    {
+        return -1;
+    }
+
+    auto pid = GetProcessId();
+    int64_t numEvents = 0;
+    const char* separator = "";
+    std::fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (auto buffer = threadBuffers.load(std::memory_order_acquire); buffer; buffer = buffer->next)
+    {
+        std::fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}", separator, pid, buffer->threadId, buffer->threadId);
+        separator = ",";
+
+        // A full buffer overwrites the entries of regions whose exits it still holds, which the viewers would
+        // otherwise match with the entries of the regions enclosing them
+        int64_t depth = 0;
+        for (const auto& event : buffer->Events())
+        {
+            if (!event.begin && depth == 0)
+            {
+                continue;
+            }
+            depth += event.begin ? 1 : -1;
+
+            std::fprintf(file, ",\n{\"name\":");
+            WriteJsonString(file, event.name);
+            std::fprintf(file, ",\"ph\":\"%c\",\"ts\":%lld.%03lld,\"pid\":%d,\"tid\":%d}", event.begin ? 'B' : 'E', static_cast<long long>(event.timestamp / 1000), static_cast<long long>(event.timestamp % 1000), pid, buffer->threadId);
+            ++numEvents;
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+
+    return std::fclose(file) == 0 ? numEvents : -1;
+}
+
+void AcceraResetProfileTrace()
+{
+    for (auto buffer = threadBuffers.load(std::memory_order_acquire); buffer; buffer = buffer->next)
+    {
+        buffer->Reset();
+    }
+}
+
+} // extern "C"
@@ -0,0 +1,157 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) Microsoft Corporation. All rights reserved.
+//  Licensed under the MIT License. See LICENSE in the project root for license information.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ThreadAffinity.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+namespace
+{
+struct CpuTopology
+{
+    int numCpus = 1;
+    std::vector<std::vector<int>> socketCpus; // the logical CPUs of each socket
+};
+
+CpuTopology ReadCpuTopology()
+{
+    CpuTopology topology;
+    topology.numCpus = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+    std::map<int, std::vector<int>> cpusBySocket;
+#if defined(__linux__)
+    for (int cpu = 0; cpu < topology.numCpus; ++cpu)
+    {
+        std::ifstream packageId("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/physical_package_id");
+        int socket = 0;
+        if (!(packageId >> socket))
+        {
+            socket = 0;
+        }
+        cpusBySocket[socket].push_back(cpu);
+    }
+#else
+    for (int cpu = 0; cpu < topology.numCpus; ++cpu)
+    {
+        cpusBySocket[0].push_back(cpu);
+    }
+#endif // defined(__linux__)
+
+    for (auto& [socket, cpus] : cpusBySocket)
+    {
+        topology.socketCpus.push_back(std::move(cpus));
+    }
+    return topology;
+}
+
+const CpuTopology& GetCpuTopology()
+{
+    static const CpuTopology topology = ReadCpuTopology();
+    return topology;
+}
+
+bool SetCurrentThreadAffinity(const std::vector<int>& cpus)
+{
+#if defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (auto cpu : cpus)
+    {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+    return sched_setaffinity(0, sizeof(cpuSet), &cpuSet) == 0;
+#elif defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for (auto cpu : cpus)
+    {
+        if (cpu >= 0 && cpu < static_cast<int>(sizeof(DWORD_PTR) * 8))
+        {
+            mask |= (static_cast<DWORD_PTR>(1) << cpu);
+        }
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+    // Not supported (e.g. macOS does not expose thread-to-core binding)
+    (void)cpus;
+    return false;
+#endif
+}
+
+// Binding the current thread is a system call, but the emitted code requests the binding at the
+// top of every parallel region, so remember the current binding of each thread.
+thread_local int64_t currentBinding = -1;
+
+void BindCurrentThread(int64_t bindingKey, const std::vector<int>& cpus)
+{
+    if (currentBinding == bindingKey)
+    {
+        return;
+    }
+
+    if (SetCurrentThreadAffinity(cpus))
+    {
+        currentBinding = bindingKey;
+    }
+}
+
+constexpr int64_t SocketBindingFlag = int64_t{ 1 } << 32;
+} // namespace
+
+extern "C" {
+
+void AcceraBindThread(int32_t threadIndex, int32_t numThreads, int32_t affinity)
+{
+    const auto& topology = GetCpuTopology();
+    threadIndex = std::max(threadIndex, 0);
+    numThreads = std::max(numThreads, 1);
+
+    switch (affinity)
+    {
+    case AcceraThreadAffinitySocket: {
+        auto numSockets = static_cast<int64_t>(topology.socketCpus.size());
+        auto socket = static_cast<int>((static_cast<int64_t>(threadIndex % numThreads) * numSockets) / numThreads);
+        BindCurrentThread(SocketBindingFlag | socket, topology.socketCpus[socket]);
+        break;
+    }
+    case AcceraThreadAffinitySpread: {
+        auto cpu = static_cast<int>((static_cast<int64_t>(threadIndex % numThreads) * topology.numCpus) / numThreads);
+        BindCurrentThread(cpu, { cpu });
+        break;
+    }
+    case AcceraThreadAffinityClose:
+    case AcceraThreadAffinityExplicit:
+    default: {
+        auto cpu = threadIndex % topology.numCpus;
+        BindCurrentThread(cpu, { cpu });
+        break;
+    }
+    }
+}
+
+void AcceraBindThreadToCore(int64_t core)
+{
+    if (core < 0 || core >= SocketBindingFlag)
+    {
+        return;
+    }
+    BindCurrentThread(core, { static_cast<int>(core) });
+}
+
+} // extern "C"
@@ -0,0 +1,249 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) Microsoft Corporation. All rights reserved.
+//  Licensed under the MIT License. See LICENSE in the project root for license information.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+// Idle threads first poll with a pause instruction, then yield their time slice between polls, and
+// (for workers) finally go to sleep. Back-to-back parallel loops are dispatched while the workers are
+// still polling, which avoids the cost of waking them up, and yielding keeps oversubscribed cores usable.
+constexpr int SpinCount = 1 << 10;
+constexpr int YieldCount = 1 << 10;
+
+inline void CpuRelax()
+{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+thread_local int32_t currentThreadNum = 0;
+thread_local bool inParallelRegion = false;
+
+struct Job
+{
+    AcceraParallelForBody body = nullptr;
+    void* context = nullptr;
+    int64_t numIterations = 0;
+    int32_t numThreads = 1;
+    int64_t chunkSize = 1; // only used for dynamic scheduling
+    bool dynamic = false;
+    alignas(64) std::atomic<int64_t> nextIteration{ 0 };
+    alignas(64) std::atomic<int32_t> pendingWorkers{ 0 };
+};
+
+void RunJob(Job& job, int32_t threadNum)
+{
+    currentThreadNum = threadNum;
+    inParallelRegion = true;
+    if (job.dynamic)
+    {
+        for (;;)
+        {
+            auto begin = job.nextIteration.fetch_add(job.chunkSize, std::memory_order_relaxed);
+            if (begin >= job.numIterations)
+            {
+                break;
+            }
+            job.body(job.context, begin, std::min(begin + job.chunkSize, job.numIterations));
+        }
+    }
+    else
+    {
+        auto begin = job.numIterations * threadNum / job.numThreads;
+        auto end = job.numIterations * (threadNum + 1) / job.numThreads;
+        if (begin < end)
+        {
+            job.body(job.context, begin, end);
+        }
+    }
+    inParallelRegion = false;
+    currentThreadNum = 0;
+}
+
+class ThreadPool
+{
+public:
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_sleepMutex);
+            _shuttingDown.store(true);
+        }
+        _wake.notify_all();
+        for (auto& worker : _workers)
+        {
+            worker->thread.join();
+        }
+    }
+
+    void ParallelFor(int64_t numIterations, int32_t numThreads, bool dynamic, AcceraParallelForBody body, void* context)
+    {
+        std::lock_guard<std::mutex> dispatchLock(_dispatchMutex);
+
+        EnsureWorkers(numThreads - 1);
+
+        _job.body = body;
+        _job.context = context;
+        _job.numIterations = numIterations;
+        _job.numThreads = numThreads;
+        _job.dynamic = dynamic;
+        _job.chunkSize = std::max<int64_t>(1, numIterations / (int64_t{ numThreads } * 8));
+        _job.nextIteration.store(0, std::memory_order_relaxed);
+        _job.pendingWorkers.store(numThreads - 1, std::memory_order_relaxed);
+
+        // Hand the job to the first (numThreads - 1) workers
+        ++_generation;
+        bool anySleeping = false;
+        for (int32_t i = 0; i < numThreads - 1; ++i)
+        {
+            _workers[i]->assignedGeneration.store(_generation);
+            anySleeping |= _workers[i]->sleeping.load();
+        }
+        if (anySleeping)
+        {
+            // Synchronize with workers that are about to sleep, so that they do not miss the wakeup
+            {
+                std::lock_guard<std::mutex> lock(_sleepMutex);
+            }
+            _wake.notify_all();
+        }
+
+        RunJob(_job, 0);
+
+        for (int spins = 0; _job.pendingWorkers.load(std::memory_order_acquire) != 0; ++spins)
+        {
+            if (spins < SpinCount)
+            {
+                CpuRelax();
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    struct Worker
+    {
+        std::thread thread;
+        alignas(64) std::atomic<uint64_t> assignedGeneration{ 0 };
+        std::atomic<bool> sleeping{ false };
+    };
+
+    void EnsureWorkers(int32_t count)
+    {
+        while (static_cast<int32_t>(_workers.size()) < count)
+        {
+            auto worker = std::make_unique<Worker>();
+            auto threadNum = static_cast<int32_t>(_workers.size()) + 1;
+            auto* workerPtr = worker.get();
+            worker->thread = std::thread([this, workerPtr, threadNum] { WorkerLoop(*workerPtr, threadNum); });
+            _workers.push_back(std::move(worker));
+        }
+    }
+
+    void WorkerLoop(Worker& worker, int32_t threadNum)
+    {
+        uint64_t seenGeneration = 0;
+        for (;;)
+        {
+            int spins = 0;
+            while (worker.assignedGeneration.load(std::memory_order_acquire) == seenGeneration)
+            {
+                if (_shuttingDown.load(std::memory_order_relaxed))
+                {
+                    return;
+                }
+
+                if (++spins < SpinCount)
+                {
+                    CpuRelax();
+                    continue;
+                }
+                if (spins < SpinCount + YieldCount)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(_sleepMutex);
+                worker.sleeping.store(true);
+                _wake.wait(lock, [&] { return worker.assignedGeneration.load() != seenGeneration || _shuttingDown.load(); });
+                worker.sleeping.store(false);
+                spins = 0;
+            }
+
+            seenGeneration = worker.assignedGeneration.load(std::memory_order_acquire);
+            RunJob(_job, threadNum);
+            _job.pendingWorkers.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    std::mutex _dispatchMutex;
+    std::vector<std::unique_ptr<Worker>> _workers;
+    uint64_t _generation = 0;
+    Job _job;
+
+    std::mutex _sleepMutex;
+    std::condition_variable _wake;
+    std::atomic<bool> _shuttingDown{ false };
+};
+
+ThreadPool& GetThreadPool()
+{
+    static ThreadPool pool;
+    return pool;
+}
+} // namespace
+
+extern "C" {
+
+void AcceraParallelFor(int64_t numIterations, int32_t numThreads, int32_t dynamic, AcceraParallelForBody body, void* context)
+{
+    if (numIterations <= 0)
+    {
+        return;
+    }
+
+    if (numThreads <= 0)
+    {
+        numThreads = std::max(1, static_cast<int32_t>(std::thread::hardware_concurrency()));
+    }
+    numThreads = static_cast<int32_t>(std::min<int64_t>(numThreads, numIterations));
+
+    if (numThreads == 1 || inParallelRegion)
+    {
+        body(context, 0, numIterations);
+        return;
+    }
+
+    GetThreadPool().ParallelFor(numIterations, numThreads, dynamic != 0, body, context);
+}
+
+int32_t AcceraGetThreadNum()
+{
+    return currentThreadNum;
+}
+
+} // extern "C"
@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) Microsoft Corporation. All rights reserved.
+//  Licensed under the MIT License. See LICENSE in the project root for license information.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "AcceraPasses.h"
+
+#include <value/include/TargetDevice.h>
+
+#include <mlir/IR/BuiltinOps.h>
+#include <mlir/Pass/PassInstrumentation.h>
+#include <mlir/Support/LogicalResult.h>
+
+#include <llvm/Support/raw_ostream.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace accera::transforms
+{
+/// Options for generating machine code from a module in the LLVM dialect
+struct CodeGenerationOptions
+{
+    unsigned optimizationLevel = 3;
+    unsigned sizeLevel = 0;
+    bool fastFPContract = true;
+
+    /// If set, LLVM's time trace of the optimization and code generation passes is written to this file
+    std::optional<std::string> timeTraceFilePath;
+};
+
+/// The wall-clock time of one run of a pass over one operation
+struct PassTiming
+{
+    std::string passName;
+    std::string opName;
+    double seconds;
+
+    /// The peak resident set size of the process when the pass finished, or 0 if the platform doesn't report it.
+    /// Passes that run concurrently share the process, so this is only attributable to a single pass when the
+    /// pass manager runs single-threaded.
+    uint64_t peakResidentBytes;
+};
+
+/// Creates an instrumentation that appends a record to timings for every pass run, in completion order
+std::unique_ptr<mlir::PassInstrumentation> CreatePassTimingInstrumentation(std::vector<PassTiming>& timings);
+
+/// Writes the pass timings as a JSON array of { "pass", "op", "seconds", "peak_rss_bytes" } objects
+void WritePassTimings(const std::vector<PassTiming>& timings, llvm::raw_ostream& os);
+
+/// Runs the Accera to LLVM dialect pipeline over the module, in place.
+/// This is the in-process equivalent of `acc-opt --acc-to-llvm`.
+/// If passTimings is given, a record is appended to it for every pass run, in completion order.
+mlir::LogicalResult LowerToLLVMDialect(mlir::ModuleOp module, const AcceraPassPipelineOptions& options, std::vector<PassTiming>* passTimings = nullptr);
+
+/// Returns the planned scratch footprint in bytes of each function in the lowered module that has one, keyed by name
+std::map<std::string, int64_t> GetScratchFootprints(mlir::ModuleOp module);
+
+/// Translates a module in the LLVM dialect to LLVM IR, optimizes it for the target device and writes an object file,
+/// and optionally an assembly listing. This is the in-process equivalent of `mlir-translate`, `opt` and `llc`.
+mlir::LogicalResult EmitObjectFile(mlir::ModuleOp module,
+                                   const value::TargetDevice& targetDevice,
+                                   const CodeGenerationOptions& options,
+                                   const std::string& objectFilePath,
+                                   const std::optional<std::string>& asmFilePath = std::nullopt);
+
+} // namespace accera::transforms
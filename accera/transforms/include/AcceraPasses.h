@@ -16,11 +16,14 @@
 #include "util/DebugFunctionPass.h"
 #include "value/BarrierOptPass.h"
 #include "value/FunctionPointerResolutionPass.h"
+#include "value/MemoryPlanningPass.h"
 #include "value/RangeValueOptimizePass.h"
+#include "value/ThreadPoolLoweringPass.h"
 #include "value/ValueFuncToTargetPass.h"
 #include "value/ValueSimplifyPass.h"
 #include "value/ValueToLLVMLoweringPass.h"
 #include "value/ValueToStandardLoweringPass.h"
+#include "value/WorkspaceAllocationPass.h"
 
 #include <ir/include/exec/ExecutionPlanOps.h>
 #include <ir/include/nest/LoopNestOps.h>
@@ -81,11 +84,16 @@ struct AcceraPassPipelineOptions : mlir::PassPipelineOptions<AcceraPassPipelineO
             clEnumValN(accera::value::ExecutionRuntime::ROCM, "rocm", "ROCm runtime"),
             clEnumValN(accera::value::ExecutionRuntime::VULKAN, "vulkan", "Vulkan runtime"),
             clEnumValN(accera::value::ExecutionRuntime::OPENMP, "openmp", "OpenMP runtime"),
+            clEnumValN(accera::value::ExecutionRuntime::THREAD_POOL, "thread_pool", "Accera CPU thread pool runtime"),
             clEnumValN(accera::value::ExecutionRuntime::DEFAULT, "default", "default runtime")),
         llvm::cl::init(accera::value::ExecutionRuntime::DEFAULT)
     };
     Option<bool> enableAsync{ *this, "enable-async", llvm::cl::init(false) };
     Option<bool> enableProfile{ *this, "enable-profiling", llvm::cl::init(false) };
+    Option<std::string> profileCounters{ *this, "profile-counters", llvm::cl::init(std::string{}) };
+    Option<bool> instrumentProfile{ *this, "instrument-profile-regions", llvm::cl::init(false) };
+    Option<bool> profileTrace{ *this, "profile-trace", llvm::cl::init(false) };
+    Option<std::string> timer{ *this, "timer", llvm::cl::init(std::string{ "clock" }) };
     Option<bool> printLoops{ *this, "print-loops", llvm::cl::init(false) };
     Option<bool> printVecOpDetails{ *this, "print-vec-details", llvm::cl::init(false) };
     Option<bool> writeBarrierGraph{ *this, "barrier-opt-dot", llvm::cl::init(false) };
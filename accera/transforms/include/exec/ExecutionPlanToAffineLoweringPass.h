@@ -30,6 +30,7 @@ void populateExecutionPlanMaxElementCacheRegionPatterns(mlir::OwningRewritePatte
 void populateExecutionPlanVectorizePatterns(bool printVectorizationDetails, mlir::OwningRewritePatternList& patterns);
 void populateExecutionPlanTensorizePatterns(mlir::OwningRewritePatternList& patterns);
 void populateExecutionPlanParallelizePatterns(mlir::OwningRewritePatternList& patterns);
+void populateExecutionPlanThreadAffinityPatterns(mlir::OwningRewritePatternList& patterns);
 void populateExecutionPlanScaleHoistingPatterns(mlir::OwningRewritePatternList& patterns);
 void populateOutOfBoundsAccessHandlingPatterns(mlir::OwningRewritePatternList& patterns);
 void populateConvergeLoadStoresPatterns(mlir::OwningRewritePatternList& patterns);
@@ -36,6 +36,9 @@ namespace transforms::loopnest
         accera::transforms::IntraPassSnapshotOptions snapshotOptions;
         bool printLoops = false;
         bool printVecOpDetails = false;
+
+        // Wrap each kernel, cache copy and parallel region in a profile region
+        bool instrumentProfileRegions = false;
     };
 
     void populateLoopnestToValueFuncPatterns(mlir::OwningRewritePatternList& patterns);
@@ -56,4 +56,22 @@ bool CanVectorizeOp(mlir::Operation* op,
                     int64_t step,
                     int64_t vectorSize);
 
+// Masked vectorization, used for loops with fewer iterations than the vector size: only the leading
+// lanes of `mask` are set, and the memory ops only touch the elements in those lanes.
+bool CanVectorizeMaskedOp(mlir::PatternRewriter& rewriter,
+                          mlir::Operation* op,
+                          std::vector<mlir::BlockAndValueMapping>& laneMappings,
+                          mlir::Value inductionVar,
+                          int64_t step,
+                          int64_t vectorSize);
+
+std::optional<VectorizedOp> VectorizeMaskedOp(mlir::PatternRewriter& rewriter,
+                                              mlir::Operation* op,
+                                              mlir::Value mask,
+                                              const VectorizedOpMap& vectorizedOps,
+                                              std::vector<mlir::BlockAndValueMapping>& laneMappings,
+                                              mlir::Value inductionVar,
+                                              int64_t step,
+                                              int64_t vectorSize);
+
 } // namespace accera::transforms
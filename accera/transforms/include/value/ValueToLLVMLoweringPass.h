@@ -7,6 +7,7 @@
 #pragma once
 
 #include <memory>
+#include <string>
 
 #include <transforms/include/util/SnapshotUtilities.h>
 
@@ -48,5 +49,7 @@ std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>> createValueToLLVMPass(bool
                                                                            unsigned indexBitwidth,
                                                                            bool useAlignedAlloc,
                                                                            llvm::DataLayout dataLayout,
+                                                                           const std::string& timer = "clock",
+                                                                           const std::string& targetTriple = {},
                                                                            const IntraPassSnapshotOptions& options = {});
 } // namespace accera::transforms::value
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <memory>
+#include <string>
 
 // fwd decls
 namespace mlir
@@ -27,5 +28,5 @@ void populateValueToStandardPatterns(bool enableProfiling, mlir::RewritePatternS
 void populateValueLaunchFuncPatterns(mlir::RewritePatternSet& patterns);
 void populateValueModuleRewritePatterns(mlir::RewritePatternSet& patterns);
 
-std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>> createValueToStdPass(bool enableProfiling = false);
+std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>> createValueToStdPass(bool enableProfiling = false, const std::string& profileCounters = {}, bool profileTrace = false);
 } // namespace accera::transforms::value
@@ -0,0 +1,330 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) Microsoft Corporation. All rights reserved.
+//  Licensed under the MIT License. See LICENSE in the project root for license information.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "AcceraCompiler.h"
+
+#include <ir/include/InitializeAccera.h>
+#include <ir/include/value/ValueDialect.h>
+
+#include <mlir/Dialect/LLVMIR/LLVMDialect.h>
+#include <mlir/ExecutionEngine/OptUtils.h>
+#include <mlir/IR/Dialect.h>
+#include <mlir/Pass/PassInstrumentation.h>
+#include <mlir/Pass/PassManager.h>
+#include <mlir/Target/LLVMIR/Dialect/All.h>
+#include <mlir/Target/LLVMIR/Export.h>
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/TargetRegistry.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Target/TargetOptions.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+
+#include <chrono>
+#include <map>
+#include <mutex>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace mlir;
+
+namespace
+{
+llvm::CodeGenOpt::Level GetCodeGenOptLevel(unsigned optimizationLevel)
+{
+    switch (optimizationLevel)
+    {
+    case 0:
+        return llvm::CodeGenOpt::None;
+    case 1:
+        return llvm::CodeGenOpt::Less;
+    case 2:
+        return llvm::CodeGenOpt::Default;
+    default:
+        return llvm::CodeGenOpt::Aggressive;
+    }
+}
+
+LogicalResult EmitFile(ModuleOp module, llvm::TargetMachine& targetMachine, llvm::Module& llvmModule, const std::string& filePath, llvm::CodeGenFileType fileType)
+{
+    std::error_code ec;
+    llvm::raw_fd_ostream stream(filePath, ec, llvm::sys::fs::OF_None);
+    if (ec)
+    {
+        return module.emitError("Unable to open ") << filePath << ": " << ec.message();
+    }
+
+    llvm::legacy::PassManager pm;
+    if (targetMachine.addPassesToEmitFile(pm, stream, nullptr, fileType))
+    {
+        return module.emitError("The target machine can't emit files of this type");
+    }
+    pm.run(llvmModule);
+    return success();
+}
+
+uint64_t GetPeakResidentBytes()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return static_cast<uint64_t>(usage.ru_maxrss); // bytes
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // kilobytes
+#endif
+#endif
+}
+
+// Records the wall-clock time of every pass run. Nested pass managers run in parallel over the
+// functions of a module, so the runs in flight are keyed by the pass instance and the op it runs on.
+class PassTimingInstrumentation : public PassInstrumentation
+{
+public:
+    PassTimingInstrumentation(std::vector<accera::transforms::PassTiming>& timings) :
+        _timings(timings) {}
+
+    void runBeforePass(Pass* pass, Operation* op) override
+    {
+        if (IsPassAdaptor(pass))
+        {
+            return;
+        }
+        auto start = Clock::now();
+        std::lock_guard<std::mutex> lock(_mutex);
+        _starts[{ pass, op }] = start;
+    }
+
+    void runAfterPass(Pass* pass, Operation* op) override { Record(pass, op); }
+
+    void runAfterPassFailed(Pass* pass, Operation* op) override { Record(pass, op); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Nested pass managers run as adaptor passes, whose time is the sum of the passes they run. The adaptor
+    // type is declared in a private MLIR header, so it's recognized by name.
+    static bool IsPassAdaptor(Pass* pass)
+    {
+        return pass->getName().endswith("OpToOpPassAdaptor");
+    }
+
+    void Record(Pass* pass, Operation* op)
+    {
+        if (IsPassAdaptor(pass))
+        {
+            return;
+        }
+        auto end = Clock::now();
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _starts.find({ pass, op });
+        if (it == _starts.end())
+        {
+            return;
+        }
+        std::chrono::duration<double> elapsed = end - it->second;
+        _timings.push_back({ pass->getName().str(), op->getName().getStringRef().str(), elapsed.count(), GetPeakResidentBytes() });
+        _starts.erase(it);
+    }
+
+    std::vector<accera::transforms::PassTiming>& _timings;
+    std::map<std::pair<Pass*, Operation*>, Clock::time_point> _starts;
+    std::mutex _mutex;
+};
+
+// The time trace profiler is per-thread, so it's scoped to the codegen call that runs on this thread
+struct TimeTraceProfile
+{
+    TimeTraceProfile(const std::optional<std::string>& filePath) :
+        filePath(filePath)
+    {
+        if (filePath)
+        {
+            llvm::timeTraceProfilerInitialize(/*TimeTraceGranularity=*/0, "accera");
+        }
+    }
+
+    ~TimeTraceProfile()
+    {
+        if (filePath)
+        {
+            llvm::timeTraceProfilerCleanup();
+        }
+    }
+
+    LogicalResult Write(ModuleOp module)
+    {
+        if (!filePath)
+        {
+            return success();
+        }
+
+        std::error_code ec;
+        llvm::raw_fd_ostream stream(*filePath, ec, llvm::sys::fs::OF_Text);
+        if (ec)
+        {
+            return module.emitError("Unable to open ") << *filePath << ": " << ec.message();
+        }
+        llvm::timeTraceProfilerWrite(stream);
+        return success();
+    }
+
+    std::optional<std::string> filePath;
+};
+} // namespace
+
+namespace accera::transforms
+{
+std::unique_ptr<PassInstrumentation> CreatePassTimingInstrumentation(std::vector<PassTiming>& timings)
+{
+    return std::make_unique<PassTimingInstrumentation>(timings);
+}
+
+void WritePassTimings(const std::vector<PassTiming>& timings, llvm::raw_ostream& os)
+{
+    llvm::json::OStream json(os, /*IndentSize=*/2);
+    json.array([&] {
+        for (const auto& timing : timings)
+        {
+            json.object([&] {
+                json.attribute("pass", timing.passName);
+                json.attribute("op", timing.opName);
+                json.attribute("seconds", timing.seconds);
+                json.attribute("peak_rss_bytes", static_cast<int64_t>(timing.peakResidentBytes));
+            });
+        }
+    });
+    os << "\n";
+}
+
+LogicalResult LowerToLLVMDialect(ModuleOp module, const AcceraPassPipelineOptions& options, std::vector<PassTiming>* passTimings)
+{
+    PassManager pm(module.getContext());
+
+    // Matches acc-opt's --verify-each=false
+    pm.enableVerifier(false);
+    if (passTimings)
+    {
+        pm.addInstrumentation(CreatePassTimingInstrumentation(*passTimings));
+    }
+    addAcceraToLLVMPassPipeline(pm, options);
+    return pm.run(module);
+}
+
+std::map<std::string, int64_t> GetScratchFootprints(ModuleOp module)
+{
+    std::map<std::string, int64_t> footprints;
+    module.walk([&](LLVM::LLVMFuncOp fnOp) {
+        if (auto footprintAttr = fnOp->getAttrOfType<IntegerAttr>(ir::ScratchFootprintAttrName))
+        {
+            footprints[fnOp.getName().str()] = footprintAttr.getInt();
+        }
+    });
+    return footprints;
+}
+
+LogicalResult EmitObjectFile(ModuleOp module,
+                             const value::TargetDevice& targetDevice,
+                             const CodeGenerationOptions& options,
+                             const std::string& objectFilePath,
+                             const std::optional<std::string>& asmFilePath)
+{
+    ir::InitializeAccera();
+
+    DialectRegistry registry;
+    registerAllToLLVMIRTranslations(registry);
+    module.getContext()->appendDialectRegistry(registry);
+
+    TimeTraceProfile timeTrace(options.timeTraceFilePath);
+
+    llvm::LLVMContext llvmContext;
+    std::unique_ptr<llvm::Module> llvmModule;
+    {
+        llvm::TimeTraceScope scope("TranslateToLLVMIR");
+        llvmModule = translateModuleToLLVMIR(module, llvmContext, module.getName().getValueOr("LLVMDialectModule"));
+    }
+    if (!llvmModule)
+    {
+        return module.emitError("Failed to translate the module to LLVM IR");
+    }
+
+    std::string error;
+    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(targetDevice.triple, error);
+    if (target == nullptr)
+    {
+        return module.emitError("Couldn't create target ") << error;
+    }
+
+    llvm::TargetOptions targetOptions;
+    if (options.fastFPContract)
+    {
+        targetOptions.AllowFPOpFusion = llvm::FPOpFusion::Fast;
+    }
+    std::unique_ptr<llvm::TargetMachine> targetMachine(target->createTargetMachine(targetDevice.triple,
+                                                                                   targetDevice.cpu,
+                                                                                   targetDevice.features,
+                                                                                   targetOptions,
+                                                                                   llvm::Reloc::PIC_,
+                                                                                   llvm::None,
+                                                                                   GetCodeGenOptLevel(options.optimizationLevel)));
+    if (!targetMachine)
+    {
+        return module.emitError("Unable to allocate target machine");
+    }
+    llvmModule->setTargetTriple(targetDevice.triple);
+    llvmModule->setDataLayout(targetMachine->createDataLayout());
+
+    auto optimize = makeOptimizingTransformer(options.optimizationLevel, options.sizeLevel, targetMachine.get());
+    {
+        llvm::TimeTraceScope scope("Optimize");
+        if (auto err = optimize(llvmModule.get()))
+        {
+            return module.emitError("Failed to optimize the LLVM IR: ") << llvm::toString(std::move(err));
+        }
+    }
+
+    // Code generation rewrites the IR it runs over, so the assembly listing is generated from a copy
+    if (asmFilePath)
+    {
+        llvm::TimeTraceScope scope("EmitAssembly");
+        auto asmModule = llvm::CloneModule(*llvmModule);
+        if (failed(EmitFile(module, *targetMachine, *asmModule, *asmFilePath, llvm::CGFT_AssemblyFile)))
+        {
+            return failure();
+        }
+    }
+    {
+        llvm::TimeTraceScope scope("EmitObject");
+        if (failed(EmitFile(module, *targetMachine, *llvmModule, objectFilePath, llvm::CGFT_ObjectFile)))
+        {
+            return failure();
+        }
+    }
+    return timeTrace.Write(module);
+}
+
+} // namespace accera::transforms
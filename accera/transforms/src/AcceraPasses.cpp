@@ -158,9 +158,11 @@ void addAcceraToLLVMPassPipeline(OpPassManager& pm, const AcceraPassPipelineOpti
     // Can't use ValueSimplify here because ExecToAffine doesn't know how to handle "simplified" ops (memref::SubView, etc.)
     // valueFuncOpPM.addPass(value::createValueSimplifyPass());
     valueFuncOpPM.addPass(createCanonicalizerPass());
-    valueFuncOpPM.addPass(loopnest::createLoopNestToValueFuncPass({ { options.dumpIntraPassIR.getValue(), options.basename + "LoopNestToValueFuncPass_Subpasses" }, options.printLoops.getValue(), options.printVecOpDetails.getValue() }));
+    valueFuncOpPM.addPass(loopnest::createLoopNestToValueFuncPass({ { options.dumpIntraPassIR.getValue(), options.basename + "LoopNestToValueFuncPass_Subpasses" }, options.printLoops.getValue(), options.printVecOpDetails.getValue(), options.instrumentProfile.getValue() }));
 
+    pmAdaptor.addPass(value::createMemoryPlanningPass());
     pmAdaptor.addPass(value::createValueFuncToTargetPass());
+    pmAdaptor.addPass(value::createWorkspaceAllocationPass());
     pmAdaptor.addPass(createSymbolDCEPass());
 
     auto funcOpPM = pmAdaptor.nestPassManager([&]() -> OpPassManager& { return pm.nest<v::ValueModuleOp>().nest<FuncOp>(); });
@@ -171,7 +173,8 @@ void addAcceraToLLVMPassPipeline(OpPassManager& pm, const AcceraPassPipelineOpti
     funcOpPM.addPass(createCSEPass());
     funcOpPM.addPass(createConvertSCFToOpenMPPass());
 
-    pmAdaptor.addPass(value::createValueToStdPass(options.enableProfile));
+    // Instrumented and traced profile regions are only useful if they're timed
+    pmAdaptor.addPass(value::createValueToStdPass(options.enableProfile || options.instrumentProfile || options.profileTrace, options.profileCounters, options.profileTrace));
     funcOpPM.addPass(value::createBarrierOptPass(options.writeBarrierGraph.getValue(), options.barrierGraphFilename.getValue()));
     pmAdaptor.addPass(value::createRangeValueOptimizePass());
     pmAdaptor.addPass(createCanonicalizerPass());
@@ -251,7 +254,13 @@ void addAcceraToLLVMPassPipeline(OpPassManager& pm, const AcceraPassPipelineOpti
         /* indexBitwidth = */ kDeriveIndexBitwidthFromDataLayout,
         /* useAlignedAlloc = */ true,
         /* dataLayout = */ llvm::DataLayout(accera::value::GetTargetDevice(options.target).dataLayout),
+        /* timer = */ options.timer,
+        /* targetTriple = */ accera::value::GetTargetDevice(options.target).triple,
         { options.dumpIntraPassIR.getValue(), options.basename + "ValueToLLVM_Subpasses" }));
+    if (execRuntime == accera::value::ExecutionRuntime::THREAD_POOL)
+    {
+        pmAdaptor.addPass(value::createThreadPoolLoweringPass());
+    }
     pmAdaptor.addPass(createCanonicalizerPass());
     pmAdaptor.addPass(LLVM::createLegalizeForExportPass());
     pmAdaptor.addPass(value::createFunctionPointerResolutionPass());
@@ -23,6 +23,7 @@
 #include <utilities/include/TypeTraits.h>
 
 #include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/SetVector.h>
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/TypeSwitch.h>
 #include <llvm/Support/Casting.h>
@@ -45,6 +46,7 @@
 #include <mlir/IR/Dominance.h>
 #include <mlir/IR/Identifier.h>
 #include <mlir/IR/IntegerSet.h>
+#include <mlir/IR/Matchers.h>
 #include <mlir/IR/Operation.h>
 #include <mlir/Pass/Pass.h>
 #include <mlir/Support/LLVM.h>
@@ -57,6 +59,7 @@
 #include <algorithm>
 #include <map>
 #include <numeric>
+#include <optional>
 #include <queue>
 #include <stack>
 #include <stdexcept>
@@ -81,6 +84,7 @@ namespace
 const std::string BoundsCheckedAttrName = "accxp_bounds_checked";
 const std::string BaseArrayAccessMapAttrName = "accxp_base_array_access_map";
 const std::string BaseArrayAccessIndicesAttrName = "accxp_base_array_access_indices";
+const std::string NumaFirstTouchedAttrName = "accxp_numa_first_touched";
 
 // These strings are used to create predictable index names for internally-generated GPU-related loops
 // for the purposes of cache accesses. MakeCacheOps identify the loop indices to look for and combine those
@@ -103,6 +107,9 @@ const std::string ThreadZIndexName = "accxp_thread_z_loop_index";
 const std::string UnswitchPrefixItersName = "accxp_unswitch_prefix_iters";
 const std::string UnswitchSuffixItersName = "accxp_unswitch_suffix_iters";
 
+// Marks a MultiCacheCopyOp that only prefetches the array data of its active blocks rather than copying it
+const std::string CachePrefetchAttrName = "accxp_cache_prefetch";
+
 GPUIndexDimension GPUProcessorToDim(v::Processor gpuProc)
 {
     switch (gpuProc)
@@ -287,6 +294,10 @@ struct VectorizeAffineForOpConversion : public OpRewritePattern<AffineForOp>
                              std::vector<BlockAndValueMapping>& laneMappings,
                              int64_t step,
                              int64_t unrollMax) const;
+    LogicalResult vectorizeMaskedTail(PatternRewriter& rewriter,
+                                      AffineForOp affineForOp,
+                                      const VectorizationInfo& vectorInfo,
+                                      int64_t numIters) const;
 
     bool printVectorizationDetails = false;
 };
@@ -311,6 +322,14 @@ struct TensorizeAffineForOpConversion : public OpRewritePattern<AffineForOp>
     LogicalResult matchAndRewrite(AffineForOp affineForOp, PatternRewriter& rewriter) const final;
 };
 
+// Rewrites an (i, j, k) int8 matmul nest tensorized with a CPU MMA shape into an int8 dot-product micro-kernel
+struct CPUTensorizeAffineForOpConversion : public OpRewritePattern<AffineForOp>
+{
+    using OpRewritePattern<AffineForOp>::OpRewritePattern;
+
+    LogicalResult matchAndRewrite(AffineForOp affineForOp, PatternRewriter& rewriter) const final;
+};
+
 struct ParallelizeAffineForOpConversion : public OpRewritePattern<AffineForOp>
 {
     using OpRewritePattern<AffineForOp>::OpRewritePattern;
@@ -325,6 +344,13 @@ struct CollapseAffineParallelOpsRewrite : public OpRewritePattern<AffineParallel
     LogicalResult matchAndRewrite(AffineParallelOp affineParallelOp, PatternRewriter& rewriter) const final;
 };
 
+struct AffineParallelThreadAffinityRewrite : public OpRewritePattern<AffineParallelOp>
+{
+    using OpRewritePattern<AffineParallelOp>::OpRewritePattern;
+
+    LogicalResult matchAndRewrite(AffineParallelOp affineParallelOp, PatternRewriter& rewriter) const final;
+};
+
 struct HoistScalingToCacheReduceRewrite : public OpRewritePattern<mlir::AffineStoreOp>
 {
     using OpRewritePattern<mlir::AffineStoreOp>::OpRewritePattern;
@@ -600,6 +626,416 @@ ParallelizationInfo GetParallelizationInfo(Operation* op)
     return parallelizationInfoAttr.getValue();
 }
 
+void RemoveParallelizationInfo(Operation* op)
+{
+    OpBuilder builder(op);
+    auto parallelizationInfoIdentifier = builder.getIdentifier(ParallelizationInfoAttr::getKeyName());
+    op->removeAttr(parallelizationInfoIdentifier);
+}
+
+// Returns true if the thread placement requested by the parallelization info cannot be expressed with OpenMP's proc_bind clause alone
+bool RequiresRuntimeThreadPlacement(const ParallelizationInfo& parallelizationInfo)
+{
+    return parallelizationInfo.numaFirstTouch ||
+           parallelizationInfo.affinity == ParallelizationAffinity::Socket ||
+           parallelizationInfo.affinity == ParallelizationAffinity::Explicit;
+}
+
+// Sets the OpenMP clauses and the thread placement for a parallel op
+void SetParallelizationAttributes(AffineParallelOp parallelOp, const ParallelizationInfo& parallelizationInfo, OpBuilder& builder)
+{
+    // cf. mlir\lib\Conversion\SCFToOpenMP\SCFToOpenMP.cpp
+    parallelOp->setAttr(mlir::omp::getNumThreadsAttrName(), builder.getI64IntegerAttr(parallelizationInfo.numThreads));
+
+    // Valid clause values: llvm\include\llvm\Frontend\OpenMP\OMP.td
+    parallelOp->setAttr(mlir::omp::getScheduleAttrName(), builder.getStringAttr(parallelizationInfo.isDynamicPolicy ? "Dynamic" : "Static"));
+    // Per-socket grouping and explicit core lists are layered on top of proc_bind by AffineParallelThreadAffinityRewrite
+    parallelOp->setAttr(mlir::omp::getProcBindAttrName(), builder.getStringAttr(parallelizationInfo.affinity == ParallelizationAffinity::Spread ? "spread" : "close"));
+    if (RequiresRuntimeThreadPlacement(parallelizationInfo))
+    {
+        parallelOp->setAttr(ParallelizationInfoAttr::getKeyName(), ParallelizationInfoAttr::get(parallelizationInfo, builder.getContext()));
+    }
+}
+
+// Parallel reduction functions
+
+enum class ParallelReductionKind
+{
+    Sum,
+    Product,
+};
+
+// An array that a parallelized loop accumulates into at positions that do not depend on the loop's induction variable
+struct ParallelReductionInfo
+{
+    mlir::Value array;
+    ParallelReductionKind kind;
+    std::vector<mlir::Operation*> accesses; // the loads and stores of the array inside of the loop
+
+    // For each dimension of the array, the index that every access uses (a constant or a value defined outside of
+    // the loop), or null if the accesses cover a range of the dimension. The private accumulators only hold the
+    // positions that the loop accesses, so these dimensions have a size of 1 in them.
+    std::vector<mlir::OpFoldResult> fixedPositions;
+};
+
+// The private accumulators of a parallel reduction are allocated on the stack up to this size, and on the heap beyond it
+const int64_t MaxStackReductionAccumulatorBytes = 64 * 1024;
+
+bool IsPrivatizableStoreOp(mlir::Operation* op)
+{
+    return isa<mlir::AffineStoreOp, memref::StoreOp, vector::StoreOp>(op);
+}
+
+bool IsPrivatizableLoadOp(mlir::Operation* op)
+{
+    return isa<mlir::AffineLoadOp, memref::LoadOp, vector::LoadOp>(op);
+}
+
+// Returns the memref and the index operands of an access that can be redirected to a private accumulator
+std::pair<mlir::Value, mlir::ValueRange> GetPrivatizableAccessMemRefAndIndices(mlir::Operation* op)
+{
+    return llvm::TypeSwitch<mlir::Operation*, std::pair<mlir::Value, mlir::ValueRange>>(op)
+        .Case([](mlir::AffineLoadOp loadOp) { return std::make_pair(loadOp.getMemRef(), mlir::ValueRange{ loadOp.getMapOperands() }); })
+        .Case([](mlir::AffineStoreOp storeOp) { return std::make_pair(storeOp.getMemRef(), mlir::ValueRange{ storeOp.getMapOperands() }); })
+        .Case([](memref::LoadOp loadOp) { return std::make_pair(loadOp.memref(), mlir::ValueRange{ loadOp.indices() }); })
+        .Case([](memref::StoreOp storeOp) { return std::make_pair(storeOp.memref(), mlir::ValueRange{ storeOp.indices() }); })
+        .Case([](vector::LoadOp loadOp) { return std::make_pair(loadOp.base(), mlir::ValueRange{ loadOp.indices() }); })
+        .Case([](vector::StoreOp storeOp) { return std::make_pair(storeOp.base(), mlir::ValueRange{ storeOp.indices() }); })
+        .Default([](mlir::Operation*) { return std::make_pair(mlir::Value{}, mlir::ValueRange{}); });
+}
+
+mlir::Value GetStoredValue(mlir::Operation* storeOp)
+{
+    return llvm::TypeSwitch<mlir::Operation*, mlir::Value>(storeOp)
+        .Case([](mlir::AffineStoreOp op) { return op.getValueToStore(); })
+        .Case([](memref::StoreOp op) { return op.value(); })
+        .Case([](vector::StoreOp op) { return op.valueToStore(); })
+        .Default([](mlir::Operation*) { return mlir::Value{}; });
+}
+
+bool IsSameAccessPosition(mlir::Operation* loadOp, mlir::Operation* storeOp)
+{
+    auto [loadMemRef, loadIndices] = GetPrivatizableAccessMemRefAndIndices(loadOp);
+    auto [storeMemRef, storeIndices] = GetPrivatizableAccessMemRefAndIndices(storeOp);
+    if (loadMemRef != storeMemRef || !std::equal(loadIndices.begin(), loadIndices.end(), storeIndices.begin(), storeIndices.end()))
+    {
+        return false;
+    }
+    if (auto affineLoadOp = dyn_cast<mlir::AffineLoadOp>(loadOp))
+    {
+        auto affineStoreOp = dyn_cast<mlir::AffineStoreOp>(storeOp);
+        return affineStoreOp && affineLoadOp.getAffineMap() == affineStoreOp.getAffineMap();
+    }
+    return !isa<mlir::AffineStoreOp>(storeOp) || cast<mlir::AffineStoreOp>(storeOp).getAffineMap().isIdentity();
+}
+
+// Returns true if the value is computed from the loop's induction variable. The results are memoized in `dependsOnIV`,
+// so that it can be shared by the queries of several accesses whose indices are computed from common values.
+bool DependsOnInductionVar(mlir::Value value, mlir::AffineForOp loop, llvm::DenseMap<mlir::Value, bool>& dependsOnIV)
+{
+    if (value == loop.getInductionVar())
+    {
+        return true;
+    }
+    if (auto it = dependsOnIV.find(value); it != dependsOnIV.end())
+    {
+        return it->second;
+    }
+
+    // Values defined inside of the loop depend on the induction variable through the operands of their
+    // defining op, or for block arguments (e.g. the induction variables of nested loops), of their parent op
+    mlir::Operation* ownerOp = nullptr;
+    if (auto blockArg = value.dyn_cast<mlir::BlockArgument>())
+    {
+        ownerOp = blockArg.getOwner()->getParentOp();
+    }
+    else
+    {
+        ownerOp = value.getDefiningOp();
+    }
+    if (!ownerOp || !loop->isProperAncestor(ownerOp))
+    {
+        dependsOnIV[value] = false;
+        return false;
+    }
+
+    // Entered before recursing, in case the operands lead back to this value
+    dependsOnIV[value] = false;
+    auto result = llvm::any_of(ownerOp->getOperands(), [&](mlir::Value operand) { return DependsOnInductionVar(operand, loop, dependsOnIV); });
+    dependsOnIV[value] = result;
+    return result;
+}
+
+// Returns the kind of reduction if storing the value into the array is an accumulation, e.g.:
+//   %0 = affine.load %array[%i, %j]
+//   %1 = accv.bin_op "ADD" %0, %x
+//   affine.store %1, %array[%i, %j]
+std::optional<ParallelReductionKind> GetAccumulationKind(mlir::Operation* storeOp)
+{
+    auto accumulateOp = GetStoredValue(storeOp).getDefiningOp();
+    if (!accumulateOp || accumulateOp->getNumOperands() != 2)
+    {
+        return std::nullopt;
+    }
+
+    std::optional<ParallelReductionKind> kind;
+    if (auto binOp = dyn_cast<v::BinOp>(accumulateOp))
+    {
+        if (binOp.predicate() == v::BinaryOpPredicate::ADD)
+        {
+            kind = ParallelReductionKind::Sum;
+        }
+        else if (binOp.predicate() == v::BinaryOpPredicate::MUL)
+        {
+            kind = ParallelReductionKind::Product;
+        }
+    }
+    else if (isa<mlir::AddFOp, mlir::AddIOp>(accumulateOp))
+    {
+        kind = ParallelReductionKind::Sum;
+    }
+    else if (isa<mlir::MulFOp, mlir::MulIOp>(accumulateOp))
+    {
+        kind = ParallelReductionKind::Product;
+    }
+    if (!kind)
+    {
+        return std::nullopt;
+    }
+
+    for (auto operand : accumulateOp->getOperands())
+    {
+        if (auto loadOp = operand.getDefiningOp(); loadOp && IsPrivatizableLoadOp(loadOp) && IsSameAccessPosition(loadOp, storeOp))
+        {
+            return kind;
+        }
+    }
+    return std::nullopt;
+}
+
+// Returns, for each dimension of the array that the op accesses, the index that it uses if that index is a constant or a
+// value defined outside of the loop, or null otherwise
+std::vector<mlir::OpFoldResult> GetLoopInvariantAccessPositions(mlir::Operation* accessOp, mlir::AffineForOp loop)
+{
+    auto getPosition = [&](mlir::Value index) -> mlir::OpFoldResult {
+        mlir::Attribute constant;
+        if (matchPattern(index, m_Constant(&constant)))
+        {
+            return constant;
+        }
+        auto ownerOp = index.isa<mlir::BlockArgument>() ? index.cast<mlir::BlockArgument>().getOwner()->getParentOp() : index.getDefiningOp();
+        return ownerOp && loop->isAncestor(ownerOp) ? mlir::OpFoldResult{} : mlir::OpFoldResult{ index };
+    };
+
+    std::vector<mlir::OpFoldResult> positions;
+    if (auto affineLoadOp = dyn_cast<mlir::AffineLoadOp>(accessOp); affineLoadOp || isa<mlir::AffineStoreOp>(accessOp))
+    {
+        auto map = affineLoadOp ? affineLoadOp.getAffineMap() : cast<mlir::AffineStoreOp>(accessOp).getAffineMap();
+        auto operands = GetPrivatizableAccessMemRefAndIndices(accessOp).second;
+        for (auto expr : map.getResults())
+        {
+            if (auto constantExpr = expr.dyn_cast<mlir::AffineConstantExpr>())
+            {
+                positions.push_back(mlir::IntegerAttr::get(mlir::IndexType::get(loop.getContext()), constantExpr.getValue()));
+            }
+            else if (auto dimExpr = expr.dyn_cast<mlir::AffineDimExpr>())
+            {
+                positions.push_back(getPosition(operands[dimExpr.getPosition()]));
+            }
+            else if (auto symbolExpr = expr.dyn_cast<mlir::AffineSymbolExpr>())
+            {
+                positions.push_back(getPosition(operands[map.getNumDims() + symbolExpr.getPosition()]));
+            }
+            else
+            {
+                positions.push_back({});
+            }
+        }
+        return positions;
+    }
+
+    for (auto index : GetPrivatizableAccessMemRefAndIndices(accessOp).second)
+    {
+        positions.push_back(getPosition(index));
+    }
+    if (isa<vector::LoadOp, vector::StoreOp>(accessOp) && !positions.empty())
+    {
+        // Vector accesses cover a range of the innermost dimension
+        positions.back() = {};
+    }
+    return positions;
+}
+
+// Finds the arrays that the loop accumulates into at positions that do not depend on its induction variable.
+// Returns failure if an array is written to at such positions in a way that cannot be privatized, e.g. because
+// it is not a sum or a product, or because the array is also accessed by ops other than loads and stores.
+LogicalResult GetParallelReductions(mlir::AffineForOp loop, std::vector<ParallelReductionInfo>& reductions)
+{
+    llvm::DenseMap<mlir::Value, bool> dependsOnIV;
+    auto dependsOnInductionVar = [&](mlir::ValueRange indices) {
+        return llvm::any_of(indices, [&](mlir::Value index) { return DependsOnInductionVar(index, loop, dependsOnIV); });
+    };
+
+    llvm::SetVector<mlir::Value> reducedArrays;
+    loop.getBody()->walk([&](mlir::Operation* op) {
+        if (IsPrivatizableStoreOp(op))
+        {
+            auto [array, indices] = GetPrivatizableAccessMemRefAndIndices(op);
+            if (!loop.region().isAncestor(array.getParentRegion()) && !dependsOnInductionVar(indices))
+            {
+                reducedArrays.insert(array);
+            }
+        }
+    });
+
+    for (auto array : reducedArrays)
+    {
+        auto arrayType = array.getType().dyn_cast<MemRefType>();
+        if (!arrayType || !arrayType.hasStaticShape())
+        {
+            return failure();
+        }
+
+        ParallelReductionInfo reduction{ array, ParallelReductionKind::Sum, {} };
+        std::optional<ParallelReductionKind> kind;
+        llvm::DenseSet<mlir::Operation*> accumulateOps;
+        std::vector<mlir::Operation*> loadOps;
+        for (auto user : array.getUsers())
+        {
+            if (!loop->isProperAncestor(user))
+            {
+                continue;
+            }
+
+            auto [accessArray, indices] = GetPrivatizableAccessMemRefAndIndices(user);
+            if (accessArray != array || dependsOnInductionVar(indices))
+            {
+                return failure();
+            }
+
+            if (IsPrivatizableStoreOp(user))
+            {
+                auto storeKind = GetAccumulationKind(user);
+                if (!storeKind || (kind && *kind != *storeKind))
+                {
+                    return failure();
+                }
+                kind = storeKind;
+                auto accumulateOp = GetStoredValue(user).getDefiningOp();
+                if (!llvm::all_of(accumulateOp->getUsers(), [&](mlir::Operation* accumulateUser) {
+                        return IsPrivatizableStoreOp(accumulateUser) && GetPrivatizableAccessMemRefAndIndices(accumulateUser).first == array;
+                    }))
+                {
+                    return failure();
+                }
+                accumulateOps.insert(accumulateOp);
+            }
+            else
+            {
+                loadOps.push_back(user);
+            }
+            reduction.accesses.push_back(user);
+        }
+
+        // The partial values held by the private accumulators may only be used to accumulate into them, at the
+        // position they were loaded from: any other load, e.g. of S[1] in S[0] = S[0] + S[1], would read the
+        // identity value of the private accumulator instead of the data
+        for (auto loadOp : loadOps)
+        {
+            if (!llvm::all_of(loadOp->getUsers(), [&](mlir::Operation* loadUser) {
+                    return accumulateOps.count(loadUser) != 0 &&
+                           llvm::all_of(loadUser->getUsers(), [&](mlir::Operation* storeOp) { return IsSameAccessPosition(loadOp, storeOp); });
+                }))
+            {
+                return failure();
+            }
+        }
+
+        reduction.kind = *kind;
+        reduction.fixedPositions.assign(arrayType.getRank(), mlir::OpFoldResult{});
+        for (auto it = reduction.accesses.begin(); it != reduction.accesses.end(); ++it)
+        {
+            auto positions = GetLoopInvariantAccessPositions(*it, loop);
+            for (unsigned dim = 0; dim < positions.size(); ++dim)
+            {
+                if (it == reduction.accesses.begin())
+                {
+                    reduction.fixedPositions[dim] = positions[dim];
+                }
+                else if (reduction.fixedPositions[dim] != positions[dim])
+                {
+                    reduction.fixedPositions[dim] = {};
+                }
+            }
+        }
+        reductions.push_back(reduction);
+    }
+
+    return success();
+}
+
+// Returns (t, d0, ..., dn)[s...] -> (t, f(d0, ..., dn)[s...]) for map (d0, ..., dn)[s...] -> f(d0, ..., dn)[s...],
+// with the results of the dimensions that have a fixed position replaced by 0
+mlir::AffineMap PrependThreadIndexToMap(mlir::AffineMap map, llvm::ArrayRef<mlir::OpFoldResult> fixedPositions)
+{
+    auto* context = map.getContext();
+    SmallVector<mlir::AffineExpr, 4> results{ mlir::getAffineDimExpr(0, context) };
+    for (unsigned dim = 0; dim < map.getNumResults(); ++dim)
+    {
+        results.push_back(fixedPositions[dim] ? mlir::getAffineConstantExpr(0, context) : map.getResult(dim).shiftDims(map.getNumDims(), 1));
+    }
+    return mlir::AffineMap::get(map.getNumDims() + 1, map.getNumSymbols(), results, context);
+}
+
+// Redirects a load or store of a reduced array to the private accumulator of the thread
+void RedirectToPrivateAccumulator(mlir::Operation* accessOp, mlir::Value privateAccumulator, llvm::ArrayRef<mlir::OpFoldResult> fixedPositions, mlir::Value threadIndex, PatternRewriter& rewriter)
+{
+    OpBuilder::InsertionGuard guard(rewriter);
+    rewriter.setInsertionPoint(accessOp);
+    auto loc = accessOp->getLoc();
+    auto prependThreadIndex = [&](mlir::ValueRange indices) {
+        SmallVector<mlir::Value, 4> result{ threadIndex };
+        result.append(indices.begin(), indices.end());
+        return result;
+    };
+
+    // The private accumulators only hold the positions that the loop accesses, so the dimensions with a fixed position are accessed at 0
+    auto getAccumulatorIndices = [&](mlir::ValueRange indices) {
+        SmallVector<mlir::Value, 4> result{ threadIndex };
+        for (unsigned dim = 0; dim < indices.size(); ++dim)
+        {
+            result.push_back(fixedPositions[dim] ? rewriter.create<ConstantIndexOp>(loc, 0).getResult() : indices[dim]);
+        }
+        return result;
+    };
+
+    llvm::TypeSwitch<mlir::Operation*>(accessOp)
+        .Case([&](mlir::AffineLoadOp op) {
+            rewriter.replaceOpWithNewOp<mlir::AffineLoadOp>(op, privateAccumulator, PrependThreadIndexToMap(op.getAffineMap(), fixedPositions), prependThreadIndex(op.getMapOperands()));
+        })
+        .Case([&](mlir::AffineStoreOp op) {
+            rewriter.replaceOpWithNewOp<mlir::AffineStoreOp>(op, op.getValueToStore(), privateAccumulator, PrependThreadIndexToMap(op.getAffineMap(), fixedPositions), prependThreadIndex(op.getMapOperands()));
+        })
+        .Case([&](memref::LoadOp op) {
+            rewriter.replaceOpWithNewOp<memref::LoadOp>(op, privateAccumulator, getAccumulatorIndices(op.indices()));
+        })
+        .Case([&](memref::StoreOp op) {
+            rewriter.replaceOpWithNewOp<memref::StoreOp>(op, op.value(), privateAccumulator, getAccumulatorIndices(op.indices()));
+        })
+        .Case([&](vector::LoadOp op) {
+            rewriter.replaceOpWithNewOp<vector::LoadOp>(op, op.getVectorType(), privateAccumulator, getAccumulatorIndices(op.indices()));
+        })
+        .Case([&](vector::StoreOp op) {
+            rewriter.replaceOpWithNewOp<vector::StoreOp>(op, op.valueToStore(), privateAccumulator, getAccumulatorIndices(op.indices()));
+        })
+        .Default([](mlir::Operation*) { llvm_unreachable("Unexpected reduction array access"); });
+}
+
+mlir::Value CreateReductionCombineOp(OpBuilder& builder, Location loc, ParallelReductionKind kind, mlir::Value lhs, mlir::Value rhs)
+{
+    return builder.create<v::BinOp>(loc, kind == ParallelReductionKind::Sum ? BinaryOpPredicate::ADD : BinaryOpPredicate::MUL, lhs, rhs);
+}
+
 bool IsTerminalOp(mlir::Operation* op)
 {
     // TODO: change this to also look for terminator ops
@@ -1941,6 +2377,89 @@ StoreOp CreateStore(mlir::OpBuilder& builder,
     }
 }
 
+// Convert a value loaded from an array or cache to the element type of the buffer it is being copied into.
+// f16 is converted with fpext / fptrunc, which LLVM lowers to vcvtph2ps / vcvtps2ph when F16C is available.
+// bf16 has no widening instruction: it is the upper half of an f32, so it is widened with a zero-extend and shift
+// and narrowed with round-to-nearest-even integer arithmetic that keeps NaNs NaNs. These are all elementwise ops
+// that vectorize along with the rest of the cache copy loop.
+mlir::Value ConvertCacheElementType(mlir::OpBuilder& builder, mlir::Location loc, mlir::Value value, mlir::Type dstType)
+{
+    auto srcType = value.getType();
+    if (srcType == dstType)
+    {
+        return value;
+    }
+
+    auto srcFloatType = srcType.dyn_cast<mlir::FloatType>();
+    auto dstFloatType = dstType.dyn_cast<mlir::FloatType>();
+    assert(srcFloatType && dstFloatType && "Cache element type conversion is only supported between floating point types");
+
+    auto i16Type = builder.getIntegerType(16);
+    auto i32Type = builder.getIntegerType(32);
+    auto f32Type = builder.getF32Type();
+    if (srcFloatType.isBF16())
+    {
+        mlir::Value bits = builder.create<mlir::BitcastOp>(loc, i16Type, value);
+        mlir::Value widenedBits = builder.create<mlir::ZeroExtendIOp>(loc, bits, i32Type);
+        mlir::Value shift = builder.create<mlir::ConstantIntOp>(loc, 16, i32Type);
+        mlir::Value shiftedBits = builder.create<mlir::ShiftLeftOp>(loc, widenedBits, shift);
+        mlir::Value f32Value = builder.create<mlir::BitcastOp>(loc, f32Type, shiftedBits);
+        return ConvertCacheElementType(builder, loc, f32Value, dstType);
+    }
+    if (dstFloatType.isBF16())
+    {
+        mlir::Value f32Value = ConvertCacheElementType(builder, loc, value, f32Type);
+        mlir::Value bits = builder.create<mlir::BitcastOp>(loc, i32Type, f32Value);
+        mlir::Value shift = builder.create<mlir::ConstantIntOp>(loc, 16, i32Type);
+        mlir::Value one = builder.create<mlir::ConstantIntOp>(loc, 1, i32Type);
+        mlir::Value roundingBias = builder.create<mlir::ConstantIntOp>(loc, 0x7fff, i32Type);
+        mlir::Value upperBits = builder.create<mlir::UnsignedShiftRightOp>(loc, bits, shift);
+        mlir::Value lsb = builder.create<mlir::AndOp>(loc, upperBits, one);
+        mlir::Value bias = builder.create<mlir::AddIOp>(loc, roundingBias, lsb);
+        mlir::Value roundedBits = builder.create<mlir::AddIOp>(loc, bits, bias);
+        mlir::Value roundedUpperBits = builder.create<mlir::UnsignedShiftRightOp>(loc, roundedBits, shift);
+
+        // Rounding a NaN could carry into the exponent and produce an infinity, so NaNs are truncated instead and
+        // made quiet, which keeps them NaNs even when their payload is all in the lower 16 bits
+        mlir::Value quietBit = builder.create<mlir::ConstantIntOp>(loc, 0x40, i32Type);
+        mlir::Value quietNaNBits = builder.create<mlir::OrOp>(loc, upperBits, quietBit);
+        mlir::Value isNaN = builder.create<mlir::CmpFOp>(loc, mlir::CmpFPredicate::UNO, f32Value, f32Value);
+        mlir::Value resultBits = builder.create<mlir::SelectOp>(loc, isNaN, quietNaNBits, roundedUpperBits);
+        mlir::Value narrowedBits = builder.create<mlir::TruncateIOp>(loc, resultBits, i16Type);
+        return builder.create<mlir::BitcastOp>(loc, dstType, narrowedBits);
+    }
+
+    if (srcFloatType.getWidth() < dstFloatType.getWidth())
+    {
+        return builder.create<mlir::FPExtOp>(loc, value, dstType);
+    }
+    return builder.create<mlir::FPTruncOp>(loc, value, dstType);
+}
+
+// Replace the uses of a load from an array with a value loaded from a cache that may hold the data in a different
+// element type. Conversions of the loaded value to the cache element type, e.g. a bf16 -> f32 fpext in the kernel,
+// are folded away and any remaining users receive the cached value converted back to the array element type
+void ReplaceLoadWithCacheLoad(mlir::PatternRewriter& rewriter, mlir::Location loc, mlir::Operation* loadOp, mlir::Value cacheLoadValue)
+{
+    auto loadedValue = loadOp->getResult(0);
+    if (loadedValue.getType() != cacheLoadValue.getType())
+    {
+        for (auto user : llvm::make_early_inc_range(loadedValue.getUsers()))
+        {
+            if (mlir::isa<mlir::FPExtOp, mlir::FPTruncOp>(user) && user->getResult(0).getType() == cacheLoadValue.getType())
+            {
+                rewriter.replaceOp(user, cacheLoadValue);
+            }
+        }
+        if (loadedValue.use_empty())
+        {
+            return;
+        }
+        cacheLoadValue = ConvertCacheElementType(rewriter, loc, cacheLoadValue, loadedValue.getType());
+    }
+    loadedValue.replaceAllUsesWith(cacheLoadValue);
+}
+
 // Create an MMALoadSyncOp that understands how to access caches
 v::MMALoadSyncOp CreateMMALoad(mlir::OpBuilder& builder,
                                mlir::Location loc,
@@ -2327,6 +2846,10 @@ LogicalResult MakeCacheOpLowering::matchAndRewrite(MakeCacheOp makeCacheOp, Patt
         else
         {
             cacheGlobalBuffer = util::CreateGlobalBuffer(rewriter, makeCacheOp, cacheType, "cache");
+
+            // The cache contents only live for the duration of a call, so memory planning may share its storage
+            auto globalOp = cacheGlobalBuffer.getDefiningOp<v::ReferenceGlobalOp>().getGlobal();
+            globalOp->setAttr(ScratchBufferAttrName, rewriter.getUnitAttr());
         }
     }
     else
@@ -2545,6 +3068,36 @@ LogicalResult MultiCacheCopyOpRewrite::matchAndRewrite(MultiCacheCopyOp multiCac
         return success();
     }
 
+    if (multiCacheCopyOp->hasAttr(CachePrefetchAttrName))
+    {
+        // Only prefetch the array data of each active block, touching one element per cache line
+        auto lbMaps = util::ArrayAttrToVector<mlir::AffineMap, mlir::AffineMapAttr>(adaptor.activeBlockLowerBoundMaps(), [](const mlir::AffineMapAttr& mapAttr) -> mlir::AffineMap {
+            return mapAttr.getValue();
+        });
+        auto ubMaps = util::ArrayAttrToVector<mlir::AffineMap, mlir::AffineMapAttr>(adaptor.activeBlockUpperBoundMaps(), [](const mlir::AffineMapAttr& mapAttr) -> mlir::AffineMap {
+            return mapAttr.getValue();
+        });
+        auto array = multiCacheCopyOp.array();
+        auto elementByteWidth = std::max<int64_t>(1, array.getType().cast<mlir::MemRefType>().getElementTypeBitWidth() / 8);
+        auto elementsPerCacheLine = std::max<int64_t>(1, CacheLineBytes / elementByteWidth);
+
+        CreateMultiCacheLoops(rewriter, multiCacheCopyOp, [&](mlir::OpBuilder& currentBuilder, const MultiCacheLoopInfo& info) {
+            std::vector<mlir::Value> prefetchIVs;
+            mlir::OpBuilder loopBuilder = currentBuilder;
+            for (unsigned arrayDim = 0; arrayDim < lbMaps.size(); ++arrayDim)
+            {
+                auto step = arrayDim + 1 == lbMaps.size() ? elementsPerCacheLine : 1;
+                auto forOp = mlir::createCanonicalizedAffineForOp(loopBuilder, loc, info.activeBlockExternalSymbols, lbMaps[arrayDim], info.activeBlockExternalSymbols, ubMaps[arrayDim], step);
+                loopBuilder = mlir::OpBuilder::atBlockTerminator(forOp.getBody());
+                prefetchIVs.push_back(forOp.getInductionVar());
+            }
+            loopBuilder.create<mlir::memref::PrefetchOp>(loc, array, prefetchIVs, /*isWrite=*/false, /*localityHint=*/3, /*isDataCache=*/true);
+        });
+
+        rewriter.eraseOp(multiCacheCopyOp);
+        return success();
+    }
+
     MultiCacheLoopInfo multiCacheInfo = CreateMultiCacheLoops(rewriter, multiCacheCopyOp, [&](mlir::OpBuilder& currentBuilder, const MultiCacheLoopInfo& info) {
         currentBuilder.create<ActiveBlockCacheCopyOp>(loc,
                                                       multiCacheCopyOp.array(),
@@ -2595,7 +3148,7 @@ LogicalResult ActiveBlockCacheCopyOpRewrite::matchAndRewrite(ActiveBlockCacheCop
     assert(array.getType().isa<MemRefType>());
     auto memRefType = array.getType().cast<MemRefType>();
     unsigned outerArrayMemRefSpace = memRefType.getMemorySpaceAsInt();
-    [[maybe_unused]] auto baseArrayElementType = GetInnerElementType(array); // e.g. f32
+    auto baseArrayElementType = GetInnerElementType(array); // e.g. bf16
     unsigned outerArrayRank = memRefType.getRank();
 
     auto elementBitWidth = memRefType.getElementTypeBitWidth();
@@ -2608,7 +3161,8 @@ LogicalResult ActiveBlockCacheCopyOpRewrite::matchAndRewrite(ActiveBlockCacheCop
     auto baseCacheElementType = GetInnerElementType(cache); // e.g. f32
     [[maybe_unused]] unsigned fullCacheRank = cacheMemRefType.getRank();
 
-    assert(baseArrayElementType == baseCacheElementType && "Copy source and dest data types don't match");
+    // The cache may hold the array data in a different precision, in which case the element type conversion
+    // is fused into the copy
 
     bool arrayToCache = cacheCopyOp.toCache();
 
@@ -2783,12 +3337,14 @@ LogicalResult ActiveBlockCacheCopyOpRewrite::matchAndRewrite(ActiveBlockCacheCop
                 if (arrayToCache)
                 {
                     mlir::Value loadedValue = CreateLoad(currentBuilder, loc, array, lowerBoundOffsetIVs);
-                    CreateStore(currentBuilder, loc, loadedValue, cache, lowerBoundOffsetIVs);
+                    mlir::Value convertedValue = ConvertCacheElementType(currentBuilder, loc, loadedValue, baseCacheElementType);
+                    CreateStore(currentBuilder, loc, convertedValue, cache, lowerBoundOffsetIVs);
                 }
                 else
                 {
                     mlir::Value loadedValue = CreateLoad(currentBuilder, loc, cache, lowerBoundOffsetIVs);
-                    CreateStore(currentBuilder, loc, loadedValue, array, lowerBoundOffsetIVs);
+                    mlir::Value convertedValue = ConvertCacheElementType(currentBuilder, loc, loadedValue, baseArrayElementType);
+                    CreateStore(currentBuilder, loc, convertedValue, array, lowerBoundOffsetIVs);
                 }
             });
 
@@ -2844,12 +3400,14 @@ LogicalResult ActiveBlockCacheCopyOpRewrite::matchAndRewrite(ActiveBlockCacheCop
                 if (arrayToCache)
                 {
                     mlir::Value loadedValue = CreateLoad(currentBuilder, loc, array, lowerBoundOffsetIVs);
-                    CreateStore(currentBuilder, loc, loadedValue, cache, lowerBoundOffsetIVs);
+                    mlir::Value convertedValue = ConvertCacheElementType(currentBuilder, loc, loadedValue, baseCacheElementType);
+                    CreateStore(currentBuilder, loc, convertedValue, cache, lowerBoundOffsetIVs);
                 }
                 else
                 {
                     mlir::Value loadedValue = CreateLoad(currentBuilder, loc, cache, lowerBoundOffsetIVs);
-                    CreateStore(currentBuilder, loc, loadedValue, array, lowerBoundOffsetIVs);
+                    mlir::Value convertedValue = ConvertCacheElementType(currentBuilder, loc, loadedValue, baseArrayElementType);
+                    CreateStore(currentBuilder, loc, convertedValue, array, lowerBoundOffsetIVs);
                 }
             });
             // Bounds check cache copy loads/stores so we don't introduce
@@ -2878,12 +3436,14 @@ LogicalResult ActiveBlockCacheCopyOpRewrite::matchAndRewrite(ActiveBlockCacheCop
         if (arrayToCache)
         {
             mlir::Value loadedValue = CreateLoad(currentBuilder, loc, array, copyIVs);
-            CreateStore(currentBuilder, loc, loadedValue, cache, copyIVs);
+            mlir::Value convertedValue = ConvertCacheElementType(currentBuilder, loc, loadedValue, baseCacheElementType);
+            CreateStore(currentBuilder, loc, convertedValue, cache, copyIVs);
         }
         else
         {
             mlir::Value loadedValue = CreateLoad(currentBuilder, loc, cache, copyIVs);
-            CreateStore(currentBuilder, loc, loadedValue, array, copyIVs);
+            mlir::Value convertedValue = ConvertCacheElementType(currentBuilder, loc, loadedValue, baseArrayElementType);
+            CreateStore(currentBuilder, loc, convertedValue, array, copyIVs);
         }
     }
 
@@ -3205,29 +3765,186 @@ std::vector<int64_t> GetFullCacheShapeHelper(const std::vector<int64_t>& multiCa
     return combinedCacheShape;
 }
 
-bool ThriftyCacheAllSingleElementStridesHelper(mlir::PatternRewriter& rewriter,
-                                               mlir::OpBuilder& currentBuilder, // Builder positioned inside of the temp multicache loops (if there are any)
-                                               mlir::Location loc,
-                                               mlir::Value outerArray,
-                                               mlir::Value cacheArray,
-                                               const std::vector<mlir::Value>& multiCacheIVs,
-                                               const std::vector<int64_t>& fullCacheShape,
-                                               const std::vector<int64_t>& fullCacheStepSizes,
-                                               const std::vector<mlir::Value>& activeBlockExternalSymbols,
-                                               mlir::ArrayAttr lbMapsArrayAttr,
-                                               mlir::ArrayAttr ubMapsArrayAttr)
+// Returns true if the expression is a linear combination of its dims and symbols, i.e. it has no mod, floordiv,
+// ceildiv or products of two non-constant terms
+bool IsLinearAffineExpr(mlir::AffineExpr expr)
 {
-    mlir::ValueRange lbOperands = activeBlockExternalSymbols;
-    [[maybe_unused]] mlir::ValueRange ubOperands = activeBlockExternalSymbols;
-
-    auto lbMaps = util::ArrayAttrToVector<mlir::AffineMap, mlir::AffineMapAttr>(lbMapsArrayAttr, [](const mlir::AffineMapAttr& mapAttr) -> mlir::AffineMap {
-        return mapAttr.getValue();
-    });
-    auto ubMaps = util::ArrayAttrToVector<mlir::AffineMap, mlir::AffineMapAttr>(ubMapsArrayAttr, [](const mlir::AffineMapAttr& mapAttr) -> mlir::AffineMap {
-        return mapAttr.getValue();
-    });
-
-    // Walk the combinedCacheStepSizes dimensions from innermost to outermost and loop over the loads and stores in that order
+    bool isLinear = true;
+    expr.walk([&](mlir::AffineExpr subExpr) {
+        switch (subExpr.getKind())
+        {
+        case mlir::AffineExprKind::Mod:
+        case mlir::AffineExprKind::FloorDiv:
+        case mlir::AffineExprKind::CeilDiv:
+            isLinear = false;
+            break;
+        case mlir::AffineExprKind::Mul: {
+            auto mulExpr = subExpr.cast<mlir::AffineBinaryOpExpr>();
+            if (!mulExpr.getLHS().isa<mlir::AffineConstantExpr>() && !mulExpr.getRHS().isa<mlir::AffineConstantExpr>())
+            {
+                isLinear = false;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    });
+    return isLinear;
+}
+
+// Returns the coefficient of each of the given values in the flat memory location the load accesses, or std::nullopt if
+// the location isn't a linear function of its operands
+std::optional<std::vector<int64_t>> GetLinearAccessCoefficients(mlir::AffineLoadOp loadOp, const std::vector<mlir::Value>& values)
+{
+    auto locationMap = util::GetIndexToMemoryLocationMap(loadOp.getContext(), loadOp);
+    llvm::SmallVector<mlir::Value, 8> locationOperands(loadOp.indices().begin(), loadOp.indices().end());
+    mlir::fullyComposeAffineMapAndOperands(&locationMap, &locationOperands);
+    if (locationMap.getNumResults() != 1 || !IsLinearAffineExpr(locationMap.getResult(0)))
+    {
+        return std::nullopt;
+    }
+
+    auto locationExpr = locationMap.getResult(0);
+    auto numDims = locationMap.getNumDims();
+    auto context = loadOp.getContext();
+    auto evaluateAt = [&](std::optional<unsigned> unitOperand) {
+        llvm::SmallVector<mlir::AffineExpr, 8> dimReplacements;
+        llvm::SmallVector<mlir::AffineExpr, 8> symbolReplacements;
+        for (unsigned operandIdx = 0; operandIdx < locationOperands.size(); ++operandIdx)
+        {
+            auto replacement = mlir::getAffineConstantExpr(unitOperand == operandIdx ? 1 : 0, context);
+            (operandIdx < numDims ? dimReplacements : symbolReplacements).push_back(replacement);
+        }
+        return locationExpr.replaceDimsAndSymbols(dimReplacements, symbolReplacements).cast<mlir::AffineConstantExpr>().getValue();
+    };
+
+    auto origin = evaluateAt(std::nullopt);
+    std::vector<int64_t> coefficients;
+    coefficients.reserve(values.size());
+    for (auto value : values)
+    {
+        auto it = llvm::find(locationOperands, value);
+        coefficients.push_back(it == locationOperands.end() ? 0 : evaluateAt(static_cast<unsigned>(it - locationOperands.begin())) - origin);
+    }
+    return coefficients;
+}
+
+// Computes the result of ThriftyCacheAllSingleElementStridesBySimulation without visiting every element of the cache.
+// When both the outer array and the cache are accessed at locations that are linear functions of the loop IVs, the
+// difference between consecutive accesses only depends on which loop advanced: advancing loop d by its step moves the
+// access by (coefficient_d * step_d) minus the distance covered by the inner loops that wrap back to 0. So it is enough
+// to check one transition per loop. Returns std::nullopt if either access isn't linear in the loop IVs.
+std::optional<bool> ThriftyCacheAllSingleElementStridesAnalytic(mlir::PatternRewriter& rewriter,
+                                                                mlir::OpBuilder& currentBuilder,
+                                                                mlir::Location loc,
+                                                                mlir::Value outerArray,
+                                                                mlir::Value cacheArray,
+                                                                const std::vector<mlir::Value>& multiCacheIVs,
+                                                                const std::vector<int64_t>& fullCacheShape,
+                                                                const std::vector<int64_t>& fullCacheStepSizes,
+                                                                const std::vector<mlir::Value>& activeBlockExternalSymbols,
+                                                                const std::vector<mlir::AffineMap>& lbMaps)
+{
+    std::stack<mlir::Operation*> temporaryOps;
+    util::TempOpCleanupGuard cleanupGuard(&temporaryOps, rewriter);
+
+    // Opaque stand-ins for the loop IVs, so that the accesses compose to affine functions of them rather than constants
+    std::vector<mlir::Value> loopIVs;
+    for (size_t loopIdx = 0; loopIdx < fullCacheShape.size(); ++loopIdx)
+    {
+        auto constantOp = currentBuilder.create<mlir::ConstantIntOp>(loc, 0, 64);
+        auto castOp = currentBuilder.create<mlir::IndexCastOp>(loc, constantOp, currentBuilder.getIndexType());
+        temporaryOps.push(constantOp);
+        temporaryOps.push(castOp);
+        loopIVs.push_back(castOp);
+    }
+
+    // Build the accesses the same way as the simulation does, with the IVs in place of the constant positions
+    auto numMultiCacheDims = multiCacheIVs.size();
+    mlir::AffineMap sumMap = mlir::AffineMap::get(2, 0, currentBuilder.getAffineDimExpr(0) + currentBuilder.getAffineDimExpr(1));
+    std::vector<mlir::Value> globalIndices;
+    for (unsigned arrayDim = 0; arrayDim < lbMaps.size(); ++arrayDim)
+    {
+        mlir::Value lbMapApplied = currentBuilder.create<mlir::AffineApplyOp>(loc, lbMaps[arrayDim], activeBlockExternalSymbols);
+        mlir::Value lbOffsetIV = currentBuilder.create<mlir::AffineApplyOp>(loc, sumMap, mlir::ValueRange{ lbMapApplied, loopIVs[numMultiCacheDims + arrayDim] });
+        temporaryOps.push(lbMapApplied.getDefiningOp());
+        temporaryOps.push(lbOffsetIV.getDefiningOp());
+        globalIndices.push_back(lbOffsetIV);
+    }
+
+    mlir::AffineLoadOp outerArrayAccessOp = CreateLoad(currentBuilder, loc, outerArray, globalIndices);
+    mlir::AffineLoadOp cacheArrayAccessOp = CreateLoad(currentBuilder, loc, cacheArray, globalIndices);
+    temporaryOps.push(outerArrayAccessOp);
+    temporaryOps.push(cacheArrayAccessOp);
+    for (auto accessOp : { outerArrayAccessOp, cacheArrayAccessOp })
+    {
+        for (unsigned multiCacheDim = 0; multiCacheDim < numMultiCacheDims; ++multiCacheDim)
+        {
+            accessOp->replaceUsesOfWith(multiCacheIVs[multiCacheDim], loopIVs[multiCacheDim]);
+        }
+    }
+
+    auto outerArrayCoefficients = GetLinearAccessCoefficients(outerArrayAccessOp, loopIVs);
+    auto cacheArrayCoefficients = GetLinearAccessCoefficients(cacheArrayAccessOp, loopIVs);
+    if (!outerArrayCoefficients || !cacheArrayCoefficients)
+    {
+        return std::nullopt;
+    }
+
+    // The loops run from 0 up to their shape, exclusive, in increments of their step size
+    auto lastIV = [&](size_t loopIdx) {
+        return ((fullCacheShape[loopIdx] - 1) / fullCacheStepSizes[loopIdx]) * fullCacheStepSizes[loopIdx];
+    };
+    auto strideWhenAdvancing = [&](const std::vector<int64_t>& coefficients, size_t loopIdx) {
+        int64_t stride = coefficients[loopIdx] * fullCacheStepSizes[loopIdx];
+        for (size_t innerLoopIdx = loopIdx + 1; innerLoopIdx < fullCacheShape.size(); ++innerLoopIdx)
+        {
+            stride -= coefficients[innerLoopIdx] * lastIV(innerLoopIdx);
+        }
+        return stride;
+    };
+
+    for (size_t loopIdx = 0; loopIdx < fullCacheShape.size(); ++loopIdx)
+    {
+        if (fullCacheShape[loopIdx] <= fullCacheStepSizes[loopIdx])
+        {
+            // This loop only runs once, so it never advances
+            continue;
+        }
+        auto outerArrayStride = strideWhenAdvancing(*outerArrayCoefficients, loopIdx);
+        auto cacheArrayStride = strideWhenAdvancing(*cacheArrayCoefficients, loopIdx);
+        if (outerArrayStride != cacheArrayStride || outerArrayStride != 1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ThriftyCacheAllSingleElementStridesBySimulation(mlir::PatternRewriter& rewriter,
+                                                     mlir::OpBuilder& currentBuilder, // Builder positioned inside of the temp multicache loops (if there are any)
+                                                     mlir::Location loc,
+                                                     mlir::Value outerArray,
+                                                     mlir::Value cacheArray,
+                                                     const std::vector<mlir::Value>& multiCacheIVs,
+                                                     const std::vector<int64_t>& fullCacheShape,
+                                                     const std::vector<int64_t>& fullCacheStepSizes,
+                                                     const std::vector<mlir::Value>& activeBlockExternalSymbols,
+                                                     mlir::ArrayAttr lbMapsArrayAttr,
+                                                     mlir::ArrayAttr ubMapsArrayAttr)
+{
+    mlir::ValueRange lbOperands = activeBlockExternalSymbols;
+    [[maybe_unused]] mlir::ValueRange ubOperands = activeBlockExternalSymbols;
+
+    auto lbMaps = util::ArrayAttrToVector<mlir::AffineMap, mlir::AffineMapAttr>(lbMapsArrayAttr, [](const mlir::AffineMapAttr& mapAttr) -> mlir::AffineMap {
+        return mapAttr.getValue();
+    });
+    auto ubMaps = util::ArrayAttrToVector<mlir::AffineMap, mlir::AffineMapAttr>(ubMapsArrayAttr, [](const mlir::AffineMapAttr& mapAttr) -> mlir::AffineMap {
+        return mapAttr.getValue();
+    });
+
+    // Walk the combinedCacheStepSizes dimensions from innermost to outermost and loop over the loads and stores in that order
 
     // Create temporary op stacks to hold the ops created as part of computing the difference in accesses between iterations.
     // We create two so that one holds the current iteration accesses and one holds the previuos iteration accesses.
@@ -3393,6 +4110,31 @@ bool ThriftyCacheAllSingleElementStridesHelper(mlir::PatternRewriter& rewriter,
     return allSingleElementStrides;
 }
 
+bool ThriftyCacheAllSingleElementStridesHelper(mlir::PatternRewriter& rewriter,
+                                               mlir::OpBuilder& currentBuilder, // Builder positioned inside of the temp multicache loops (if there are any)
+                                               mlir::Location loc,
+                                               mlir::Value outerArray,
+                                               mlir::Value cacheArray,
+                                               const std::vector<mlir::Value>& multiCacheIVs,
+                                               const std::vector<int64_t>& fullCacheShape,
+                                               const std::vector<int64_t>& fullCacheStepSizes,
+                                               const std::vector<mlir::Value>& activeBlockExternalSymbols,
+                                               mlir::ArrayAttr lbMapsArrayAttr,
+                                               mlir::ArrayAttr ubMapsArrayAttr)
+{
+    auto lbMaps = util::ArrayAttrToVector<mlir::AffineMap, mlir::AffineMapAttr>(lbMapsArrayAttr, [](const mlir::AffineMapAttr& mapAttr) -> mlir::AffineMap {
+        return mapAttr.getValue();
+    });
+
+    // Comparing the access functions is constant time in the size of the cache, the simulation is linear in it, so the
+    // simulation is only used for the accesses the comparison can't reason about, such as tiled layouts
+    if (auto allSingleElementStrides = ThriftyCacheAllSingleElementStridesAnalytic(rewriter, currentBuilder, loc, outerArray, cacheArray, multiCacheIVs, fullCacheShape, fullCacheStepSizes, activeBlockExternalSymbols, lbMaps))
+    {
+        return *allSingleElementStrides;
+    }
+    return ThriftyCacheAllSingleElementStridesBySimulation(rewriter, currentBuilder, loc, outerArray, cacheArray, multiCacheIVs, fullCacheShape, fullCacheStepSizes, activeBlockExternalSymbols, lbMapsArrayAttr, ubMapsArrayAttr);
+}
+
 template <typename CacheOpTy>
 std::pair<mlir::Block::iterator, mlir::Block::iterator> GetCacheRegionIterators(CacheOpTy cacheOp)
 {
@@ -4089,7 +4831,7 @@ LogicalResult BeginCacheMappingOpRewrite::matchAndRewrite(BeginCacheMappingOp be
                 {
                     auto baseArrayPosition = GetBaseArrayPosition(rewriter, loc, loadOp);
                     mlir::AffineLoadOp newLoadOp = CreateLoad(rewriter, loc, toValue, baseArrayPosition);
-                    loadOp.replaceAllUsesWith(newLoadOp.getResult());
+                    ReplaceLoadWithCacheLoad(rewriter, loc, loadOp, newLoadOp.getResult());
                     TransferOrSetAccessAttrs(loadOp, newLoadOp);
                     rewriter.eraseOp(loadOp);
                 }
@@ -4105,7 +4847,8 @@ LogicalResult BeginCacheMappingOpRewrite::matchAndRewrite(BeginCacheMappingOp be
                 if (isActiveBlockCache)
                 {
                     auto baseArrayPosition = GetBaseArrayPosition(rewriter, loc, storeOp);
-                    auto newStoreOp = CreateStore(rewriter, loc, storeAdaptor.value(), toValue, baseArrayPosition);
+                    auto storeValue = ConvertCacheElementType(rewriter, loc, storeAdaptor.value(), GetInnerElementType(toValue));
+                    auto newStoreOp = CreateStore(rewriter, loc, storeValue, toValue, baseArrayPosition);
                     TransferOrSetAccessAttrs(storeOp, newStoreOp);
                     rewriter.eraseOp(storeOp);
                 }
@@ -4122,7 +4865,7 @@ LogicalResult BeginCacheMappingOpRewrite::matchAndRewrite(BeginCacheMappingOp be
                 {
                     std::vector<mlir::Value> baseArrayPosition(loadAdaptor.indices().begin(), loadAdaptor.indices().end());
                     mlir::AffineLoadOp newLoadOp = CreateLoad(rewriter, loc, toValue, baseArrayPosition);
-                    loadOp.replaceAllUsesWith(newLoadOp.getResult());
+                    ReplaceLoadWithCacheLoad(rewriter, loc, loadOp, newLoadOp.getResult());
                     rewriter.eraseOp(loadOp);
                 }
                 else
@@ -4137,7 +4880,8 @@ LogicalResult BeginCacheMappingOpRewrite::matchAndRewrite(BeginCacheMappingOp be
                 if (isActiveBlockCache)
                 {
                     std::vector<mlir::Value> baseArrayPosition(storeAdaptor.indices().begin(), storeAdaptor.indices().end());
-                    CreateStore(rewriter, loc, storeAdaptor.value(), toValue, baseArrayPosition);
+                    auto storeValue = ConvertCacheElementType(rewriter, loc, storeAdaptor.value(), GetInnerElementType(toValue));
+                    CreateStore(rewriter, loc, storeValue, toValue, baseArrayPosition);
                     rewriter.eraseOp(storeOp);
                 }
                 else
@@ -4153,7 +4897,7 @@ LogicalResult BeginCacheMappingOpRewrite::matchAndRewrite(BeginCacheMappingOp be
                 {
                     std::vector<mlir::Value> baseArrayPosition(loadAdaptor.indices().begin(), loadAdaptor.indices().end());
                     mlir::AffineLoadOp newLoadOp = CreateLoad(rewriter, loc, toValue, baseArrayPosition);
-                    loadOp.replaceAllUsesWith(newLoadOp.getResult());
+                    ReplaceLoadWithCacheLoad(rewriter, loc, loadOp, newLoadOp.getResult());
                     rewriter.eraseOp(loadOp);
                 }
                 else
@@ -4168,7 +4912,8 @@ LogicalResult BeginCacheMappingOpRewrite::matchAndRewrite(BeginCacheMappingOp be
                 if (isActiveBlockCache)
                 {
                     std::vector<mlir::Value> baseArrayPosition(storeAdaptor.indices().begin(), storeAdaptor.indices().end());
-                    CreateStore(rewriter, loc, storeAdaptor.value(), toValue, baseArrayPosition);
+                    auto storeValue = ConvertCacheElementType(rewriter, loc, storeAdaptor.value(), GetInnerElementType(toValue));
+                    CreateStore(rewriter, loc, storeValue, toValue, baseArrayPosition);
                     rewriter.eraseOp(storeOp);
                 }
                 else
@@ -4607,6 +5352,76 @@ LogicalResult MergeCacheRegionOpsRewrite::matchAndRewrite(BeginCreateCacheOp beg
     return success();
 }
 
+// Returns the innermost loop enclosing (or equal to) triggerLoopParentLoop whose induction variable the position of the active block
+// depends on, or a null op if there is none. Iterations of loops the active block doesn't depend on all copy the same data into the cache
+mlir::AffineForOp GetCachePrefetchLoop(const MultiCacheInfo& multiCacheInfo, mlir::AffineForOp triggerLoopParentLoop)
+{
+    const auto& externalSymbols = multiCacheInfo.multiCacheExternalSymbols;
+    for (auto loop = triggerLoopParentLoop; loop; loop = loop->getParentOfType<mlir::AffineForOp>())
+    {
+        if (std::find(externalSymbols.begin(), externalSymbols.end(), loop.getInductionVar()) != externalSymbols.end())
+        {
+            return loop;
+        }
+    }
+    return {};
+}
+
+// Creates a prefetch of the array data that the iteration `distance` iterations after the current one of the innermost loop
+// that moves the active block will copy into the cache, so that it is in flight while the current active block is being computed.
+// The prefetch is guarded so that none is issued past the last iteration of that loop
+void CreateCachePrefetch(mlir::PatternRewriter& rewriter,
+                         mlir::Location loc,
+                         BeginCreateCacheOp beginCreateCacheOp,
+                         const MultiCacheInfo& multiCacheInfo,
+                         mlir::AffineForOp triggerLoopParentLoop,
+                         int64_t distance)
+{
+    auto prefetchLoop = GetCachePrefetchLoop(multiCacheInfo, triggerLoopParentLoop);
+    if (!prefetchLoop)
+    {
+        return;
+    }
+    auto tripCountOpt = mlir::getConstantTripCount(prefetchLoop);
+    if (!prefetchLoop.hasConstantLowerBound() || !tripCountOpt.hasValue() || static_cast<int64_t>(tripCountOpt.getValue()) <= distance)
+    {
+        return;
+    }
+
+    mlir::Value prefetchLoopIV = prefetchLoop.getInductionVar();
+    int64_t prefetchOffset = distance * prefetchLoop.getStep();
+    int64_t lastIterValue = prefetchLoop.getConstantLowerBound() + (static_cast<int64_t>(tripCountOpt.getValue()) - 1) * prefetchLoop.getStep();
+
+    auto prefetchIterMap = mlir::AffineMap::get(1, 0, rewriter.getAffineDimExpr(0) + prefetchOffset);
+    mlir::Value prefetchIterValue = rewriter.create<mlir::AffineApplyOp>(loc, prefetchIterMap, mlir::ValueRange{ prefetchLoopIV });
+
+    // Prefetch if (lastIterValue - prefetchOffset) - prefetchLoopIV >= 0
+    mlir::AffineExpr inBoundsExpr = rewriter.getAffineConstantExpr(lastIterValue - prefetchOffset) - rewriter.getAffineDimExpr(0);
+    SmallVector<bool, 1> constraintEqFlags(1, false);
+    auto inBoundsSet = mlir::IntegerSet::get(1, 0, { inBoundsExpr }, constraintEqFlags);
+    auto prefetchIfOp = rewriter.create<mlir::AffineIfOp>(loc, inBoundsSet, ValueRange{ prefetchLoopIV }, false);
+    auto prefetchThenBuilder = prefetchIfOp.getThenBodyBuilder();
+
+    MakeDelayedMappingRegion(prefetchThenBuilder, prefetchLoopIV, prefetchIterValue, [&](mlir::OpBuilder& builder) {
+        auto prefetchOp = builder.create<MultiCacheCopyOp>(loc,
+                                                           beginCreateCacheOp.input(),
+                                                           multiCacheInfo.multiCache,
+                                                           multiCacheInfo.multiCacheExternalSymbols,
+                                                           builder.getAffineMapArrayAttr(multiCacheInfo.multiCacheLBMaps),
+                                                           builder.getAffineMapArrayAttr(multiCacheInfo.multiCacheUBMaps),
+                                                           builder.getI64ArrayAttr(multiCacheInfo.multiCacheStepSizes),
+                                                           util::ConvertIndexVectorToArrayAttr(multiCacheInfo.multiCacheLoopIndexIds, builder.getContext()),
+                                                           builder.getAffineMapArrayAttr(multiCacheInfo.activeBlockInfo.lbMaps),
+                                                           builder.getAffineMapArrayAttr(multiCacheInfo.activeBlockInfo.ubMaps),
+                                                           multiCacheInfo.multiCacheExternalSymbolsPermutationMap,
+                                                           multiCacheInfo.activeBlockToCacheMap,
+                                                           false, // thrifty
+                                                           true, // toCache
+                                                           beginCreateCacheOp.vectorizationInfoAttr());
+        prefetchOp->setAttr(CachePrefetchAttrName, builder.getUnitAttr());
+    });
+}
+
 MakeCacheOp CreateDoubleBufferTempArray(mlir::OpBuilder& builder,
                                         MultiCacheInfo& info,
                                         BeginCreateCacheOp& cacheRegionOp)
@@ -5264,6 +6079,15 @@ LogicalResult BeginCreateCacheOpRewrite::matchAndRewrite(BeginCreateCacheOp begi
                     }
                 });
 
+                // Prefetch the active block of a later iteration of the innermost loop that moves it while this one is computed
+                auto prefetchDistance = beginCreateCacheOp.prefetchDistance();
+                bool copiesIntoCache = multiCacheInfo.arrayAccessInfo.valueRead && !multiCacheInfo.arrayAccessInfo.onlyReadsAreAccumulates;
+                if (prefetchDistance.hasValue() && triggerLoopParentLoop != nullptr && execTarget == v::ExecutionTarget::CPU &&
+                    beginCreateCacheOp.activeBlockCache() && copiesIntoCache && multiCacheInfo.arrayAccessInfo.parametricIVHandles.empty())
+                {
+                    CreateCachePrefetch(rewriter, loc, beginCreateCacheOp, multiCacheInfo, triggerLoopParentLoop, prefetchDistance.getValue());
+                }
+
                 // Create mapping ops for each cache active block region associated with this multiCache
                 CreateCacheMappingRegionHelper(rewriter, beginCreateCacheOp, multiCacheInfo);
 
@@ -5496,6 +6320,11 @@ LogicalResult MaxElementCacheRegionOpRewrite::matchAndRewrite(BeginCreateMaxElem
                                                           doubleBufferMemorySpace,
                                                           GetCacheOpVectorizationInfoOrDefault(beginCreateMaxElementCacheOp));
 
+    if (auto prefetchDistanceAttr = beginCreateMaxElementCacheOp.prefetchDistanceAttr())
+    {
+        newBeginOp.prefetchDistanceAttr(prefetchDistanceAttr);
+    }
+
     // This new cache region op has already been hoisted as high as we want to hoist it
     newBeginOp->setAttr("hoisted", rewriter.getUnitAttr());
 
@@ -5544,6 +6373,11 @@ void VectorizeAffineForOpConversion::vectorizeOpsInBlock(PatternRewriter& rewrit
                 didVectorizeOp(sourceOp, *result);
             }
         }
+        else if (!vectorInfo.unrollOnly && !sourceOp->hasTrait<mlir::OpTrait::IsTerminator>())
+        {
+            // Report the ops that force the loop body to be scalarized
+            emitVectorizationRemark(sourceOp, "Op is not vectorizable: " + sourceOp->getName().getStringRef().str());
+        }
 
         emitVectorizationRemark(sourceOp, "Unrolling op if needed");
 
@@ -5617,6 +6451,11 @@ LogicalResult VectorizeAffineForOpConversion::matchAndRewrite(AffineForOp affine
         return success();
     }
 
+    if (vectorInfo.maskedTail && !vectorInfo.unrollOnly && succeeded(vectorizeMaskedTail(rewriter, affineForOp, vectorInfo, constantTripCount)))
+    {
+        return success();
+    }
+
     rewriter.startRootUpdate(affineForOp);
 
     assert(affineForOp.hasConstantLowerBound() && "Vectorized loops must have a constant lower bound");
@@ -5676,6 +6515,148 @@ LogicalResult VectorizeAffineForOpConversion::matchAndRewrite(AffineForOp affine
     return success();
 }
 
+LogicalResult VectorizeAffineForOpConversion::vectorizeMaskedTail(PatternRewriter& rewriter,
+                                                                  AffineForOp affineForOp,
+                                                                  const VectorizationInfo& vectorInfo,
+                                                                  int64_t numIters) const
+{
+    // A loop with fewer iterations than the vector width (typically the boundary block of a split index whose
+    // size isn't a multiple of the split size) is run as a single vector op per scalar op, padded up to the
+    // next power-of-two width. Only the first `numIters` lanes are enabled in the mask of the loads and stores,
+    // which lower to masked moves (e.g. vmaskmov on AVX2 and masked moves on AVX-512)
+    auto affineForOpIV = affineForOp.getInductionVar();
+    auto body = affineForOp.getBody();
+
+    int64_t maxElementBits = 0;
+    for (auto& op : body->without_terminator())
+    {
+        if (op.getNumRegions() != 0)
+        {
+            return failure();
+        }
+        if (auto memRefType = TypeSwitch<Operation*, MemRefType>(&op)
+                                  .Case<memref::LoadOp, memref::StoreOp, AffineLoadOp, AffineStoreOp>([](auto accessOp) { return accessOp.getMemRefType(); })
+                                  .Default([](Operation*) { return MemRefType{}; }))
+        {
+            auto elementType = memRefType.getElementType();
+            if (!elementType.isIntOrFloat())
+            {
+                return failure();
+            }
+            maxElementBits = std::max<int64_t>(maxElementBits, elementType.getIntOrFloatBitWidth());
+        }
+    }
+    if (maxElementBits == 0)
+    {
+        return failure();
+    }
+
+    auto vectorLanes = (vectorInfo.vectorBytes * 8) / maxElementBits;
+    auto paddedLanes = static_cast<int64_t>(llvm::PowerOf2Ceil(numIters));
+    if (numIters >= vectorLanes || paddedLanes == numIters)
+    {
+        // Full-width loops and power-of-two tails already map onto whole vector registers
+        return failure();
+    }
+
+    auto loc = affineForOp.getLoc();
+    int64_t step = affineForOp.getStep();
+    rewriter.setInsertionPoint(body->getTerminator());
+
+    // Map every lane, including the ones that are masked off, so that the memory access pattern can be checked
+    std::vector<Operation*> laneOps;
+    std::vector<BlockAndValueMapping> laneMappings(paddedLanes);
+    auto inductionVarMap = AffineMap::get(1, 1, rewriter.getAffineDimExpr(0) + step * rewriter.getAffineSymbolExpr(0));
+    for (int64_t i = 0; i < paddedLanes; ++i)
+    {
+        auto offset = rewriter.create<mlir::ConstantIndexOp>(loc, i);
+        auto offsetInductionVar = rewriter.create<AffineApplyOp>(loc, inductionVarMap, ValueRange{ affineForOpIV, offset });
+        laneOps.push_back(offset);
+        laneOps.push_back(offsetInductionVar);
+        laneMappings[i].map(affineForOpIV, offsetInductionVar);
+    }
+
+    std::vector<Operation*> srcOps;
+    for (auto& op : body->without_terminator())
+    {
+        if (std::find(laneOps.begin(), laneOps.end(), &op) == laneOps.end())
+        {
+            srcOps.push_back(&op);
+        }
+    }
+
+    auto canVectorize = llvm::all_of(srcOps, [&](Operation* op) {
+        return CanVectorizeMaskedOp(rewriter, op, laneMappings, affineForOpIV, step, paddedLanes);
+    });
+    if (!canVectorize)
+    {
+        emitVectorizationRemark(affineForOp, "Can't vectorize the loop with a masked tail");
+        for (auto it = laneOps.rbegin(); it != laneOps.rend(); ++it)
+        {
+            rewriter.eraseOp(*it);
+        }
+        return failure();
+    }
+
+    rewriter.startRootUpdate(affineForOp);
+
+    auto numItersValue = rewriter.create<mlir::ConstantIndexOp>(loc, numIters);
+    auto maskType = VectorType::get({ paddedLanes }, rewriter.getI1Type());
+    auto mask = rewriter.create<vector::CreateMaskOp>(loc, maskType, ValueRange{ numItersValue });
+
+    VectorizedOpMap vectorizedOps;
+    std::stack<Operation*> opsToErase;
+    for (auto op : srcOps)
+    {
+        if (isa<AffineApplyOp>(op) || !ir::util::hasRecursiveUseOfOp(affineForOpIV, op))
+        {
+            // Index computations and loop-invariant values stay scalar
+            continue;
+        }
+
+        auto result = VectorizeMaskedOp(rewriter, op, mask, vectorizedOps, laneMappings, affineForOpIV, step, paddedLanes);
+        if (!result.has_value())
+        {
+            // The ops created so far, from numItersValue on, are only used by each other, so the loop can be left as it was
+            emitVectorizationRemark(affineForOp, "Failed to vectorize an op with a masked tail");
+            auto terminator = body->getTerminator();
+            while (terminator->getPrevNode() != numItersValue.getOperation())
+            {
+                rewriter.eraseOp(terminator->getPrevNode());
+            }
+            rewriter.eraseOp(numItersValue);
+            for (auto it = laneOps.rbegin(); it != laneOps.rend(); ++it)
+            {
+                rewriter.eraseOp(*it);
+            }
+            rewriter.cancelRootUpdate(affineForOp);
+            return failure();
+        }
+        vectorizedOps.Map(op, *result);
+        didVectorizeOp(op, *result);
+        opsToErase.push(op);
+    }
+
+    RemoveVectorizationInfo(affineForOp);
+    affineForOp.setStep(step * numIters);
+
+    while (!opsToErase.empty())
+    {
+        auto eraseOp = opsToErase.top();
+        if (eraseOp->use_empty())
+        {
+            rewriter.eraseOp(eraseOp);
+        }
+        opsToErase.pop();
+    }
+
+    (void)util::PromoteIfSingleIteration(rewriter, affineForOp);
+
+    rewriter.finalizeRootUpdate(affineForOp);
+
+    return success();
+}
+
 void VectorizeAffineForOpConversion::didVectorizeOp(mlir::Operation* sourceOp, VectorizedOp& vectorizedOp) const
 {
     if (printVectorizationDetails)
@@ -6060,6 +7041,40 @@ bool AreSameElement(OpT1 memOp1, OpT2 memOp2)
     return true;
 }
 
+// Returns true if memOp2 accesses the element following the one memOp1 accesses in the innermost dimension of their
+// memref, and that dimension has unit stride, so the two accesses can be part of the same vector access
+template <typename OpT1, typename OpT2>
+bool AreConsecutiveElements(OpT1 memOp1, OpT2 memOp2)
+{
+    if (memOp1.getMemRef() != memOp2.getMemRef() || memOp1.getAffineMap() != memOp2.getAffineMap())
+    {
+        return false;
+    }
+    llvm::SmallVector<int64_t, 4> strides;
+    int64_t offset;
+    if (failed(mlir::getStridesAndOffset(memOp1.getMemRefType(), strides, offset)) || strides.empty() || strides.back() != 1)
+    {
+        return false;
+    }
+    AffineValueMap memOp2ValueMap(memOp2.getAffineMap(), memOp2.getMapOperands());
+    AffineValueMap memOp1ValueMap(memOp1.getAffineMap(), memOp1.getMapOperands());
+    AffineValueMap differenceMap;
+    AffineValueMap::difference(memOp2ValueMap, memOp1ValueMap, &differenceMap);
+    if (!differenceMap.getAffineMap().isConstant())
+    {
+        return false;
+    }
+    auto constantResults = differenceMap.getAffineMap().getConstantResults();
+    for (unsigned i = 0; i < differenceMap.getNumResults(); ++i)
+    {
+        if (constantResults[i] != (i + 1 == differenceMap.getNumResults() ? 1 : 0))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 auto GetCombinedAccessMap(PatternRewriter& rewriter, const int externalIndices, mlir::AffineMap& offsetMap)
 {
     auto mfmaExternalDimsMap = mlir::AffineMap::getMultiDimIdentityMap(externalIndices, rewriter.getContext());
@@ -6309,6 +7324,11 @@ LogicalResult TensorizeAffineForOpConversion::matchAndRewrite(AffineForOp affine
     }
 
     auto tensorizationInfo = GetTensorizationInfo(affineForOp);
+    if (IsCPUMMAShape(tensorizationInfo.dim))
+    {
+        // Handled by CPUTensorizeAffineForOpConversion
+        return failure();
+    }
 
     SmallVector<AffineForOp, 4> nestedLoops;
     mlir::getPerfectlyNestedLoops(nestedLoops, affineForOp);
@@ -6841,47 +7861,920 @@ LogicalResult TensorizeAffineForOpConversion::matchAndRewrite(AffineForOp affine
     return success();
 }
 
-LogicalResult ParallelizeAffineForOpConversion::matchAndRewrite(AffineForOp affineForOp, PatternRewriter& rewriter) const
+namespace
 {
-    if (!HasParallelizationInfo(affineForOp))
+// Walks up through the no-op casts that the DSL emits between signed/unsigned and signless integer types
+mlir::Value LookThroughConversionCasts(mlir::Value value, std::vector<mlir::Operation*>& castOps)
+{
+    while (auto castOp = value.getDefiningOp<mlir::UnrealizedConversionCastOp>())
     {
-        // This isn't an AffineForOp marked for parallelization so just return without modifying it
-        return success();
+        if (castOp.getNumOperands() != 1)
+        {
+            break;
+        }
+        castOps.push_back(castOp);
+        value = castOp.getOperand(0);
     }
+    return value;
+}
 
-    assert(affineForOp.hasConstantLowerBound() && "Parallelized loops must have a constant lower bound");
-    assert(affineForOp.hasConstantUpperBound() && "Parallelized loops must have a constant upper bound");
-
-    rewriter.startRootUpdate(affineForOp);
-
-    //  Replace affine.for with affine.parallel, tagged with vectorization info
-    //  cf. mlir::affineParallelize() in  mlir\lib\Dialect\Affine\Utils\Utils.cpp
-    //  lowering path: affine.parallel -> scf.parallel -> omp.parallel + omp.wsloop
-    auto newParallelOp = rewriter.create<mlir::AffineParallelOp>(
-        affineForOp.getLoc(), /*resultTypes=*/llvm::None, /*reductionKinds=*/llvm::None, llvm::makeArrayRef(affineForOp.getLowerBoundMap()), affineForOp.getLowerBoundOperands(), llvm::makeArrayRef(affineForOp.getUpperBoundMap()), affineForOp.getUpperBoundOperands(), llvm::makeArrayRef(affineForOp.getStep()));
-
-    // Move the loop block to the new op
-    rewriter.inlineRegionBefore(affineForOp.region(), newParallelOp.region(), newParallelOp.region().begin());
+bool AccessDependsOnLoop(mlir::AffineLoadOp loadOp, mlir::AffineForOp loop)
+{
+    llvm::DenseMap<mlir::Value, bool> dependsOnIV;
+    return llvm::any_of(loadOp.getMapOperands(), [&](mlir::Value operand) { return DependsOnInductionVar(operand, loop, dependsOnIV); });
+}
 
-    // Unpack the parallelization info into OpenMP dialect attributes
-    // cf. mlir\lib\Conversion\SCFToOpenMP\SCFToOpenMP.cpp
-    auto parallelizationInfo = GetParallelizationInfo(affineForOp);
-    newParallelOp->setAttr(mlir::omp::getNumThreadsAttrName(), rewriter.getI64IntegerAttr(parallelizationInfo.numThreads));
+// Clones `op` along with the ops nested in `scope` that compute its operands, using `mapping` for the loop induction variables
+mlir::Operation* CloneWithOperands(mlir::PatternRewriter& rewriter, mlir::Operation* op, mlir::BlockAndValueMapping& mapping, mlir::Operation* scope)
+{
+    for (auto operand : op->getOperands())
+    {
+        if (mapping.contains(operand))
+        {
+            continue;
+        }
+        if (auto definingOp = operand.getDefiningOp(); definingOp && scope->isProperAncestor(definingOp))
+        {
+            CloneWithOperands(rewriter, definingOp, mapping, scope);
+        }
+    }
+    return rewriter.clone(*op, mapping);
+}
 
-    // Valid clause values: llvm\include\llvm\Frontend\OpenMP\OMP.td
-    newParallelOp->setAttr(mlir::omp::getScheduleAttrName(), rewriter.getStringAttr(parallelizationInfo.isDynamicPolicy ? "Dynamic" : "Static"));
-    newParallelOp->setAttr(mlir::omp::getProcBindAttrName(), rewriter.getStringAttr("close"));
+struct CPUMatmulOperand
+{
+    mlir::AffineLoadOp loadOp;
+    bool isUnsigned = false;
+};
 
-    rewriter.eraseOp(affineForOp);
-    rewriter.finalizeRootUpdate(affineForOp);
+// Matches `cast(load8(...), int32)`, returning the 8-bit load and the signedness of the extension
+std::optional<CPUMatmulOperand> MatchInt8Operand(mlir::Value value, std::vector<mlir::Operation*>& matchedOps)
+{
+    value = LookThroughConversionCasts(value, matchedOps);
+    auto extOp = value.getDefiningOp();
+    if (!extOp || !isa<mlir::SignExtendIOp, mlir::ZeroExtendIOp>(extOp))
+    {
+        return std::nullopt;
+    }
+    matchedOps.push_back(extOp);
 
-    return success();
+    auto source = LookThroughConversionCasts(extOp->getOperand(0), matchedOps);
+    auto loadOp = source.getDefiningOp<mlir::AffineLoadOp>();
+    if (!loadOp || !loadOp.getMemRefType().getElementType().isInteger(8))
+    {
+        return std::nullopt;
+    }
+    matchedOps.push_back(loadOp);
+    return CPUMatmulOperand{ loadOp, isa<mlir::ZeroExtendIOp>(extOp) };
 }
 
-LogicalResult CollapseAffineParallelOpsRewrite::matchAndRewrite(AffineParallelOp affineParallelOp, PatternRewriter& rewriter) const
+// Matches `load(...)` or `cast(load(...), float type)` of a floating point array
+std::optional<CPUMatmulOperand> MatchFloatOperand(mlir::Value value, std::vector<mlir::Operation*>& matchedOps)
 {
-    // Find a pair of perfectly nested ops (i.e. affineParallelOp with a child AffineParallelOp):
-    // ...
+    if (auto extOp = value.getDefiningOp<mlir::FPExtOp>())
+    {
+        matchedOps.push_back(extOp);
+        value = extOp.getOperand();
+    }
+    auto loadOp = value.getDefiningOp<mlir::AffineLoadOp>();
+    if (!loadOp || !loadOp.getMemRefType().getElementType().isa<mlir::FloatType>())
+    {
+        return std::nullopt;
+    }
+    matchedOps.push_back(loadOp);
+    return CPUMatmulOperand{ loadOp };
+}
+
+mlir::Value CreateSplatConstant(mlir::PatternRewriter& rewriter, mlir::Location loc, mlir::VectorType type, int64_t value)
+{
+    return rewriter.create<mlir::ConstantOp>(loc, SplatElementsAttr::get(type, rewriter.getIntegerAttr(type.getElementType(), value)));
+}
+
+mlir::Value CallIntrinsic(mlir::PatternRewriter& rewriter, mlir::Operation* anchorOp, const std::string& name, mlir::Type resultType, mlir::ValueRange args)
+{
+    auto fn = util::GetOrCreateExternalFunctionDeclaration(rewriter, anchorOp, name, rewriter.getFunctionType(args.getTypes(), { resultType }));
+    return rewriter.create<v::CallOp>(anchorOp->getLoc(), fn, args).getResult(0);
+}
+
+// Returns acc[l] + sum_{kk < 4} row[4*l + kk] * col[4*l + kk] for each lane l of `acc`
+mlir::Value EmitInt8DotProductAccumulate(mlir::PatternRewriter& rewriter, mlir::Operation* anchorOp, MMAInstructionSet instructionSet, mlir::Value acc, mlir::Value rowBytes, bool rowUnsigned, mlir::Value colBytes, bool colUnsigned)
+{
+    auto loc = anchorOp->getLoc();
+    auto accType = acc.getType().cast<mlir::VectorType>();
+    auto numLanes = accType.getNumElements();
+    auto i16Type = rewriter.getIntegerType(16);
+    auto i32Type = rewriter.getIntegerType(32);
+    auto byteVecType = rowBytes.getType().cast<mlir::VectorType>();
+    auto wordVecType = mlir::VectorType::get({ 2 * numLanes }, i16Type);
+
+    // The x86 instructions multiply unsigned bytes by signed bytes
+    if (instructionSet != MMAInstructionSet::Generic && rowUnsigned != colUnsigned)
+    {
+        auto unsignedBytes = rowUnsigned ? rowBytes : colBytes;
+        auto signedBytes = rowUnsigned ? colBytes : rowBytes;
+        auto suffix = numLanes == 8 ? "256" : "512";
+
+        if (instructionSet == MMAInstructionSet::VNNI)
+        {
+            auto unsignedDwords = rewriter.create<mlir::vector::BitCastOp>(loc, accType, unsignedBytes);
+            auto signedDwords = rewriter.create<mlir::vector::BitCastOp>(loc, accType, signedBytes);
+            return CallIntrinsic(rewriter, anchorOp, std::string("llvm.x86.avx512.vpdpbusd.") + suffix, accType, ValueRange{ acc, unsignedDwords, signedDwords });
+        }
+
+        // vpmaddubsw sums adjacent pairs of products into (saturated) 16-bit words, vpmaddwd sums adjacent words into dwords
+        auto pairSums = CallIntrinsic(rewriter, anchorOp, numLanes == 8 ? "llvm.x86.avx2.pmadd.ub.sw" : "llvm.x86.avx512.pmaddubs.w.512", wordVecType, ValueRange{ unsignedBytes, signedBytes });
+        auto ones = CreateSplatConstant(rewriter, loc, wordVecType, 1);
+        auto quadSums = CallIntrinsic(rewriter, anchorOp, numLanes == 8 ? "llvm.x86.avx2.pmadd.wd" : "llvm.x86.avx512.pmaddw.d.512", accType, ValueRange{ pairSums, ones });
+        return rewriter.create<mlir::AddIOp>(loc, acc, quadSums);
+    }
+
+    // Generic: widen to 32 bits, multiply, and add up the 4 products of each lane
+    auto wideType = mlir::VectorType::get(byteVecType.getShape(), i32Type);
+    auto extend = [&](mlir::Value bytes, bool isUnsigned) -> mlir::Value {
+        if (isUnsigned)
+        {
+            return rewriter.create<mlir::ZeroExtendIOp>(loc, bytes, wideType);
+        }
+        return rewriter.create<mlir::SignExtendIOp>(loc, bytes, wideType);
+    };
+    mlir::Value products = rewriter.create<mlir::MulIOp>(loc, extend(rowBytes, rowUnsigned), extend(colBytes, colUnsigned));
+    mlir::Value result = acc;
+    for (int64_t kk = 0; kk < 4; ++kk)
+    {
+        std::vector<int64_t> mask;
+        for (int64_t lane = 0; lane < numLanes; ++lane)
+        {
+            mask.push_back(4 * lane + kk);
+        }
+        auto partial = rewriter.create<mlir::vector::ShuffleOp>(loc, products, products, mask);
+        result = rewriter.create<mlir::AddIOp>(loc, result, partial);
+    }
+    return result;
+}
+
+// Returns acc + lhs * rhs, fused into a single instruction on targets with FMA
+mlir::Value EmitFloatMultiplyAccumulate(mlir::PatternRewriter& rewriter, mlir::Location loc, MMAInstructionSet instructionSet, mlir::Value acc, mlir::Value lhs, mlir::Value rhs)
+{
+    if (instructionSet == MMAInstructionSet::FMA)
+    {
+        return rewriter.create<mlir::vector::FMAOp>(loc, lhs, rhs, acc);
+    }
+    mlir::Value product = rewriter.create<mlir::MulFOp>(loc, lhs, rhs);
+    return rewriter.create<mlir::AddFOp>(loc, acc, product);
+}
+
+// Loads `numLanes` elements, where `cloneLane(l)` creates the scalar load of lane l. This is a single vector load when
+// consecutive lanes access consecutive elements, otherwise the scalar loads are inserted into a vector
+mlir::Value CreateLaneVectorLoad(mlir::PatternRewriter& rewriter, mlir::Location loc, int64_t numLanes, const std::function<mlir::AffineLoadOp(int64_t)>& cloneLane)
+{
+    std::vector<mlir::AffineLoadOp> laneLoads{ cloneLane(0) };
+    auto vectorType = mlir::VectorType::get({ numLanes }, laneLoads[0].getMemRefType().getElementType());
+    if (numLanes > 1)
+    {
+        laneLoads.push_back(cloneLane(1));
+    }
+    if (numLanes == 1 || AreConsecutiveElements(laneLoads[0], laneLoads[1]))
+    {
+        mlir::Value result = rewriter.create<mlir::AffineVectorLoadOp>(loc, vectorType, laneLoads[0].getMemRef(), laneLoads[0].getAffineMap(), laneLoads[0].getMapOperands());
+        for (auto laneLoad : laneLoads)
+        {
+            rewriter.eraseOp(laneLoad);
+        }
+        return result;
+    }
+
+    mlir::Value result = rewriter.create<mlir::vector::BroadcastOp>(loc, vectorType, laneLoads[0].getResult());
+    for (int64_t lane = 1; lane < numLanes; ++lane)
+    {
+        auto laneLoad = lane < static_cast<int64_t>(laneLoads.size()) ? laneLoads[lane] : cloneLane(lane);
+        result = rewriter.create<mlir::vector::InsertOp>(loc, laneLoad.getResult(), result, lane);
+    }
+    return result;
+}
+
+// Stores the lanes of `vector`, where `cloneLane(l, element)` creates the scalar store of lane l. This is a single vector
+// store when consecutive lanes access consecutive elements, otherwise each lane is extracted and stored separately
+void CreateLaneVectorStore(mlir::PatternRewriter& rewriter, mlir::Location loc, mlir::Value vector, const std::function<mlir::AffineStoreOp(int64_t, mlir::Value)>& cloneLane)
+{
+    auto numLanes = vector.getType().cast<mlir::VectorType>().getNumElements();
+    auto extractLane = [&](int64_t lane) -> mlir::Value { return rewriter.create<mlir::vector::ExtractOp>(loc, vector, lane); };
+    std::vector<mlir::AffineStoreOp> laneStores{ cloneLane(0, extractLane(0)) };
+    if (numLanes > 1)
+    {
+        laneStores.push_back(cloneLane(1, extractLane(1)));
+    }
+    if (numLanes == 1 || AreConsecutiveElements(laneStores[0], laneStores[1]))
+    {
+        rewriter.create<mlir::AffineVectorStoreOp>(loc, vector, laneStores[0].getMemRef(), laneStores[0].getAffineMap(), laneStores[0].getMapOperands());
+        for (auto laneStore : laneStores)
+        {
+            auto element = laneStore.getValueToStore().getDefiningOp();
+            rewriter.eraseOp(laneStore);
+            rewriter.eraseOp(element);
+        }
+        return;
+    }
+
+    for (int64_t lane = 2; lane < numLanes; ++lane)
+    {
+        cloneLane(lane, extractLane(lane));
+    }
+}
+
+// Casts a vector of signed or unsigned integers to the signless vector type the arithmetic ops expect
+mlir::Value ToSignlessVector(mlir::PatternRewriter& rewriter, mlir::Location loc, mlir::Value vector)
+{
+    auto vectorType = vector.getType().cast<mlir::VectorType>();
+    auto signlessType = mlir::VectorType::get(vectorType.getShape(), util::ToSignlessMLIRType(rewriter, vectorType.getElementType()));
+    if (signlessType == vectorType)
+    {
+        return vector;
+    }
+    return rewriter.create<mlir::UnrealizedConversionCastOp>(loc, signlessType, vector).getResult(0);
+}
+
+// Interleaves the 4 byte vectors of kRows, one per kk, into the [lane][kk] layout of vpdpbusd and vpmaddubsw
+mlir::Value InterleaveByteQuads(mlir::PatternRewriter& rewriter, mlir::Location loc, llvm::ArrayRef<mlir::Value> kRows)
+{
+    auto numLanes = kRows[0].getType().cast<mlir::VectorType>().getNumElements();
+    std::vector<int64_t> concatMask(2 * numLanes);
+    std::iota(concatMask.begin(), concatMask.end(), 0);
+    auto lowRows = rewriter.create<mlir::vector::ShuffleOp>(loc, kRows[0], kRows[1], concatMask);
+    auto highRows = rewriter.create<mlir::vector::ShuffleOp>(loc, kRows[2], kRows[3], concatMask);
+
+    // Row kk starts at element kk * numLanes of the concatenation of lowRows and highRows
+    std::vector<int64_t> interleaveMask;
+    for (int64_t lane = 0; lane < numLanes; ++lane)
+    {
+        for (int64_t kk = 0; kk < 4; ++kk)
+        {
+            interleaveMask.push_back(kk * numLanes + lane);
+        }
+    }
+    return rewriter.create<mlir::vector::ShuffleOp>(loc, lowRows, highRows, interleaveMask);
+}
+} // namespace
+
+LogicalResult CPUTensorizeAffineForOpConversion::matchAndRewrite(AffineForOp affineForOp, PatternRewriter& rewriter) const
+{
+    if (!HasTensorizationInfo(affineForOp))
+    {
+        return failure();
+    }
+
+    auto tensorizationInfo = GetTensorizationInfo(affineForOp);
+    if (!IsCPUMMAShape(tensorizationInfo.dim))
+    {
+        return failure();
+    }
+    const v::MMAOp mmaOp(tensorizationInfo.dim);
+    const int64_t numLanes = mmaOp.getN();
+
+    // K = 4 shapes are int8 dot products, K = 1 shapes are floating point outer products
+    const bool isFloatKernel = mmaOp.getK() == 1;
+
+    SmallVector<AffineForOp, 4> nestedLoops;
+    mlir::getPerfectlyNestedLoops(nestedLoops, affineForOp);
+    if (nestedLoops.size() != 3 || !llvm::all_of(nestedLoops, [](mlir::AffineForOp loop) { return HasTensorizationInfo(loop); }))
+    {
+        return rewriter.notifyMatchFailure(affineForOp, "Expected exactly 3 perfectly nested tensorized loops");
+    }
+    for (auto loop : nestedLoops)
+    {
+        if (!loop.hasConstantBounds() || loop.getConstantLowerBound() != 0)
+        {
+            return rewriter.notifyMatchFailure(loop, "Tensorized loops must have constant bounds starting at 0");
+        }
+    }
+
+    auto innerLoop = nestedLoops.back();
+    auto innerBody = innerLoop.getBody();
+    mlir::Operation* scope = affineForOp.getOperation();
+
+    // Match C[...] = C[...] + cast(A[...], int32) * cast(B[...], int32), or C[...] = C[...] + A[...] * B[...] for
+    // floating point C, starting from the store
+    std::vector<mlir::Operation*> matchedOps;
+    mlir::AffineStoreOp storeCOp;
+    std::vector<std::pair<mlir::AffineLoadOp, mlir::AffineStoreOp>> redundantCopies;
+    for (auto& op : innerBody->without_terminator())
+    {
+        auto storeOp = dyn_cast<mlir::AffineStoreOp>(&op);
+        if (!storeOp)
+        {
+            continue;
+        }
+        // A load and store of the same element is sometimes left behind, it can be dropped
+        auto copiedLoad = storeOp.getValueToStore().getDefiningOp<mlir::AffineLoadOp>();
+        if (copiedLoad && copiedLoad.getMemRef() == storeOp.getMemRef() && AreSameElement(copiedLoad, storeOp))
+        {
+            redundantCopies.emplace_back(copiedLoad, storeOp);
+            continue;
+        }
+        if (storeCOp)
+        {
+            return rewriter.notifyMatchFailure(storeOp, "Expected a single store into C");
+        }
+        storeCOp = storeOp;
+    }
+    auto cElementType = storeCOp ? storeCOp.getMemRefType().getElementType() : mlir::Type{};
+    if (!storeCOp || !(isFloatKernel ? cElementType.isa<mlir::FloatType>() : cElementType.isInteger(32)))
+    {
+        return rewriter.notifyMatchFailure(affineForOp, isFloatKernel ? "Failed to match the store into a floating point C" : "Failed to match the store into an int32 C");
+    }
+    matchedOps.push_back(storeCOp);
+
+    auto accumC = LookThroughConversionCasts(storeCOp.getValueToStore(), matchedOps).getDefiningOp<v::BinOp>();
+    if (!accumC || accumC.predicate() != v::BinaryOpPredicate::ADD)
+    {
+        return rewriter.notifyMatchFailure(storeCOp, "Failed to match the accumulation op");
+    }
+    matchedOps.push_back(accumC);
+
+    mlir::AffineLoadOp loadCOp;
+    v::BinOp mulAB;
+    for (auto operand : { accumC.lhs(), accumC.rhs() })
+    {
+        auto source = LookThroughConversionCasts(operand, matchedOps);
+        if (auto loadOp = source.getDefiningOp<mlir::AffineLoadOp>(); loadOp && !loadCOp)
+        {
+            loadCOp = loadOp;
+        }
+        else if (auto binOp = source.getDefiningOp<v::BinOp>(); binOp && binOp.predicate() == v::BinaryOpPredicate::MUL)
+        {
+            mulAB = binOp;
+        }
+    }
+    if (!loadCOp || !mulAB || loadCOp.getMemRef() != storeCOp.getMemRef() || !AreSameElement(loadCOp, storeCOp))
+    {
+        return rewriter.notifyMatchFailure(accumC, "Failed to match the accumulation operands");
+    }
+    matchedOps.push_back(loadCOp);
+    matchedOps.push_back(mulAB);
+
+    auto matchOperand = isFloatKernel ? MatchFloatOperand : MatchInt8Operand;
+    auto lhs = matchOperand(mulAB.lhs(), matchedOps);
+    auto rhs = matchOperand(mulAB.rhs(), matchedOps);
+    if (!lhs || !rhs)
+    {
+        return rewriter.notifyMatchFailure(mulAB, "Failed to match the multiplication operands");
+    }
+    auto isWiderThanC = [&](const CPUMatmulOperand& operand) {
+        return operand.loadOp.getMemRefType().getElementTypeBitWidth() > cElementType.getIntOrFloatBitWidth();
+    };
+    if (isFloatKernel && (isWiderThanC(*lhs) || isWiderThanC(*rhs)))
+    {
+        // The operands are only ever extended to the element type of C
+        return rewriter.notifyMatchFailure(mulAB, "The multiplication operands can't be wider than C");
+    }
+
+    // Everything else in the body must be side-effect free (e.g. index computations)
+    for (auto& op : innerBody->without_terminator())
+    {
+        auto isMatched = llvm::is_contained(matchedOps, &op) ||
+                         llvm::any_of(redundantCopies, [&](const auto& copy) { return copy.first == &op || copy.second == &op; });
+        if (!isMatched && !mlir::MemoryEffectOpInterface::hasNoEffect(&op))
+        {
+            return rewriter.notifyMatchFailure(&op, "Unexpected op in the tensorized loop body");
+        }
+    }
+
+    // Assign the loop roles: C is indexed by i and j, the row operand by i and k, the column operand by j and k
+    std::optional<mlir::AffineForOp> kLoop;
+    std::vector<mlir::AffineForOp> outputLoops;
+    for (auto loop : nestedLoops)
+    {
+        if (AccessDependsOnLoop(loadCOp, loop))
+        {
+            outputLoops.push_back(loop);
+        }
+        else
+        {
+            kLoop = loop;
+        }
+    }
+    if (!kLoop || outputLoops.size() != 2 || !AccessDependsOnLoop(lhs->loadOp, *kLoop) || !AccessDependsOnLoop(rhs->loadOp, *kLoop))
+    {
+        return rewriter.notifyMatchFailure(affineForOp, "Failed to match the reduction index of the matmul");
+    }
+
+    auto tripCount = [](mlir::AffineForOp loop) { return static_cast<int64_t>(*mlir::getConstantTripCount(loop)); };
+
+    // j is the (innermost, if ambiguous) output loop with N iterations, or a multiple of N for the register tiles
+    std::optional<mlir::AffineForOp> iLoop, jLoop;
+    for (auto it = outputLoops.rbegin(); it != outputLoops.rend(); ++it)
+    {
+        if (!jLoop && (isFloatKernel ? tripCount(*it) % numLanes == 0 : tripCount(*it) == numLanes))
+        {
+            jLoop = *it;
+        }
+        else
+        {
+            iLoop = *it;
+        }
+    }
+    if (!iLoop || !jLoop)
+    {
+        return rewriter.notifyMatchFailure(affineForOp, "The tensorized column index must have as many iterations as the MMA shape's N (or a multiple of N for the register tile shapes)");
+    }
+    if (!isFloatKernel && tripCount(*kLoop) % 4 != 0)
+    {
+        return rewriter.notifyMatchFailure(*kLoop, "The tensorized reduction index must have a multiple of 4 iterations");
+    }
+
+    auto isOperandOf = [&](const CPUMatmulOperand& operand, mlir::AffineForOp loop, mlir::AffineForOp otherLoop) {
+        return AccessDependsOnLoop(operand.loadOp, loop) && !AccessDependsOnLoop(operand.loadOp, otherLoop);
+    };
+    auto rowOperand = *lhs;
+    auto colOperand = *rhs;
+    if (!isOperandOf(rowOperand, *iLoop, *jLoop))
+    {
+        std::swap(rowOperand, colOperand);
+    }
+    if (!isOperandOf(rowOperand, *iLoop, *jLoop) || !isOperandOf(colOperand, *jLoop, *iLoop))
+    {
+        return rewriter.notifyMatchFailure(mulAB, "The multiplication operands must be indexed by (i, k) and (k, j)");
+    }
+
+    // Rewrite
+    auto loc = innerLoop.getLoc();
+    mlir::OpBuilder::InsertionGuard guard(rewriter);
+    rewriter.setInsertionPoint(innerBody, innerBody->getTerminator()->getIterator());
+    rewriter.startRootUpdate(affineForOp);
+
+    auto indexAt = [&](mlir::AffineForOp loop, int64_t iter) -> mlir::Value {
+        return rewriter.create<mlir::ConstantIndexOp>(loc, iter * loop.getStep());
+    };
+    // Clones a memory op of the loop body for the given values of the tensorized loops' induction variables
+    auto cloneWith = [&](mlir::Operation* op, mlir::Value iIndex, mlir::Value jIndex, mlir::Value kIndex, std::optional<std::pair<mlir::Value, mlir::Value>> valueMapping = std::nullopt) {
+        mlir::BlockAndValueMapping mapping;
+        mapping.map(iLoop->getInductionVar(), iIndex);
+        mapping.map(jLoop->getInductionVar(), jIndex);
+        mapping.map(kLoop->getInductionVar(), kIndex);
+        if (valueMapping)
+        {
+            mapping.map(valueMapping->first, valueMapping->second);
+        }
+        return CloneWithOperands(rewriter, op, mapping, scope);
+    };
+    // Clones a memory op of the loop body for the iteration (iIter, jIter, kIter) of the tensorized loops
+    auto cloneAt = [&](mlir::Operation* op, int64_t iIter, int64_t jIter, int64_t kIter, std::optional<std::pair<mlir::Value, mlir::Value>> valueMapping = std::nullopt) {
+        return cloneWith(op, indexAt(*iLoop, iIter), indexAt(*jLoop, jIter), indexAt(*kLoop, kIter), valueMapping);
+    };
+
+    auto numRows = tripCount(*iLoop);
+    if (isFloatKernel)
+    {
+        // Register-blocked outer product: the numRows x numColVectors accumulator vectors stay in registers across a
+        // loop over the whole reduction, where each step broadcasts one element of the row operand per row and
+        // multiply-accumulates it with each vector of the column operand
+        auto numColVectors = tripCount(*jLoop) / numLanes;
+        auto accType = mlir::VectorType::get({ numLanes }, cElementType);
+        auto toAccType = [&](mlir::Value value) -> mlir::Value {
+            auto valueType = value.getType().isa<mlir::VectorType>() ? mlir::Type{ mlir::VectorType::get(value.getType().cast<mlir::VectorType>().getShape(), cElementType) } : cElementType;
+            return value.getType() == valueType ? value : rewriter.create<mlir::FPExtOp>(loc, value, valueType);
+        };
+        auto vectorLoadAt = [&](mlir::AffineLoadOp loadOp, int64_t iIter, int64_t jIter, mlir::Value kIndex) {
+            return toAccType(CreateLaneVectorLoad(rewriter, loc, numLanes, [&](int64_t lane) {
+                return mlir::cast<mlir::AffineLoadOp>(cloneWith(loadOp, indexAt(*iLoop, iIter), indexAt(*jLoop, jIter + lane), kIndex));
+            }));
+        };
+
+        std::vector<mlir::Value> initAccs;
+        for (int64_t row = 0; row < numRows; ++row)
+        {
+            for (int64_t colVector = 0; colVector < numColVectors; ++colVector)
+            {
+                initAccs.push_back(vectorLoadAt(loadCOp, row, colVector * numLanes, indexAt(*kLoop, 0)));
+            }
+        }
+
+        auto kStep = kLoop->getStep();
+        auto reductionLoop = rewriter.create<mlir::AffineForOp>(loc, 0, tripCount(*kLoop) * kStep, kStep, initAccs);
+        {
+            mlir::OpBuilder::InsertionGuard bodyGuard(rewriter);
+            rewriter.setInsertionPointToStart(reductionLoop.getBody());
+            auto kIndex = reductionLoop.getInductionVar();
+
+            std::vector<mlir::Value> colVectors;
+            for (int64_t colVector = 0; colVector < numColVectors; ++colVector)
+            {
+                colVectors.push_back(vectorLoadAt(colOperand.loadOp, 0, colVector * numLanes, kIndex));
+            }
+
+            std::vector<mlir::Value> accs(reductionLoop.getRegionIterArgs().begin(), reductionLoop.getRegionIterArgs().end());
+            for (int64_t row = 0; row < numRows; ++row)
+            {
+                auto rowElement = toAccType(cloneWith(rowOperand.loadOp, indexAt(*iLoop, row), indexAt(*jLoop, 0), kIndex)->getResult(0));
+                mlir::Value rowVector = rewriter.create<mlir::vector::BroadcastOp>(loc, accType, rowElement);
+                for (int64_t colVector = 0; colVector < numColVectors; ++colVector)
+                {
+                    auto& acc = accs[row * numColVectors + colVector];
+                    acc = EmitFloatMultiplyAccumulate(rewriter, loc, tensorizationInfo.instructionSet, acc, rowVector, colVectors[colVector]);
+                }
+            }
+            rewriter.create<mlir::AffineYieldOp>(loc, accs);
+        }
+
+        for (int64_t row = 0; row < numRows; ++row)
+        {
+            for (int64_t colVector = 0; colVector < numColVectors; ++colVector)
+            {
+                CreateLaneVectorStore(rewriter, loc, reductionLoop.getResult(row * numColVectors + colVector), [&](int64_t lane, mlir::Value element) {
+                    return mlir::cast<mlir::AffineStoreOp>(cloneAt(storeCOp, row, colVector * numLanes + lane, 0, std::pair{ storeCOp.getValueToStore(), element }));
+                });
+            }
+        }
+    }
+    else
+    {
+        auto i8Type = rewriter.getIntegerType(8);
+        auto i32Type = rewriter.getIntegerType(32);
+        auto accType = mlir::VectorType::get({ numLanes }, i32Type);
+        auto byteVecType = mlir::VectorType::get({ 4 * numLanes }, i8Type);
+
+        // The accumulators stay in registers for the whole reduction, which is a loop over groups of 4 k iterations
+        // rather than being unrolled, so that the code size doesn't grow with K
+        std::vector<mlir::Value> initAccs;
+        for (int64_t row = 0; row < numRows; ++row)
+        {
+            initAccs.push_back(ToSignlessVector(rewriter, loc, CreateLaneVectorLoad(rewriter, loc, numLanes, [&](int64_t lane) {
+                                                    return mlir::cast<mlir::AffineLoadOp>(cloneAt(loadCOp, row, lane, 0));
+                                                })));
+        }
+
+        auto kStep = kLoop->getStep();
+        auto reductionLoop = rewriter.create<mlir::AffineForOp>(loc, 0, tripCount(*kLoop) * kStep, 4 * kStep, initAccs);
+        {
+            mlir::OpBuilder::InsertionGuard bodyGuard(rewriter);
+            rewriter.setInsertionPointToStart(reductionLoop.getBody());
+            auto kGroupIndex = reductionLoop.getInductionVar();
+            std::vector<mlir::Value> kIndices;
+            for (int64_t kk = 0; kk < 4; ++kk)
+            {
+                auto kkMap = mlir::AffineMap::get(1, 0, rewriter.getAffineDimExpr(0) + kk * kStep);
+                kIndices.push_back(rewriter.create<mlir::AffineApplyOp>(loc, kkMap, mlir::ValueRange{ kGroupIndex }));
+            }
+
+            // Load the numLanes column bytes of each kk (a single vector load when the column operand is row-major)
+            // and interleave them as [lane][kk], which is the operand layout of vpdpbusd and vpmaddubsw
+            std::vector<mlir::Value> colRows;
+            for (int64_t kk = 0; kk < 4; ++kk)
+            {
+                colRows.push_back(ToSignlessVector(rewriter, loc, CreateLaneVectorLoad(rewriter, loc, numLanes, [&](int64_t lane) {
+                                                       return mlir::cast<mlir::AffineLoadOp>(cloneWith(colOperand.loadOp, indexAt(*iLoop, 0), indexAt(*jLoop, lane), kIndices[kk]));
+                                                   })));
+            }
+            auto colBytes = InterleaveByteQuads(rewriter, loc, colRows);
+
+            std::vector<mlir::Value> accs(reductionLoop.getRegionIterArgs().begin(), reductionLoop.getRegionIterArgs().end());
+            for (int64_t row = 0; row < numRows; ++row)
+            {
+                // Broadcast the 4 row bytes to every lane
+                auto quad = ToSignlessVector(rewriter, loc, CreateLaneVectorLoad(rewriter, loc, 4, [&](int64_t kk) {
+                                                 return mlir::cast<mlir::AffineLoadOp>(cloneWith(rowOperand.loadOp, indexAt(*iLoop, row), indexAt(*jLoop, 0), kIndices[kk]));
+                                             }));
+                auto quadAsDword = rewriter.create<mlir::vector::BitCastOp>(loc, mlir::VectorType::get({ 1 }, i32Type), quad);
+                auto dword = rewriter.create<mlir::vector::ExtractOp>(loc, quadAsDword, 0);
+                auto dwords = rewriter.create<mlir::vector::BroadcastOp>(loc, accType, dword);
+                auto rowBytes = rewriter.create<mlir::vector::BitCastOp>(loc, byteVecType, dwords);
+
+                accs[row] = EmitInt8DotProductAccumulate(rewriter, innerLoop, tensorizationInfo.instructionSet, accs[row], rowBytes, rowOperand.isUnsigned, colBytes, colOperand.isUnsigned);
+            }
+            rewriter.create<mlir::AffineYieldOp>(loc, accs);
+        }
+        auto cVectorType = mlir::VectorType::get({ numLanes }, cElementType);
+        for (int64_t row = 0; row < numRows; ++row)
+        {
+            mlir::Value acc = reductionLoop.getResult(row);
+            if (cVectorType != accType)
+            {
+                acc = rewriter.create<mlir::UnrealizedConversionCastOp>(loc, cVectorType, acc).getResult(0);
+            }
+            CreateLaneVectorStore(rewriter, loc, acc, [&](int64_t lane, mlir::Value element) {
+                return mlir::cast<mlir::AffineStoreOp>(cloneAt(storeCOp, row, lane, 0, std::pair{ storeCOp.getValueToStore(), element }));
+            });
+        }
+    }
+
+    // Erase the scalar body, users first
+    for (auto& [loadOp, storeOp] : redundantCopies)
+    {
+        rewriter.eraseOp(storeOp);
+        rewriter.eraseOp(loadOp);
+    }
+    llvm::DenseSet<mlir::Operation*> erasedOps;
+    for (auto op : matchedOps)
+    {
+        if (!erasedOps.count(op) && op->use_empty())
+        {
+            erasedOps.insert(op);
+            rewriter.eraseOp(op);
+        }
+    }
+
+    for (auto loop : nestedLoops)
+    {
+        // run each loop once
+        loop.setConstantUpperBound(loop.getStep());
+        RemoveTensorizationInfo(loop);
+    }
+    rewriter.finalizeRootUpdate(affineForOp);
+
+    return success();
+}
+
+// Parallelizes a loop that accumulates into arrays (e.g. the K loop of a matrix multiplication) by giving each thread a
+// private accumulator for each array, then combining the accumulators into the arrays once the parallel loop is done:
+//
+//   affine.for %k = 0 to 1024 {                  affine.parallel (%t) = (0) to (4) {
+//     %0 = affine.load %C[%i, %j]                  <fill %C_private[%t] with 0>
+//     %1 = accv.bin_op "ADD" %0, %x      -->       affine.for %k = (%t * 256) to min(%t * 256 + 256, 1024) {
+//     affine.store %1, %C[%i, %j]                    %0 = affine.load %C_private[%t, 0, 0]
+//   }                                                %1 = accv.bin_op "ADD" %0, %x
+//                                                    affine.store %1, %C_private[%t, 0, 0]
+//                                                  }
+//                                                }
+//                                                <%C[%i, %j] += (%C_private[0] + %C_private[1]) + (%C_private[2] + %C_private[3])>
+//
+// The accumulators only hold the positions that the loop accesses: dimensions that every access indexes with the same
+// value defined outside of the loop (like %i and %j above) have a size of 1. They are allocated per call, on the stack
+// when they are small and on the heap otherwise. They are combined pairwise, with the innermost dimension vectorized
+// when the array layout allows it.
+LogicalResult ParallelizeReductionAffineForOp(AffineForOp affineForOp, ParallelizationInfo parallelizationInfo, const std::vector<ParallelReductionInfo>& reductions, PatternRewriter& rewriter)
+{
+    auto loc = affineForOp.getLoc();
+
+    auto runSerially = [&]() {
+        rewriter.updateRootInPlace(affineForOp, [&] { RemoveParallelizationInfo(affineForOp); });
+        return success();
+    };
+
+    for (auto parentOp = affineForOp->getParentOp(); parentOp; parentOp = parentOp->getParentOp())
+    {
+        if (isa<AffineParallelOp>(parentOp) || (isa<AffineForOp>(parentOp) && HasParallelizationInfo(parentOp)))
+        {
+            // The threads of the enclosing parallel loop would share the private accumulators,
+            // so the reduction runs serially within each of those threads instead
+            return runSerially();
+        }
+    }
+
+    auto lowerBound = affineForOp.getConstantLowerBound();
+    auto upperBound = affineForOp.getConstantUpperBound();
+    auto step = affineForOp.getStep();
+    auto numIterations = CeilDiv(upperBound - lowerBound, step);
+    if (numIterations <= 1 || parallelizationInfo.numThreads <= 1)
+    {
+        return runSerially();
+    }
+
+    // Thread t runs the contiguous range of iterations [t * iterationsPerThread, (t + 1) * iterationsPerThread)
+    auto iterationsPerThread = CeilDiv(numIterations, std::min(parallelizationInfo.numThreads, numIterations));
+    auto numThreads = CeilDiv(numIterations, iterationsPerThread);
+    parallelizationInfo.numThreads = numThreads;
+
+    // The accumulators are allocated per call, so that concurrent calls don't share them. Each thread initializes its own
+    // accumulator, which already places its pages on the NUMA node of the thread.
+    auto allocationScope = affineForOp->getParentWithTrait<mlir::OpTrait::FunctionLike>();
+    std::vector<mlir::Value> privateAccumulators;
+    std::vector<mlir::Value> heapAccumulators;
+    for (const auto& reduction : reductions)
+    {
+        OpBuilder::InsertionGuard guard(rewriter);
+        auto arrayType = reduction.array.getType().cast<MemRefType>();
+        SmallVector<int64_t, 4> accumulatorShape{ numThreads };
+        for (unsigned dim = 0; dim < arrayType.getRank(); ++dim)
+        {
+            accumulatorShape.push_back(reduction.fixedPositions[dim] ? 1 : arrayType.getDimSize(dim));
+        }
+        auto accumulatorType = MemRefType::get(accumulatorShape, arrayType.getElementType());
+        auto accumulatorBytes = accumulatorType.getNumElements() * std::max<int64_t>(1, accumulatorType.getElementTypeBitWidth() / 8);
+        if (accumulatorBytes <= MaxStackReductionAccumulatorBytes && allocationScope)
+        {
+            // Allocated once at the top of the function, rather than each time an enclosing loop runs the parallel region
+            rewriter.setInsertionPointToStart(&allocationScope->getRegion(0).front());
+            privateAccumulators.push_back(rewriter.create<memref::AllocaOp>(loc, accumulatorType, mlir::ValueRange{}, rewriter.getI64IntegerAttr(AVX2Alignment)));
+        }
+        else
+        {
+            rewriter.setInsertionPoint(affineForOp);
+            auto accumulator = rewriter.create<memref::AllocOp>(loc, accumulatorType, mlir::ValueRange{}, rewriter.getI64IntegerAttr(AVX2Alignment));
+            privateAccumulators.push_back(accumulator);
+            heapAccumulators.push_back(accumulator);
+        }
+    }
+
+    // Creates a loop nest that iterates over the shape, and leaves the insertion point in the innermost loop
+    auto createLoopNest = [&](ArrayRef<int64_t> shape, int64_t innermostStep) {
+        SmallVector<mlir::Value, 4> ivs;
+        for (unsigned dim = 0; dim < shape.size(); ++dim)
+        {
+            auto loop = rewriter.create<AffineForOp>(loc, 0, shape[dim], dim + 1 == shape.size() ? innermostStep : 1);
+            rewriter.setInsertionPointToStart(loop.getBody());
+            ivs.push_back(loop.getInductionVar());
+        }
+        return ivs;
+    };
+
+    rewriter.setInsertionPoint(affineForOp);
+    auto parallelLbMap = rewriter.getConstantAffineMap(0);
+    auto parallelUbMap = rewriter.getConstantAffineMap(numThreads);
+    int64_t parallelStep = 1;
+    auto parallelOp = rewriter.create<AffineParallelOp>(loc, /*resultTypes=*/llvm::None, /*reductionKinds=*/llvm::None, llvm::makeArrayRef(parallelLbMap), ValueRange{}, llvm::makeArrayRef(parallelUbMap), ValueRange{}, llvm::makeArrayRef(parallelStep));
+    SetParallelizationAttributes(parallelOp, parallelizationInfo, rewriter);
+    auto threadIndex = parallelOp.getIVs()[0];
+
+    {
+        OpBuilder::InsertionGuard guard(rewriter);
+        rewriter.setInsertionPointToStart(parallelOp.getBody());
+
+        // Fill the private accumulators with the identity of the reduction
+        for (unsigned i = 0; i < reductions.size(); ++i)
+        {
+            OpBuilder::InsertionGuard fillGuard(rewriter);
+            auto arrayType = reductions[i].array.getType().cast<MemRefType>();
+            auto elementType = arrayType.getElementType();
+            auto identity = reductions[i].kind == ParallelReductionKind::Sum ? rewriter.getZeroAttr(elementType) : util::GetOneAttr(rewriter, elementType);
+            auto identityValue = rewriter.create<mlir::ConstantOp>(loc, identity);
+            SmallVector<mlir::Value, 4> indices{ threadIndex };
+            auto ivs = createLoopNest(privateAccumulators[i].getType().cast<MemRefType>().getShape().drop_front(), 1);
+            indices.append(ivs.begin(), ivs.end());
+            rewriter.create<AffineStoreOp>(loc, identityValue, privateAccumulators[i], indices);
+        }
+
+        // Move the loop body into a loop over the iterations of this thread
+        auto d0 = rewriter.getAffineDimExpr(0);
+        auto chunkSize = iterationsPerThread * step;
+        auto chunkLbMap = AffineMap::get(1, 0, d0 * chunkSize + lowerBound);
+        auto chunkUbMap = AffineMap::get(1, 0, { d0 * chunkSize + (lowerBound + chunkSize), rewriter.getAffineConstantExpr(upperBound) }, rewriter.getContext());
+        auto chunkLoop = rewriter.create<AffineForOp>(loc, ValueRange{ threadIndex }, chunkLbMap, ValueRange{ threadIndex }, chunkUbMap, step);
+        for (auto attr : affineForOp->getAttrs())
+        {
+            if (attr.first != AffineForOp::getLowerBoundAttrName() && attr.first != AffineForOp::getUpperBoundAttrName() && attr.first != AffineForOp::getStepAttrName() && attr.first != ParallelizationInfoAttr::getKeyName())
+            {
+                chunkLoop->setAttr(attr.first, attr.second);
+            }
+        }
+
+        auto body = affineForOp.getBody();
+        auto chunkBody = chunkLoop.getBody();
+        chunkBody->getOperations().splice(Block::iterator(chunkBody->getTerminator()), body->getOperations(), body->begin(), std::prev(body->end()));
+        affineForOp.getInductionVar().replaceAllUsesWith(chunkLoop.getInductionVar());
+
+        for (unsigned i = 0; i < reductions.size(); ++i)
+        {
+            for (auto accessOp : reductions[i].accesses)
+            {
+                RedirectToPrivateAccumulator(accessOp, privateAccumulators[i], reductions[i].fixedPositions, threadIndex, rewriter);
+            }
+        }
+    }
+
+    // Combine the private accumulators into the arrays
+    std::optional<VectorizationInfo> vectorizationInfo;
+    if (auto lambdaOp = affineForOp->getParentOfType<v::ValueLambdaOp>(); lambdaOp && HasVectorizationInfo(lambdaOp))
+    {
+        vectorizationInfo = GetVectorizationInfo(lambdaOp);
+    }
+
+    rewriter.setInsertionPointAfter(parallelOp);
+    for (unsigned i = 0; i < reductions.size(); ++i)
+    {
+        OpBuilder::InsertionGuard guard(rewriter);
+        auto kind = reductions[i].kind;
+        auto array = reductions[i].array;
+        auto arrayType = array.getType().cast<MemRefType>();
+        auto shape = privateAccumulators[i].getType().cast<MemRefType>().getShape().drop_front();
+        auto elementType = arrayType.getElementType();
+        const auto& fixedPositions = reductions[i].fixedPositions;
+
+        int64_t vectorSize = 1;
+        auto layoutMaps = arrayType.getAffineMaps();
+        bool hasIdentityLayout = layoutMaps.empty() || (layoutMaps.size() == 1 && layoutMaps.front().isIdentity());
+        if (vectorizationInfo && !shape.empty() && !fixedPositions.back() && hasIdentityLayout && elementType.isIntOrFloat())
+        {
+            auto elementsPerVector = vectorizationInfo->vectorBytes / std::max<int64_t>(1, elementType.getIntOrFloatBitWidth() / 8);
+            if (elementsPerVector > 1 && shape.back() % elementsPerVector == 0)
+            {
+                vectorSize = elementsPerVector;
+            }
+        }
+        auto vectorType = VectorType::get({ vectorSize }, elementType);
+
+        // The loops run over the positions held by the accumulators, the dimensions with a fixed position go to that position of the array
+        auto ivs = createLoopNest(shape, vectorSize);
+        SmallVector<mlir::Value, 4> arrayIndices;
+        for (unsigned dim = 0; dim < ivs.size(); ++dim)
+        {
+            if (!fixedPositions[dim])
+            {
+                arrayIndices.push_back(ivs[dim]);
+            }
+            else if (auto position = fixedPositions[dim].dyn_cast<mlir::Value>())
+            {
+                arrayIndices.push_back(position);
+            }
+            else
+            {
+                arrayIndices.push_back(rewriter.create<ConstantIndexOp>(loc, fixedPositions[dim].get<mlir::Attribute>().cast<IntegerAttr>().getInt()));
+            }
+        }
+        auto load = [&](mlir::Value memref, mlir::ValueRange indices) -> mlir::Value {
+            if (vectorSize > 1)
+            {
+                return rewriter.create<vector::LoadOp>(loc, vectorType, memref, indices);
+            }
+            return rewriter.create<memref::LoadOp>(loc, memref, indices);
+        };
+
+        SmallVector<mlir::Value, 8> partials;
+        for (int64_t thread = 0; thread < numThreads; ++thread)
+        {
+            SmallVector<mlir::Value, 4> indices{ rewriter.create<ConstantIndexOp>(loc, thread) };
+            indices.append(ivs.begin(), ivs.end());
+            partials.push_back(load(privateAccumulators[i], indices));
+        }
+        while (partials.size() > 1)
+        {
+            SmallVector<mlir::Value, 8> combined;
+            for (unsigned p = 0; p + 1 < partials.size(); p += 2)
+            {
+                combined.push_back(CreateReductionCombineOp(rewriter, loc, kind, partials[p], partials[p + 1]));
+            }
+            if (partials.size() % 2 != 0)
+            {
+                combined.push_back(partials.back());
+            }
+            partials = std::move(combined);
+        }
+
+        auto result = CreateReductionCombineOp(rewriter, loc, kind, load(array, arrayIndices), partials.front());
+        if (vectorSize > 1)
+        {
+            rewriter.create<vector::StoreOp>(loc, result, array, arrayIndices);
+        }
+        else
+        {
+            rewriter.create<memref::StoreOp>(loc, result, array, arrayIndices);
+        }
+    }
+
+    // The combine loops are inserted between the parallel loop and the original loop
+    rewriter.setInsertionPoint(affineForOp);
+    for (auto accumulator : heapAccumulators)
+    {
+        rewriter.create<memref::DeallocOp>(loc, accumulator);
+    }
+
+    rewriter.eraseOp(affineForOp);
+    return success();
+}
+
+LogicalResult ParallelizeAffineForOpConversion::matchAndRewrite(AffineForOp affineForOp, PatternRewriter& rewriter) const
+{
+    if (!HasParallelizationInfo(affineForOp))
+    {
+        // This isn't an AffineForOp marked for parallelization so just return without modifying it
+        return success();
+    }
+
+    assert(affineForOp.hasConstantLowerBound() && "Parallelized loops must have a constant lower bound");
+    assert(affineForOp.hasConstantUpperBound() && "Parallelized loops must have a constant upper bound");
+
+    auto parallelizationInfo = GetParallelizationInfo(affineForOp);
+
+    // Loops that accumulate into arrays at positions that do not depend on the loop index (e.g. the K loop of a matrix multiplication)
+    // are parallelized with one private accumulator per thread. Reductions that cannot be privatized keep the previous behavior.
+    std::vector<ParallelReductionInfo> reductions;
+    if (succeeded(GetParallelReductions(affineForOp, reductions)) && !reductions.empty())
+    {
+        return ParallelizeReductionAffineForOp(affineForOp, parallelizationInfo, reductions, rewriter);
+    }
+
+    rewriter.startRootUpdate(affineForOp);
+
+    //  Replace affine.for with affine.parallel, tagged with vectorization info
+    //  cf. mlir::affineParallelize() in  mlir\lib\Dialect\Affine\Utils\Utils.cpp
+    //  lowering path: affine.parallel -> scf.parallel -> omp.parallel + omp.wsloop
+    auto newParallelOp = rewriter.create<mlir::AffineParallelOp>(
+        affineForOp.getLoc(), /*resultTypes=*/llvm::None, /*reductionKinds=*/llvm::None, llvm::makeArrayRef(affineForOp.getLowerBoundMap()), affineForOp.getLowerBoundOperands(), llvm::makeArrayRef(affineForOp.getUpperBoundMap()), affineForOp.getUpperBoundOperands(), llvm::makeArrayRef(affineForOp.getStep()));
+
+    // Move the loop block to the new op
+    rewriter.inlineRegionBefore(affineForOp.region(), newParallelOp.region(), newParallelOp.region().begin());
+
+    // Unpack the parallelization info into OpenMP dialect attributes
+    SetParallelizationAttributes(newParallelOp, parallelizationInfo, rewriter);
+
+    rewriter.eraseOp(affineForOp);
+    rewriter.finalizeRootUpdate(affineForOp);
+
+    return success();
+}
+
+LogicalResult CollapseAffineParallelOpsRewrite::matchAndRewrite(AffineParallelOp affineParallelOp, PatternRewriter& rewriter) const
+{
+    // Find a pair of perfectly nested ops (i.e. affineParallelOp with a child AffineParallelOp):
+    // ...
     //  affine.parallel { <-- parent (do the rewrite at this level)
     //      affine.parallel { <-- child
     //          ...
@@ -6996,6 +8889,10 @@ LogicalResult CollapseAffineParallelOpsRewrite::matchAndRewrite(AffineParallelOp
     mergedParallelOp->setAttr(mlir::omp::getNumThreadsAttrName(), affineParallelOp->getAttr(mlir::omp::getNumThreadsAttrName()));
     mergedParallelOp->setAttr(mlir::omp::getScheduleAttrName(), affineParallelOp->getAttr(mlir::omp::getScheduleAttrName()));
     mergedParallelOp->setAttr(mlir::omp::getProcBindAttrName(), affineParallelOp->getAttr(mlir::omp::getProcBindAttrName()));
+    if (HasParallelizationInfo(affineParallelOp))
+    {
+        mergedParallelOp->setAttr(ParallelizationInfoAttr::getKeyName(), affineParallelOp->getAttr(ParallelizationInfoAttr::getKeyName()));
+    }
 
     // Merge and set the collapse attribute
     int64_t collapse = (affineParallelOp->hasAttrOfType<IntegerAttr>(mlir::omp::getCollapseAttrName())) ? affineParallelOp->getAttrOfType<IntegerAttr>(mlir::omp::getCollapseAttrName()).getInt() : 1;
@@ -7013,6 +8910,156 @@ LogicalResult CollapseAffineParallelOpsRewrite::matchAndRewrite(AffineParallelOp
     return success();
 }
 
+LogicalResult AffineParallelThreadAffinityRewrite::matchAndRewrite(AffineParallelOp affineParallelOp, PatternRewriter& rewriter) const
+{
+    // Lowers the thread placement policies that the OpenMP proc_bind clause cannot express into calls to the
+    // accera CPU runtime library (runtime/include/ThreadAffinity.h):
+    //
+    //   affine.parallel (%i, %j) = ... {
+    //     %tid = accv.call @omp_get_thread_num() : () -> i32
+    //     accv.call @AcceraBindThread(%tid, %numThreads, %affinity) : (i32, i32, i32) -> ()  // or AcceraBindThreadToCore(%core)
+    //     ...
+    //   }
+    //
+    // This runs after the perfectly nested parallel ops have been collapsed, so that the binding is done once at the top of the
+    // parallel region. The runtime caches the current binding per thread, so repeated calls from the same thread are cheap.
+    if (!HasParallelizationInfo(affineParallelOp))
+    {
+        return failure();
+    }
+
+    auto parallelizationInfo = GetParallelizationInfo(affineParallelOp);
+    auto loc = affineParallelOp.getLoc();
+    auto i32Type = rewriter.getI32Type();
+    auto i64Type = rewriter.getI64Type();
+
+    rewriter.startRootUpdate(affineParallelOp);
+    RemoveParallelizationInfo(affineParallelOp);
+
+    if (parallelizationInfo.numaFirstTouch)
+    {
+        // Touch the pages of the global cache buffers used in this parallel region from the threads that will use them,
+        // before anything else writes to them. The operating system places each page on the NUMA node of the thread that
+        // first touches it. The touch is done once per buffer, and is guarded by a zero-initialized flag that persists across calls.
+        llvm::SetVector<v::ReferenceGlobalOp> cacheGlobalRefs;
+        affineParallelOp.walk([&](Operation* op) {
+            for (auto operand : op->getOperands())
+            {
+                if (auto refGlobalOp = operand.getDefiningOp<v::ReferenceGlobalOp>();
+                    refGlobalOp && !affineParallelOp->isAncestor(refGlobalOp) && !refGlobalOp->hasAttr(NumaFirstTouchedAttrName))
+                {
+                    auto globalOp = refGlobalOp.getGlobal();
+                    if (globalOp && !globalOp.constant() && !globalOp.external() && refGlobalOp.getType().hasStaticShape() && refGlobalOp.getType().getRank() > 0)
+                    {
+                        cacheGlobalRefs.insert(refGlobalOp);
+                    }
+                }
+            }
+        });
+
+        // The touch loops are parallelized with the same placement policy (but without first-touch), and will be lowered by this pattern in turn
+        auto touchParallelizationInfo = parallelizationInfo;
+        touchParallelizationInfo.numaFirstTouch = false;
+        touchParallelizationInfo.isDynamicPolicy = false;
+
+        for (auto refGlobalOp : cacheGlobalRefs)
+        {
+            // Mark the reference so that other parallel regions using this buffer do not touch it again
+            refGlobalOp->setAttr(NumaFirstTouchedAttrName, rewriter.getUnitAttr());
+
+            // The page placement has to persist across calls, so the buffer can no longer share storage with others
+            refGlobalOp.getGlobal()->removeAttr(ScratchBufferAttrName);
+
+            OpBuilder::InsertionGuard guard(rewriter);
+
+            auto flagType = MemRefType::get({ 1 }, i32Type);
+            auto flagInit = DenseElementsAttr::get(RankedTensorType::get({ 1 }, i32Type), llvm::makeArrayRef<int32_t>(0));
+            auto flag = util::CreateGlobalBuffer(rewriter, refGlobalOp, flagType, refGlobalOp.getGlobal().sym_name().str() + "_first_touched", /*constant=*/false, flagInit);
+            auto flagRefOp = flag.getDefiningOp();
+            rewriter.setInsertionPointAfter(flagRefOp->isBeforeInBlock(refGlobalOp) ? refGlobalOp.getOperation() : flagRefOp);
+            auto zeroIndex = rewriter.create<ConstantIndexOp>(loc, 0);
+            auto zeroI32 = rewriter.create<ConstantIntOp>(loc, 0, i32Type);
+            auto oneI32 = rewriter.create<ConstantIntOp>(loc, 1, i32Type);
+
+            // Atomically swap in 1, so that only the first of several calls racing from different threads sees 0 and does the touch.
+            // The flag only ever goes from 0 to 1, so the exchange acts as a compare-and-swap of 0 with 1.
+            auto flagValue = rewriter.create<AtomicRMWOp>(loc, i32Type, AtomicRMWKind::assign, oneI32, flag, ValueRange{ zeroIndex });
+            auto notTouched = rewriter.create<CmpIOp>(loc, CmpIPredicate::eq, flagValue, zeroI32);
+            auto ifOp = rewriter.create<scf::IfOp>(loc, notTouched, /*withElseRegion=*/false);
+
+            rewriter.setInsertionPointToStart(ifOp.thenBlock());
+            auto buffer = refGlobalOp.getResult();
+            auto bufferType = refGlobalOp.getType();
+            auto shape = bufferType.getShape();
+            auto elementType = bufferType.getElementType();
+
+            // Distribute the outermost dimension across the threads with a static schedule, so that each thread touches a contiguous range of pages
+            auto lbMap = rewriter.getConstantAffineMap(0);
+            auto ubMap = rewriter.getConstantAffineMap(shape[0]);
+            int64_t step = 1;
+            auto touchOp = rewriter.create<AffineParallelOp>(loc, /*resultTypes=*/llvm::None, /*reductionKinds=*/llvm::None, llvm::makeArrayRef(lbMap), ValueRange{}, llvm::makeArrayRef(ubMap), ValueRange{}, llvm::makeArrayRef(step));
+            touchOp->setAttr(mlir::omp::getNumThreadsAttrName(), rewriter.getI64IntegerAttr(touchParallelizationInfo.numThreads));
+            touchOp->setAttr(mlir::omp::getScheduleAttrName(), rewriter.getStringAttr("Static"));
+            touchOp->setAttr(mlir::omp::getProcBindAttrName(), affineParallelOp->getAttr(mlir::omp::getProcBindAttrName()));
+            if (RequiresRuntimeThreadPlacement(touchParallelizationInfo))
+            {
+                touchOp->setAttr(ParallelizationInfoAttr::getKeyName(), ParallelizationInfoAttr::get(touchParallelizationInfo, rewriter.getContext()));
+            }
+
+            {
+                OpBuilder::InsertionGuard touchGuard(rewriter);
+                rewriter.setInsertionPointToStart(touchOp.getBody());
+                SmallVector<mlir::Value, 4> indices{ touchOp.getIVs()[0] };
+                for (auto dimSize : shape.drop_front())
+                {
+                    auto innerLoop = rewriter.create<AffineForOp>(loc, 0, dimSize);
+                    rewriter.setInsertionPointToStart(innerLoop.getBody());
+                    indices.push_back(innerLoop.getInductionVar());
+                }
+                auto zero = rewriter.create<ConstantOp>(loc, elementType, rewriter.getZeroAttr(elementType));
+                rewriter.create<AffineStoreOp>(loc, zero, buffer, indices);
+            }
+        }
+    }
+
+    if (parallelizationInfo.affinity == ParallelizationAffinity::Socket || parallelizationInfo.affinity == ParallelizationAffinity::Explicit)
+    {
+        OpBuilder::InsertionGuard guard(rewriter);
+        rewriter.setInsertionPointToStart(affineParallelOp.getBody());
+
+        auto getThreadNumFn = util::GetOrCreateExternalFunctionDeclaration(rewriter, affineParallelOp, "omp_get_thread_num", rewriter.getFunctionType({}, { i32Type }));
+        auto threadIndex = rewriter.create<v::CallOp>(loc, getThreadNumFn).getResult(0);
+
+        if (parallelizationInfo.affinity == ParallelizationAffinity::Explicit)
+        {
+            // Look up this thread's core in a constant table: cores[threadIndex % numCores]
+            auto numCores = static_cast<int64_t>(parallelizationInfo.cores.size());
+            auto coresType = MemRefType::get({ numCores }, i64Type);
+            auto coresAttr = DenseElementsAttr::get(RankedTensorType::get({ numCores }, i64Type), llvm::makeArrayRef(parallelizationInfo.cores));
+            auto cores = util::CreateGlobalBuffer(rewriter, affineParallelOp, coresType, "thread_cores", /*constant=*/true, coresAttr);
+
+            auto threadIndexAsIndex = rewriter.create<IndexCastOp>(loc, threadIndex, rewriter.getIndexType());
+            auto numCoresIndex = rewriter.create<ConstantIndexOp>(loc, numCores);
+            auto coreIndex = rewriter.create<UnsignedRemIOp>(loc, threadIndexAsIndex, numCoresIndex);
+            auto core = rewriter.create<memref::LoadOp>(loc, cores, ValueRange{ coreIndex });
+
+            auto bindFn = util::GetOrCreateExternalFunctionDeclaration(rewriter, affineParallelOp, "AcceraBindThreadToCore", rewriter.getFunctionType({ i64Type }, {}));
+            rewriter.create<v::CallOp>(loc, bindFn, ValueRange{ core });
+        }
+        else
+        {
+            auto numThreads = rewriter.create<ConstantIntOp>(loc, parallelizationInfo.numThreads, i32Type);
+            auto affinity = rewriter.create<ConstantIntOp>(loc, static_cast<int>(parallelizationInfo.affinity), i32Type);
+
+            auto bindFn = util::GetOrCreateExternalFunctionDeclaration(rewriter, affineParallelOp, "AcceraBindThread", rewriter.getFunctionType({ i32Type, i32Type, i32Type }, {}));
+            rewriter.create<v::CallOp>(loc, bindFn, ValueRange{ threadIndex, numThreads, affinity });
+        }
+    }
+
+    rewriter.finalizeRootUpdate(affineParallelOp);
+    return success();
+}
+
 LogicalResult HoistScalingToCacheReduceRewrite::matchAndRewrite(mlir::AffineStoreOp affineStoreOp, PatternRewriter& rewriter) const
 {
     // Find if the cache has a CacheReduceOp within the current scope or a parent scope
@@ -7644,6 +9691,12 @@ void ExecutionPlanParallelizationPass::runOnOperation()
     accera::transforms::executionPlan::populateExecutionPlanParallelizePatterns(patterns);
 
     (void)applyPatternsAndFoldGreedily(operation, std::move(patterns));
+
+    // Thread placement is lowered once the parallel ops have been collapsed
+    OwningRewritePatternList affinityPatterns(&getContext());
+    accera::transforms::executionPlan::populateExecutionPlanThreadAffinityPatterns(affinityPatterns);
+
+    (void)applyPatternsAndFoldGreedily(operation, std::move(affinityPatterns));
 }
 
 void ExecutionPlanTensorizationPass::runOnOperation()
@@ -7844,7 +9897,8 @@ void populateExecutionPlanVectorizePatterns(bool printVectorizationDetails, mlir
 
 void populateExecutionPlanTensorizePatterns(mlir::OwningRewritePatternList& patterns)
 {
-    patterns.insert<TensorizeAffineForOpConversion>(patterns.getContext());
+    patterns.insert<TensorizeAffineForOpConversion,
+                    CPUTensorizeAffineForOpConversion>(patterns.getContext());
 }
 
 void populateExecutionPlanParallelizePatterns(mlir::OwningRewritePatternList& patterns)
@@ -7853,6 +9907,11 @@ void populateExecutionPlanParallelizePatterns(mlir::OwningRewritePatternList& pa
                     CollapseAffineParallelOpsRewrite>(patterns.getContext());
 }
 
+void populateExecutionPlanThreadAffinityPatterns(mlir::OwningRewritePatternList& patterns)
+{
+    patterns.insert<AffineParallelThreadAffinityRewrite>(patterns.getContext());
+}
+
 void populateExecutionPlanScaleHoistingPatterns(mlir::OwningRewritePatternList& patterns)
 {
     patterns.insert<HoistScalingToCacheReduceRewrite>(patterns.getContext());
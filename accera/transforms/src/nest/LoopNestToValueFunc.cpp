@@ -8,11 +8,13 @@
 
 #include <ir/include/IRUtil.h>
 #include <ir/include/exec/ExecutionPlanAttributes.h>
+#include <ir/include/exec/ExecutionPlanOps.h>
 #include <ir/include/value/ValueDialect.h>
 
 #include <transforms/include/nest/LoopNestToValue.h>
 #include <transforms/include/util/SnapshotUtilities.h>
 
+#include <mlir/Dialect/Affine/IR/AffineOps.h>
 #include <mlir/Dialect/SPIRV/IR/SPIRVAttributes.h>
 #include <mlir/Pass/Pass.h>
 #include <mlir/Pass/PassManager.h>
@@ -21,7 +23,10 @@
 
 #include <llvm/ADT/TypeSwitch.h>
 
+#include <map>
 #include <memory>
+#include <optional>
+#include <string>
 
 using namespace mlir;
 namespace lnir = accera::ir::loopnest;
@@ -37,6 +42,99 @@ namespace affinetr = accera::transforms::affine;
 
 namespace
 {
+// Wraps the loop nests, cache copies and parallel loops of a CPU function in profile regions named
+// "<function>/<kind>_<n>", so that a profiled package reports how its time splits between them
+class ProfileRegionInstrumenter
+{
+public:
+    ProfileRegionInstrumenter(vir::ValueFuncOp fn) :
+        _fn(fn),
+        _prefix(mlir::SymbolTable::getSymbolName(fn).getValue().str() + "/")
+    {
+        auto target = utilir::ResolveExecutionTarget(fn);
+        _enabled = target && *target == vir::ExecutionTarget::CPU;
+    }
+
+    // Wraps the nests at the top level of the function, before they're lowered to loops. Only called once, before any
+    // lowering, so that the nests that cache copies are later lowered to aren't counted as kernels.
+    void InstrumentKernels()
+    {
+        if (!_enabled) return;
+        for (auto nestOp : llvm::make_early_inc_range(_fn.getBody().getOps<lnir::NestOp>()))
+        {
+            Wrap(nestOp, "kernel");
+        }
+    }
+
+    // Wraps the cache copies and reductions that are about to be lowered. Ones that are still inside a nest are
+    // left for a later round, and ones that are wrapped already are marked so they aren't wrapped twice.
+    void InstrumentCaches()
+    {
+        if (!_enabled) return;
+        std::vector<std::pair<mlir::Operation*, std::string>> cacheOps;
+        _fn.walk([&](mlir::Operation* op) {
+            if (op->hasAttr(kInstrumentedAttrName) || op->getParentOfType<lnir::NestOp>() || op->getParentOfType<lnir::KernelOp>())
+            {
+                return;
+            }
+            if (auto copyOp = mlir::dyn_cast<xpir::ActiveBlockCacheCopyOp>(op))
+            {
+                cacheOps.emplace_back(op, copyOp.toCache() ? "cache_fill" : "cache_flush");
+            }
+            else if (auto multiCopyOp = mlir::dyn_cast<xpir::MultiCacheCopyOp>(op))
+            {
+                cacheOps.emplace_back(op, multiCopyOp.toCache() ? "multi_cache_fill" : "multi_cache_flush");
+            }
+            else if (mlir::isa<xpir::ActiveBlockCacheReduceOp>(op))
+            {
+                cacheOps.emplace_back(op, "cache_reduce");
+            }
+        });
+
+        for (auto& [op, kind] : cacheOps)
+        {
+            op->setAttr(kInstrumentedAttrName, mlir::UnitAttr::get(op->getContext()));
+            Wrap(op, kind);
+        }
+    }
+
+    // Wraps the outermost parallel loops. The region is entered and exited by the thread that launches the loop,
+    // so it measures the wall-clock time of the whole parallel region.
+    void InstrumentParallelRegions()
+    {
+        if (!_enabled) return;
+        std::vector<mlir::Operation*> parallelOps;
+        _fn.walk([&](mlir::AffineParallelOp op) {
+            if (!op->getParentOfType<mlir::AffineParallelOp>())
+            {
+                parallelOps.push_back(op);
+            }
+        });
+
+        for (auto op : parallelOps)
+        {
+            Wrap(op, "parallel");
+        }
+    }
+
+private:
+    void Wrap(mlir::Operation* op, const std::string& kind)
+    {
+        auto regionName = _prefix + kind + "_" + std::to_string(_counts[kind]++);
+        mlir::OpBuilder builder(op);
+        builder.create<vir::EnterProfileRegionOp>(op->getLoc(), regionName);
+        builder.setInsertionPointAfter(op);
+        builder.create<vir::ExitProfileRegionOp>(op->getLoc(), regionName);
+    }
+
+    static constexpr const char* kInstrumentedAttrName = "accv.profile_instrumented";
+
+    vir::ValueFuncOp _fn;
+    std::string _prefix;
+    bool _enabled = false;
+    std::map<std::string, int> _counts;
+};
+
 struct LoopNestToValueFuncPass : public accera::transforms::LoopNestToValueFuncBase<LoopNestToValueFuncPass>
 {
     LoopNestToValueFuncPass(const lntr::LoopNestToValueFuncOptions& options = {}) :
@@ -44,6 +142,7 @@ struct LoopNestToValueFuncPass : public accera::transforms::LoopNestToValueFuncB
     {
         printVecOpDetails = options.printVecOpDetails;
         printLoops = options.printLoops;
+        instrumentProfileRegions = options.instrumentProfileRegions;
     }
 
     void runOnOperation() final
@@ -56,6 +155,13 @@ struct LoopNestToValueFuncPass : public accera::transforms::LoopNestToValueFuncB
         auto snapshotter = _intrapassSnapshotter.MakeSnapshotPipe();
         snapshotter.Snapshot("Initial", vFuncOp);
 
+        std::optional<ProfileRegionInstrumenter> instrumenter;
+        if (instrumentProfileRegions)
+        {
+            instrumenter.emplace(vFuncOp);
+            instrumenter->InstrumentKernels();
+        }
+
         mlir::GreedyRewriteConfig topDownConfig; // Some patterns require a top-down handling of ops to ensure relative orders stay consistent
         topDownConfig.useTopDownTraversal = true;
 
@@ -232,6 +338,12 @@ struct LoopNestToValueFuncPass : public accera::transforms::LoopNestToValueFuncB
                 snapshotter.Snapshot("Canonicalize", vFuncOp);
             }
 
+            if (instrumenter)
+            {
+                instrumenter->InstrumentCaches();
+                snapshotter.Snapshot("InstrumentCaches", vFuncOp);
+            }
+
             {
                 OwningRewritePatternList patterns(context);
                 xptr::populateExecutionPlanMultiCachePatterns(patterns);
@@ -329,6 +441,19 @@ struct LoopNestToValueFuncPass : public accera::transforms::LoopNestToValueFuncB
             (void)applyPatternsAndFoldGreedily(vFuncOp, std::move(patterns));
             snapshotter.Snapshot("ExecutionPlanParallelize", vFuncOp);
         }
+
+        {
+            OwningRewritePatternList patterns(context);
+            xptr::populateExecutionPlanThreadAffinityPatterns(patterns);
+            (void)applyPatternsAndFoldGreedily(vFuncOp, std::move(patterns));
+            snapshotter.Snapshot("ExecutionPlanThreadAffinity", vFuncOp);
+        }
+
+        if (instrumenter)
+        {
+            instrumenter->InstrumentParallelRegions();
+            snapshotter.Snapshot("InstrumentParallelRegions", vFuncOp);
+        }
     }
 
     tr::IRSnapshotter _intrapassSnapshotter;
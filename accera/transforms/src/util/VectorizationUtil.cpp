@@ -24,6 +24,8 @@
 #include <llvm/ADT/TypeSwitch.h>
 
 #include <algorithm>
+#include <cstdlib>
+#include <limits>
 #include <map>
 #include <stdexcept>
 
@@ -87,6 +89,19 @@ bool VectorizedOpMap::HasMapping(void* value) const
     return _vectorizedOps.find(value) != _vectorizedOps.end();
 }
 
+// Returns true for the standard and math dialect ops that apply the same scalar computation to each element of their
+// operands (arithmetic, bitwise, comparison, cast, and math ops), which map one-to-one onto their vector form
+bool IsVectorizableElementwiseOp(mlir::Operation* op)
+{
+    if (!op->hasTrait<mlir::OpTrait::Elementwise>() || !op->hasTrait<mlir::OpTrait::Vectorizable>() || op->getNumResults() != 1)
+    {
+        return false;
+    }
+
+    auto isScalar = [](mlir::Type type) { return type.isIntOrFloat(); };
+    return llvm::all_of(op->getOperandTypes(), isScalar) && isScalar(op->getResult(0).getType());
+}
+
 bool CanVectorizeOp(mlir::Operation* op,
                     const VectorizedOpMap& vectorizedOps,
                     std::vector<mlir::BlockAndValueMapping>& laneMappings,
@@ -119,7 +134,7 @@ bool CanVectorizeOp(mlir::Operation* op,
             .Case([](v::CmpOp) { return true; })
             .Case([](v::ReferenceGlobalOp) { return true; })
             .Default([&](mlir::Operation* defaultOp) {
-                return false;
+                return IsVectorizableElementwiseOp(defaultOp);
             });
     return result;
 }
@@ -254,13 +269,15 @@ std::optional<mlir::Operation*> VectorizeConstantOp(mlir::PatternRewriter& rewri
     return constVec;
 }
 
+// Returns the constant distance (in elements) between the memory locations accessed by consecutive unrolled lanes of
+// the given load or store op, or std::nullopt if the distance isn't the same constant for every pair of lanes
 template <typename OpType>
-bool IsUnrolledAccessSequential(mlir::PatternRewriter& rewriter,
-                                OpType op,
-                                std::vector<mlir::BlockAndValueMapping>& laneMappings,
-                                int64_t vectorSize)
+std::optional<int64_t> GetUnrolledAccessStride(mlir::PatternRewriter& rewriter,
+                                               OpType op,
+                                               std::vector<mlir::BlockAndValueMapping>& laneMappings,
+                                               int64_t vectorSize)
 {
-    // Create some unrolled clones in-memory and see whether they are accessing memory-sequential elements in the MemRef
+    // Create some unrolled clones in-memory and see what stride they are accessing the MemRef with
     auto loc = op.getLoc();
     std::vector<OpType> temporaryClones;
     temporaryClones.reserve(vectorSize);
@@ -269,10 +286,10 @@ bool IsUnrolledAccessSequential(mlir::PatternRewriter& rewriter,
         temporaryClones.push_back(mlir::dyn_cast<OpType>(rewriter.clone(*op.getOperation(), laneMappings[i])));
     }
 
-    // Check if the temporary clones are all accessing sequential memory
+    // Check if the temporary clones are all accessing memory with the same constant stride
     auto accessMapComposition = ir::util::GetIndexToMemoryLocationMap(rewriter.getContext(), op);
 
-    bool sequential = true;
+    std::optional<int64_t> stride;
     for (int64_t unrollIdx = 1; unrollIdx < vectorSize; ++unrollIdx)
     {
         std::vector<mlir::Value> prevIndicesVec(temporaryClones[unrollIdx - 1].indices().begin(), temporaryClones[unrollIdx - 1].indices().end());
@@ -289,27 +306,15 @@ bool IsUnrolledAccessSequential(mlir::PatternRewriter& rewriter,
         mlir::fullyComposeAffineMapAndOperands(&diffMap, &compareAccesses);
 
         assert(diffMap.getNumResults() == 1);
-        auto resultExpr = diffMap.getResult(0);
-        if (resultExpr.isa<mlir::AffineConstantExpr>())
+        auto constExpr = diffMap.getResult(0).dyn_cast<mlir::AffineConstantExpr>();
+        if (!constExpr || (stride && *stride != constExpr.getValue()))
         {
-            auto constExpr = resultExpr.dyn_cast<mlir::AffineConstantExpr>();
-            if (constExpr.getValue() != 1)
-            {
-                // There is a constant difference between sequential op memory accesses
-                // but the stride is not 1, so the memory isn't contiguous and therefore
-                // it's not safe to replace all of the memory ops with a single vector op
-                sequential = false;
-                break;
-            }
-        }
-        else
-        {
-            // There isn't a constant difference between sequential op memory accesses
-            // so it's not necessarily safe to convert all of the memory ops into a single
-            // vector op
-            sequential = false;
+            // There isn't a constant difference between sequential op memory accesses, or it varies across lanes,
+            // so the accesses can't be described by a single strided vector access
+            stride = std::nullopt;
             break;
         }
+        stride = constExpr.getValue();
     }
 
     // Clean up the temporary clones
@@ -317,7 +322,17 @@ bool IsUnrolledAccessSequential(mlir::PatternRewriter& rewriter,
     {
         rewriter.eraseOp(clone);
     }
-    return sequential;
+    return stride;
+}
+
+template <typename OpType>
+bool IsUnrolledAccessSequential(mlir::PatternRewriter& rewriter,
+                                OpType op,
+                                std::vector<mlir::BlockAndValueMapping>& laneMappings,
+                                int64_t vectorSize)
+{
+    // The accesses are only contiguous (and therefore replaceable by a single vector op) if the stride is 1
+    return GetUnrolledAccessStride(rewriter, op, laneMappings, vectorSize) == 1;
 }
 
 mlir::Value FlattenMemRefCast(mlir::OpBuilder& builder, mlir::Value memref)
@@ -344,6 +359,137 @@ std::pair<mlir::Value, mlir::Value> FlattenAccess(mlir::OpBuilder& builder, OpTy
     return std::make_pair(flatCastMemref, flatPosition);
 }
 
+// Strided loads with a stride of at most this many elements are done with one contiguous vector load
+// followed by a shuffle, which reads at most this many vectors' worth of memory
+constexpr int64_t MaxShuffleStride = 4;
+
+// Returns true if a hardware gather or scatter is expected to be cheaper than accessing each lane individually.
+// x86 (AVX2 / AVX-512) and ARM SVE only gather 32- and 64-bit elements, and short vectors don't make up for the
+// latency of the gather
+bool IsGatherScatterProfitable(mlir::Type elementType, int64_t vectorSize)
+{
+    if (!elementType.isIntOrFloat() || vectorSize < 4)
+    {
+        return false;
+    }
+    auto bitWidth = elementType.getIntOrFloatBitWidth();
+    return bitWidth == 32 || bitWidth == 64;
+}
+
+// Returns a constant vector of the offsets (in elements) of each lane's memory location relative to lane 0,
+// for use as the index vector of a vector.gather or vector.scatter
+mlir::Value CreateLaneOffsetsVector(mlir::OpBuilder& builder, mlir::Location loc, int64_t stride, int64_t vectorSize)
+{
+    // 32-bit offsets let x86 gather twice as many elements per instruction as 64-bit ones
+    auto offsetType = std::abs(stride) * vectorSize <= std::numeric_limits<int32_t>::max() ? builder.getI32Type() : builder.getI64Type();
+    auto offsetsType = mlir::VectorType::get({ vectorSize }, offsetType);
+    std::vector<mlir::Attribute> offsets;
+    for (int64_t i = 0; i < vectorSize; ++i)
+    {
+        offsets.push_back(builder.getIntegerAttr(offsetType, i * stride));
+    }
+    return builder.create<mlir::ConstantOp>(loc, offsetsType, mlir::DenseElementsAttr::get(offsetsType, offsets));
+}
+
+mlir::Value CreateAllTrueMask(mlir::OpBuilder& builder, mlir::Location loc, int64_t vectorSize)
+{
+    auto maskType = mlir::VectorType::get({ vectorSize }, builder.getI1Type());
+    return builder.create<mlir::vector::ConstantMaskOp>(loc, maskType, builder.getI64ArrayAttr({ vectorSize }));
+}
+
+// Loads the elements accessed by the unrolled lanes of `op`, which are `stride` elements apart in memory, into a vector.
+// Returns a null value if there is no cheaper way of doing it than loading each lane individually.
+template <typename OpTy>
+mlir::Value CreateStridedLoad(mlir::PatternRewriter& rewriter,
+                              OpTy op,
+                              const std::vector<mlir::Value>& indices,
+                              std::vector<mlir::BlockAndValueMapping>& laneMappings,
+                              int64_t stride,
+                              int64_t vectorSize)
+{
+    auto loc = op.getLoc();
+    auto elementType = op.getMemRefType().getElementType();
+    auto vectorType = mlir::VectorType::get({ vectorSize }, elementType);
+
+    if (stride == 0)
+    {
+        // Every lane reads the same element, so load it once and broadcast it
+        auto elementLoad = rewriter.clone(*op.getOperation(), laneMappings[0]);
+        return rewriter.create<mlir::vector::BroadcastOp>(loc, vectorType, elementLoad->getResult(0));
+    }
+
+    if (std::abs(stride) <= MaxShuffleStride)
+    {
+        // Load the contiguous span of memory that covers every lane, then pick the lanes out of it with a shuffle
+        auto [flatCastMemref, flattenedPosition] = FlattenAccess(rewriter, op, indices);
+        auto spanSize = (vectorSize - 1) * std::abs(stride) + 1;
+        mlir::Value spanStart = flattenedPosition;
+        if (stride < 0)
+        {
+            // The last lane accesses the lowest address
+            auto lastLaneMap = mlir::AffineMap::get(1, 0, rewriter.getAffineDimExpr(0) + (vectorSize - 1) * stride);
+            spanStart = rewriter.create<mlir::AffineApplyOp>(loc, lastLaneMap, mlir::ValueRange{ flattenedPosition });
+        }
+        auto spanType = mlir::VectorType::get({ spanSize }, elementType);
+        auto span = rewriter.create<mlir::vector::LoadOp>(loc, spanType, flatCastMemref, mlir::ValueRange{ spanStart });
+
+        std::vector<int64_t> shuffleMask;
+        for (int64_t i = 0; i < vectorSize; ++i)
+        {
+            shuffleMask.push_back(stride > 0 ? i * stride : (vectorSize - 1 - i) * -stride);
+        }
+        return rewriter.create<mlir::vector::ShuffleOp>(loc, span, span, shuffleMask);
+    }
+
+    if (IsGatherScatterProfitable(elementType, vectorSize))
+    {
+        auto [flatCastMemref, flattenedPosition] = FlattenAccess(rewriter, op, indices);
+        auto offsets = CreateLaneOffsetsVector(rewriter, loc, stride, vectorSize);
+        auto mask = CreateAllTrueMask(rewriter, loc, vectorSize);
+        auto zero = rewriter.create<mlir::ConstantOp>(loc, elementType, rewriter.getZeroAttr(elementType));
+        auto passThru = rewriter.create<mlir::vector::BroadcastOp>(loc, vectorType, zero);
+        return rewriter.create<mlir::vector::GatherOp>(loc, vectorType, flatCastMemref, mlir::ValueRange{ flattenedPosition }, offsets, mask, passThru);
+    }
+
+    return {};
+}
+
+// Stores the lanes of `vectorValue` to the elements accessed by the unrolled lanes of `op`, which are `stride` elements apart in memory.
+// Returns std::nullopt if there is no cheaper way of doing it than storing each lane individually.
+template <typename OpTy>
+std::optional<VectorizedOp> CreateStridedStore(mlir::PatternRewriter& rewriter,
+                                               OpTy op,
+                                               mlir::Value vectorValue,
+                                               const std::vector<mlir::Value>& indices,
+                                               std::vector<mlir::BlockAndValueMapping>& laneMappings,
+                                               int64_t stride,
+                                               int64_t vectorSize)
+{
+    auto loc = op.getLoc();
+    auto elementType = op.getMemRefType().getElementType();
+
+    if (stride == 0)
+    {
+        // Every lane writes the same element, so only the last lane's write is observable
+        auto element = rewriter.create<mlir::vector::ExtractElementOp>(loc, vectorValue, vectorSize - 1);
+        auto elementStore = rewriter.clone(*op.getOperation(), laneMappings[vectorSize - 1]);
+        elementStore->setOperand(0, element);
+        return elementStore;
+    }
+
+    // Unlike loads, strided stores can't be done with a wider contiguous access, since that would write to the elements in between
+    if (IsGatherScatterProfitable(elementType, vectorSize))
+    {
+        auto [flatCastMemref, flattenedPosition] = FlattenAccess(rewriter, op, indices);
+        auto offsets = CreateLaneOffsetsVector(rewriter, loc, stride, vectorSize);
+        auto mask = CreateAllTrueMask(rewriter, loc, vectorSize);
+        mlir::Operation* scatterOp = rewriter.create<mlir::vector::ScatterOp>(loc, flatCastMemref, mlir::ValueRange{ flattenedPosition }, offsets, mask, vectorValue);
+        return scatterOp;
+    }
+
+    return std::nullopt;
+}
+
 std::optional<VectorizedOp> VectorizeLoadOp(mlir::PatternRewriter& rewriter,
                                             mlir::memref::LoadOp op,
                                             const VectorizedOpMap& vectorizedOps,
@@ -361,13 +507,18 @@ std::optional<VectorizedOp> VectorizeLoadOp(mlir::PatternRewriter& rewriter,
     std::vector<mlir::Value> indices(adaptor.indices().begin(), adaptor.indices().end());
 
     mlir::Value result;
-    if (IsUnrolledAccessSequential(rewriter, op, laneMappings, vectorSize))
+    auto stride = GetUnrolledAccessStride(rewriter, op, laneMappings, vectorSize);
+    if (stride == 1)
     {
         // We know these reads are sequential, but mlir::vector::LoadOp only operates on memrefs where the minor
         // dimension has unit stride, so cast the memref to a flat buffer and load from that shape
         auto [flatCastMemref, flattenedPosition] = FlattenAccess(rewriter, op, indices);
         result = rewriter.create<mlir::vector::LoadOp>(op.getLoc(), vectorType, flatCastMemref, mlir::ValueRange{ flattenedPosition });
     }
+    else if (auto stridedLoad = stride ? CreateStridedLoad(rewriter, op, indices, laneMappings, *stride, vectorSize) : mlir::Value{})
+    {
+        result = stridedLoad;
+    }
     else
     {
         // Fall back to many loads and stores into a vector
@@ -408,7 +559,8 @@ std::optional<VectorizedOp> VectorizeStoreOp(mlir::PatternRewriter& rewriter,
 
     std::vector<mlir::Value> indices(adaptor.indices().begin(), adaptor.indices().end());
 
-    if (IsUnrolledAccessSequential(rewriter, op, laneMappings, vectorSize))
+    auto stride = GetUnrolledAccessStride(rewriter, op, laneMappings, vectorSize);
+    if (stride == 1)
     {
         // We know these reads are sequential, but mlir::vector::StoreOp only operates on memrefs where the minor
         // dimension has unit stride, so cast the memref to a flat buffer and load from that shape
@@ -416,6 +568,10 @@ std::optional<VectorizedOp> VectorizeStoreOp(mlir::PatternRewriter& rewriter,
         mlir::Operation* storeOp = rewriter.create<mlir::vector::StoreOp>(op.getLoc(), vectorizedValueToStore, flatCastMemref, mlir::ValueRange{ flattenedPosition });
         return storeOp;
     }
+    else if (auto stridedStore = stride ? CreateStridedStore(rewriter, op, vectorizedValueToStore, indices, laneMappings, *stride, vectorSize) : std::nullopt)
+    {
+        return stridedStore;
+    }
     else
     {
         std::vector<mlir::Operation*> storeOps;
@@ -447,13 +603,18 @@ std::optional<VectorizedOp> VectorizeAffineLoadOp(mlir::PatternRewriter& rewrite
     std::vector<mlir::Value> baseIndices(adaptor.indices().begin(), adaptor.indices().end());
 
     mlir::Value result;
-    if (IsUnrolledAccessSequential(rewriter, op, laneMappings, vectorSize))
+    auto stride = GetUnrolledAccessStride(rewriter, op, laneMappings, vectorSize);
+    if (stride == 1)
     {
         // We know these reads are sequential, but mlir::vector::LoadOp only operates on memrefs where the minor
         // dimension has unit stride, so cast the memref to a flat buffer and load from that shape
         auto [flatCastMemref, flattenedPosition] = FlattenAccess(rewriter, op, baseIndices);
         result = rewriter.create<mlir::vector::LoadOp>(op.getLoc(), vectorType, flatCastMemref, mlir::ValueRange{ flattenedPosition });
     }
+    else if (auto stridedLoad = stride ? CreateStridedLoad(rewriter, op, baseIndices, laneMappings, *stride, vectorSize) : mlir::Value{})
+    {
+        result = stridedLoad;
+    }
     else
     {
         // Fall back to many loads and stores into a vector
@@ -494,7 +655,8 @@ std::optional<VectorizedOp> VectorizeAffineStoreOp(mlir::PatternRewriter& rewrit
 
     std::vector<mlir::Value> baseIndices(adaptor.indices().begin(), adaptor.indices().end());
 
-    if (IsUnrolledAccessSequential(rewriter, op, laneMappings, vectorSize))
+    auto stride = GetUnrolledAccessStride(rewriter, op, laneMappings, vectorSize);
+    if (stride == 1)
     {
         // We know these reads are sequential, but mlir::vector::StoreOp only operates on memrefs where the minor
         // dimension has unit stride, so cast the memref to a flat buffer and load from that shape
@@ -502,6 +664,10 @@ std::optional<VectorizedOp> VectorizeAffineStoreOp(mlir::PatternRewriter& rewrit
         mlir::Operation* storeOp = rewriter.create<mlir::vector::StoreOp>(op.getLoc(), vectorizedValueToStore, flatCastMemref, mlir::ValueRange{ flattenedPosition });
         return storeOp;
     }
+    else if (auto stridedStore = stride ? CreateStridedStore(rewriter, op, vectorizedValueToStore, baseIndices, laneMappings, *stride, vectorSize) : std::nullopt)
+    {
+        return stridedStore;
+    }
     else
     {
         std::vector<mlir::Operation*> storeOps;
@@ -756,6 +922,35 @@ std::optional<mlir::Operation*> VectorizeBitcastOp(mlir::PatternRewriter& rewrit
     return result;
 }
 
+std::optional<mlir::Operation*> VectorizeElementwiseOp(mlir::PatternRewriter& rewriter,
+                                                       mlir::Operation* op,
+                                                       const VectorizedOpMap& vectorizedOps,
+                                                       std::vector<mlir::BlockAndValueMapping>& laneMappings,
+                                                       mlir::Value inductionVar,
+                                                       int64_t step,
+                                                       int64_t vectorSize)
+{
+    // Get (vector) arguments from map
+    std::vector<mlir::Value> operands;
+    for (auto operand : op->getOperands())
+    {
+        auto vecOperand = GetVectorizedPredecessor(rewriter, operand, vectorizedOps, laneMappings, inductionVar, step, vectorSize);
+        if (!vecOperand || !vecOperand->HasVectorType())
+        {
+            return std::nullopt;
+        }
+        operands.push_back(vecOperand->GetVectorResult());
+    }
+
+    // Re-create the op with the same name and attributes, but vector operands and result
+    auto scalarResultType = op->getResult(0).getType();
+    mlir::OperationState state(op->getLoc(), op->getName());
+    state.addOperands(operands);
+    state.addTypes(mlir::VectorType::get({ vectorSize }, scalarResultType));
+    state.addAttributes(op->getAttrs());
+    return rewriter.createOperation(state);
+}
+
 std::optional<mlir::Operation*> VectorizeReferenceGlobalOp(mlir::PatternRewriter& rewriter,
                                                            v::ReferenceGlobalOp op,
                                                            const VectorizedOpMap& vectorizedOps,
@@ -838,6 +1033,11 @@ std::optional<VectorizedOp> VectorizeOp(mlir::PatternRewriter& rewriter,
                     }
                 }
 
+                if (IsVectorizableElementwiseOp(defaultOp))
+                {
+                    return VectorizeElementwiseOp(rewriter, defaultOp, vectorizedOps, laneMappings, inductionVar, step, vectorSize);
+                }
+
                 op->emitError("Trying to vectorize an un-vectorizable op");
                 llvm_unreachable("unexpected");
                 return {};
@@ -846,4 +1046,118 @@ std::optional<VectorizedOp> VectorizeOp(mlir::PatternRewriter& rewriter,
     return resultOp;
 }
 
+bool CanVectorizeMaskedOp(mlir::PatternRewriter& rewriter,
+                          mlir::Operation* op,
+                          std::vector<mlir::BlockAndValueMapping>& laneMappings,
+                          mlir::Value inductionVar,
+                          int64_t step,
+                          int64_t vectorSize)
+{
+    // Ops that don't depend on the induction variable stay scalar and get broadcast when a vector op needs them
+    if (op->getNumResults() == 1 && (!inductionVar || !ir::util::hasRecursiveUseOfOp(inductionVar, op)))
+    {
+        return true;
+    }
+
+    // The lanes past the end of the loop are never materialized, so every op that depends on the
+    // induction variable has to turn into a single vector op (or only feed the indices of the memory ops)
+    auto result =
+        mlir::TypeSwitch<mlir::Operation*, bool>(op)
+            .Case([&](mlir::memref::LoadOp loadOp) { return IsUnrolledAccessSequential(rewriter, loadOp, laneMappings, vectorSize); })
+            .Case([&](mlir::memref::StoreOp storeOp) { return IsUnrolledAccessSequential(rewriter, storeOp, laneMappings, vectorSize); })
+            .Case([&](mlir::AffineLoadOp loadOp) { return IsUnrolledAccessSequential(rewriter, loadOp, laneMappings, vectorSize); })
+            .Case([&](mlir::AffineStoreOp storeOp) { return IsUnrolledAccessSequential(rewriter, storeOp, laneMappings, vectorSize); })
+            .Case([](mlir::AffineApplyOp applyOp) {
+                return llvm::all_of(applyOp->getUsers(), [](mlir::Operation* user) {
+                    return mlir::isa<mlir::memref::LoadOp, mlir::memref::StoreOp, mlir::AffineLoadOp, mlir::AffineStoreOp>(user);
+                });
+            })
+            .Case([](v::CmpOp cmpOp) {
+                return ir::util::getRecursiveUsesOfType<mlir::scf::IfOp>(cmpOp).empty() &&
+                       ir::util::getRecursiveUsesOfType<v::IfOp>(cmpOp).empty();
+            })
+            .Case([](mlir::SelectOp) { return true; })
+            .Case([](mlir::ShiftLeftOp) { return true; })
+            .Case([](mlir::FPToSIOp) { return true; })
+            .Case([](mlir::AbsFOp) { return true; })
+            .Case([](mlir::math::ExpOp) { return true; })
+            .Case([](v::BitcastOp) { return true; })
+            .Case([](v::BinOp binOp) {
+                // The lanes that are masked off load zeros, which would trap as integer divisors
+                auto predicate = binOp.predicate();
+                return !(predicate == v::BinaryOpPredicate::DIV || predicate == v::BinaryOpPredicate::MOD) ||
+                       !mlir::getElementTypeOrSelf(binOp.getType()).isa<mlir::IntegerType, mlir::IndexType>();
+            })
+            .Default([](mlir::Operation*) { return false; });
+    return result;
+}
+
+template <typename OpTy>
+mlir::Value CreateMaskedLoad(mlir::PatternRewriter& rewriter, OpTy op, mlir::Value mask, int64_t vectorSize)
+{
+    auto loc = op.getLoc();
+    auto elementType = op.getMemRefType().getElementType();
+    auto vectorType = mlir::VectorType::get({ vectorSize }, elementType);
+
+    std::vector<mlir::Value> indices(op.indices().begin(), op.indices().end());
+    auto [flatCastMemref, flattenedPosition] = FlattenAccess(rewriter, op, indices);
+    auto zero = rewriter.create<mlir::ConstantOp>(loc, elementType, rewriter.getZeroAttr(elementType));
+    auto passThru = rewriter.create<mlir::vector::BroadcastOp>(loc, vectorType, zero);
+    return rewriter.create<mlir::vector::MaskedLoadOp>(loc, vectorType, flatCastMemref, mlir::ValueRange{ flattenedPosition }, mask, passThru);
+}
+
+template <typename OpTy>
+std::optional<VectorizedOp> CreateMaskedStore(mlir::PatternRewriter& rewriter,
+                                              OpTy op,
+                                              mlir::Value mask,
+                                              const VectorizedOpMap& vectorizedOps,
+                                              std::vector<mlir::BlockAndValueMapping>& laneMappings,
+                                              mlir::Value inductionVar,
+                                              int64_t step,
+                                              int64_t vectorSize)
+{
+    auto vecValue = GetVectorizedPredecessor(rewriter, op.getValueToStore(), vectorizedOps, laneMappings, inductionVar, step, vectorSize);
+    if (!vecValue || !vecValue->HasVectorType())
+    {
+        return std::nullopt;
+    }
+
+    std::vector<mlir::Value> indices(op.indices().begin(), op.indices().end());
+    auto [flatCastMemref, flattenedPosition] = FlattenAccess(rewriter, op, indices);
+    mlir::Operation* storeOp = rewriter.create<mlir::vector::MaskedStoreOp>(op.getLoc(), flatCastMemref, mlir::ValueRange{ flattenedPosition }, mask, vecValue->GetVectorResult());
+    return storeOp;
+}
+
+std::optional<VectorizedOp> VectorizeMaskedOp(mlir::PatternRewriter& rewriter,
+                                              mlir::Operation* op,
+                                              mlir::Value mask,
+                                              const VectorizedOpMap& vectorizedOps,
+                                              std::vector<mlir::BlockAndValueMapping>& laneMappings,
+                                              mlir::Value inductionVar,
+                                              int64_t step,
+                                              int64_t vectorSize)
+{
+    namespace memref = mlir::memref;
+    auto resultOp =
+        mlir::TypeSwitch<mlir::Operation*, std::optional<VectorizedOp>>(op)
+            .Case([&](memref::LoadOp loadOp) -> std::optional<VectorizedOp> {
+                return CreateMaskedLoad(rewriter, loadOp, mask, vectorSize);
+            })
+            .Case([&](mlir::AffineLoadOp affineLoadOp) -> std::optional<VectorizedOp> {
+                return CreateMaskedLoad(rewriter, affineLoadOp, mask, vectorSize);
+            })
+            .Case([&](memref::StoreOp storeOp) {
+                return CreateMaskedStore(rewriter, storeOp, mask, vectorizedOps, laneMappings, inductionVar, step, vectorSize);
+            })
+            .Case([&](mlir::AffineStoreOp affineStoreOp) {
+                return CreateMaskedStore(rewriter, affineStoreOp, mask, vectorizedOps, laneMappings, inductionVar, step, vectorSize);
+            })
+            .Default([&](mlir::Operation* defaultOp) {
+                // Elementwise ops don't touch memory, so the lanes that are masked off can safely compute garbage
+                return VectorizeOp(rewriter, defaultOp, vectorizedOps, laneMappings, inductionVar, step, vectorSize);
+            });
+
+    return resultOp;
+}
+
 } // namespace accera::transforms
@@ -0,0 +1,352 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) Microsoft Corporation. All rights reserved.
+//  Licensed under the MIT License. See LICENSE in the project root for license information.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "AcceraPasses.h"
+
+#include <ir/include/IRUtil.h>
+#include <ir/include/value/ValueDialect.h>
+
+#include <mlir/Dialect/MemRef/IR/MemRef.h>
+#include <mlir/Dialect/StandardOps/IR/Ops.h>
+#include <mlir/IR/Builders.h>
+#include <mlir/IR/BuiltinOps.h>
+#include <mlir/IR/SymbolTable.h>
+#include <mlir/Interfaces/CallInterfaces.h>
+#include <mlir/Interfaces/LoopLikeInterface.h>
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/MapVector.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/Support/MathExtras.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <limits>
+
+using namespace mlir;
+namespace ir = accera::ir;
+namespace irutil = accera::ir::util;
+namespace vir = accera::ir::value;
+
+namespace
+{
+// Every buffer placed in an arena starts on a cache line boundary
+constexpr int64_t kArenaAlignment = 64;
+
+struct ScratchBuffer
+{
+    // The ops producing the buffer: the ReferenceGlobalOps of a scratch global, or a single AllocOp
+    SmallVector<Operation*, 2> defs;
+    vir::GlobalOp globalOp;
+    int64_t size = 0;
+    int64_t alignment = kArenaAlignment;
+
+    // Live range, in pre-order op numbers of the function body
+    int64_t begin = std::numeric_limits<int64_t>::max();
+    int64_t end = -1;
+
+    int64_t offset = 0;
+
+    bool Overlaps(const ScratchBuffer& other) const
+    {
+        return begin <= other.end && other.begin <= end;
+    }
+};
+
+class MemoryPlanningPass : public accera::transforms::MemoryPlanningBase<MemoryPlanningPass>
+{
+public:
+    void runOnModule() final
+    {
+        for (auto vModule : getModule().getOps<vir::ValueModuleOp>())
+        {
+            for (auto fnOp : llvm::make_early_inc_range(vModule.getOps<vir::ValueFuncOp>()))
+            {
+                if (fnOp.isExternal())
+                    continue;
+
+                auto execTarget = irutil::ResolveExecutionTarget(fnOp).value_or(vir::ExecutionTarget::CPU);
+                if (execTarget != vir::ExecutionTarget::CPU)
+                    continue;
+
+                PlanFunction(vModule, fnOp);
+            }
+            AddCalleeFootprints(vModule);
+        }
+    }
+
+private:
+    void PlanFunction(vir::ValueModuleOp vModule, vir::ValueFuncOp fnOp)
+    {
+        _preOrder.clear();
+        _lastDescendant.clear();
+        int64_t nextIndex = 0;
+        NumberOps(fnOp, nextIndex);
+
+        std::vector<ScratchBuffer> buffers;
+        llvm::DenseMap<Operation*, size_t> globalBufferIndices;
+        fnOp.walk([&](Operation* op) {
+            if (auto refOp = dyn_cast<vir::ReferenceGlobalOp>(op))
+            {
+                auto globalOp = refOp.getGlobal();
+                if (!IsPlannableGlobal(vModule, fnOp, globalOp))
+                    return;
+                auto [it, inserted] = globalBufferIndices.try_emplace(globalOp, buffers.size());
+                if (inserted)
+                {
+                    auto& buffer = buffers.emplace_back();
+                    buffer.globalOp = globalOp;
+                    buffer.size = irutil::GetBufferByteSize(globalOp.getType());
+                }
+                buffers[it->second].defs.push_back(op);
+            }
+            else if (auto allocOp = dyn_cast<vir::AllocOp>(op))
+            {
+                if (allocOp.data() || allocOp.allocType().getValueOr(vir::MemoryAllocType::Global) != vir::MemoryAllocType::Global)
+                    return;
+                auto& buffer = buffers.emplace_back();
+                buffer.defs.push_back(op);
+                buffer.size = irutil::GetBufferByteSize(allocOp.getType());
+                buffer.alignment = std::max<int64_t>(kArenaAlignment, allocOp.alignment().getValueOr(0));
+            }
+        });
+
+        int64_t unplannedSize = 0;
+        int64_t plannedSize = 0;
+
+        // Buffers can only share storage with buffers in the same memory space
+        llvm::MapVector<Attribute, SmallVector<ScratchBuffer*, 8>> buffersByMemorySpace;
+        for (auto& buffer : buffers)
+        {
+            unplannedSize += buffer.size;
+            if (!ComputeLiveRange(fnOp, buffer))
+            {
+                plannedSize += buffer.size;
+                continue;
+            }
+            auto memorySpace = buffer.defs.front()->getResult(0).getType().cast<MemRefType>().getMemorySpace();
+            buffersByMemorySpace[memorySpace].push_back(&buffer);
+        }
+
+        for (auto& [memorySpace, group] : buffersByMemorySpace)
+        {
+            int64_t groupSize = 0;
+            int64_t arenaSize = PackBuffers(group);
+            for (auto buffer : group)
+            {
+                groupSize += buffer->size;
+            }
+
+            if (group.size() < 2 || arenaSize >= groupSize)
+            {
+                // Nothing to share, leave the buffers as they are
+                plannedSize += groupSize;
+                continue;
+            }
+
+            plannedSize += arenaSize;
+            CreateArena(vModule, fnOp, memorySpace, arenaSize, group);
+        }
+
+        OpBuilder builder(fnOp);
+        fnOp->setAttr(ir::ScratchFootprintAttrName, builder.getI64IntegerAttr(plannedSize));
+        if (printFootprint)
+        {
+            llvm::errs() << fnOp.sym_name() << ": scratch footprint " << plannedSize << " bytes (" << unplannedSize << " bytes without buffer reuse)\n";
+        }
+    }
+
+    // The scratch buffers of the functions that a function calls have storage of their own, so a call needs them
+    // on top of its own buffers. The footprint recorded on each function includes every function it reaches.
+    void AddCalleeFootprints(vir::ValueModuleOp vModule)
+    {
+        llvm::MapVector<Operation*, int64_t> ownFootprints;
+        for (auto fnOp : vModule.getOps<vir::ValueFuncOp>())
+        {
+            if (auto footprintAttr = fnOp->getAttrOfType<IntegerAttr>(ir::ScratchFootprintAttrName))
+            {
+                ownFootprints[fnOp] = footprintAttr.getInt();
+            }
+        }
+
+        for (auto& entry : ownFootprints)
+        {
+            auto fnOp = entry.first;
+            int64_t footprint = 0;
+            llvm::SmallPtrSet<Operation*, 8> reached{ fnOp };
+            SmallVector<Operation*, 8> worklist{ fnOp };
+            while (!worklist.empty())
+            {
+                auto op = worklist.pop_back_val();
+                footprint += ownFootprints.lookup(op);
+                op->walk([&](CallOpInterface callOp) {
+                    auto symbol = callOp.getCallableForCallee().dyn_cast<SymbolRefAttr>();
+                    auto callee = symbol ? SymbolTable::lookupSymbolIn(vModule, symbol) : nullptr;
+                    if (callee && reached.insert(callee).second)
+                    {
+                        worklist.push_back(callee);
+                    }
+                });
+            }
+            fnOp->setAttr(ir::ScratchFootprintAttrName, OpBuilder(fnOp).getI64IntegerAttr(footprint));
+        }
+    }
+
+    // Only cache buffers that are local to this function may be shared. Buffers that persist across calls
+    // (e.g. ones tied to a NUMA first-touch placement) don't carry the scratch buffer tag.
+    bool IsPlannableGlobal(vir::ValueModuleOp vModule, vir::ValueFuncOp fnOp, vir::GlobalOp globalOp)
+    {
+        if (!globalOp || !globalOp->hasAttr(ir::ScratchBufferAttrName) || globalOp.value() || globalOp.constant() || globalOp.external())
+            return false;
+
+        auto uses = SymbolTable::getSymbolUses(globalOp, vModule);
+        return uses && llvm::all_of(*uses, [&](const SymbolTable::SymbolUse& use) {
+                   return fnOp->isProperAncestor(use.getUser());
+               });
+    }
+
+    void NumberOps(Operation* op, int64_t& nextIndex)
+    {
+        _preOrder[op] = nextIndex++;
+        for (auto& region : op->getRegions())
+        {
+            for (auto& block : region)
+            {
+                for (auto& nestedOp : block)
+                {
+                    NumberOps(&nestedOp, nextIndex);
+                }
+            }
+        }
+        _lastDescendant[op] = nextIndex - 1;
+    }
+
+    // Extends the buffer's live range to cover each of its uses, including uses through views and casts.
+    // The range starts at the first use rather than at the definition, since the ReferenceGlobalOps for cache
+    // buffers are hoisted to the top of their block. Returns false if a use cannot be ordered relative to the
+    // definition.
+    bool ComputeLiveRange(vir::ValueFuncOp fnOp, ScratchBuffer& buffer)
+    {
+        for (auto def : buffer.defs)
+        {
+            auto defBlock = def->getBlock();
+            auto extend = [&](Operation* op) {
+                buffer.begin = std::min(buffer.begin, _preOrder[op]);
+                buffer.end = std::max(buffer.end, _lastDescendant[op]);
+            };
+
+            SmallVector<Value, 4> worklist{ def->getResult(0) };
+            llvm::SmallPtrSet<Operation*, 16> visited;
+            while (!worklist.empty())
+            {
+                auto value = worklist.pop_back_val();
+                for (auto user : value.getUsers())
+                {
+                    if (!visited.insert(user).second)
+                        continue;
+
+                    auto ancestor = defBlock->findAncestorOpInBlock(*user);
+                    if (!ancestor)
+                        return false;
+                    extend(ancestor);
+
+                    for (auto result : user->getResults())
+                    {
+                        if (result.getType().isa<MemRefType>())
+                        {
+                            worklist.push_back(result);
+                        }
+                    }
+                }
+            }
+
+            // Contents written in one iteration may be read in the next, so a buffer defined inside a loop
+            // stays live for the whole loop
+            for (auto parentOp = defBlock->getParentOp(); parentOp && parentOp != fnOp; parentOp = parentOp->getParentOp())
+            {
+                if (isa<LoopLikeOpInterface>(parentOp))
+                {
+                    extend(parentOp);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Greedily assigns offsets, largest buffer first, placing each buffer at the lowest aligned offset
+    // that does not collide with a buffer whose live range overlaps its own. Returns the arena size.
+    int64_t PackBuffers(ArrayRef<ScratchBuffer*> group)
+    {
+        SmallVector<ScratchBuffer*, 8> order(group.begin(), group.end());
+        std::stable_sort(order.begin(), order.end(), [](ScratchBuffer* a, ScratchBuffer* b) { return a->size > b->size; });
+
+        int64_t arenaSize = 0;
+        SmallVector<ScratchBuffer*, 8> placed;
+        for (auto buffer : order)
+        {
+            SmallVector<ScratchBuffer*, 8> conflicts;
+            for (auto other : placed)
+            {
+                if (buffer->Overlaps(*other))
+                {
+                    conflicts.push_back(other);
+                }
+            }
+            llvm::sort(conflicts, [](ScratchBuffer* a, ScratchBuffer* b) { return a->offset < b->offset; });
+
+            int64_t offset = 0;
+            for (auto other : conflicts)
+            {
+                if (static_cast<int64_t>(llvm::alignTo(offset, buffer->alignment)) + buffer->size <= other->offset)
+                    break;
+                offset = std::max(offset, other->offset + other->size);
+            }
+            buffer->offset = llvm::alignTo(offset, buffer->alignment);
+            arenaSize = std::max(arenaSize, buffer->offset + buffer->size);
+            placed.push_back(buffer);
+        }
+        return arenaSize;
+    }
+
+    void CreateArena(vir::ValueModuleOp vModule, vir::ValueFuncOp fnOp, Attribute memorySpace, int64_t arenaSize, ArrayRef<ScratchBuffer*> group)
+    {
+        OpBuilder builder(fnOp);
+        auto arenaType = MemRefType::get({ arenaSize }, builder.getIntegerType(8), {}, memorySpace);
+        auto arenaOp = irutil::CreateGlobalBufferOp(builder, fnOp, arenaType, fnOp.sym_name().str() + "_scratch_arena");
+        arenaOp->setAttr(ir::ScratchBufferAttrName, builder.getUnitAttr());
+
+        for (auto buffer : group)
+        {
+            for (auto def : buffer->defs)
+            {
+                builder.setInsertionPoint(def);
+                auto loc = def->getLoc();
+                auto type = def->getResult(0).getType().cast<MemRefType>();
+                Value arena = builder.create<vir::ReferenceGlobalOp>(loc, arenaOp);
+                auto view = irutil::CreateByteBufferView(builder, loc, arena, buffer->offset, type);
+                def->getResult(0).replaceAllUsesWith(view);
+                def->erase();
+            }
+            if (buffer->globalOp && SymbolTable::symbolKnownUseEmpty(buffer->globalOp, vModule))
+            {
+                buffer->globalOp->erase();
+            }
+        }
+    }
+
+    llvm::DenseMap<Operation*, int64_t> _preOrder;
+    llvm::DenseMap<Operation*, int64_t> _lastDescendant;
+};
+
+} // namespace
+
+namespace accera::transforms::value
+{
+std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>> createMemoryPlanningPass()
+{
+    return std::make_unique<MemoryPlanningPass>();
+}
+} // namespace accera::transforms::value
@@ -0,0 +1,416 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) Microsoft Corporation. All rights reserved.
+//  Licensed under the MIT License. See LICENSE in the project root for license information.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "AcceraPasses.h"
+
+#include <mlir/Dialect/LLVMIR/LLVMDialect.h>
+#include <mlir/Dialect/OpenMP/OpenMPDialect.h>
+#include <mlir/IR/BlockAndValueMapping.h>
+#include <mlir/IR/Builders.h>
+#include <mlir/IR/BuiltinOps.h>
+#include <mlir/IR/SymbolTable.h>
+#include <mlir/Transforms/RegionUtils.h>
+
+#include <llvm/ADT/SetVector.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/Twine.h>
+
+#include <string>
+
+using namespace mlir;
+
+namespace
+{
+// Entry points of the Accera CPU runtime (see runtime/include/ThreadPool.h)
+const char ParallelForFunctionName[] = "AcceraParallelFor";
+const char GetThreadNumFunctionName[] = "AcceraGetThreadNum";
+const char OmpGetThreadNumFunctionName[] = "omp_get_thread_num";
+
+Value CastInteger(OpBuilder& builder, Location loc, Value value, IntegerType type)
+{
+    auto valueType = value.getType().cast<IntegerType>();
+    if (valueType.getWidth() < type.getWidth())
+    {
+        return builder.create<LLVM::SExtOp>(loc, type, value);
+    }
+    if (valueType.getWidth() > type.getWidth())
+    {
+        return builder.create<LLVM::TruncOp>(loc, type, value);
+    }
+    return value;
+}
+
+Value CreateI64Constant(OpBuilder& builder, Location loc, int64_t value)
+{
+    return builder.create<LLVM::ConstantOp>(loc, builder.getI64Type(), builder.getI64IntegerAttr(value));
+}
+
+// Returns max(0, ceildiv(ub - lb, step)) as an i64
+Value CreateTripCount(OpBuilder& builder, Location loc, Value lb, Value ub, Value step)
+{
+    auto i64Type = builder.getI64Type();
+    lb = CastInteger(builder, loc, lb, i64Type);
+    ub = CastInteger(builder, loc, ub, i64Type);
+    step = CastInteger(builder, loc, step, i64Type);
+
+    auto zero = CreateI64Constant(builder, loc, 0);
+    auto one = CreateI64Constant(builder, loc, 1);
+    Value range = builder.create<LLVM::SubOp>(loc, i64Type, ub, lb);
+    Value roundedRange = builder.create<LLVM::AddOp>(loc, i64Type, range, builder.create<LLVM::SubOp>(loc, i64Type, step, one));
+    Value tripCount = builder.create<LLVM::SDivOp>(loc, i64Type, roundedRange, step);
+    Value isEmpty = builder.create<LLVM::ICmpOp>(loc, LLVM::ICmpPredicate::slt, tripCount, zero);
+    return builder.create<LLVM::SelectOp>(loc, isEmpty, zero, tripCount);
+}
+
+// Lowers OpenMP parallel loops to calls into the Accera thread pool:
+//
+//   omp.parallel num_threads(%n) {
+//     <setup ops>
+//     omp.wsloop (%i, %j) : i64 = (%lb0, %lb1) to (%ub0, %ub1) step (%s0, %s1) schedule(...) {
+//       <body>
+//       omp.yield
+//     }
+//     omp.terminator
+//   }
+//
+// -->
+//
+//   llvm.func internal @<parent>_parallel_region_<k>(%ctx: !llvm.ptr<i8>, %begin: i64, %end: i64) {
+//     <load the captured values from %ctx>
+//     <setup ops>
+//     for %iter in [%begin, %end):
+//       %i, %j = delinearize(%iter)
+//       <body>
+//   }
+//
+//   <store the captured values into %ctx>
+//   llvm.call @AcceraParallelFor(%tripCount0 * %tripCount1, %n, %isDynamic, @<parent>_parallel_region_<k>, %ctx)
+class ThreadPoolLoweringPass : public accera::transforms::ThreadPoolLoweringBase<ThreadPoolLoweringPass>
+{
+public:
+    void runOnModule() override;
+
+private:
+    LogicalResult LowerParallelOp(omp::ParallelOp parallelOp, LLVM::LLVMFuncOp parallelForFn);
+    LLVM::LLVMFuncOp OutlineParallelRegion(omp::ParallelOp parallelOp, omp::WsLoopOp wsLoop, ArrayRef<Value> captures, Type contextType);
+    std::string GetUniqueRegionFunctionName(LLVM::LLVMFuncOp parentFn);
+
+    int64_t _nextRegionIndex = 0;
+};
+
+void ThreadPoolLoweringPass::runOnModule()
+{
+    auto module = getOperation();
+    auto* context = module.getContext();
+
+    // The post-order walk visits nested parallel ops before their parents, so that
+    // by the time a parallel op gets lowered its region no longer contains OpenMP loops
+    SmallVector<omp::ParallelOp, 4> parallelOps;
+    module.walk([&](omp::ParallelOp op) { parallelOps.push_back(op); });
+
+    if (!parallelOps.empty())
+    {
+        auto parallelForFn = module.lookupSymbol<LLVM::LLVMFuncOp>(ParallelForFunctionName);
+        if (!parallelForFn)
+        {
+            auto i8PtrType = LLVM::LLVMPointerType::get(IntegerType::get(context, 8));
+            auto i64Type = IntegerType::get(context, 64);
+            auto i32Type = IntegerType::get(context, 32);
+            auto voidType = LLVM::LLVMVoidType::get(context);
+            auto bodyFnPtrType = LLVM::LLVMPointerType::get(LLVM::LLVMFunctionType::get(voidType, { i8PtrType, i64Type, i64Type }));
+
+            auto builder = OpBuilder::atBlockEnd(module.getBody());
+            parallelForFn = builder.create<LLVM::LLVMFuncOp>(
+                module.getLoc(), ParallelForFunctionName, LLVM::LLVMFunctionType::get(voidType, { i64Type, i32Type, i32Type, bodyFnPtrType, i8PtrType }));
+        }
+
+        for (auto parallelOp : parallelOps)
+        {
+            if (failed(LowerParallelOp(parallelOp, parallelForFn)))
+            {
+                signalPassFailure();
+                return;
+            }
+        }
+    }
+
+    // Thread indices used for thread placement come from the pool rather than from the OpenMP runtime
+    if (auto ompGetThreadNumFn = module.lookupSymbol<LLVM::LLVMFuncOp>(OmpGetThreadNumFunctionName))
+    {
+        if (auto getThreadNumFn = module.lookupSymbol<LLVM::LLVMFuncOp>(GetThreadNumFunctionName))
+        {
+            if (failed(SymbolTable::replaceAllSymbolUses(ompGetThreadNumFn, GetThreadNumFunctionName, module)))
+            {
+                signalPassFailure();
+                return;
+            }
+            ompGetThreadNumFn.erase();
+        }
+        else
+        {
+            if (failed(SymbolTable::replaceAllSymbolUses(ompGetThreadNumFn, GetThreadNumFunctionName, module)))
+            {
+                signalPassFailure();
+                return;
+            }
+            SymbolTable::setSymbolName(ompGetThreadNumFn, GetThreadNumFunctionName);
+        }
+    }
+}
+
+LogicalResult ThreadPoolLoweringPass::LowerParallelOp(omp::ParallelOp parallelOp, LLVM::LLVMFuncOp parallelForFn)
+{
+    auto loc = parallelOp.getLoc();
+    auto* context = parallelOp.getContext();
+    auto& region = parallelOp.region();
+
+    if (!region.hasOneBlock())
+    {
+        return parallelOp.emitError("Thread pool lowering expects a single block in the parallel region");
+    }
+
+    auto& block = region.front();
+    omp::WsLoopOp wsLoop;
+    for (auto& op : block)
+    {
+        if (auto loop = dyn_cast<omp::WsLoopOp>(op))
+        {
+            if (wsLoop)
+            {
+                return parallelOp.emitError("Thread pool lowering expects a single worksharing loop in the parallel region");
+            }
+            wsLoop = loop;
+        }
+    }
+    if (!wsLoop || wsLoop->getNextNode() != block.getTerminator())
+    {
+        return parallelOp.emitError("Thread pool lowering expects the parallel region to end with a worksharing loop");
+    }
+
+    // Values defined before the parallel op are passed to the outlined function through a context struct
+    llvm::SetVector<Value> captureSet;
+    getUsedValuesDefinedAbove(region, captureSet);
+    SmallVector<Value, 8> captures(captureSet.begin(), captureSet.end());
+    SmallVector<Type, 8> captureTypes;
+    for (auto capture : captures)
+    {
+        captureTypes.push_back(capture.getType());
+    }
+    auto contextType = LLVM::LLVMStructType::getLiteral(context, captureTypes);
+
+    auto regionFn = OutlineParallelRegion(parallelOp, wsLoop, captures, contextType);
+
+    OpBuilder builder(parallelOp);
+    auto i8PtrType = LLVM::LLVMPointerType::get(builder.getIntegerType(8));
+    auto i32Type = builder.getI32Type();
+    auto i64Type = builder.getI64Type();
+
+    Value contextArg;
+    if (captures.empty())
+    {
+        contextArg = builder.create<LLVM::NullOp>(loc, i8PtrType);
+    }
+    else
+    {
+        // The context lives in the frame of whoever launches the loop. For a parallel op nested in another one, that
+        // is each thread of the enclosing region: its ops before the worksharing loop become the entry block of the
+        // outlined function, so every thread gets a context of its own rather than sharing the outer function's.
+        Block* allocaBlock = nullptr;
+        if (auto enclosingParallelOp = parallelOp->getParentOfType<omp::ParallelOp>())
+        {
+            allocaBlock = &enclosingParallelOp.region().front();
+        }
+        else
+        {
+            allocaBlock = &parallelOp->getParentOfType<LLVM::LLVMFuncOp>().getBody().front();
+        }
+        auto allocaBuilder = OpBuilder::atBlockBegin(allocaBlock);
+        auto contextPtrType = LLVM::LLVMPointerType::get(contextType);
+        auto contextAlloca = allocaBuilder.create<LLVM::AllocaOp>(loc, contextPtrType, CreateI64Constant(allocaBuilder, loc, 1), /*alignment=*/0);
+
+        auto zero = builder.create<LLVM::ConstantOp>(loc, i32Type, builder.getI32IntegerAttr(0));
+        for (auto en : llvm::enumerate(captures))
+        {
+            auto index = builder.create<LLVM::ConstantOp>(loc, i32Type, builder.getI32IntegerAttr(static_cast<int32_t>(en.index())));
+            auto fieldPtr = builder.create<LLVM::GEPOp>(loc, LLVM::LLVMPointerType::get(en.value().getType()), contextAlloca, ValueRange{ zero, index });
+            builder.create<LLVM::StoreOp>(loc, en.value(), fieldPtr);
+        }
+        contextArg = builder.create<LLVM::BitcastOp>(loc, i8PtrType, contextAlloca);
+    }
+
+    // The loop bounds are needed outside of the parallel region to compute the number of iterations
+    BlockAndValueMapping boundsMapping;
+    auto getBoundOutsideRegion = [&](Value bound) -> Value {
+        if (!region.isAncestor(bound.getParentRegion()))
+        {
+            return bound;
+        }
+        if (auto constantOp = bound.getDefiningOp<LLVM::ConstantOp>())
+        {
+            return builder.clone(*constantOp, boundsMapping)->getResult(0);
+        }
+        return {};
+    };
+
+    Value numIterations = CreateI64Constant(builder, loc, 1);
+    for (auto [lb, ub, step] : llvm::zip(wsLoop.lowerBound(), wsLoop.upperBound(), wsLoop.step()))
+    {
+        auto outerLb = getBoundOutsideRegion(lb);
+        auto outerUb = getBoundOutsideRegion(ub);
+        auto outerStep = getBoundOutsideRegion(step);
+        if (!outerLb || !outerUb || !outerStep)
+        {
+            regionFn.erase();
+            return wsLoop.emitError("Thread pool lowering expects loop bounds that are constant or defined outside of the parallel region");
+        }
+        auto tripCount = CreateTripCount(builder, loc, outerLb, outerUb, outerStep);
+        numIterations = builder.create<LLVM::MulOp>(loc, i64Type, numIterations, tripCount);
+    }
+
+    Value numThreads;
+    if (auto numThreadsVar = parallelOp.num_threads_var())
+    {
+        numThreads = CastInteger(builder, loc, numThreadsVar, i32Type);
+    }
+    else
+    {
+        // Let the runtime use one thread per logical CPU
+        numThreads = builder.create<LLVM::ConstantOp>(loc, i32Type, builder.getI32IntegerAttr(0));
+    }
+
+    auto schedule = wsLoop.schedule_val();
+    bool isDynamic = schedule.hasValue() && schedule.getValue() != "Static";
+    auto dynamic = builder.create<LLVM::ConstantOp>(loc, i32Type, builder.getI32IntegerAttr(isDynamic ? 1 : 0));
+
+    auto regionFnPtr = builder.create<LLVM::AddressOfOp>(loc, regionFn);
+    builder.create<LLVM::CallOp>(loc, parallelForFn, ValueRange{ numIterations, numThreads, dynamic, regionFnPtr, contextArg });
+
+    parallelOp.erase();
+    return success();
+}
+
+LLVM::LLVMFuncOp ThreadPoolLoweringPass::OutlineParallelRegion(omp::ParallelOp parallelOp, omp::WsLoopOp wsLoop, ArrayRef<Value> captures, Type contextType)
+{
+    auto loc = parallelOp.getLoc();
+    auto* context = parallelOp.getContext();
+    auto parentFn = parallelOp->getParentOfType<LLVM::LLVMFuncOp>();
+
+    auto i8PtrType = LLVM::LLVMPointerType::get(IntegerType::get(context, 8));
+    auto i32Type = IntegerType::get(context, 32);
+    auto i64Type = IntegerType::get(context, 64);
+    auto voidType = LLVM::LLVMVoidType::get(context);
+
+    OpBuilder moduleBuilder(parentFn);
+    auto regionFn = moduleBuilder.create<LLVM::LLVMFuncOp>(
+        loc, GetUniqueRegionFunctionName(parentFn), LLVM::LLVMFunctionType::get(voidType, { i8PtrType, i64Type, i64Type }), LLVM::Linkage::Internal);
+    auto& fnBody = regionFn.getBody();
+    auto* entryBlock = regionFn.addEntryBlock();
+    auto contextArg = entryBlock->getArgument(0);
+    auto beginArg = entryBlock->getArgument(1);
+    auto endArg = entryBlock->getArgument(2);
+
+    // Unpack the captured values
+    auto builder = OpBuilder::atBlockEnd(entryBlock);
+    BlockAndValueMapping mapping;
+    if (!captures.empty())
+    {
+        auto typedContext = builder.create<LLVM::BitcastOp>(loc, LLVM::LLVMPointerType::get(contextType), contextArg);
+        auto zero = builder.create<LLVM::ConstantOp>(loc, i32Type, builder.getI32IntegerAttr(0));
+        for (auto en : llvm::enumerate(captures))
+        {
+            auto index = builder.create<LLVM::ConstantOp>(loc, i32Type, builder.getI32IntegerAttr(static_cast<int32_t>(en.index())));
+            auto fieldPtr = builder.create<LLVM::GEPOp>(loc, LLVM::LLVMPointerType::get(en.value().getType()), typedContext, ValueRange{ zero, index });
+            mapping.map(en.value(), builder.create<LLVM::LoadOp>(loc, fieldPtr));
+        }
+    }
+
+    // Every thread runs the ops that precede the worksharing loop, as with OpenMP
+    for (auto& op : llvm::make_range(parallelOp.region().front().begin(), wsLoop->getIterator()))
+    {
+        builder.clone(op, mapping);
+    }
+
+    SmallVector<Value, 4> lbs, steps, tripCounts;
+    for (auto [lb, ub, step] : llvm::zip(wsLoop.lowerBound(), wsLoop.upperBound(), wsLoop.step()))
+    {
+        lbs.push_back(mapping.lookupOrDefault(lb));
+        steps.push_back(mapping.lookupOrDefault(step));
+        tripCounts.push_back(CreateTripCount(builder, loc, lbs.back(), mapping.lookupOrDefault(ub), steps.back()));
+    }
+
+    // Build the loop over [begin, end) around a copy of the worksharing loop body
+    auto* exitBlock = builder.createBlock(&fnBody, fnBody.end());
+    builder.create<LLVM::ReturnOp>(loc, ValueRange{});
+
+    auto* headerBlock = builder.createBlock(exitBlock, { i64Type });
+    auto* dispatchBlock = builder.createBlock(exitBlock);
+    auto* latchBlock = builder.createBlock(exitBlock);
+    auto iter = headerBlock->getArgument(0);
+
+    wsLoop.region().cloneInto(&fnBody, latchBlock->getIterator(), mapping);
+    auto* loopBodyBlock = mapping.lookup(&wsLoop.region().front());
+
+    builder.setInsertionPointToEnd(entryBlock);
+    builder.create<LLVM::BrOp>(loc, ValueRange{ beginArg }, headerBlock);
+
+    builder.setInsertionPointToEnd(headerBlock);
+    auto inRange = builder.create<LLVM::ICmpOp>(loc, LLVM::ICmpPredicate::slt, iter, endArg);
+    builder.create<LLVM::CondBrOp>(loc, inRange, dispatchBlock, ValueRange{}, exitBlock, ValueRange{});
+
+    // Delinearize the iteration number, with the innermost dimension varying fastest
+    builder.setInsertionPointToEnd(dispatchBlock);
+    SmallVector<Value, 4> ivs(lbs.size());
+    Value remaining = iter;
+    for (int64_t dim = static_cast<int64_t>(lbs.size()) - 1; dim >= 0; --dim)
+    {
+        Value index = remaining;
+        if (dim > 0)
+        {
+            index = builder.create<LLVM::SRemOp>(loc, i64Type, remaining, tripCounts[dim]);
+            remaining = builder.create<LLVM::SDivOp>(loc, i64Type, remaining, tripCounts[dim]);
+        }
+        auto ivType = lbs[dim].getType().cast<IntegerType>();
+        Value offset = builder.create<LLVM::MulOp>(loc, i64Type, index, CastInteger(builder, loc, steps[dim], i64Type));
+        Value iv = builder.create<LLVM::AddOp>(loc, i64Type, CastInteger(builder, loc, lbs[dim], i64Type), offset);
+        ivs[dim] = CastInteger(builder, loc, iv, ivType);
+    }
+    builder.create<LLVM::BrOp>(loc, ivs, loopBodyBlock);
+
+    builder.setInsertionPointToEnd(latchBlock);
+    auto next = builder.create<LLVM::AddOp>(loc, i64Type, iter, CreateI64Constant(builder, loc, 1));
+    builder.create<LLVM::BrOp>(loc, ValueRange{ next }, headerBlock);
+
+    SmallVector<omp::YieldOp, 2> yieldOps;
+    regionFn.walk([&](omp::YieldOp op) { yieldOps.push_back(op); });
+    for (auto yieldOp : yieldOps)
+    {
+        builder.setInsertionPoint(yieldOp);
+        builder.create<LLVM::BrOp>(yieldOp.getLoc(), ValueRange{}, latchBlock);
+        yieldOp.erase();
+    }
+
+    return regionFn;
+}
+
+std::string ThreadPoolLoweringPass::GetUniqueRegionFunctionName(LLVM::LLVMFuncOp parentFn)
+{
+    auto module = getOperation();
+    std::string name;
+    do
+    {
+        name = (parentFn.getName() + "_parallel_region_" + llvm::Twine(_nextRegionIndex++)).str();
+    } while (module.lookupSymbol(name));
+    return name;
+}
+
+} // namespace
+
+namespace accera::transforms::value
+{
+std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>> createThreadPoolLoweringPass()
+{
+    return std::make_unique<ThreadPoolLoweringPass>();
+}
+} // namespace accera::transforms::value
@@ -42,7 +42,9 @@
 #include <mlir/Transforms/GreedyPatternRewriteDriver.h>
 #include <mlir/Transforms/Passes.h>
 
+#include <llvm/ADT/Triple.h>
 #include <llvm/IR/DataLayout.h>
+#include <llvm/Support/Host.h>
 #include <llvm/Support/raw_os_ostream.h>
 
 #include <iostream>
@@ -202,6 +204,56 @@ struct BitcastOpLowering : public OpConversionPattern<BitcastOp>
         ConversionPatternRewriter& rewriter) const override;
 };
 
+struct BufferAddressOpLowering : public ValueLLVMOpConversionPattern<BufferAddressOp>
+{
+    using ValueLLVMOpConversionPattern::ValueLLVMOpConversionPattern;
+
+    LogicalResult matchAndRewrite(
+        BufferAddressOp op,
+        ArrayRef<mlir::Value> operands,
+        ConversionPatternRewriter& rewriter) const override;
+};
+
+struct ReadHardwareCountersOpLowering : public ValueLLVMOpConversionPattern<ReadHardwareCountersOp>
+{
+    using ValueLLVMOpConversionPattern::ValueLLVMOpConversionPattern;
+
+    LogicalResult matchAndRewrite(
+        ReadHardwareCountersOp op,
+        ArrayRef<mlir::Value> operands,
+        ConversionPatternRewriter& rewriter) const override;
+};
+
+struct TraceProfileEventOpLowering : public ValueLLVMOpConversionPattern<TraceProfileEventOp>
+{
+    using ValueLLVMOpConversionPattern::ValueLLVMOpConversionPattern;
+
+    LogicalResult matchAndRewrite(
+        TraceProfileEventOp op,
+        ArrayRef<mlir::Value> operands,
+        ConversionPatternRewriter& rewriter) const override;
+};
+
+struct WriteProfileTraceOpLowering : public ValueLLVMOpConversionPattern<WriteProfileTraceOp>
+{
+    using ValueLLVMOpConversionPattern::ValueLLVMOpConversionPattern;
+
+    LogicalResult matchAndRewrite(
+        WriteProfileTraceOp op,
+        ArrayRef<mlir::Value> operands,
+        ConversionPatternRewriter& rewriter) const override;
+};
+
+struct ResetProfileTraceOpLowering : public ValueLLVMOpConversionPattern<ResetProfileTraceOp>
+{
+    using ValueLLVMOpConversionPattern::ValueLLVMOpConversionPattern;
+
+    LogicalResult matchAndRewrite(
+        ResetProfileTraceOp op,
+        ArrayRef<mlir::Value> operands,
+        ConversionPatternRewriter& rewriter) const override;
+};
+
 struct GlobalOpToLLVMLowering : public ValueLLVMOpConversionPattern<GlobalOp>
 {
     using ValueLLVMOpConversionPattern::ValueLLVMOpConversionPattern;
@@ -344,9 +396,32 @@ struct GetTimeOpLowering : public ValueLLVMOpConversionPattern<GetTimeOp>
         return llvmIntTy;
     }
 };
+
+// Lowers accv.gettime to a read of the CPU's cycle counter, scaled to seconds, instead of a call to the OS clock. It
+// costs a few tens of cycles rather than a system call, which matters when timing short regions like cache fills.
+struct CycleCounterGetTimeOpLowering : public ValueLLVMOpConversionPattern<GetTimeOp>
+{
+    CycleCounterGetTimeOpLowering(LLVMTypeConverter& typeConverter, mlir::MLIRContext* context, llvm::Triple::ArchType arch) :
+        ValueLLVMOpConversionPattern(typeConverter, context, /*benefit=*/2),
+        arch(arch)
+    {}
+
+    LogicalResult matchAndRewrite(
+        GetTimeOp op,
+        ArrayRef<mlir::Value> operands,
+        ConversionPatternRewriter& rewriter) const override;
+
+    static bool IsSupported(llvm::Triple::ArchType arch)
+    {
+        return arch == llvm::Triple::x86_64 || arch == llvm::Triple::aarch64;
+    }
+
+    llvm::Triple::ArchType arch;
+};
+
 struct ValueToLLVMLoweringPass : public ConvertValueToLLVMBase<ValueToLLVMLoweringPass>
 {
-    ValueToLLVMLoweringPass(bool useBarePtrCallConv, bool emitCWrappers, unsigned indexBitwidth, bool useAlignedAlloc, llvm::DataLayout dataLayout, const IntraPassSnapshotOptions& snapshotteroptions = {}) :
+    ValueToLLVMLoweringPass(bool useBarePtrCallConv, bool emitCWrappers, unsigned indexBitwidth, bool useAlignedAlloc, llvm::DataLayout dataLayout, const std::string& timer = "clock", const std::string& targetTriple = {}, const IntraPassSnapshotOptions& snapshotteroptions = {}) :
         _intrapassSnapshotter(snapshotteroptions)
     {
         this->useBarePtrCallConv = useBarePtrCallConv;
@@ -355,6 +430,8 @@ struct ValueToLLVMLoweringPass : public ConvertValueToLLVMBase<ValueToLLVMLoweri
         // TODO: move to mlir::LowerToLLVMOptions::AllocLowering
         this->useAlignedAlloc = useAlignedAlloc;
         this->dataLayout = dataLayout.getStringRepresentation();
+        this->timer = timer;
+        this->targetTriple = targetTriple;
     }
 
     void runOnModule() final;
@@ -539,8 +616,33 @@ struct RawPointerAPIFnConversion : public ConvertOpToLLVMPattern<FuncOp>
             //       already accounts for this type of scenario and doesn't perform the replacement on any
             //       ops that preceed the new op that is the old arg is being replaced with.
             Location loc = funcOp.getLoc();
-            Value desc = MemRefDescriptor::fromStaticShape(
-                rewriter, loc, *getTypeConverter(), memrefTy, arg);
+            Value desc;
+            if (memrefTy.hasStaticShape())
+            {
+                desc = MemRefDescriptor::fromStaticShape(
+                    rewriter, loc, *getTypeConverter(), memrefTy, arg);
+            }
+            else
+            {
+                // Dynamically-sized arguments (e.g. workspace buffers) only carry a base pointer through the raw
+                // pointer API, so the dynamic extents are left as 0. The strides and offset are still static.
+                int64_t offset = 0;
+                SmallVector<int64_t, 4> strides;
+                [[maybe_unused]] auto stridesResult = getStridesAndOffset(memrefTy, strides, offset);
+                assert(succeeded(stridesResult) && "Expected a strided memref");
+
+                auto memrefDesc = MemRefDescriptor::undef(rewriter, loc, getTypeConverter()->convertType(memrefTy));
+                memrefDesc.setAllocatedPtr(rewriter, loc, arg);
+                memrefDesc.setAlignedPtr(rewriter, loc, arg);
+                memrefDesc.setConstantOffset(rewriter, loc, offset);
+                auto shape = memrefTy.getShape();
+                for (unsigned pos = 0; pos < shape.size(); ++pos)
+                {
+                    memrefDesc.setConstantSize(rewriter, loc, pos, ShapedType::isDynamic(shape[pos]) ? 0 : shape[pos]);
+                    memrefDesc.setConstantStride(rewriter, loc, pos, strides[pos]);
+                }
+                desc = memrefDesc;
+            }
             rewriter.replaceUsesOfBlockArgument(arg, desc);
         }
 
@@ -882,6 +984,104 @@ LogicalResult BitcastOpLowering::matchAndRewrite(
     return success();
 }
 
+LogicalResult BufferAddressOpLowering::matchAndRewrite(
+    BufferAddressOp op,
+    ArrayRef<mlir::Value> operands,
+    ConversionPatternRewriter& rewriter) const
+{
+    BufferAddressOp::Adaptor operandAdapter(operands);
+    MemRefDescriptor descriptor(operandAdapter.source());
+    auto alignedPtr = descriptor.alignedPtr(rewriter, op.getLoc());
+    rewriter.replaceOpWithNewOp<LLVM::PtrToIntOp>(op, op.getType(), alignedPtr);
+    return success();
+}
+
+LogicalResult ReadHardwareCountersOpLowering::matchAndRewrite(
+    ReadHardwareCountersOp op,
+    ArrayRef<mlir::Value> operands,
+    ConversionPatternRewriter& rewriter) const
+{
+    // void AcceraReadHardwareCounters(int32_t counterMask, int64_t* values), from the CPU runtime library
+    auto loc = op.getLoc();
+    auto* context = rewriter.getContext();
+    auto* llvmDialect = context->getOrLoadDialect<LLVM::LLVMDialect>();
+    auto parentModule = op->getParentOfType<ModuleOp>();
+    auto i32Ty = IntegerType::get(context, 32);
+    auto i64PtrTy = LLVM::LLVMPointerType::get(IntegerType::get(context, 64));
+    auto fnType = LLVM::LLVMFunctionType::get(LLVM::LLVMVoidType::get(context), { i32Ty, i64PtrTy }, /*isVarArg=*/false);
+    auto readCountersFn = getOrInsertLibraryFunction(rewriter, "AcceraReadHardwareCounters", fnType, parentModule, llvmDialect);
+
+    ReadHardwareCountersOp::Adaptor operandAdapter(operands);
+    MemRefDescriptor descriptor(operandAdapter.buffer());
+    Value values = descriptor.alignedPtr(rewriter, loc);
+    Value counterMask = rewriter.create<LLVM::ConstantOp>(loc, i32Ty, rewriter.getI32IntegerAttr(static_cast<int32_t>(op.counters())));
+    rewriter.create<LLVM::CallOp>(loc, TypeRange{}, readCountersFn, ValueRange{ counterMask, values });
+    rewriter.eraseOp(op);
+    return success();
+}
+
+LogicalResult TraceProfileEventOpLowering::matchAndRewrite(
+    TraceProfileEventOp op,
+    ArrayRef<mlir::Value> operands,
+    ConversionPatternRewriter& rewriter) const
+{
+    // void AcceraTraceProfileEvent(const char* name, int32_t begin), from the CPU runtime library
+    auto loc = op.getLoc();
+    auto* context = rewriter.getContext();
+    auto* llvmDialect = context->getOrLoadDialect<LLVM::LLVMDialect>();
+    auto parentModule = op->getParentOfType<ModuleOp>();
+    auto i32Ty = IntegerType::get(context, 32);
+    auto i8PtrTy = LLVM::LLVMPointerType::get(IntegerType::get(context, 8));
+    auto fnType = LLVM::LLVMFunctionType::get(LLVM::LLVMVoidType::get(context), { i8PtrTy, i32Ty }, /*isVarArg=*/false);
+    auto traceEventFn = getOrInsertLibraryFunction(rewriter, "AcceraTraceProfileEvent", fnType, parentModule, llvmDialect);
+
+    TraceProfileEventOp::Adaptor operandAdapter(operands);
+    MemRefDescriptor descriptor(operandAdapter.name());
+    Value name = descriptor.alignedPtr(rewriter, loc);
+    Value begin = rewriter.create<LLVM::ConstantOp>(loc, i32Ty, rewriter.getI32IntegerAttr(op.entry() ? 1 : 0));
+    rewriter.create<LLVM::CallOp>(loc, TypeRange{}, traceEventFn, ValueRange{ name, begin });
+    rewriter.eraseOp(op);
+    return success();
+}
+
+LogicalResult WriteProfileTraceOpLowering::matchAndRewrite(
+    WriteProfileTraceOp op,
+    ArrayRef<mlir::Value> operands,
+    ConversionPatternRewriter& rewriter) const
+{
+    // int64_t AcceraWriteProfileTrace(const char* path), from the CPU runtime library
+    auto loc = op.getLoc();
+    auto* context = rewriter.getContext();
+    auto* llvmDialect = context->getOrLoadDialect<LLVM::LLVMDialect>();
+    auto parentModule = op->getParentOfType<ModuleOp>();
+    auto i64Ty = IntegerType::get(context, 64);
+    auto i8PtrTy = LLVM::LLVMPointerType::get(IntegerType::get(context, 8));
+    auto fnType = LLVM::LLVMFunctionType::get(i64Ty, { i8PtrTy }, /*isVarArg=*/false);
+    auto writeTraceFn = getOrInsertLibraryFunction(rewriter, "AcceraWriteProfileTrace", fnType, parentModule, llvmDialect);
+
+    WriteProfileTraceOp::Adaptor operandAdapter(operands);
+    MemRefDescriptor descriptor(operandAdapter.path());
+    Value path = descriptor.alignedPtr(rewriter, loc);
+    rewriter.replaceOpWithNewOp<LLVM::CallOp>(op, TypeRange{ i64Ty }, writeTraceFn, ValueRange{ path });
+    return success();
+}
+
+LogicalResult ResetProfileTraceOpLowering::matchAndRewrite(
+    ResetProfileTraceOp op,
+    ArrayRef<mlir::Value> operands,
+    ConversionPatternRewriter& rewriter) const
+{
+    // void AcceraResetProfileTrace(), from the CPU runtime library
+    auto* context = rewriter.getContext();
+    auto* llvmDialect = context->getOrLoadDialect<LLVM::LLVMDialect>();
+    auto parentModule = op->getParentOfType<ModuleOp>();
+    auto fnType = LLVM::LLVMFunctionType::get(LLVM::LLVMVoidType::get(context), {}, /*isVarArg=*/false);
+    auto resetTraceFn = getOrInsertLibraryFunction(rewriter, "AcceraResetProfileTrace", fnType, parentModule, llvmDialect);
+    rewriter.create<LLVM::CallOp>(op.getLoc(), TypeRange{}, resetTraceFn, ValueRange{});
+    rewriter.eraseOp(op);
+    return success();
+}
+
 mlir::Value GetTimeOpLowering::GetTime(ConversionPatternRewriter& rewriter, mlir::Location loc, ModuleOp& parentModule) const
 {
     auto* llvmDialect = rewriter.getContext()->getOrLoadDialect<LLVM::LLVMDialect>();
@@ -962,6 +1162,115 @@ LogicalResult GetTimeOpLowering::matchAndRewrite(
     return success();
 }
 
+namespace
+{
+// The emitted module reads the length of a cycle counter tick once, in a constructor that runs when the module is loaded,
+// and keeps it in a module global for the lowered accv.gettime ops to scale the counter with
+constexpr const char* kCycleCounterPeriodGlobalName = "__accera_cycle_counter_period";
+constexpr const char* kCycleCounterInitFnName = "__accera_init_cycle_counter";
+
+void EmitCycleCounterPeriodInit(ModuleOp moduleOp)
+{
+    if (moduleOp.lookupSymbol(kCycleCounterPeriodGlobalName))
+    {
+        return;
+    }
+
+    auto* context = moduleOp.getContext();
+    auto loc = moduleOp.getLoc();
+    auto builder = OpBuilder::atBlockBegin(moduleOp.getBody());
+    auto i32Ty = IntegerType::get(context, 32);
+    auto doubleTy = Float64Type::get(context);
+    auto i8PtrTy = LLVM::LLVMPointerType::get(IntegerType::get(context, 8));
+
+    auto periodGlobal = builder.create<LLVM::GlobalOp>(loc, doubleTy, /*isConstant=*/false, LLVM::Linkage::Internal, kCycleCounterPeriodGlobalName, builder.getF64FloatAttr(0.0));
+
+    // double AcceraGetCycleCounterPeriod(), from the CPU runtime library, which calibrates the counter on its first call
+    const char* periodFnName = "AcceraGetCycleCounterPeriod";
+    auto periodFnOp = moduleOp.lookupSymbol<LLVM::LLVMFuncOp>(periodFnName);
+    if (!periodFnOp)
+    {
+        periodFnOp = builder.create<LLVM::LLVMFuncOp>(loc, periodFnName, LLVM::LLVMFunctionType::get(doubleTy, {}, /*isVarArg=*/false));
+        periodFnOp->setAttr("passthrough", builder.getArrayAttr({ builder.getStringAttr("nounwind") }));
+    }
+
+    auto initFnType = LLVM::LLVMFunctionType::get(LLVM::LLVMVoidType::get(context), {}, /*isVarArg=*/false);
+    auto initFnOp = builder.create<LLVM::LLVMFuncOp>(loc, kCycleCounterInitFnName, initFnType, LLVM::Linkage::Internal);
+    {
+        OpBuilder::InsertionGuard guard(builder);
+        builder.setInsertionPointToStart(initFnOp.addEntryBlock());
+        auto periodCall = builder.create<LLVM::CallOp>(loc, TypeRange{ doubleTy }, SymbolRefAttr::get(context, periodFnName), ValueRange{});
+        Value periodPtr = builder.create<LLVM::AddressOfOp>(loc, periodGlobal);
+        builder.create<LLVM::StoreOp>(loc, periodCall.getResult(0), periodPtr);
+        builder.create<LLVM::ReturnOp>(loc, ValueRange{});
+    }
+
+    // @llvm.global_ctors = appending global [1 x { i32, void ()*, i8* }] [{ i32 65535, void ()* @init, i8* null }]
+    auto ctorTy = LLVM::LLVMStructType::getLiteral(context, { i32Ty, LLVM::LLVMPointerType::get(initFnType), i8PtrTy });
+    auto ctorsTy = LLVM::LLVMArrayType::get(ctorTy, 1);
+    auto ctorsGlobal = builder.create<LLVM::GlobalOp>(loc, ctorsTy, /*isConstant=*/false, LLVM::Linkage::Appending, "llvm.global_ctors", Attribute{});
+    {
+        OpBuilder::InsertionGuard guard(builder);
+        builder.createBlock(&ctorsGlobal.getInitializerRegion());
+        Value ctor = builder.create<LLVM::UndefOp>(loc, ctorTy);
+        Value priority = builder.create<LLVM::ConstantOp>(loc, i32Ty, builder.getI32IntegerAttr(65535));
+        Value initFnPtr = builder.create<LLVM::AddressOfOp>(loc, initFnOp);
+        Value data = builder.create<LLVM::NullOp>(loc, i8PtrTy);
+        ctor = builder.create<LLVM::InsertValueOp>(loc, ctor, priority, builder.getI64ArrayAttr(0));
+        ctor = builder.create<LLVM::InsertValueOp>(loc, ctor, initFnPtr, builder.getI64ArrayAttr(1));
+        ctor = builder.create<LLVM::InsertValueOp>(loc, ctor, data, builder.getI64ArrayAttr(2));
+        Value ctors = builder.create<LLVM::UndefOp>(loc, ctorsTy);
+        ctors = builder.create<LLVM::InsertValueOp>(loc, ctors, ctor, builder.getI64ArrayAttr(0));
+        builder.create<LLVM::ReturnOp>(loc, ctors);
+    }
+}
+} // namespace
+
+LogicalResult CycleCounterGetTimeOpLowering::matchAndRewrite(
+    GetTimeOp op,
+    ArrayRef<mlir::Value> operands,
+    ConversionPatternRewriter& rewriter) const
+{
+    auto loc = op.getLoc();
+    auto* context = rewriter.getContext();
+    auto* llvmDialect = context->getOrLoadDialect<LLVM::LLVMDialect>();
+    auto parentModule = op->getParentOfType<ModuleOp>();
+    auto i32Ty = IntegerType::get(context, 32);
+    auto i64Ty = IntegerType::get(context, 64);
+    auto doubleTy = Float64Type::get(context);
+
+    // Loaded before the counter is read, so that the load isn't part of the timed interval
+    auto periodGlobal = parentModule.lookupSymbol<LLVM::GlobalOp>(kCycleCounterPeriodGlobalName);
+    if (!periodGlobal)
+    {
+        return rewriter.notifyMatchFailure(op, "The module doesn't hold the cycle counter period");
+    }
+    Value periodPtr = rewriter.create<LLVM::AddressOfOp>(loc, periodGlobal);
+    Value period = rewriter.create<LLVM::LoadOp>(loc, periodPtr);
+
+    Value ticks;
+    if (arch == llvm::Triple::x86_64)
+    {
+        // { i64, i32 } @llvm.x86.rdtscp(), which waits for the preceding instructions to finish before it reads the
+        // time stamp counter, unlike rdtsc
+        auto resultTy = LLVM::LLVMStructType::getLiteral(context, { i64Ty, i32Ty });
+        auto rdtscpFn = getOrInsertLibraryFunction(rewriter, "llvm.x86.rdtscp", LLVM::LLVMFunctionType::get(resultTy, {}, /*isVarArg=*/false), parentModule, llvmDialect);
+        auto rdtscpCall = rewriter.create<LLVM::CallOp>(loc, TypeRange{ resultTy }, rdtscpFn, ValueRange{});
+        ticks = rewriter.create<LLVM::ExtractValueOp>(loc, i64Ty, rdtscpCall.getResult(0), rewriter.getI64ArrayAttr(0));
+    }
+    else
+    {
+        // LLVM has no intrinsic for the virtual counter. The isb keeps the read from being moved ahead of the
+        // preceding instructions.
+        auto readCounter = rewriter.create<LLVM::InlineAsmOp>(loc, i64Ty, ValueRange{}, "isb\n\tmrs $0, cntvct_el0", "=r", /*has_side_effects=*/true, /*is_align_stack=*/false, LLVM::AsmDialectAttr{});
+        ticks = readCounter.getResult(0);
+    }
+
+    Value ticksDoubleVal = rewriter.create<LLVM::UIToFPOp>(loc, doubleTy, ticks);
+    rewriter.replaceOpWithNewOp<LLVM::FMulOp>(op, doubleTy, ticksDoubleVal, period);
+    return success();
+}
+
 void ValueToLLVMLoweringPass::runOnModule()
 {
     llvm::DebugFlag =
@@ -980,6 +1289,16 @@ void ValueToLLVMLoweringPass::runOnModule()
 
     target.addLegalOp<ModuleOp>();
 
+    if (timer != "clock" && timer != "cycle-counter")
+    {
+        moduleOp.emitError("Unknown timer '") << timer << "', expected clock or cycle-counter";
+        return signalPassFailure();
+    }
+
+    // Targets without a cycle counter that user code can read keep timing with the clock
+    auto timerArch = llvm::Triple(targetTriple.empty() ? llvm::sys::getProcessTriple() : std::string(targetTriple)).getArch();
+    bool useCycleCounter = timer == "cycle-counter" && CycleCounterGetTimeOpLowering::IsSupported(timerArch);
+
     // Set pass parameter values with command line options inherited from ConvertValueToLLVMBase
     mlir::LowerToLLVMOptions options(&getContext());
     options.useBarePtrCallConv = useBarePtrCallConv;
@@ -1028,6 +1347,14 @@ void ValueToLLVMLoweringPass::runOnModule()
     {
         OwningRewritePatternList patterns(&getContext());
         populateValueToLLVMPatterns(llvmTypeConverter, patterns);
+        if (useCycleCounter)
+        {
+            if (moduleOp.walk([](GetTimeOp) { return WalkResult::interrupt(); }).wasInterrupted())
+            {
+                EmitCycleCounterPeriodInit(moduleOp);
+            }
+            patterns.insert<CycleCounterGetTimeOpLowering>(llvmTypeConverter, &getContext(), timerArch);
+        }
 
         populateLinalgToLLVMConversionPatterns(llvmTypeConverter, patterns);
 
@@ -1106,9 +1433,14 @@ void populateLocalValueToLLVMPatterns(mlir::LLVMTypeConverter& typeConverter, ml
         CPUEarlyReturnRewritePattern,
         ReferenceGlobalOpLowering,
         BitcastOpLowering,
+        BufferAddressOpLowering,
         CallOpLowering,
         PrintFOpLowering,
-        GetTimeOpLowering>(typeConverter, context);
+        GetTimeOpLowering,
+        ReadHardwareCountersOpLowering,
+        TraceProfileEventOpLowering,
+        WriteProfileTraceOpLowering,
+        ResetProfileTraceOpLowering>(typeConverter, context);
 }
 
 void populateValueToLLVMPatterns(mlir::LLVMTypeConverter& typeConverter, mlir::OwningRewritePatternList& patterns)
@@ -1142,9 +1474,11 @@ std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>> createValueToLLVMPass(bool
                                                                            unsigned indexBitwidth,
                                                                            bool useAlignedAlloc,
                                                                            llvm::DataLayout dataLayout,
+                                                                           const std::string& timer /* = "clock" */,
+                                                                           const std::string& targetTriple /* = {} */,
                                                                            const IntraPassSnapshotOptions& options /*  = {} */)
 {
-    return std::make_unique<ValueToLLVMLoweringPass>(useBasePtrCallConv, emitCWrappers, indexBitwidth, useAlignedAlloc, dataLayout, options);
+    return std::make_unique<ValueToLLVMLoweringPass>(useBasePtrCallConv, emitCWrappers, indexBitwidth, useAlignedAlloc, dataLayout, timer, targetTriple, options);
 }
 
 std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>> createValueToLLVMPass()
@@ -21,6 +21,7 @@
 #include <mlir/Dialect/Linalg/IR/LinalgOps.h>
 #include <mlir/Dialect/Math/Transforms/Passes.h>
 #include <mlir/Dialect/MemRef/IR/MemRef.h>
+#include <mlir/Dialect/OpenMP/OpenMPDialect.h>
 #include <mlir/Dialect/SCF/SCF.h>
 #include <mlir/Dialect/SPIRV/IR/SPIRVAttributes.h>
 #include <mlir/Dialect/SPIRV/IR/SPIRVOps.h>
@@ -38,6 +39,7 @@
 #include <llvm/Support/FormatVariadic.h>
 
 #include <algorithm>
+#include <optional>
 #include <unordered_set>
 
 #ifndef RC_FILE_LOC
@@ -78,15 +80,49 @@ const char kGlobalOpSymNameFormat[] = "allocated_memref_{0}";
 const char kProfileRegionSymNameFormat[] = "profile_region_{0}_{1}";
 const char kProfileRegionNameIdentifier[] = "profile_region_name";
 const char kProfileRegionTypeIdentifier[] = "profile_region_type";
+const char kProfileRegionHardwareCountersIdentifier[] = "profile_region_hardware_counters";
+const char kProfileRegionTracedIdentifier[] = "profile_region_traced";
 
 enum class ProfileCounterType
 {
     count = 0,
     time = 1,
     startTime = 2,
+    name = 3,
+    hardwareCounters = 4,
+    startHardwareCounters = 5,
 };
 
-void InitializeProfileRegions(mlir::ModuleOp module, mlir::OpBuilder& builder)
+// In the order of AcceraHardwareCounter in the CPU runtime library. A counter's position is its bit in the counter
+// mask and its index in the hardware counter globals of each region.
+constexpr int64_t kNumHardwareCounters = 5;
+const char* const kHardwareCounterNames[kNumHardwareCounters] = { "cycles", "instructions", "l1d_misses", "llc_misses", "dtlb_misses" };
+
+// The size of the AcceraProfileCounter record that accv.get_profile_counters writes, on the 64-bit targets that
+// profiling is limited to (the name pointer is stored as an i64):
+// { const char* name; int64_t count; double seconds; int64_t cycles, instructions, l1d_misses, llc_misses, dtlb_misses; }
+constexpr int64_t kProfileCounterRecordSize = 64;
+constexpr int64_t kProfileCounterRecordHardwareCountersOffset = 24;
+
+// Parses a comma-separated list of hardware counter names into a counter mask
+std::optional<int32_t> ParseHardwareCounters(llvm::StringRef counterNames)
+{
+    int32_t mask = 0;
+    llvm::SmallVector<llvm::StringRef, kNumHardwareCounters> names;
+    counterNames.split(names, ',', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+    for (auto name : names)
+    {
+        auto it = std::find(std::begin(kHardwareCounterNames), std::end(kHardwareCounterNames), name.trim());
+        if (it == std::end(kHardwareCounterNames))
+        {
+            return std::nullopt;
+        }
+        mask |= 1 << (it - std::begin(kHardwareCounterNames));
+    }
+    return mask;
+}
+
+void InitializeProfileRegions(mlir::ModuleOp module, mlir::OpBuilder& builder, int32_t hardwareCounterMask, bool trace)
 {
     std::unordered_set<std::string> regionNames;
     module.walk([&](vir::EnterProfileRegionOp op) {
@@ -121,6 +157,36 @@ void InitializeProfileRegions(mlir::ModuleOp module, mlir::OpBuilder& builder)
         auto startTime = builder.create<vir::GlobalOp>(loc, timeType, false, llvm::formatv(kProfileRegionSymNameFormat, name, "start").str(), mlir::DenseFPElementsAttr::get(timeTensorType, { 0.0 }));
         startTime->setAttr(kProfileRegionNameIdentifier, nameAttr);
         startTime->setAttr(kProfileRegionTypeIdentifier, builder.getI32IntegerAttr(static_cast<int>(ProfileCounterType::startTime)));
+
+        // The NUL-terminated region name, which accv.get_profile_counters hands out pointers to
+        std::vector<int8_t> nameChars(name.begin(), name.end());
+        nameChars.push_back(0);
+        auto nameType = mlir::MemRefType::get({ static_cast<int64_t>(nameChars.size()) }, builder.getIntegerType(8));
+        auto nameTensorType = mlir::RankedTensorType::get({ static_cast<int64_t>(nameChars.size()) }, builder.getIntegerType(8));
+        auto nameString = builder.create<vir::GlobalOp>(loc, nameType, true, llvm::formatv(kProfileRegionSymNameFormat, name, "name").str(), mlir::DenseElementsAttr::get(nameTensorType, llvm::makeArrayRef(nameChars)));
+        nameString->setAttr(kProfileRegionNameIdentifier, nameAttr);
+        nameString->setAttr(kProfileRegionTypeIdentifier, builder.getI32IntegerAttr(static_cast<int>(ProfileCounterType::name)));
+        if (trace)
+        {
+            nameString->setAttr(kProfileRegionTracedIdentifier, builder.getUnitAttr());
+        }
+
+        // The hardware counter totals are kept next to the time and count, one element per counter. Counters that
+        // aren't enabled stay 0, so that the layout doesn't depend on which ones are.
+        if (hardwareCounterMask != 0)
+        {
+            auto hardwareCountersType = mlir::MemRefType::get({ kNumHardwareCounters }, int64Type);
+            auto zeros = builder.getI64TensorAttr(std::vector<int64_t>(kNumHardwareCounters, 0));
+
+            auto hardwareCounters = builder.create<vir::GlobalOp>(loc, hardwareCountersType, false, llvm::formatv(kProfileRegionSymNameFormat, name, "hardware_counters").str(), zeros);
+            hardwareCounters->setAttr(kProfileRegionNameIdentifier, nameAttr);
+            hardwareCounters->setAttr(kProfileRegionTypeIdentifier, builder.getI32IntegerAttr(static_cast<int>(ProfileCounterType::hardwareCounters)));
+            hardwareCounters->setAttr(kProfileRegionHardwareCountersIdentifier, builder.getI32IntegerAttr(hardwareCounterMask));
+
+            auto startHardwareCounters = builder.create<vir::GlobalOp>(loc, hardwareCountersType, false, llvm::formatv(kProfileRegionSymNameFormat, name, "start_hardware_counters").str(), zeros);
+            startHardwareCounters->setAttr(kProfileRegionNameIdentifier, nameAttr);
+            startHardwareCounters->setAttr(kProfileRegionTypeIdentifier, builder.getI32IntegerAttr(static_cast<int>(ProfileCounterType::startHardwareCounters)));
+        }
     }
 }
 
@@ -129,6 +195,15 @@ struct ProfileCounter
     vir::GlobalOp count;
     vir::GlobalOp time;
     vir::GlobalOp startTime;
+    vir::GlobalOp name;
+
+    // Whether entering and exiting the region is recorded in the trace of the CPU runtime library
+    bool traced = false;
+
+    // Only set if the module reads hardware counters
+    vir::GlobalOp hardwareCounters;
+    vir::GlobalOp startHardwareCounters;
+    int32_t hardwareCounterMask = 0;
 };
 
 struct ProfileRegions
@@ -150,6 +225,17 @@ struct ProfileRegions
                 case ProfileCounterType::startTime:
                     counters[regionNameAttr.getValue().str()].startTime = op;
                     break;
+                case ProfileCounterType::name:
+                    counters[regionNameAttr.getValue().str()].name = op;
+                    counters[regionNameAttr.getValue().str()].traced = op->hasAttr(kProfileRegionTracedIdentifier);
+                    break;
+                case ProfileCounterType::hardwareCounters:
+                    counters[regionNameAttr.getValue().str()].hardwareCounters = op;
+                    counters[regionNameAttr.getValue().str()].hardwareCounterMask = static_cast<int32_t>(op->getAttrOfType<mlir::IntegerAttr>(kProfileRegionHardwareCountersIdentifier).getInt());
+                    break;
+                case ProfileCounterType::startHardwareCounters:
+                    counters[regionNameAttr.getValue().str()].startHardwareCounters = op;
+                    break;
                 default:
                     op.emitError("Error: bad counter type");
                     break;
@@ -161,6 +247,149 @@ struct ProfileRegions
     std::map<std::string, ProfileCounter> counters;
 };
 
+// Allocates a buffer for one reading of the hardware counters at the top of the function or OpenMP parallel region
+// that op is (or is in), so that every thread gets its own
+mlir::Value AllocateHardwareCounterBuffer(mlir::OpBuilder& builder, mlir::Location loc, mlir::Operation* op)
+{
+    auto parentOp = op;
+    while (parentOp && !mlir::isa<mlir::FuncOp, mlir::omp::ParallelOp>(parentOp))
+    {
+        parentOp = parentOp->getParentOp();
+    }
+    assert(parentOp && "Profile regions must be inside a function");
+
+    OpBuilder::InsertionGuard guard(builder);
+    builder.setInsertionPointToStart(&parentOp->getRegion(0).front());
+    return builder.create<memref::AllocaOp>(loc, mlir::MemRefType::get({ kNumHardwareCounters }, builder.getI64Type()));
+}
+
+// Adds the time since startTime to the region's total and counts one more visit. Every thread that runs the region
+// adds to the same totals, so they are updated with atomic read-modify-writes. If the module reads hardware
+// counters, startHardwareCounters holds their values at the start of the visit, and the number of events since
+// then is added to the region's totals the same way.
+void AccumulateProfileRegion(mlir::OpBuilder& builder, mlir::Location loc, const ProfileCounter& counters, mlir::Value startTime, mlir::Value startHardwareCounters)
+{
+    if (counters.hardwareCounterMask != 0)
+    {
+        // The counters are read before the time, so that they don't count the time being read
+        auto endHardwareCounters = AllocateHardwareCounterBuffer(builder, loc, builder.getInsertionBlock()->getParentOp());
+        builder.create<vir::ReadHardwareCountersOp>(loc, endHardwareCounters, counters.hardwareCounterMask);
+
+        mlir::Value totalsRef = builder.create<vir::ReferenceGlobalOp>(loc, counters.hardwareCounters);
+        for (int64_t counter = 0; counter < kNumHardwareCounters; ++counter)
+        {
+            if ((counters.hardwareCounterMask & (1 << counter)) == 0)
+            {
+                continue;
+            }
+            mlir::Value index = builder.create<ConstantIndexOp>(loc, counter);
+            mlir::Value start = builder.create<memref::LoadOp>(loc, startHardwareCounters, ValueRange{ index });
+            mlir::Value end = builder.create<memref::LoadOp>(loc, endHardwareCounters, ValueRange{ index });
+            mlir::Value events = builder.create<mlir::SubIOp>(loc, end, start);
+            (void)builder.create<mlir::AtomicRMWOp>(loc, events.getType(), mlir::AtomicRMWKind::addi, events, totalsRef, ValueRange{ index });
+        }
+    }
+
+    mlir::Value currentTime = builder.create<vir::GetTimeOp>(loc);
+    mlir::Value duration = builder.create<mlir::SubFOp>(loc, currentTime, startTime);
+    mlir::Value zero = builder.create<ConstantIndexOp>(loc, 0);
+
+    mlir::Value totalTimeRef = builder.create<vir::ReferenceGlobalOp>(loc, counters.time);
+    (void)builder.create<mlir::AtomicRMWOp>(loc, duration.getType(), mlir::AtomicRMWKind::addf, duration, totalTimeRef, ValueRange{ zero });
+
+    mlir::Value countRef = builder.create<vir::ReferenceGlobalOp>(loc, counters.count);
+    mlir::Value one = builder.create<ConstantIntOp>(loc, 1, 64);
+    (void)builder.create<mlir::AtomicRMWOp>(loc, one.getType(), mlir::AtomicRMWKind::addi, one, countRef, ValueRange{ zero });
+}
+
+// Records the calling thread entering or exiting the region in the trace, if the module is traced. Entries are
+// recorded before the region's counters are read and exits after they're accumulated, so that the counters don't
+// include the cost of tracing.
+void TraceProfileRegion(mlir::OpBuilder& builder, mlir::Location loc, const ProfileCounter& counters, bool entry)
+{
+    if (counters.traced)
+    {
+        mlir::Value nameRef = builder.create<vir::ReferenceGlobalOp>(loc, counters.name);
+        builder.create<vir::TraceProfileEventOp>(loc, nameRef, entry);
+    }
+}
+
+// Returns the enter op that opens the region an exit op closes: the nearest preceding enter of the same region in the
+// exit op's block or in one of the blocks enclosing it in the same function
+vir::EnterProfileRegionOp FindEnterProfileRegionOp(vir::ExitProfileRegionOp exitOp)
+{
+    auto regionName = exitOp.regionName();
+    for (mlir::Operation* op = exitOp; op && !mlir::isa<mlir::FuncOp>(op); op = op->getParentOp())
+    {
+        for (auto prevOp = op->getPrevNode(); prevOp; prevOp = prevOp->getPrevNode())
+        {
+            if (auto enterOp = mlir::dyn_cast<vir::EnterProfileRegionOp>(prevOp); enterOp && enterOp.regionName() == regionName)
+            {
+                return enterOp;
+            }
+        }
+    }
+    return {};
+}
+
+// Lowers the exit ops whose enter op dominates them by keeping the start time in a value local to the function, so
+// that threads running the same region concurrently each time their own visit. The remaining enter and exit ops
+// keep the start time in the region's global and are lowered by the patterns, which is only correct when a single
+// thread runs the region at a time.
+void LowerPairedProfileRegions(mlir::ModuleOp module)
+{
+    ProfileRegions regions(module);
+
+    std::vector<vir::ExitProfileRegionOp> exitOps;
+    module.walk([&](vir::ExitProfileRegionOp op) { exitOps.push_back(op); });
+
+    struct StartValues
+    {
+        mlir::Value time;
+        mlir::Value hardwareCounters;
+    };
+    llvm::DenseMap<mlir::Operation*, StartValues> startValues;
+    std::unordered_set<std::string> unpairedRegions;
+    for (auto exitOp : exitOps)
+    {
+        auto regionName = exitOp.regionName().str();
+        auto enterOp = FindEnterProfileRegionOp(exitOp);
+        if (!enterOp || regions.counters.count(regionName) == 0)
+        {
+            unpairedRegions.insert(regionName);
+            continue;
+        }
+
+        const auto& counters = regions.counters[regionName];
+        auto& start = startValues[enterOp];
+        if (!start.time)
+        {
+            mlir::OpBuilder builder(enterOp);
+            TraceProfileRegion(builder, enterOp.getLoc(), counters, /*entry=*/true);
+            start.time = builder.create<vir::GetTimeOp>(enterOp.getLoc());
+            if (counters.hardwareCounterMask != 0)
+            {
+                start.hardwareCounters = AllocateHardwareCounterBuffer(builder, enterOp.getLoc(), enterOp);
+                builder.create<vir::ReadHardwareCountersOp>(enterOp.getLoc(), start.hardwareCounters, counters.hardwareCounterMask);
+            }
+        }
+
+        mlir::OpBuilder builder(exitOp);
+        AccumulateProfileRegion(builder, exitOp.getLoc(), counters, start.time, start.hardwareCounters);
+        TraceProfileRegion(builder, exitOp.getLoc(), counters, /*entry=*/false);
+        exitOp.erase();
+    }
+
+    for (auto& entry : startValues)
+    {
+        auto enterOp = mlir::cast<vir::EnterProfileRegionOp>(entry.first);
+        if (unpairedRegions.count(enterOp.regionName().str()) == 0)
+        {
+            enterOp.erase();
+        }
+    }
+}
+
 std::string GetFormatStringForElementType(mlir::Type elementType)
 {
     if (elementType.isa<mlir::FloatType>())
@@ -414,6 +643,8 @@ public:
 using vir::EnterProfileRegionOp;
 using vir::ExitProfileRegionOp;
 using vir::PrintProfileResultsOp;
+using vir::ResetProfileCountersOp;
+using vir::GetProfileCountersOp;
 
 struct EnterProfileRegionOpLowering : public OpRewritePattern<EnterProfileRegionOp>
 {
@@ -453,6 +684,30 @@ struct PrintProfileResultsOpLowering : public OpRewritePattern<PrintProfileResul
     bool enableProfiling = true;
 };
 
+struct ResetProfileCountersOpLowering : public OpRewritePattern<ResetProfileCountersOp>
+{
+    using OpRewritePattern::OpRewritePattern;
+    ResetProfileCountersOpLowering(MLIRContext* context, bool enableProfiling) :
+        OpRewritePattern(context),
+        enableProfiling(enableProfiling)
+    {}
+    LogicalResult matchAndRewrite(ResetProfileCountersOp op, PatternRewriter& rewriter) const final;
+
+    bool enableProfiling = true;
+};
+
+struct GetProfileCountersOpLowering : public OpRewritePattern<GetProfileCountersOp>
+{
+    using OpRewritePattern::OpRewritePattern;
+    GetProfileCountersOpLowering(MLIRContext* context, bool enableProfiling) :
+        OpRewritePattern(context),
+        enableProfiling(enableProfiling)
+    {}
+    LogicalResult matchAndRewrite(GetProfileCountersOp op, PatternRewriter& rewriter) const final;
+
+    bool enableProfiling = true;
+};
+
 using ValueAllocOp = vir::AllocOp;
 struct AllocOpLowering : public OpRewritePattern<ValueAllocOp>
 {
@@ -498,10 +753,12 @@ struct AllocOpLowering : public OpRewritePattern<ValueAllocOp>
 struct ValueToStdLoweringPass : public ConvertValueToStdBase<ValueToStdLoweringPass>
 {
     ValueToStdLoweringPass() = default;
-    ValueToStdLoweringPass(bool enableProfiling) :
+    ValueToStdLoweringPass(bool enableProfiling, const std::string& profileCounters, bool profileTrace) :
         ValueToStdLoweringPass()
     {
         this->enableProfiling = enableProfiling;
+        this->profileCounters = profileCounters;
+        this->profileTrace = profileTrace;
     }
 
     void runOnModule() final;
@@ -894,6 +1151,279 @@ struct ValueLaunchFuncOpRewritePattern : OpRewritePattern<vir::LaunchFuncOp>
     }
 };
 
+// Vectorized reductions keep several independent vector accumulators, so that the loop is not bound by the
+// latency of a single chain of dependent ops
+constexpr int64_t kMaxReductionAccumulators = 8;
+const char kReductionAccumulatorsAttrName[] = "numAccumulators";
+
+// The reduce_sum and reduce_max ops don't carry vectorization info, so they use AVX2-sized vectors
+constexpr int64_t kDefaultReductionVectorBytes = 32;
+constexpr int64_t kDefaultReductionAccumulators = 4;
+
+int64_t GetNumReductionAccumulators(int64_t vectorUnits)
+{
+    // Leave most of the vector registers for the loads and the body of the reduction
+    return std::clamp<int64_t>(vectorUnits / 4, 1, kMaxReductionAccumulators);
+}
+
+bool HasUnitInnermostStride(mlir::MemRefType memRefType)
+{
+    if (memRefType.getAffineMaps().empty())
+    {
+        return true;
+    }
+
+    SmallVector<int64_t, 4> strides;
+    int64_t offset;
+    return succeeded(getStridesAndOffset(memRefType, strides, offset)) && !strides.empty() && strides.back() == 1;
+}
+
+mlir::Value LoadReductionVector(PatternRewriter& rewriter, mlir::Location loc, mlir::Value input, mlir::Value index, mlir::VectorType vectorType)
+{
+    if (HasUnitInnermostStride(input.getType().cast<mlir::MemRefType>()))
+    {
+        return rewriter.create<mlir::vector::LoadOp>(loc, vectorType, input, ValueRange{ index });
+    }
+
+    // Strided input: gather the elements one at a time
+    auto elementType = vectorType.getElementType();
+    auto zero = rewriter.create<mlir::ConstantOp>(loc, elementType, rewriter.getZeroAttr(elementType));
+    mlir::Value element = rewriter.create<mlir::vector::BroadcastOp>(loc, vectorType, zero);
+    for (int64_t i = 0; i < vectorType.getNumElements(); ++i)
+    {
+        auto offset = rewriter.create<mlir::ConstantIndexOp>(loc, i);
+        auto offsetIndex = rewriter.create<mlir::AddIOp>(loc, index, offset);
+        auto elementLoad = rewriter.create<memref::LoadOp>(loc, input, ValueRange{ offsetIndex });
+        element = rewriter.create<mlir::vector::InsertElementOp>(loc, elementLoad.getResult(), element, i);
+    }
+    return element;
+}
+
+void StoreReductionVector(PatternRewriter& rewriter, mlir::Location loc, mlir::Value value, mlir::Value input, mlir::Value index)
+{
+    if (HasUnitInnermostStride(input.getType().cast<mlir::MemRefType>()))
+    {
+        rewriter.create<mlir::vector::StoreOp>(loc, value, input, ValueRange{ index });
+        return;
+    }
+
+    auto vectorType = value.getType().cast<mlir::VectorType>();
+    for (int64_t i = 0; i < vectorType.getNumElements(); ++i)
+    {
+        auto element = rewriter.create<mlir::vector::ExtractElementOp>(loc, value, i);
+        auto offset = rewriter.create<mlir::ConstantIndexOp>(loc, i);
+        auto offsetIndex = rewriter.create<mlir::AddIOp>(loc, index, offset);
+        rewriter.create<memref::StoreOp>(loc, element, input, ValueRange{ offsetIndex });
+    }
+}
+
+enum class ReductionKind
+{
+    Sum,
+    Product,
+    Max,
+    Min
+};
+
+// Returns a splat of the identity value of the reduction, or a null value if the element type can't be held by a constant
+mlir::Value CreateReductionIdentity(PatternRewriter& rewriter, mlir::Location loc, mlir::VectorType vectorType, ReductionKind kind)
+{
+    auto elementType = vectorType.getElementType();
+    mlir::Attribute identity;
+    if (auto floatType = elementType.dyn_cast<mlir::FloatType>())
+    {
+        switch (kind)
+        {
+        case ReductionKind::Sum:
+            identity = rewriter.getZeroAttr(floatType);
+            break;
+        case ReductionKind::Product:
+            identity = rewriter.getFloatAttr(floatType, 1.0);
+            break;
+        case ReductionKind::Max:
+            identity = rewriter.getFloatAttr(floatType, llvm::APFloat::getInf(floatType.getFloatSemantics(), /*Negative=*/true));
+            break;
+        case ReductionKind::Min:
+            identity = rewriter.getFloatAttr(floatType, llvm::APFloat::getInf(floatType.getFloatSemantics(), /*Negative=*/false));
+            break;
+        }
+    }
+    else if (elementType.isSignlessInteger())
+    {
+        auto bitWidth = elementType.getIntOrFloatBitWidth();
+        switch (kind)
+        {
+        case ReductionKind::Sum:
+            identity = rewriter.getZeroAttr(elementType);
+            break;
+        case ReductionKind::Product:
+            identity = rewriter.getIntegerAttr(elementType, 1);
+            break;
+        case ReductionKind::Max:
+            identity = rewriter.getIntegerAttr(elementType, llvm::APInt::getSignedMinValue(bitWidth));
+            break;
+        case ReductionKind::Min:
+            identity = rewriter.getIntegerAttr(elementType, llvm::APInt::getSignedMaxValue(bitWidth));
+            break;
+        }
+    }
+    else
+    {
+        return {};
+    }
+
+    auto scalarIdentity = rewriter.create<mlir::ConstantOp>(loc, elementType, identity);
+    return rewriter.create<mlir::vector::BroadcastOp>(loc, vectorType, scalarIdentity);
+}
+
+// The op that merges two partial results of a reduction, along with its identity value
+struct ReductionCombiner
+{
+    std::function<mlir::Value(mlir::Value, mlir::Value)> combine;
+    mlir::Value identity;
+};
+
+// Emits the vector part of a reduction over the first `numVectors * vectorSize` elements of the input.
+// `getElement` returns the vector of elements starting at the given index, and `accumulate` folds an element vector
+// into an accumulator. If there's a combiner, the elements are spread over several accumulators: the first one
+// starts from the initial value and the others from the identity, and they're merged with `combiner->combine`
+// at the end. Without a combiner there's a single accumulator.
+mlir::Value EmitMultiAccumulatorReduction(PatternRewriter& rewriter,
+                                          mlir::Location loc,
+                                          int64_t numVectors,
+                                          int64_t vectorSize,
+                                          int64_t numAccumulators,
+                                          mlir::Value initialValue,
+                                          std::function<mlir::Value(mlir::Value)> getElement,
+                                          std::function<mlir::Value(mlir::Value, mlir::Value)> accumulate,
+                                          const std::optional<ReductionCombiner>& combiner)
+{
+    if (numVectors == 0)
+    {
+        return initialValue;
+    }
+
+    numAccumulators = combiner ? std::clamp<int64_t>(numAccumulators, 1, numVectors) : 1;
+    auto blockSize = numAccumulators * vectorSize;
+    auto vectorLoopSize = numVectors * vectorSize;
+    auto mainLoopSize = RoundDownToMultiple(vectorLoopSize, blockSize);
+
+    std::vector<mlir::Value> accumulators;
+    for (int64_t i = 0; i < numAccumulators; ++i)
+    {
+        auto element = getElement(rewriter.create<ConstantIndexOp>(loc, i * vectorSize));
+        accumulators.push_back(accumulate(element, i == 0 ? initialValue : combiner->identity));
+    }
+
+    if (mainLoopSize > blockSize)
+    {
+        auto lowerBound = rewriter.create<ConstantIndexOp>(loc, blockSize);
+        auto upperBound = rewriter.create<ConstantIndexOp>(loc, mainLoopSize);
+        auto step = rewriter.create<ConstantIndexOp>(loc, blockSize);
+        auto loop = rewriter.create<scf::ForOp>(loc, lowerBound, upperBound, step, accumulators);
+        {
+            OpBuilder::InsertionGuard guard(rewriter);
+            rewriter.setInsertionPointToStart(loop.getBody());
+
+            std::vector<mlir::Value> results;
+            for (int64_t i = 0; i < numAccumulators; ++i)
+            {
+                auto offset = rewriter.create<ConstantIndexOp>(loc, i * vectorSize);
+                auto index = rewriter.create<mlir::AddIOp>(loc, loop.getInductionVar(), offset);
+                results.push_back(accumulate(getElement(index), loop.getRegionIterArgs()[i]));
+            }
+            rewriter.create<scf::YieldOp>(loc, results);
+        }
+        accumulators.assign(loop.getResults().begin(), loop.getResults().end());
+    }
+
+    // Combine the accumulators pairwise
+    while (accumulators.size() > 1)
+    {
+        std::vector<mlir::Value> combined;
+        for (size_t i = 0; i + 1 < accumulators.size(); i += 2)
+        {
+            combined.push_back(combiner->combine(accumulators[i], accumulators[i + 1]));
+        }
+        if (accumulators.size() % 2 != 0)
+        {
+            combined.push_back(accumulators.back());
+        }
+        accumulators = std::move(combined);
+    }
+
+    // Fold in the (fewer than numAccumulators) remaining whole vectors
+    auto result = accumulators[0];
+    for (auto index = mainLoopSize; index < vectorLoopSize; index += vectorSize)
+    {
+        result = accumulate(getElement(rewriter.create<ConstantIndexOp>(loc, index)), result);
+    }
+    return result;
+}
+
+int64_t GetDefaultReductionVectorSize(mlir::Type elementType)
+{
+    return std::max<int64_t>(1, kDefaultReductionVectorBytes * 8 / elementType.getIntOrFloatBitWidth());
+}
+
+bool UseChunkedElementwiseReduction(mlir::MemRefType memRefType)
+{
+    // Small inputs are reduced as a single vector
+    auto elementType = memRefType.getElementType();
+    return memRefType.hasStaticShape() && elementType.isIntOrFloat() &&
+           memRefType.getNumElements() > kDefaultReductionAccumulators * GetDefaultReductionVectorSize(elementType);
+}
+
+// Lowers reduce_sum and reduce_max of a large rank-1 memref to a multi-accumulator vector loop
+mlir::Value EmitElementwiseReduction(PatternRewriter& rewriter, mlir::Location loc, mlir::Value input, bool isMax)
+{
+    auto memRefType = input.getType().cast<mlir::MemRefType>();
+    auto elementType = memRefType.getElementType();
+    auto size = memRefType.getShape()[0];
+    auto vectorSize = GetDefaultReductionVectorSize(elementType);
+    auto vectorType = mlir::VectorType::get({ vectorSize }, elementType);
+    auto isFloat = elementType.isa<mlir::FloatType>();
+
+    auto combine = [&](mlir::Value a, mlir::Value b) -> mlir::Value {
+        if (isMax)
+        {
+            mlir::Value greater = isFloat ? rewriter.create<mlir::CmpFOp>(loc, CmpFPredicate::OGT, a, b).getResult() : rewriter.create<mlir::CmpIOp>(loc, CmpIPredicate::sgt, a, b).getResult();
+            return rewriter.create<mlir::SelectOp>(loc, greater, a, b);
+        }
+        return isFloat ? rewriter.create<mlir::AddFOp>(loc, a, b).getResult() : rewriter.create<mlir::AddIOp>(loc, a, b).getResult();
+    };
+
+    std::optional<ReductionCombiner> combiner;
+    if (auto identity = CreateReductionIdentity(rewriter, loc, vectorType, isMax ? ReductionKind::Max : ReductionKind::Sum))
+    {
+        combiner = ReductionCombiner{ combine, identity };
+    }
+
+    auto numVectors = size / vectorSize;
+    auto firstElement = LoadReductionVector(rewriter, loc, input, rewriter.create<ConstantIndexOp>(loc, 0), vectorType);
+    auto vectorResult = EmitMultiAccumulatorReduction(
+        rewriter,
+        loc,
+        numVectors - 1,
+        vectorSize,
+        kDefaultReductionAccumulators,
+        firstElement,
+        [&](mlir::Value index) {
+            auto offsetIndex = rewriter.create<mlir::AddIOp>(loc, index, rewriter.create<ConstantIndexOp>(loc, vectorSize));
+            return LoadReductionVector(rewriter, loc, input, offsetIndex, vectorType);
+        },
+        combine,
+        combiner);
+
+    mlir::Value result = rewriter.create<mlir::vector::ReductionOp>(loc, elementType, rewriter.getStringAttr(isMax ? "max" : "add"), vectorResult, llvm::None);
+    for (auto index = numVectors * vectorSize; index < size; ++index)
+    {
+        auto element = rewriter.create<memref::LoadOp>(loc, input, ValueRange{ rewriter.create<ConstantIndexOp>(loc, index) });
+        result = combine(element, result);
+    }
+    return result;
+}
+
 } // namespace
 
 LogicalResult BinOpLowering::matchAndRewrite(
@@ -1143,6 +1673,106 @@ static ValueCmpOpPredicate NegateCmpOpPredicate(ValueCmpOpPredicate pred)
 #undef MAP_PREDICATE
 }
 
+// Finds the op that folds the accumulator into the result of a reduction body, e.g. the add in `p + a * a`, and
+// returns a combiner that applies it to two partial results. The body itself can't merge partial results, since
+// it treats one of them as an input element. Returns std::nullopt if the body isn't of that form.
+static std::optional<ReductionCombiner> GetReductionCombiner(PatternRewriter& rewriter, mlir::Location loc, mlir::Value accumulator, mlir::Value yieldValue, mlir::VectorType vectorType)
+{
+    auto yieldValueOp = yieldValue.getDefiningOp();
+    if (!yieldValueOp)
+    {
+        return std::nullopt;
+    }
+
+    if (auto binOp = dyn_cast<ValueBinOp>(yieldValueOp))
+    {
+        // %4 = "accv.bin_op"(%3, %arg3) {predicate = 0 : i64} : (f32, f32) -> f32
+        // "accv.yield"(%4) : (f32) -> ()
+        using accera::ir::value::BinaryOpPredicate;
+        auto pred = binOp.predicate();
+        if ((pred != BinaryOpPredicate::ADD && pred != BinaryOpPredicate::MUL) ||
+            (binOp.lhs() != accumulator && binOp.rhs() != accumulator) ||
+            !accumulator.hasOneUse())
+        {
+            return std::nullopt;
+        }
+
+        auto identity = CreateReductionIdentity(rewriter, loc, vectorType, pred == BinaryOpPredicate::ADD ? ReductionKind::Sum : ReductionKind::Product);
+        if (!identity)
+        {
+            return std::nullopt;
+        }
+        return ReductionCombiner{
+            [&rewriter, loc, pred](mlir::Value a, mlir::Value b) -> mlir::Value {
+                return rewriter.create<ValueBinOp>(loc, pred, a, b);
+            },
+            identity
+        };
+    }
+
+    if (auto selectOp = dyn_cast<mlir::SelectOp>(yieldValueOp))
+    {
+        // %4 = "accv.cmp"(%3, %arg3) {predicate = 4 : i64} : (f32, f32) -> i1
+        // %5 = select %4, %3, %arg3 : f32
+        // "accv.yield"(%5) : (f32) -> ()
+        auto cmpOp = dyn_cast_or_null<ValueCmpOp>(selectOp.getCondition().getDefiningOp());
+        if (!cmpOp)
+        {
+            return std::nullopt;
+        }
+
+        auto trueValue = selectOp.getTrueValue();
+        auto falseValue = selectOp.getFalseValue();
+        auto other = trueValue == accumulator ? falseValue : trueValue;
+        bool isMinMax = (trueValue == accumulator || falseValue == accumulator) && other != accumulator &&
+                        ((cmpOp.lhs() == accumulator && cmpOp.rhs() == other) || (cmpOp.lhs() == other && cmpOp.rhs() == accumulator)) &&
+                        llvm::all_of(accumulator.getUsers(), [&](Operation* user) { return user == cmpOp.getOperation() || user == selectOp.getOperation(); });
+        if (!isMinMax)
+        {
+            return std::nullopt;
+        }
+
+        // Normalize to `cmp(trueValue, falseValue)`
+        auto pred = cmpOp.getPredicate();
+        if (cmpOp.lhs() == falseValue)
+        {
+            pred = NegateCmpOpPredicate(pred);
+        }
+
+        std::optional<ReductionKind> kind;
+        switch (pred)
+        {
+        case ValueCmpOpPredicate::LT:
+            [[fallthrough]];
+        case ValueCmpOpPredicate::LE:
+            kind = ReductionKind::Min;
+            break;
+        case ValueCmpOpPredicate::GT:
+            [[fallthrough]];
+        case ValueCmpOpPredicate::GE:
+            kind = ReductionKind::Max;
+            break;
+        default:
+            break;
+        }
+
+        auto identity = kind ? CreateReductionIdentity(rewriter, loc, vectorType, *kind) : mlir::Value{};
+        if (!identity)
+        {
+            return std::nullopt;
+        }
+        return ReductionCombiner{
+            [&rewriter, loc, pred](mlir::Value a, mlir::Value b) -> mlir::Value {
+                auto cmp = rewriter.create<ValueCmpOp>(loc, pred, a, b);
+                return rewriter.create<mlir::SelectOp>(loc, cmp, a, b);
+            },
+            identity
+        };
+    }
+
+    return std::nullopt;
+}
+
 static CmpFPredicate CmpOpPredicateToCmpFPredicate(ValueCmpOpPredicate pred)
 {
 #define MAP_PREDICATE(v)         \
@@ -1545,7 +2175,7 @@ LogicalResult ReduceOpVectorization::matchAndRewrite(
     }
 
     [[maybe_unused]] int vectorBytes = vectorizationInfoAttr.getValue().vectorBytes;
-    [[maybe_unused]] int vectorUnits = vectorizationInfoAttr.getValue().vectorUnitCount;
+    int vectorUnits = vectorizationInfoAttr.getValue().vectorUnitCount;
 
     auto loc = op.getLoc();
     auto input = op.input();
@@ -1618,6 +2248,7 @@ LogicalResult ReduceOpVectorization::matchAndRewrite(
         }
     }
     parallelReduce->setAttr("parallelReduction", rewriter.getUnitAttr());
+    parallelReduce->setAttr(kReductionAccumulatorsAttrName, rewriter.getI64IntegerAttr(GetNumReductionAccumulators(vectorUnits)));
 
     auto horizontalReduce = rewriter.create<ValueReduceOp>(loc, parallelReduce.getResult(), initialValue);
     {
@@ -1790,59 +2421,67 @@ LogicalResult ReduceOpLowering::matchAndRewrite(
     auto size = inputType.getShape()[0];
     auto loopSize = isParallelReduction ? RoundDownToMultiple(size, vectorSize) : size;
     auto remainder = size - loopSize;
-    auto lowerBound = rewriter.create<ConstantIndexOp>(loc, 0);
     auto upperBound = rewriter.create<ConstantIndexOp>(loc, loopSize);
-    auto step = rewriter.create<ConstantIndexOp>(loc, stepValue);
-    auto loop = rewriter.create<scf::ForOp>(loc, lowerBound, upperBound, step, initialValue);
-    auto loopBody = loop.getBody();
-    {
-        OpBuilder::InsertionGuard guard(rewriter);
-        rewriter.setInsertionPointToStart(loopBody);
 
-        // map the "input element value" to "input[i]"
+    // Clones the reduction op body to fold `element` into `accumulator`
+    auto cloneBody = [&](mlir::Value element, mlir::Value accumulator) {
         BlockAndValueMapping operandMap;
-        mlir::Value element;
-        if (isParallelReduction)
-        {
-            auto elementType = inputType.getElementType();
-            auto zero = rewriter.create<mlir::ConstantOp>(loc, elementType, rewriter.getZeroAttr(elementType));
-            auto vectorType = initialValueType;
-            element = rewriter.create<mlir::vector::BroadcastOp>(loc, vectorType, zero);
-            for (int64_t i = 0; i < vectorSize; ++i)
-            {
-                auto offset = rewriter.create<mlir::ConstantIndexOp>(loc, i);
-                auto offsetInductionVar = rewriter.create<mlir::AddIOp>(loc, loop.getInductionVar(), offset);
-                auto elementLoad = rewriter.create<memref::LoadOp>(loc, input, ValueRange{ offsetInductionVar });
-                element = rewriter.create<mlir::vector::InsertElementOp>(loc, elementLoad.getResult(), element, i);
-            }
-        }
-        else if (isHorizontalReduction)
-        {
-            // extract element from input vector
-            auto laneIndex = rewriter.create<mlir::IndexCastOp>(loc, loop.getInductionVar(), rewriter.getI32Type()).getResult();
-            element = rewriter.create<mlir::vector::ExtractElementOp>(loc, input, laneIndex).getResult();
-        }
-        else
-        {
-            element = rewriter.create<memref::LoadOp>(loc, input, loop.getInductionVar()).getResult();
-        }
-
-        auto newInductionValue = loop.getRegionIterArgs()[0];
         operandMap.map(oldInputValue, element);
-        operandMap.map(oldInductionValue, newInductionValue);
-
-        // Copy reduction op body
+        operandMap.map(oldInductionValue, accumulator);
         for (auto& op : op.getBody()->without_terminator())
         {
             rewriter.clone(op, operandMap);
         }
+        return operandMap.lookupOrDefault(oldYieldValue);
+    };
 
-        // now add an appropriate yield operation
-        auto newYieldValue = operandMap.lookupOrDefault(oldYieldValue);
-        rewriter.create<scf::YieldOp>(loc, newYieldValue);
+    mlir::Value result;
+    if (isParallelReduction)
+    {
+        auto vectorType = initialValueType.cast<mlir::VectorType>();
+        auto numAccumulatorsAttr = op->getAttrOfType<IntegerAttr>(kReductionAccumulatorsAttrName);
+        auto numAccumulators = numAccumulatorsAttr ? numAccumulatorsAttr.getInt() : 1;
+        result = EmitMultiAccumulatorReduction(
+            rewriter,
+            loc,
+            loopSize / vectorSize,
+            vectorSize,
+            numAccumulators,
+            initialValue,
+            [&](mlir::Value index) { return LoadReductionVector(rewriter, loc, input, index, vectorType); },
+            cloneBody,
+            numAccumulators > 1 ? GetReductionCombiner(rewriter, loc, oldInductionValue, oldYieldValue, vectorType) : std::nullopt);
     }
+    else
+    {
+        auto lowerBound = rewriter.create<ConstantIndexOp>(loc, 0);
+        auto step = rewriter.create<ConstantIndexOp>(loc, stepValue);
+        auto loop = rewriter.create<scf::ForOp>(loc, lowerBound, upperBound, step, initialValue);
+        auto loopBody = loop.getBody();
+        {
+            OpBuilder::InsertionGuard guard(rewriter);
+            rewriter.setInsertionPointToStart(loopBody);
 
-    mlir::Value result = loop.getResults()[0];
+            // map the "input element value" to "input[i]"
+            mlir::Value element;
+            if (isHorizontalReduction)
+            {
+                // extract element from input vector
+                auto laneIndex = rewriter.create<mlir::IndexCastOp>(loc, loop.getInductionVar(), rewriter.getI32Type()).getResult();
+                element = rewriter.create<mlir::vector::ExtractElementOp>(loc, input, laneIndex).getResult();
+            }
+            else
+            {
+                element = rewriter.create<memref::LoadOp>(loc, input, loop.getInductionVar()).getResult();
+            }
+
+            // Copy reduction op body and add an appropriate yield operation
+            auto newYieldValue = cloneBody(element, loop.getRegionIterArgs()[0]);
+            rewriter.create<scf::YieldOp>(loc, newYieldValue);
+        }
+
+        result = loop.getResults()[0];
+    }
 
     // Add remainder to value yielded by the vectorized loop
     if (remainder > 0)
@@ -1858,17 +2497,8 @@ LogicalResult ReduceOpLowering::matchAndRewrite(
             element = rewriter.create<mlir::vector::InsertElementOp>(loc, elementLoad.getResult(), element, i);
         }
 
-        BlockAndValueMapping operandMap;
-        operandMap.map(oldInputValue, element);
-        operandMap.map(oldInductionValue, result);
-
         // Copy reduction op body
-        for (auto& op : op.getBody()->without_terminator())
-        {
-            rewriter.clone(op, operandMap);
-        }
-
-        result = operandMap.lookupOrNull(oldYieldValue);
+        result = cloneBody(element, result);
         assert(result);
     }
 
@@ -1938,7 +2568,7 @@ LogicalResult MapReduceOpVectorization::matchAndRewrite(
     }
 
     [[maybe_unused]] int vectorBytes = vectorizationInfoAttr.getValue().vectorBytes;
-    [[maybe_unused]] int vectorUnits = vectorizationInfoAttr.getValue().vectorUnitCount;
+    int vectorUnits = vectorizationInfoAttr.getValue().vectorUnitCount;
 
     auto loc = op.getLoc();
     auto input = op.input();
@@ -2055,6 +2685,7 @@ LogicalResult MapReduceOpVectorization::matchAndRewrite(
         }
     }
     parallelReduce->setAttr("parallelReduction", rewriter.getUnitAttr());
+    parallelReduce->setAttr(kReductionAccumulatorsAttrName, rewriter.getI64IntegerAttr(GetNumReductionAccumulators(vectorUnits)));
 
     auto horizontalReduce = rewriter.create<ValueReduceOp>(loc, parallelReduce.getResult(), initialValue);
     {
@@ -2112,9 +2743,7 @@ LogicalResult MapReduceOpLowering::matchAndRewrite(
     auto size = inputType.getShape()[0];
     auto loopSize = isParallelReduction ? RoundDownToMultiple(size, vectorSize) : size;
     auto remainder = size - loopSize;
-    auto lowerBound = rewriter.create<ConstantIndexOp>(loc, 0);
     auto upperBound = rewriter.create<ConstantIndexOp>(loc, loopSize);
-    auto step = rewriter.create<ConstantIndexOp>(loc, stepValue);
 
     // Map loop values
     auto oldMapInputValue = op.getMapInputValueVar();
@@ -2127,89 +2756,80 @@ LogicalResult MapReduceOpLowering::matchAndRewrite(
     auto oldReduceTerminator = op.getReduceBody()->getTerminator();
     auto oldReduceYieldValue = oldReduceTerminator->getOperand(0);
 
-    auto mapReduceLoop = rewriter.create<scf::ForOp>(loc, lowerBound, upperBound, step, initialValue);
-    auto mapReduceLoopBody = mapReduceLoop.getBody();
-    {
-        OpBuilder::InsertionGuard guard(rewriter);
-        rewriter.setInsertionPointToStart(mapReduceLoopBody);
-
-        // map the "input element value" to "input[i]"
+    // Clones the map op body to map `element`
+    auto cloneMapBody = [&](mlir::Value element) {
         BlockAndValueMapping mapOperandMap;
-        mlir::Value mapElement;
-        if (isParallelReduction)
-        {
-            auto elementType = inputType.getElementType();
-            auto zero = rewriter.create<mlir::ConstantOp>(loc, elementType, rewriter.getZeroAttr(elementType));
-            auto vectorType = initialValueType;
-            mapElement = rewriter.create<mlir::vector::BroadcastOp>(loc, vectorType, zero);
-            for (int64_t i = 0; i < vectorSize; ++i)
-            {
-                auto offset = rewriter.create<mlir::ConstantIndexOp>(loc, i);
-                auto offsetInductionVar = rewriter.create<mlir::AddIOp>(loc, mapReduceLoop.getInductionVar(), offset);
-                auto elementLoad = rewriter.create<memref::LoadOp>(loc, input, ValueRange{ offsetInductionVar });
-                mapElement = rewriter.create<mlir::vector::InsertElementOp>(loc, elementLoad.getResult(), mapElement, i);
-            }
-        }
-        else
-        {
-            mapElement = rewriter.create<memref::LoadOp>(loc, input, mapReduceLoop.getInductionVar()).getResult();
-        }
-
-        mapOperandMap.map(oldMapInputValue, mapElement);
-
-        // Clone map op body
+        mapOperandMap.map(oldMapInputValue, element);
         for (auto& op : op.getMapBody()->without_terminator())
         {
             rewriter.clone(op, mapOperandMap);
         }
+        return mapOperandMap.lookupOrDefault(oldMapYieldValue);
+    };
 
-        auto newMapYieldValue = mapOperandMap.lookupOrDefault(oldMapYieldValue);
-
-        // Store the mapped value back to memory
-        if (isParallelReduction)
-        {
-            for (int64_t i = 0; i < vectorSize; ++i)
-            {
-                auto element = rewriter.create<mlir::vector::ExtractElementOp>(op.getLoc(), newMapYieldValue, i);
-                auto offset = rewriter.create<mlir::ConstantIndexOp>(loc, i);
-                auto offsetInductionVar = rewriter.create<mlir::AddIOp>(loc, mapReduceLoop.getInductionVar(), offset);
-                rewriter.create<memref::StoreOp>(loc, element, input, ValueRange{ offsetInductionVar });
-            }
-        }
-        else
-        {
-            rewriter.create<memref::StoreOp>(loc, newMapYieldValue, input, mapReduceLoop.getInductionVar());
-        }
-
-        // End of "map" part
-
-        // map the "input element value" to the output of the "map" part
+    // Clones the reduction op body to fold `element` into `accumulator`
+    auto cloneReduceBody = [&](mlir::Value element, mlir::Value accumulator) {
         BlockAndValueMapping reduceOperandMap;
-        auto reduceElement = newMapYieldValue;
-
-        auto newInductionValue = mapReduceLoop.getRegionIterArgs()[0];
-        reduceOperandMap.map(oldReduceInputValue, reduceElement);
-        reduceOperandMap.map(oldInductionValue, newInductionValue);
-
-        // Clone reduction op body
+        reduceOperandMap.map(oldReduceInputValue, element);
+        reduceOperandMap.map(oldInductionValue, accumulator);
         for (auto& op : op.getReduceBody()->without_terminator())
         {
             rewriter.clone(op, reduceOperandMap);
         }
+        return reduceOperandMap.lookupOrDefault(oldReduceYieldValue);
+    };
 
-        // now add an appropriate yield operation
-        auto newReduceYieldValue = reduceOperandMap.lookupOrDefault(oldReduceYieldValue);
-        rewriter.create<scf::YieldOp>(loc, newReduceYieldValue);
+    mlir::Value result;
+    if (isParallelReduction)
+    {
+        auto vectorType = initialValueType.cast<mlir::VectorType>();
+        auto numAccumulatorsAttr = op->getAttrOfType<IntegerAttr>(kReductionAccumulatorsAttrName);
+        auto numAccumulators = numAccumulatorsAttr ? numAccumulatorsAttr.getInt() : 1;
+        result = EmitMultiAccumulatorReduction(
+            rewriter,
+            loc,
+            loopSize / vectorSize,
+            vectorSize,
+            numAccumulators,
+            initialValue,
+            [&](mlir::Value index) {
+                // Map the elements and store the mapped values back to memory
+                auto mapElement = LoadReductionVector(rewriter, loc, input, index, vectorType);
+                auto newMapYieldValue = cloneMapBody(mapElement);
+                StoreReductionVector(rewriter, loc, newMapYieldValue, input, index);
+                return newMapYieldValue;
+            },
+            cloneReduceBody,
+            numAccumulators > 1 ? GetReductionCombiner(rewriter, loc, oldInductionValue, oldReduceYieldValue, vectorType) : std::nullopt);
     }
+    else
+    {
+        auto lowerBound = rewriter.create<ConstantIndexOp>(loc, 0);
+        auto step = rewriter.create<ConstantIndexOp>(loc, stepValue);
+        auto mapReduceLoop = rewriter.create<scf::ForOp>(loc, lowerBound, upperBound, step, initialValue);
+        auto mapReduceLoopBody = mapReduceLoop.getBody();
+        {
+            OpBuilder::InsertionGuard guard(rewriter);
+            rewriter.setInsertionPointToStart(mapReduceLoopBody);
 
-    mlir::Value result = mapReduceLoop.getResults()[0];
+            // map the "input element value" to "input[i]", and store the mapped value back to memory
+            auto mapElement = rewriter.create<memref::LoadOp>(loc, input, mapReduceLoop.getInductionVar()).getResult();
+            auto newMapYieldValue = cloneMapBody(mapElement);
+            rewriter.create<memref::StoreOp>(loc, newMapYieldValue, input, mapReduceLoop.getInductionVar());
+
+            // reduce the output of the "map" part, and add an appropriate yield operation
+            auto newReduceYieldValue = cloneReduceBody(newMapYieldValue, mapReduceLoop.getRegionIterArgs()[0]);
+            rewriter.create<scf::YieldOp>(loc, newReduceYieldValue);
+        }
+
+        result = mapReduceLoop.getResults()[0];
+    }
 
     if (remainder > 0)
     {
         assert(isParallelReduction);
 
         // map the "input element value" to "input[i]"
-        BlockAndValueMapping mapOperandMap;
         auto elementType = inputType.getElementType();
         auto zero = rewriter.create<mlir::ConstantOp>(loc, elementType, rewriter.getZeroAttr(elementType));
         auto vectorType = initialValueType;
@@ -2222,16 +2842,9 @@ LogicalResult MapReduceOpLowering::matchAndRewrite(
             mapElement = rewriter.create<mlir::vector::InsertElementOp>(loc, elementLoad.getResult(), mapElement, i);
         }
 
-        mapOperandMap.map(oldMapInputValue, mapElement);
-
         // Clone map op body
-        for (auto& op : op.getMapBody()->without_terminator())
-        {
-            rewriter.clone(op, mapOperandMap);
-        }
-
         // TODO: need to zero out the lanes we aren't using (by copying from the init value)
-        auto newMapYieldValue = mapOperandMap.lookupOrDefault(oldMapYieldValue);
+        auto newMapYieldValue = cloneMapBody(mapElement);
         auto maskedMapYieldValue = initialValue;
         for (int64_t i = 0; i < remainder; ++i)
         {
@@ -2244,19 +2857,7 @@ LogicalResult MapReduceOpLowering::matchAndRewrite(
         }
 
         // Add remainder to value yielded by the vectorized loop
-        mlir::Value reduceElement = maskedMapYieldValue;
-
-        BlockAndValueMapping reduceOperandMap;
-        reduceOperandMap.map(oldReduceInputValue, reduceElement);
-        reduceOperandMap.map(oldInductionValue, result);
-
-        // Copy reduction op body
-        for (auto& op : op.getReduceBody()->without_terminator())
-        {
-            rewriter.clone(op, reduceOperandMap);
-        }
-
-        result = reduceOperandMap.lookupOrNull(oldReduceYieldValue);
+        result = cloneReduceBody(maskedMapYieldValue, result);
         assert(result);
     }
 
@@ -2280,6 +2881,14 @@ LogicalResult ReduceMaxOpLowering::matchAndRewrite(
         return op.emitError("Can only reduce a rank-1 memref");
     }
 
+    if (UseChunkedElementwiseReduction(memRefType))
+    {
+        // Reduce large inputs in vector-sized chunks instead of as one (very wide) vector
+        auto result = EmitElementwiseReduction(rewriter, loc, input, /*isMax=*/true);
+        rewriter.replaceOp(op, { result });
+        return success();
+    }
+
     mlir::Value memrefToCast = input;
     mlir::Value loadedVector = nullptr;
     if (!memRefType.getAffineMaps().empty())
@@ -2319,12 +2928,21 @@ LogicalResult EnterProfileRegionOpLowering::matchAndRewrite(EnterProfileRegionOp
         return failure();
     }
 
+    TraceProfileRegion(rewriter, loc, regions.counters[regionName], /*entry=*/true);
+
     auto startTimeGlobal = regions.counters[regionName].startTime;
     mlir::Value startTimeRef = rewriter.create<vir::ReferenceGlobalOp>(loc, startTimeGlobal);
 
     // get current time and store it in the startTime entry
     mlir::Value currentTime = rewriter.create<vir::GetTimeOp>(loc);
     rewriter.create<vir::CopyOp>(loc, currentTime, startTimeRef);
+
+    const auto& counters = regions.counters[regionName];
+    if (counters.hardwareCounterMask != 0)
+    {
+        mlir::Value startHardwareCountersRef = rewriter.create<vir::ReferenceGlobalOp>(loc, counters.startHardwareCounters);
+        rewriter.create<vir::ReadHardwareCountersOp>(loc, startHardwareCountersRef, counters.hardwareCounterMask);
+    }
     rewriter.eraseOp(op);
     return success();
 }
@@ -2351,24 +2969,16 @@ LogicalResult ExitProfileRegionOpLowering::matchAndRewrite(ExitProfileRegionOp o
 
     auto startTimeGlobal = regions.counters[regionName].startTime;
     mlir::Value startTimeRef = rewriter.create<vir::ReferenceGlobalOp>(loc, startTimeGlobal);
-
-    auto totalTimeGlobal = regions.counters[regionName].time;
-    mlir::Value totalTimeRef = rewriter.create<vir::ReferenceGlobalOp>(loc, totalTimeGlobal);
-
-    auto countGlobal = regions.counters[regionName].count;
-    mlir::Value countRef = rewriter.create<vir::ReferenceGlobalOp>(loc, countGlobal);
-
     mlir::Value startTime = rewriter.create<vir::GetElementOp>(loc, startTimeRef);
-    mlir::Value currentTime = rewriter.create<vir::GetTimeOp>(loc);
-    mlir::Value duration = rewriter.create<vir::BinOp>(loc, vir::BinaryOpPredicate::SUB, currentTime, startTime);
-    mlir::Value prevTotalTime = rewriter.create<vir::GetElementOp>(loc, totalTimeRef);
-    mlir::Value totalTime = rewriter.create<vir::BinOp>(loc, vir::BinaryOpPredicate::ADD, prevTotalTime, duration);
-    rewriter.create<vir::CopyOp>(loc, totalTime, totalTimeRef);
 
-    mlir::Value prevCount = rewriter.create<vir::GetElementOp>(loc, countRef);
-    auto one = rewriter.create<ConstantOp>(loc, rewriter.getI64Type(), rewriter.getI64IntegerAttr(1));
-    mlir::Value newCount = rewriter.create<vir::BinOp>(loc, vir::BinaryOpPredicate::ADD, prevCount, one);
-    rewriter.create<vir::CopyOp>(loc, newCount, countRef);
+    const auto& counters = regions.counters[regionName];
+    mlir::Value startHardwareCountersRef;
+    if (counters.hardwareCounterMask != 0)
+    {
+        startHardwareCountersRef = rewriter.create<vir::ReferenceGlobalOp>(loc, counters.startHardwareCounters);
+    }
+    AccumulateProfileRegion(rewriter, loc, counters, startTime, startHardwareCountersRef);
+    TraceProfileRegion(rewriter, loc, counters, /*entry=*/false);
 
     rewriter.eraseOp(op);
     return success();
@@ -2408,6 +3018,113 @@ LogicalResult PrintProfileResultsOpLowering::matchAndRewrite(PrintProfileResults
     return success();
 }
 
+LogicalResult ResetProfileCountersOpLowering::matchAndRewrite(ResetProfileCountersOp op, PatternRewriter& rewriter) const
+{
+    if (!enableProfiling)
+    {
+        rewriter.eraseOp(op);
+        return success();
+    }
+
+    auto loc = op.getLoc();
+    auto module = op->getParentOfType<mlir::ModuleOp>();
+
+    // The totals are zeroed with atomic exchanges, like the atomic adds that accumulate them, so that a reset
+    // which races with profiled regions running on other threads is not a data race. Each total is reset on its own,
+    // so a region that exits during the reset may still be counted in some of its totals but not in others.
+    ProfileRegions regions(module);
+    mlir::Value zeroCount = rewriter.create<ConstantIntOp>(loc, 0, 64);
+    mlir::Value zeroTime = rewriter.create<ConstantFloatOp>(loc, llvm::APFloat(0.0), rewriter.getF64Type());
+    mlir::Value zeroIndex = rewriter.create<ConstantIndexOp>(loc, 0);
+    for (auto [name, counters] : regions.counters)
+    {
+        mlir::Value countRef = rewriter.create<vir::ReferenceGlobalOp>(loc, counters.count);
+        (void)rewriter.create<mlir::AtomicRMWOp>(loc, zeroCount.getType(), mlir::AtomicRMWKind::assign, zeroCount, countRef, ValueRange{ zeroIndex });
+
+        mlir::Value totalTimeRef = rewriter.create<vir::ReferenceGlobalOp>(loc, counters.time);
+        (void)rewriter.create<mlir::AtomicRMWOp>(loc, zeroTime.getType(), mlir::AtomicRMWKind::assign, zeroTime, totalTimeRef, ValueRange{ zeroIndex });
+
+        if (counters.hardwareCounters)
+        {
+            mlir::Value hardwareCountersRef = rewriter.create<vir::ReferenceGlobalOp>(loc, counters.hardwareCounters);
+            for (int64_t counter = 0; counter < kNumHardwareCounters; ++counter)
+            {
+                mlir::Value index = rewriter.create<ConstantIndexOp>(loc, counter);
+                (void)rewriter.create<mlir::AtomicRMWOp>(loc, zeroCount.getType(), mlir::AtomicRMWKind::assign, zeroCount, hardwareCountersRef, ValueRange{ index });
+            }
+        }
+    }
+
+    rewriter.eraseOp(op);
+    return success();
+}
+
+LogicalResult GetProfileCountersOpLowering::matchAndRewrite(GetProfileCountersOp op, PatternRewriter& rewriter) const
+{
+    auto loc = op.getLoc();
+    if (!enableProfiling)
+    {
+        rewriter.replaceOpWithNewOp<ConstantIntOp>(op, 0, 64);
+        return success();
+    }
+
+    auto module = op->getParentOfType<mlir::ModuleOp>();
+    ProfileRegions regions(module);
+
+    auto int64RecordType = mlir::MemRefType::get({ 2 }, rewriter.getI64Type());
+    auto timeRecordType = mlir::MemRefType::get({ 1 }, rewriter.getF64Type());
+    auto hardwareCountersRecordType = mlir::MemRefType::get({ kNumHardwareCounters }, rewriter.getI64Type());
+    mlir::Value zero = rewriter.create<ConstantIndexOp>(loc, 0);
+    mlir::Value one = rewriter.create<ConstantIndexOp>(loc, 1);
+
+    // Each record is written only if it fits, the caller learns from the result whether it needs a bigger buffer.
+    // The count and time are read separately, so a region that is running concurrently may report a count that
+    // doesn't include its latest time or vice versa.
+    int64_t index = 0;
+    for (auto [name, counters] : regions.counters)
+    {
+        mlir::Value recordIndex = rewriter.create<ConstantIntOp>(loc, index, 64);
+        mlir::Value fits = rewriter.create<CmpIOp>(loc, CmpIPredicate::slt, recordIndex, op.capacity());
+        auto ifOp = rewriter.create<scf::IfOp>(loc, fits, /*withElseRegion=*/false);
+        {
+            OpBuilder::InsertionGuard guard(rewriter);
+            rewriter.setInsertionPointToStart(&ifOp.thenRegion().front());
+
+            mlir::Value nameRef = rewriter.create<vir::ReferenceGlobalOp>(loc, counters.name);
+            mlir::Value nameAddress = rewriter.create<vir::BufferAddressOp>(loc, nameRef);
+            mlir::Value countRef = rewriter.create<vir::ReferenceGlobalOp>(loc, counters.count);
+            mlir::Value count = rewriter.create<vir::GetElementOp>(loc, countRef);
+            mlir::Value totalTimeRef = rewriter.create<vir::ReferenceGlobalOp>(loc, counters.time);
+            mlir::Value totalTime = rewriter.create<vir::GetElementOp>(loc, totalTimeRef);
+
+            auto recordOffset = index * kProfileCounterRecordSize;
+            auto int64Fields = utilir::CreateByteBufferView(rewriter, loc, op.buffer(), recordOffset, int64RecordType);
+            rewriter.create<memref::StoreOp>(loc, nameAddress, int64Fields, ValueRange{ zero });
+            rewriter.create<memref::StoreOp>(loc, count, int64Fields, ValueRange{ one });
+            auto timeField = utilir::CreateByteBufferView(rewriter, loc, op.buffer(), recordOffset + 16, timeRecordType);
+            rewriter.create<memref::StoreOp>(loc, totalTime, timeField, ValueRange{ zero });
+
+            auto hardwareCounterFields = utilir::CreateByteBufferView(rewriter, loc, op.buffer(), recordOffset + kProfileCounterRecordHardwareCountersOffset, hardwareCountersRecordType);
+            mlir::Value hardwareCountersRef;
+            if (counters.hardwareCounters)
+            {
+                hardwareCountersRef = rewriter.create<vir::ReferenceGlobalOp>(loc, counters.hardwareCounters);
+            }
+            mlir::Value noEvents = rewriter.create<ConstantIntOp>(loc, 0, 64);
+            for (int64_t counter = 0; counter < kNumHardwareCounters; ++counter)
+            {
+                mlir::Value counterIndex = rewriter.create<ConstantIndexOp>(loc, counter);
+                mlir::Value events = hardwareCountersRef ? mlir::Value(rewriter.create<memref::LoadOp>(loc, hardwareCountersRef, ValueRange{ counterIndex })) : noEvents;
+                rewriter.create<memref::StoreOp>(loc, events, hardwareCounterFields, ValueRange{ counterIndex });
+            }
+        }
+        ++index;
+    }
+
+    rewriter.replaceOpWithNewOp<ConstantIntOp>(op, index, 64);
+    return success();
+}
+
 using ValueReduceSumOp = vir::ReduceSumOp;
 LogicalResult ReduceSumOpLowering::matchAndRewrite(
     ValueReduceSumOp op,
@@ -2423,6 +3140,14 @@ LogicalResult ReduceSumOpLowering::matchAndRewrite(
     {
         return op.emitError("Can only reduce a rank-1 memref");
     }
+    if (UseChunkedElementwiseReduction(memRefType))
+    {
+        // Reduce large inputs in vector-sized chunks instead of as one (very wide) vector
+        auto result = EmitElementwiseReduction(rewriter, loc, input, /*isMax=*/false);
+        rewriter.replaceOp(op, { result });
+        return success();
+    }
+
     mlir::Value memrefToCast = input;
     mlir::Value loadedVector = nullptr;
     if (!memRefType.getAffineMaps().empty())
@@ -2524,11 +3249,37 @@ void ValueToStdLoweringPass::runOnModule()
 
     if (this->enableProfiling)
     {
-        InitializeProfileRegions(module, passBuilder);
+        auto hardwareCounterMask = ParseHardwareCounters(this->profileCounters);
+        if (!hardwareCounterMask)
+        {
+            module.emitError("Unknown hardware counter in '") << this->profileCounters << "', expected a comma-separated list of cycles, instructions, l1d_misses, llc_misses and dtlb_misses";
+            return signalPassFailure();
+        }
+        InitializeProfileRegions(module, passBuilder, *hardwareCounterMask, this->profileTrace);
+        LowerPairedProfileRegions(module);
     }
 
+    // Vector math ops have no vector instruction to lower to, so LLVM would scalarize them into one libm call per lane.
+    // Expand them into polynomial approximations built from vector arithmetic instead. Scalar math ops are left alone
+    // so that they keep lowering to the (more accurate) libm calls.
+    OwningRewritePatternList approximationPatterns(context);
+    mlir::populateMathPolynomialApproximationPatterns(approximationPatterns);
+    FrozenRewritePatternSet frozenApproximationPatterns(std::move(approximationPatterns));
+
     for (auto vModule : make_early_inc_range(module.getOps<vir::ValueModuleOp>()))
     {
+        std::vector<Operation*> vectorMathOps;
+        vModule.walk([&](Operation* op) {
+            if (isa_and_nonnull<math::MathDialect>(op->getDialect()) && op->getNumResults() == 1 && op->getResult(0).getType().isa<VectorType>())
+            {
+                vectorMathOps.push_back(op);
+            }
+        });
+        for (auto op : vectorMathOps)
+        {
+            (void)applyOpPatternsAndFold(op, frozenApproximationPatterns);
+        }
+
         OwningRewritePatternList vecPatterns(context);
         vtr::populateVectorizeValueOpPatterns(vecPatterns);
         (void)applyPatternsAndFoldGreedily(vModule, std::move(vecPatterns));
@@ -2647,12 +3398,14 @@ void populateValueToStandardPatterns(bool enableProfiling, mlir::OwningRewritePa
 
     patterns.insert<EnterProfileRegionOpLowering,
                     PrintProfileResultsOpLowering,
-                    ExitProfileRegionOpLowering>(context, enableProfiling);
+                    ExitProfileRegionOpLowering,
+                    ResetProfileCountersOpLowering,
+                    GetProfileCountersOpLowering>(context, enableProfiling);
 }
 
-std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>> createValueToStdPass(bool enableProfiling)
+std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>> createValueToStdPass(bool enableProfiling, const std::string& profileCounters, bool profileTrace)
 {
-    auto pass = std::make_unique<ValueToStdLoweringPass>(enableProfiling);
+    auto pass = std::make_unique<ValueToStdLoweringPass>(enableProfiling, profileCounters, profileTrace);
     return pass;
 }
 } // namespace accera::transforms::value
@@ -0,0 +1,306 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) Microsoft Corporation. All rights reserved.
+//  Licensed under the MIT License. See LICENSE in the project root for license information.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "AcceraPasses.h"
+
+#include <ir/include/IRUtil.h>
+#include <ir/include/value/ValueDialect.h>
+
+#include <mlir/Dialect/Affine/IR/AffineOps.h>
+#include <mlir/Dialect/MemRef/IR/MemRef.h>
+#include <mlir/Dialect/OpenMP/OpenMPDialect.h>
+#include <mlir/Dialect/SCF/SCF.h>
+#include <mlir/Dialect/StandardOps/IR/Ops.h>
+#include <mlir/IR/Builders.h>
+#include <mlir/IR/BuiltinOps.h>
+#include <mlir/IR/SymbolTable.h>
+#include <mlir/Interfaces/CallInterfaces.h>
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/MapVector.h>
+#include <llvm/ADT/SetVector.h>
+#include <llvm/Support/MathExtras.h>
+
+using namespace mlir;
+namespace ir = accera::ir;
+namespace vir = accera::ir::value;
+
+namespace
+{
+// Every buffer placed in the workspace starts on a cache line boundary
+constexpr int64_t kWorkspaceAlignment = 64;
+
+// Scratch globals are the module-level buffers tagged as only living for the duration of a call (e.g. caches and
+// the memory planning arenas). Untagged globals, such as first-touch flags or memoized packed data, keep their
+// contents across calls and stay put. The workspace lives in the default memory space, so buffers in any other
+// memory space can't be views of it.
+bool IsScratchGlobal(vir::GlobalOp globalOp)
+{
+    return globalOp && globalOp->hasAttr(ir::ScratchBufferAttrName) && !globalOp.constant() && !globalOp.external() && !globalOp.value() && globalOp.addr_space() == 0 && globalOp.getType().getMemorySpaceAsInt() == 0;
+}
+
+// Stack allocs stay on the stack, and allocs inside of a parallel region get one buffer per thread, which a single
+// workspace offset can't provide
+bool IsScratchAlloc(vir::AllocOp allocOp)
+{
+    if (allocOp.data() || allocOp.getType().getMemorySpaceAsInt() != 0 || allocOp.allocType().getValueOr(vir::MemoryAllocType::Global) == vir::MemoryAllocType::Stack)
+    {
+        return false;
+    }
+    for (auto parentOp = allocOp->getParentOp(); parentOp; parentOp = parentOp->getParentOp())
+    {
+        if (isa<AffineParallelOp, scf::ParallelOp, omp::ParallelOp>(parentOp))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+FuncOp ResolveCallee(CallOpInterface callOp)
+{
+    auto callee = callOp.resolveCallable();
+    if (!callee)
+    {
+        if (auto symbol = callOp.getCallableForCallee().dyn_cast<SymbolRefAttr>())
+        {
+            auto parentFnOp = callOp->getParentOfType<FuncOp>();
+            callee = SymbolTable::lookupNearestSymbolFrom(parentFnOp->getParentOp(), symbol);
+        }
+    }
+    return dyn_cast_or_null<FuncOp>(callee);
+}
+
+class WorkspaceAllocationPass : public accera::transforms::WorkspaceAllocationBase<WorkspaceAllocationPass>
+{
+public:
+    void runOnModule() final
+    {
+        for (auto vModule : getModule().getOps<vir::ValueModuleOp>())
+        {
+            if (failed(AllocateWorkspaces(vModule)))
+            {
+                signalPassFailure();
+                return;
+            }
+        }
+    }
+
+private:
+    struct FunctionWorkspace
+    {
+        // Offsets of the scratch buffers referenced in this function, keyed by the op that introduces them
+        llvm::MapVector<Operation*, int64_t> bufferOffsets;
+        Value workspace;
+    };
+
+    LogicalResult AllocateWorkspaces(vir::ValueModuleOp vModule)
+    {
+        SmallVector<FuncOp, 4> roots;
+        for (auto fnOp : vModule.getOps<FuncOp>())
+        {
+            if (fnOp->hasAttr(ir::WorkspaceAttrName) && !fnOp.isExternal())
+            {
+                roots.push_back(fnOp);
+            }
+        }
+        if (roots.empty())
+        {
+            return success();
+        }
+
+        // Scratch globals are shared storage, so each one gets exactly one workspace offset no matter how many
+        // functions reference it. Allocs are owned by the function they appear in.
+        llvm::DenseMap<Operation*, int64_t> globalOffsets;
+        llvm::DenseMap<Operation*, FunctionWorkspace> functionWorkspaces;
+        llvm::DenseMap<Operation*, int64_t> rootSizes;
+        llvm::SetVector<Operation*> calleesNeedingWorkspace;
+
+        for (auto root : roots)
+        {
+            // Gather every function reachable from this root
+            llvm::SetVector<Operation*> reachable;
+            SmallVector<FuncOp, 8> worklist{ root };
+            reachable.insert(root);
+            while (!worklist.empty())
+            {
+                auto fnOp = worklist.pop_back_val();
+                auto result = fnOp.walk([&](CallOpInterface callOp) {
+                    auto callee = ResolveCallee(callOp);
+                    if (!callee || callee.isExternal())
+                    {
+                        return WalkResult::advance();
+                    }
+                    if (callee.isPublic() && !callee->hasAttr(ir::WorkspaceAttrName))
+                    {
+                        callOp->emitError("Workspace functions can only call private functions or other workspace functions");
+                        return WalkResult::interrupt();
+                    }
+                    if (reachable.insert(callee))
+                    {
+                        worklist.push_back(callee);
+                    }
+                    return WalkResult::advance();
+                });
+                if (result.wasInterrupted())
+                {
+                    return failure();
+                }
+            }
+
+            // Buffers that an earlier root already placed keep their offsets, so new buffers go after them
+            int64_t workspaceSize = 0;
+            auto placeBuffer = [&](MemRefType type, int64_t alignment) {
+                auto offset = llvm::alignTo(workspaceSize, std::max(alignment, kWorkspaceAlignment));
+                workspaceSize = offset + ir::util::GetBufferByteSize(type);
+                return static_cast<int64_t>(offset);
+            };
+
+            for (auto fnOp : reachable)
+            {
+                if (auto it = functionWorkspaces.find(fnOp); it != functionWorkspaces.end())
+                {
+                    for (auto [op, offset] : it->second.bufferOffsets)
+                    {
+                        auto type = op->getResult(0).getType().cast<MemRefType>();
+                        workspaceSize = std::max(workspaceSize, offset + ir::util::GetBufferByteSize(type));
+                    }
+                }
+                fnOp->walk([&](vir::ReferenceGlobalOp refOp) {
+                    auto globalOp = refOp.getGlobal();
+                    if (!IsScratchGlobal(globalOp))
+                        return;
+                    if (auto it = globalOffsets.find(globalOp); it != globalOffsets.end())
+                    {
+                        workspaceSize = std::max(workspaceSize, it->second + ir::util::GetBufferByteSize(globalOp.getType()));
+                    }
+                });
+            }
+
+            for (auto fnOp : reachable)
+            {
+                auto& fnWorkspace = functionWorkspaces[fnOp];
+                fnOp->walk([&](Operation* op) {
+                    if (auto refOp = dyn_cast<vir::ReferenceGlobalOp>(op))
+                    {
+                        auto globalOp = refOp.getGlobal();
+                        if (!IsScratchGlobal(globalOp))
+                            return;
+                        auto [it, inserted] = globalOffsets.try_emplace(globalOp, 0);
+                        if (inserted)
+                        {
+                            it->second = placeBuffer(globalOp.getType(), 0);
+                        }
+                        fnWorkspace.bufferOffsets[op] = it->second;
+                    }
+                    else if (auto allocOp = dyn_cast<vir::AllocOp>(op); allocOp && IsScratchAlloc(allocOp))
+                    {
+                        if (!fnWorkspace.bufferOffsets.count(op))
+                        {
+                            fnWorkspace.bufferOffsets[op] = placeBuffer(allocOp.getType(), allocOp.alignment().getValueOr(0));
+                        }
+                    }
+                });
+
+                if (!fnOp->hasAttr(ir::WorkspaceAttrName))
+                {
+                    calleesNeedingWorkspace.insert(fnOp);
+                }
+            }
+
+            rootSizes[root] = workspaceSize;
+        }
+
+        // Thread the workspace argument through the call graph. Roots already declare it as their last argument.
+        auto workspaceType = MemRefType::get({ ShapedType::kDynamicSize }, IntegerType::get(vModule.getContext(), 8));
+        for (auto root : roots)
+        {
+            functionWorkspaces[root].workspace = root.getArgument(root.getNumArguments() - 1);
+        }
+        for (auto op : calleesNeedingWorkspace)
+        {
+            auto fnOp = cast<FuncOp>(op);
+            fnOp.insertArgument(fnOp.getNumArguments(), workspaceType, {});
+            functionWorkspaces[fnOp].workspace = fnOp.getArgument(fnOp.getNumArguments() - 1);
+        }
+
+        // Calls into other workspace functions share the caller's workspace, which already covers their buffers
+        auto result = vModule.walk([&](CallOpInterface callOp) {
+            auto callee = ResolveCallee(callOp);
+            if (!callee || !functionWorkspaces.count(callee))
+            {
+                return WalkResult::advance();
+            }
+            auto callerIt = functionWorkspaces.find(callOp->getParentOfType<FuncOp>());
+            if (callerIt == functionWorkspaces.end())
+            {
+                callOp->emitError("Function using a workspace is called from a function without one");
+                return WalkResult::interrupt();
+            }
+            callOp->insertOperands(callOp->getNumOperands(), callerIt->second.workspace);
+            return WalkResult::advance();
+        });
+        if (result.wasInterrupted())
+        {
+            return failure();
+        }
+
+        // Replace the scratch buffers with views into the workspace
+        for (auto& [fnOp, fnWorkspace] : functionWorkspaces)
+        {
+            for (auto [op, offset] : fnWorkspace.bufferOffsets)
+            {
+                ReplaceWithWorkspaceView(op, fnWorkspace.workspace, offset);
+            }
+        }
+
+        // Drop the scratch globals that are no longer referenced
+        for (auto [globalOp, offset] : globalOffsets)
+        {
+            if (SymbolTable::symbolKnownUseEmpty(globalOp, vModule))
+            {
+                globalOp->erase();
+            }
+        }
+
+        // Report the final sizes through the query functions
+        for (auto sizeFnOp : vModule.getOps<FuncOp>())
+        {
+            auto rootName = sizeFnOp->getAttrOfType<FlatSymbolRefAttr>(ir::WorkspaceSizeAttrName);
+            if (!rootName)
+                continue;
+
+            auto root = vModule.lookupSymbol<FuncOp>(rootName.getValue());
+            auto workspaceSize = root ? rootSizes.lookup(root) : 0;
+            sizeFnOp.walk([&](ConstantIntOp constantOp) {
+                OpBuilder builder(constantOp);
+                auto sizeOp = builder.create<ConstantIntOp>(constantOp.getLoc(), workspaceSize, 64);
+                constantOp.replaceAllUsesWith(sizeOp.getResult());
+                constantOp.erase();
+            });
+        }
+
+        return success();
+    }
+
+    void ReplaceWithWorkspaceView(Operation* op, Value workspace, int64_t offset)
+    {
+        OpBuilder builder(op);
+        auto type = op->getResult(0).getType().cast<MemRefType>();
+        auto view = ir::util::CreateByteBufferView(builder, op->getLoc(), workspace, offset, type);
+        op->getResult(0).replaceAllUsesWith(view);
+        op->erase();
+    }
+};
+
+} // namespace
+
+namespace accera::transforms::value
+{
+std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>> createWorkspaceAllocationPass()
+{
+    return std::make_unique<WorkspaceAllocationPass>();
+}
+} // namespace accera::transforms::value
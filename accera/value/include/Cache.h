@@ -70,7 +70,9 @@ namespace value
               CacheAllocation allocation = CacheAllocation::Automatic,
               MemorySpace memorySpace = MemorySpace::None,
               MemorySpace doubleBufferMemorySpace = MemorySpace::None,
-              ExecutionTarget execTarget = targets::CPU{});
+              ExecutionTarget execTarget = targets::CPU{},
+              std::optional<ValueType> elementType = std::nullopt,
+              std::optional<int64_t> prefetchDistance = std::nullopt);
 
         Cache(accera::ir::loopnest::ScheduleOp schedule,
               std::variant<ViewAdapter, Cache*> value,
@@ -85,7 +87,9 @@ namespace value
               CacheAllocation allocation = CacheAllocation::Automatic,
               MemorySpace memorySpace = MemorySpace::None,
               MemorySpace doubleBufferMemorySpace = MemorySpace::None,
-              ExecutionTarget execTarget = targets::CPU{});
+              ExecutionTarget execTarget = targets::CPU{},
+              std::optional<ValueType> elementType = std::nullopt,
+              std::optional<int64_t> prefetchDistance = std::nullopt);
 
         // Runtime-Init caching version
         Cache(accera::ir::loopnest::ScheduleOp schedule,
@@ -102,6 +106,13 @@ namespace value
               const std::string& packedBufferName,
               CacheIndexing mapping = CacheIndexing::GlobalToPhysical);
 
+        // Runtime packed caching version, memoized per buffer address and version tag
+        Cache(accera::ir::loopnest::ScheduleOp schedule,
+              ViewAdapter value,
+              const std::string& wrapperFnName,
+              int64_t maxCacheBytes,
+              CacheIndexing mapping = CacheIndexing::GlobalToPhysical);
+
         Cache(const Cache&) = delete;
         Cache(Cache&&) noexcept;
         Cache& operator=(const Cache&) = delete;
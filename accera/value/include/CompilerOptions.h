@@ -39,6 +39,9 @@ namespace value
         /// <summary> Emit profiling code. </summary>
         bool profile = false;
 
+        /// <summary> Record a per-thread timeline of the profile regions. </summary>
+        bool profileTrace = false;
+
         /// <summary> Allow emitting more efficient code that isn't necessarily IEEE-754 compatible. </summary>
         bool useFastMath = true;
 
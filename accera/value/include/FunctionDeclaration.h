@@ -99,6 +99,10 @@ namespace value
         /// <param name="rawPointerAPI"> True if the raw pointer API should be emitted. </param>
         FunctionDeclaration& RawPointerAPI(bool rawPointerAPI);
 
+        /// <summary> Sets whether this function takes a trailing caller-supplied workspace buffer that backs its scratch memory. </summary>
+        /// <param name="useWorkspace"> True if the workspace argument and its `<name>_workspace_size` query should be emitted. </param>
+        FunctionDeclaration& Workspace(bool useWorkspace);
+
         /// <summary> A tag to add to a function as an attribute. </summary>
         /// <param name="tag"> The tag to add to the function. </param>
         FunctionDeclaration& AddTag(const std::string& tag);
@@ -196,6 +200,8 @@ namespace value
 
         [[nodiscard]] bool UseRawPointerAPI() const { return _rawPointerAPI; }
 
+        [[nodiscard]] bool UsesWorkspace() const { return _useWorkspace; }
+
         [[nodiscard]] std::vector<std::string> GetTags() const { return _tags; }
 
         [[nodiscard]] std::string GetBaseName() const { return _baseName; }
@@ -240,6 +246,7 @@ namespace value
         bool _emitCWrapper = false;
         bool _emitHeaderDecl = false;
         bool _rawPointerAPI = false;
+        bool _useWorkspace = false;
         std::vector<std::string> _tags;
         std::string _baseName;
         std::vector<std::string> _outputVerifiers;
@@ -102,6 +102,18 @@ namespace value
 
         void setDebugMode(bool enable);
 
+        /// <summary> Marks the module as profiled and emits its profile counter entry points:
+        /// `void <module>_reset_profile_counters()` and
+        /// `int64_t <module>_get_profile_counters(int8_t* counters, int64_t capacity)`, which copies the totals of each
+        /// profile region into an array of `capacity` AcceraProfileCounter records </summary>
+        void setProfileMode(bool enable);
+
+        /// <summary> Marks the module as traced and emits its trace entry points:
+        /// `void <module>_reset_profile_trace()` and
+        /// `int64_t <module>_write_profile_trace(int8_t* path)`, which writes the profile region events of every thread
+        /// to the file `path` in the Chrome trace event format </summary>
+        void setProfileTraceMode(bool enable);
+
         struct EmittableInfo
         {
             void* data;
@@ -239,6 +251,7 @@ namespace value
     };
 
     ValueType MLIRTypeToValueType(mlir::Type type);
+    mlir::Type ValueTypeToMLIRType(mlir::OpBuilder& builder, ValueType type);
     mlir::Value Unwrap(ViewAdapter);
     mlir::Value UnwrapScalar(Scalar);
     ViewAdapter Wrap(mlir::Value, std::optional<utilities::MemoryLayout> layout = std::nullopt);
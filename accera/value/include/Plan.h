@@ -52,6 +52,14 @@ namespace value
         Dynamic
     };
 
+    enum class ParallelizationAffinity : int
+    {
+        Close,
+        Spread,
+        Socket,
+        Explicit
+    };
+
     class Plan
     {
     public:
@@ -73,8 +81,10 @@ namespace value
         /// <param name="allocation"> The cache allocation </param>
         /// <param name="memorySpace"> The memory space</param>
         /// <param name="doubleBufferMemorySpace"> The memory space to put the double buffer temporary buffer in </param>
+        /// <param name="elementType"> The element type to store cached data as, if different from the target's element type </param>
+        /// <param name="prefetchDistance"> If set, prefetch the data of the active block this many trigger loop iterations ahead </param>
         /// <returns> An instance of Cache </returns>
-        Cache AddCache(std::variant<ViewAdapter, Cache*> target, const ScalarIndex& outermostIncludedSplitIndex, const ScalarIndex& triggerIndex, const MemoryAffineCoefficients& memoryMap, bool thrifty, bool doubleBuffer = false, const std::optional<VectorizationInformation>& vectorizationInfo = std::nullopt, CacheIndexing indexing = CacheIndexing::GlobalToPhysical, CacheAllocation allocation = CacheAllocation::Automatic, MemorySpace memorySpace = MemorySpace::None, MemorySpace doubleBufferMemorySpace = MemorySpace::None);
+        Cache AddCache(std::variant<ViewAdapter, Cache*> target, const ScalarIndex& outermostIncludedSplitIndex, const ScalarIndex& triggerIndex, const MemoryAffineCoefficients& memoryMap, bool thrifty, bool doubleBuffer = false, const std::optional<VectorizationInformation>& vectorizationInfo = std::nullopt, CacheIndexing indexing = CacheIndexing::GlobalToPhysical, CacheAllocation allocation = CacheAllocation::Automatic, MemorySpace memorySpace = MemorySpace::None, MemorySpace doubleBufferMemorySpace = MemorySpace::None, std::optional<ValueType> elementType = std::nullopt, std::optional<int64_t> prefetchDistance = std::nullopt);
 
         /// <summary> Adds a manual active block cache for a view target or different cache </summary>
         /// <param name="target"> The target being cached (e.g Array, Matrix, etc) </param>
@@ -88,8 +98,10 @@ namespace value
         /// <param name="allocation"> The cache allocation </param>
         /// <param name="memorySpace"> The memory space</param>
         /// <param name="doubleBufferMemorySpace"> The memory space to put the double buffer temporary buffer in </param>
+        /// <param name="elementType"> The element type to store cached data as, if different from the target's element type </param>
+        /// <param name="prefetchDistance"> If set, prefetch the data of the active block this many trigger loop iterations ahead </param>
         /// <returns> An instance of Cache </returns>
-        Cache AddCache(std::variant<ViewAdapter, Cache*> target, const ScalarIndex& outermostIncludedSplitIndex, const ScalarIndex& triggerIndex, const DimensionOrder& dimOrder, bool thrifty, bool doubleBuffer = false, const std::optional<VectorizationInformation>& vectorizationInfo = std::nullopt, CacheIndexing indexing = CacheIndexing::GlobalToPhysical, CacheAllocation allocation = CacheAllocation::Automatic, MemorySpace memorySpace = MemorySpace::None, MemorySpace doubleBufferMemorySpace = MemorySpace::None);
+        Cache AddCache(std::variant<ViewAdapter, Cache*> target, const ScalarIndex& outermostIncludedSplitIndex, const ScalarIndex& triggerIndex, const DimensionOrder& dimOrder, bool thrifty, bool doubleBuffer = false, const std::optional<VectorizationInformation>& vectorizationInfo = std::nullopt, CacheIndexing indexing = CacheIndexing::GlobalToPhysical, CacheAllocation allocation = CacheAllocation::Automatic, MemorySpace memorySpace = MemorySpace::None, MemorySpace doubleBufferMemorySpace = MemorySpace::None, std::optional<ValueType> elementType = std::nullopt, std::optional<int64_t> prefetchDistance = std::nullopt);
 
         /// <summary> Adds a manual active block cache for a view target or different cache with an identity dimension ordering </summary>
         /// <param name="target"> The target being cached (e.g Array, Matrix, etc) </param>
@@ -101,8 +113,10 @@ namespace value
         /// <param name="allocation"> The cache allocation </param>
         /// <param name="memorySpace"> The memory space</param>
         /// <param name="doubleBufferMemorySpace"> The memory space to put the double buffer temporary buffer in </param>
+        /// <param name="elementType"> The element type to store cached data as, if different from the target's element type </param>
+        /// <param name="prefetchDistance"> If set, prefetch the data of the active block this many trigger loop iterations ahead </param>
         /// <returns> An instance of Cache </returns>
-        Cache AddCache(std::variant<ViewAdapter, Cache*> target, const ScalarIndex& outermostIncludedSplitIndex, bool thrifty = false, bool doubleBuffer = false, const std::optional<VectorizationInformation>& vectorizationInfo = std::nullopt, CacheIndexing indexing = CacheIndexing::GlobalToPhysical, CacheAllocation allocation = CacheAllocation::Automatic, MemorySpace memorySpace = MemorySpace::None, MemorySpace doubleBufferMemorySpace = MemorySpace::None);
+        Cache AddCache(std::variant<ViewAdapter, Cache*> target, const ScalarIndex& outermostIncludedSplitIndex, bool thrifty = false, bool doubleBuffer = false, const std::optional<VectorizationInformation>& vectorizationInfo = std::nullopt, CacheIndexing indexing = CacheIndexing::GlobalToPhysical, CacheAllocation allocation = CacheAllocation::Automatic, MemorySpace memorySpace = MemorySpace::None, MemorySpace doubleBufferMemorySpace = MemorySpace::None, std::optional<ValueType> elementType = std::nullopt, std::optional<int64_t> prefetchDistance = std::nullopt);
 
         /// <summary> Adds a manual active block cache for a view target or different cache </summary>
         /// <param name="target"> The target being cached (e.g Array, Matrix, etc) </param>
@@ -115,8 +129,10 @@ namespace value
         /// <param name="allocation"> The cache allocation </param>
         /// <param name="memorySpace"> The memory space</param>
         /// <param name="doubleBufferMemorySpace"> The memory space to put the double buffer temporary buffer in </param>
+        /// <param name="elementType"> The element type to store cached data as, if different from the target's element type </param>
+        /// <param name="prefetchDistance"> If set, prefetch the data of the active block this many trigger loop iterations ahead </param>
         /// <returns> An instance of Cache </returns>
-        Cache AddCache(std::variant<ViewAdapter, Cache*> target, int64_t maxElements, const utilities::MemoryAffineCoefficients& memoryMap, bool thrifty, bool doubleBuffer = false, const std::optional<VectorizationInformation>& vectorizationInfo = std::nullopt, CacheIndexing indexing = CacheIndexing::GlobalToPhysical, CacheAllocation allocation = CacheAllocation::Automatic, MemorySpace memorySpace = MemorySpace::None, MemorySpace doubleBufferMemorySpace = MemorySpace::None);
+        Cache AddCache(std::variant<ViewAdapter, Cache*> target, int64_t maxElements, const utilities::MemoryAffineCoefficients& memoryMap, bool thrifty, bool doubleBuffer = false, const std::optional<VectorizationInformation>& vectorizationInfo = std::nullopt, CacheIndexing indexing = CacheIndexing::GlobalToPhysical, CacheAllocation allocation = CacheAllocation::Automatic, MemorySpace memorySpace = MemorySpace::None, MemorySpace doubleBufferMemorySpace = MemorySpace::None, std::optional<ValueType> elementType = std::nullopt, std::optional<int64_t> prefetchDistance = std::nullopt);
 
         /// <summary> Adds a manual active block cache for a view target or different cache </summary>
         /// <param name="target"> The target being cached (e.g Array, Matrix, etc) </param>
@@ -129,8 +145,10 @@ namespace value
         /// <param name="allocation"> The cache allocation </param>
         /// <param name="memorySpace"> The memory space</param>
         /// <param name="doubleBufferMemorySpace"> The memory space to put the double buffer temporary buffer in </param>
+        /// <param name="elementType"> The element type to store cached data as, if different from the target's element type </param>
+        /// <param name="prefetchDistance"> If set, prefetch the data of the active block this many trigger loop iterations ahead </param>
         /// <returns> An instance of Cache </returns>
-        Cache AddCache(std::variant<ViewAdapter, Cache*> target, int64_t maxElements, const DimensionOrder& dimOrder, bool thrifty, bool doubleBuffer = false, const std::optional<VectorizationInformation>& vectorizationInfo = std::nullopt, CacheIndexing indexing = CacheIndexing::GlobalToPhysical, CacheAllocation allocation = CacheAllocation::Automatic, MemorySpace memorySpace = MemorySpace::None, MemorySpace doubleBufferMemorySpace = MemorySpace::None);
+        Cache AddCache(std::variant<ViewAdapter, Cache*> target, int64_t maxElements, const DimensionOrder& dimOrder, bool thrifty, bool doubleBuffer = false, const std::optional<VectorizationInformation>& vectorizationInfo = std::nullopt, CacheIndexing indexing = CacheIndexing::GlobalToPhysical, CacheAllocation allocation = CacheAllocation::Automatic, MemorySpace memorySpace = MemorySpace::None, MemorySpace doubleBufferMemorySpace = MemorySpace::None, std::optional<ValueType> elementType = std::nullopt, std::optional<int64_t> prefetchDistance = std::nullopt);
 
         /// <summary> Adds a manual active element cache for a view target or different cache with an identity dimension ordering </summary>
         /// <param name="target"> The target being cached (e.g Array, Matrix, etc) </param>
@@ -142,8 +160,10 @@ namespace value
         /// <param name="allocation"> The cache allocation </param>
         /// <param name="memorySpace"> The memory space</param>
         /// <param name="doubleBufferMemorySpace"> The memory space to put the double buffer temporary buffer in </param>
+        /// <param name="elementType"> The element type to store cached data as, if different from the target's element type </param>
+        /// <param name="prefetchDistance"> If set, prefetch the data of the active block this many trigger loop iterations ahead </param>
         /// <returns> An instance of Cache </returns>
-        Cache AddCache(std::variant<ViewAdapter, Cache*> target, int64_t maxElements, bool thrifty = false, bool doubleBuffer = false, const std::optional<VectorizationInformation>& vectorizationInfo = std::nullopt, CacheIndexing indexing = CacheIndexing::GlobalToPhysical, CacheAllocation allocation = CacheAllocation::Automatic, MemorySpace memorySpace = MemorySpace::None, MemorySpace doubleBufferMemorySpace = MemorySpace::None);
+        Cache AddCache(std::variant<ViewAdapter, Cache*> target, int64_t maxElements, bool thrifty = false, bool doubleBuffer = false, const std::optional<VectorizationInformation>& vectorizationInfo = std::nullopt, CacheIndexing indexing = CacheIndexing::GlobalToPhysical, CacheAllocation allocation = CacheAllocation::Automatic, MemorySpace memorySpace = MemorySpace::None, MemorySpace doubleBufferMemorySpace = MemorySpace::None, std::optional<ValueType> elementType = std::nullopt, std::optional<int64_t> prefetchDistance = std::nullopt);
 
         /// <summary> Emits an offline packing function for the given target and changes its usage in the function to assume a packed representation </summary>
         /// <param name="target"> The target being cached (e.g Array, Matrix, etc) </param>
@@ -162,6 +182,14 @@ namespace value
         /// <returns> An instance of Cache </returns>
         Cache PackAndEmbedBuffer(ViewAdapter target, ViewAdapter constantData, const std::string& wrapperFnName, const std::string& packedBufferName, CacheIndexing indexing = CacheIndexing::GlobalToPhysical);
 
+        /// <summary> Emits a wrapping function that packs the given target on the first call for a given buffer address and version tag, and reuses the packed copy on later calls. Changes the usage of the target in the function to assume a packed representation </summary>
+        /// <param name="target"> The target being cached (e.g Array, Matrix, etc) </param>
+        /// <param name="wrapperFnName"> The name to give the wrapping function, which takes the arguments of the base function followed by an int64 version tag </param>
+        /// <param name="maxCacheBytes"> The budget for the packed copies kept by the wrapping function. The least recently used copy is evicted when the budget is exhausted </param>
+        /// <param name="indexing"> The cache indexing </param>
+        /// <returns> An instance of Cache </returns>
+        Cache EmitRuntimeMemoizedPacking(ViewAdapter target, const std::string& wrapperFnName, int64_t maxCacheBytes, CacheIndexing indexing = CacheIndexing::GlobalToPhysical);
+
         /// <summary> Vectorizes along an index </summary>
         /// <param name="i"> The scalar index indicating the axis to vectorize </param>
         /// <param name="vectorizationInfo"> The vectorization configuration </param>
@@ -171,7 +199,16 @@ namespace value
         /// <param name="indices"> The scalar indices to parallelize. Specifying multiple indices is equivalent to the `collapse` argument in OpenMP. Therefore, the dimensions must be contiguous in the iteration space dimension order. </param>
         /// <param name="numThreads"> The number of threads to schedule. </param>
         /// <param name="policy"> The policy used to schedule work across the threads. </param>
-        void Parallelize(std::vector<ScalarIndex> indices, int64_t numThreads, ParallelizationPolicy policy);
+        /// <param name="affinity"> How the threads are placed on the cores of the target. </param>
+        /// <param name="cores"> The cores to pin the threads to, only used with ParallelizationAffinity::Explicit. Thread i is pinned to cores[i % cores.size()]. </param>
+        /// <param name="numaFirstTouch"> Whether to initialize the cache buffers used in the parallelized loops from the threads that will access them, so that their pages are placed on the NUMA node of those threads. </param>
+        void Parallelize(std::vector<ScalarIndex> indices, int64_t numThreads, ParallelizationPolicy policy, ParallelizationAffinity affinity = ParallelizationAffinity::Close, std::vector<int64_t> cores = {}, bool numaFirstTouch = false);
+
+        /// <summary> Tensorize three iteration space dimensions into an int8 dot-product micro-kernel </summary>
+        /// <param name="indices"> The scalar indices to tensorize, in (i, j, k) order. The dimensions must be contiguous in the iteration space dimension order. </param>
+        /// <param name="dims"> The CPU MMA shape, which sets the vector width of the micro-kernel. </param>
+        /// <param name="instructionSet"> The instructions used for the 4-way int8 dot products. </param>
+        void Tensorize(std::vector<ScalarIndex> indices, ir::value::MMAShape dims, ir::value::MMAInstructionSet instructionSet = ir::value::MMAInstructionSet::Generic);
 
     private:
         friend class Schedule;
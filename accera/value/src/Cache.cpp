@@ -18,13 +18,19 @@
 
 #include <llvm/ADT/SmallPtrSet.h>
 #include <llvm/Support/Casting.h>
+#include <llvm/Support/MathExtras.h>
 #include <llvm/Support/raw_os_ostream.h>
 
 #include <mlir/Dialect/Affine/IR/AffineOps.h>
 #include <mlir/Dialect/MemRef/IR/MemRef.h>
+#include <mlir/Dialect/SCF/SCF.h>
+#include <mlir/Dialect/StandardOps/IR/Ops.h>
 #include <mlir/IR/Attributes.h>
 #include <mlir/IR/BuiltinTypes.h>
 
+#include <algorithm>
+#include <limits>
+
 using namespace accera::ir::loopnest;
 using namespace accera::ir::executionPlan;
 namespace vir = accera::ir::value;
@@ -58,6 +64,12 @@ namespace value
             SourceToCache,
             CacheToSource,
         };
+
+        // Each packed copy kept by a runtime memoized cache starts on a cache line boundary
+        constexpr int64_t kPackedSlotAlignment = 64;
+
+        // The slots of a runtime memoized cache are searched linearly on every call, so keep the count small
+        constexpr int64_t kMaxPackedSlots = 64;
     } // namespace
 
     class CacheImpl
@@ -220,7 +232,9 @@ namespace value
                              CacheAllocation allocation,
                              MemorySpace dslMemorySpace,
                              MemorySpace dslDoubleBufferMemorySpace,
-                             ExecutionTarget execTarget) :
+                             ExecutionTarget execTarget,
+                             std::optional<ValueType> elementType,
+                             std::optional<int64_t> prefetchDistance) :
             CacheImpl(schedule, value, mapping),
             _execTarget(execTarget)
         {
@@ -231,6 +245,27 @@ namespace value
 
             _cacheInfo = MakeManualCacheInfo(builder, _baseMlirValueInput, allocation, schedule, keySliceIndex, triggerIndex, maxElements, cacheMapping, memorySpace);
 
+            // The cache may store its data in a different element type than the array it caches, e.g. a bf16 input
+            // cached as f32. A hierarchical cache defaults to the element type of the cache it is filled from.
+            auto cacheElementType = elementType.has_value() ? ValueTypeToMLIRType(builder, *elementType) : GetElementType();
+            if (cacheElementType != _cacheInfo.cacheType.getElementType())
+            {
+                if (allocation != CacheAllocation::Automatic)
+                {
+                    throw accera::utilities::InputException(accera::utilities::InputExceptionErrors::invalidArgument, "Caches with a converted element type must be automatically allocated");
+                }
+                if (!cacheElementType.isa<mlir::FloatType>() || !_cacheInfo.cacheType.getElementType().isa<mlir::FloatType>())
+                {
+                    throw accera::utilities::InputException(accera::utilities::InputExceptionErrors::invalidArgument, "Cache element type conversion is only supported between floating point types");
+                }
+                _cacheInfo.cacheType = mlir::MemRefType::Builder(_cacheInfo.cacheType).setElementType(cacheElementType);
+            }
+
+            if (prefetchDistance.has_value() && *prefetchDistance <= 0)
+            {
+                throw accera::utilities::InputException(accera::utilities::InputExceptionErrors::invalidArgument, "The cache prefetch distance must be positive");
+            }
+
             VectorizationInfo vectorizationInfo;
             if (vecInfo.has_value())
             {
@@ -274,6 +309,10 @@ namespace value
                                                                                                      doubleBufferCache,
                                                                                                      doubleBufferMemorySpace,
                                                                                                      vectorizationInfo);
+                if (prefetchDistance.has_value())
+                {
+                    regionOp.prefetchDistanceAttr(builder.getI64IntegerAttr(*prefetchDistance));
+                }
                 cacheRegionOp = regionOp;
             }
             else
@@ -292,6 +331,10 @@ namespace value
                                                                                  doubleBufferCache,
                                                                                  doubleBufferMemorySpace,
                                                                                  vectorizationInfo);
+                if (prefetchDistance.has_value())
+                {
+                    regionOp.prefetchDistanceAttr(builder.getI64IntegerAttr(*prefetchDistance));
+                }
                 cacheRegionOp = regionOp;
             }
             auto regionHandle = cacheRegionOp->getResult(0);
@@ -328,6 +371,22 @@ namespace value
             return accera::ir::util::CastOrGetParentOfType<vir::ValueFuncOp>(_scheduleOp);
         }
 
+        unsigned GetInputArgumentIndex()
+        {
+            auto scheduleFuncOp = GetScheduleFuncOp();
+            auto targetArgIdx = 0u;
+            for (const auto& arg : scheduleFuncOp.getArguments())
+            {
+                if (arg == _mlirValueInput)
+                {
+                    break;
+                }
+                targetArgIdx++;
+            }
+            assert(targetArgIdx < scheduleFuncOp.getNumArguments());
+            return targetArgIdx;
+        }
+
         void UpdateScheduleOpToUsePackedBuffer(mlir::OpBuilder& builder)
         {
             mlir::OpBuilder::InsertionGuard insertGuard(builder);
@@ -458,36 +517,6 @@ namespace value
 #endif
         }
 
-        ScheduleShardMapping _shardMapping;
-        vir::ValueModuleOp _vModuleOp;
-    };
-
-    // Runtime initialized cache Implementation class
-    class RuntimeInitCacheImpl : public OfflineCacheImpl
-    {
-    public:
-        RuntimeInitCacheImpl(ScheduleOp schedule, Value value, const std::string& packingFunctionName, const std::string& packedBufferSizeFnName, CacheIndexing mapping) :
-            OfflineCacheImpl(schedule, value, mapping)
-        {
-            auto builder = GetBuilder();
-
-            auto memorySpace = *ir::value::symbolizeMemorySpace((uint64_t)MemorySpace::Global);
-
-            _cacheInfo = MakeFullBufferAutomaticCacheInfo(builder, _mlirValueInput, CacheAllocation::Automatic, schedule, memorySpace);
-            _shardMapping = _cacheInfo.shardMapping;
-
-            // Make the packing function
-            // TODO : do we want to emit an un-pack function by default?
-            CreatePackingFunction(builder, packingFunctionName);
-
-            // Make the packed buffer size function
-            CreatePackedBufferSizeFunction(builder, packedBufferSizeFnName);
-
-            // Change the schedule to assume a packed verison of the buffer
-            UpdateScheduleOpToUsePackedBuffer(builder);
-        }
-
-    private:
         void AddCacheZero(mlir::OpBuilder& builder, mlir::Value cache)
         {
             auto loc = builder.getUnknownLoc();
@@ -509,7 +538,7 @@ namespace value
             }
         }
 
-        void CreatePackingFunction(mlir::OpBuilder& builder, const std::string& packingFunctionName)
+        vir::ValueFuncOp CreatePackingFunction(mlir::OpBuilder& builder, const std::string& packingFunctionName)
         {
             mlir::OpBuilder::InsertionGuard insertGuard(builder);
 
@@ -531,10 +560,42 @@ namespace value
             AddCacheCopy(builder, inputArrayVal, packingCacheAccessContext, CopyDirection::SourceToCache);
             builder.create<vir::ReturnOp>(loc);
 
+            return packingFuncOp;
+        }
+
+        ScheduleShardMapping _shardMapping;
+        vir::ValueModuleOp _vModuleOp;
+    };
+
+    // Runtime initialized cache Implementation class
+    class RuntimeInitCacheImpl : public OfflineCacheImpl
+    {
+    public:
+        RuntimeInitCacheImpl(ScheduleOp schedule, Value value, const std::string& packingFunctionName, const std::string& packedBufferSizeFnName, CacheIndexing mapping) :
+            OfflineCacheImpl(schedule, value, mapping)
+        {
+            auto builder = GetBuilder();
+
+            auto memorySpace = *ir::value::symbolizeMemorySpace((uint64_t)MemorySpace::Global);
+
+            _cacheInfo = MakeFullBufferAutomaticCacheInfo(builder, _mlirValueInput, CacheAllocation::Automatic, schedule, memorySpace);
+            _shardMapping = _cacheInfo.shardMapping;
+
+            // Make the packing function
+            // TODO : do we want to emit an un-pack function by default?
+            auto packingFuncOp = CreatePackingFunction(builder, packingFunctionName);
+
             // Now create the Raw pointer API function for this wrapper function
             vir::CreateRawPointerAPIWrapperFunction(builder, packingFuncOp, packingFunctionName);
+
+            // Make the packed buffer size function
+            CreatePackedBufferSizeFunction(builder, packedBufferSizeFnName);
+
+            // Change the schedule to assume a packed verison of the buffer
+            UpdateScheduleOpToUsePackedBuffer(builder);
         }
 
+    private:
         void CreatePackedBufferSizeFunction(mlir::OpBuilder& builder, const std::string& packedBufferSizeFnName)
         {
             mlir::OpBuilder::InsertionGuard insertGuard(builder);
@@ -556,6 +617,159 @@ namespace value
         }
     };
 
+    // Runtime memoized cache Implementation class
+    // The emitted wrapper function packs the target the first time it sees a given buffer address and version tag,
+    // and reuses that packed copy on later calls. Copies are evicted least-recently-used first once the budget is full.
+    class RuntimeMemoizedCacheImpl : public OfflineCacheImpl
+    {
+    public:
+        RuntimeMemoizedCacheImpl(ScheduleOp schedule, Value value, const std::string& wrapperFnName, int64_t maxCacheBytes, CacheIndexing mapping) :
+            OfflineCacheImpl(schedule, value, mapping)
+        {
+            auto builder = GetBuilder();
+
+            auto memorySpace = *ir::value::symbolizeMemorySpace((uint64_t)MemorySpace::Global);
+
+            _cacheInfo = MakeFullBufferAutomaticCacheInfo(builder, _mlirValueInput, CacheAllocation::Automatic, schedule, memorySpace);
+            _shardMapping = _cacheInfo.shardMapping;
+
+            auto packingFuncOp = CreatePackingFunction(builder, wrapperFnName + "_pack");
+
+            CreateMemoizingWrapperFunction(builder, wrapperFnName, packingFuncOp, maxCacheBytes);
+
+            // Change the schedule to assume a packed verison of the buffer
+            UpdateScheduleOpToUsePackedBuffer(builder);
+        }
+
+    private:
+        void CreateMemoizingWrapperFunction(mlir::OpBuilder& builder, const std::string& wrapperFnName, vir::ValueFuncOp packingFuncOp, int64_t maxCacheBytes)
+        {
+            mlir::OpBuilder::InsertionGuard insertGuard(builder);
+            auto loc = GetLocation();
+
+            auto insertionPoint = accera::ir::util::GetTerminalInsertPoint<vir::ValueModuleOp, vir::ModuleTerminatorOp>(_vModuleOp);
+            builder.restoreInsertionPoint(insertionPoint);
+
+            // The wrapper takes the arguments of the main function followed by the version tag of the target buffer
+            auto scheduleFuncOp = GetScheduleFuncOp();
+            auto targetArgIdx = GetInputArgumentIndex();
+            auto i64Type = builder.getI64Type();
+            auto wrapperArgTypes = scheduleFuncOp.getType().getInputs().vec();
+            wrapperArgTypes.push_back(i64Type);
+            auto wrapperFnType = builder.getFunctionType(wrapperArgTypes, scheduleFuncOp.getType().getResults());
+
+            vir::ValueFuncOp wrappingFn = builder.create<vir::ValueFuncOp>(loc, wrapperFnName + "_internal", wrapperFnType, ir::value::ExecutionTarget::CPU);
+
+            // Size the packed storage to the budget, keeping at least one slot
+            auto slotBytes = static_cast<int64_t>(llvm::alignTo(accera::ir::util::GetBufferByteSize(_cacheInfo.cacheType), kPackedSlotAlignment));
+            auto numSlots = std::clamp<int64_t>(maxCacheBytes / slotBytes, 1, kMaxPackedSlots);
+
+            // Per-slot bookkeeping starts zeroed, and a last use of 0 marks a slot that has never been filled
+            auto slotTagType = mlir::MemRefType::get({ numSlots }, i64Type);
+            auto zeroTags = mlir::DenseElementsAttr::get(mlir::RankedTensorType::get({ numSlots }, i64Type), int64_t{ 0 });
+            auto keysGlobal = accera::ir::util::CreateGlobalBufferOp(builder, wrappingFn, slotTagType, wrapperFnName + "_packed_keys", /*constant=*/false, zeroTags);
+            auto versionsGlobal = accera::ir::util::CreateGlobalBufferOp(builder, wrappingFn, slotTagType, wrapperFnName + "_packed_versions", /*constant=*/false, zeroTags);
+            auto lastUsesGlobal = accera::ir::util::CreateGlobalBufferOp(builder, wrappingFn, slotTagType, wrapperFnName + "_packed_last_uses", /*constant=*/false, zeroTags);
+
+            auto clockType = mlir::MemRefType::get({ 1 }, i64Type);
+            auto zeroClock = mlir::DenseElementsAttr::get(mlir::RankedTensorType::get({ 1 }, i64Type), int64_t{ 0 });
+            auto clockGlobal = accera::ir::util::CreateGlobalBufferOp(builder, wrappingFn, clockType, wrapperFnName + "_packed_clock", /*constant=*/false, zeroClock);
+
+            // The packed copies have to outlive the call, so the storage is zero-initialized like the bookkeeping rather than
+            // left as an uninitialized scratch buffer that could be placed in a workspace
+            auto storageType = mlir::MemRefType::get({ numSlots * slotBytes }, builder.getIntegerType(8), {}, GetInputType().getMemorySpace());
+            auto zeroStorage = mlir::DenseElementsAttr::get(mlir::RankedTensorType::get({ numSlots * slotBytes }, builder.getIntegerType(8)), int8_t{ 0 });
+            auto storageGlobal = accera::ir::util::CreateGlobalBufferOp(builder, wrappingFn, storageType, wrapperFnName + "_packed_storage", /*constant=*/false, zeroStorage);
+
+            builder.setInsertionPointToStart(&wrappingFn.body().front());
+
+            std::vector<mlir::Value> wrapperFnArgs = wrappingFn.getArguments().vec();
+            auto version = wrapperFnArgs.back();
+            wrapperFnArgs.pop_back();
+            auto target = wrapperFnArgs[targetArgIdx];
+
+            mlir::Value keys = builder.create<vir::ReferenceGlobalOp>(loc, keysGlobal);
+            mlir::Value versions = builder.create<vir::ReferenceGlobalOp>(loc, versionsGlobal);
+            mlir::Value lastUses = builder.create<vir::ReferenceGlobalOp>(loc, lastUsesGlobal);
+            mlir::Value clock = builder.create<vir::ReferenceGlobalOp>(loc, clockGlobal);
+            mlir::Value storage = builder.create<vir::ReferenceGlobalOp>(loc, storageGlobal);
+
+            mlir::Value zero = builder.create<mlir::ConstantIndexOp>(loc, 0);
+            mlir::Value one = builder.create<mlir::ConstantIndexOp>(loc, 1);
+            mlir::Value noSlot = builder.create<mlir::ConstantIndexOp>(loc, -1);
+            mlir::Value slotCount = builder.create<mlir::ConstantIndexOp>(loc, numSlots);
+            mlir::Value slotSize = builder.create<mlir::ConstantIndexOp>(loc, slotBytes);
+            mlir::Value neverUsed = builder.create<mlir::ConstantIntOp>(loc, 0, i64Type);
+
+            mlir::Value key = builder.create<vir::BufferAddressOp>(loc, target);
+
+            // Advance the clock that orders the slots by their last use
+            mlir::Value tick = builder.create<mlir::memref::LoadOp>(loc, clock, zero);
+            tick = builder.create<mlir::AddIOp>(loc, tick, builder.create<mlir::ConstantIntOp>(loc, 1, i64Type));
+            builder.create<mlir::memref::StoreOp>(loc, tick, clock, zero);
+
+            // Look for a slot that already holds this buffer at this version
+            auto lookupLoop = builder.create<mlir::scf::ForOp>(loc, zero, slotCount, one, mlir::ValueRange{ noSlot }, [&](mlir::OpBuilder& b, mlir::Location loc, mlir::Value slot, mlir::ValueRange iterArgs) {
+                mlir::Value slotKey = b.create<mlir::memref::LoadOp>(loc, keys, slot);
+                mlir::Value slotVersion = b.create<mlir::memref::LoadOp>(loc, versions, slot);
+                mlir::Value slotLastUse = b.create<mlir::memref::LoadOp>(loc, lastUses, slot);
+                mlir::Value hit = b.create<mlir::CmpIOp>(loc, mlir::CmpIPredicate::eq, slotKey, key);
+                hit = b.create<mlir::AndOp>(loc, hit, b.create<mlir::CmpIOp>(loc, mlir::CmpIPredicate::eq, slotVersion, version));
+                hit = b.create<mlir::AndOp>(loc, hit, b.create<mlir::CmpIOp>(loc, mlir::CmpIPredicate::ne, slotLastUse, neverUsed));
+                mlir::Value foundSlot = b.create<mlir::SelectOp>(loc, hit, slot, iterArgs[0]);
+                b.create<mlir::scf::YieldOp>(loc, foundSlot);
+            });
+            mlir::Value cachedSlot = lookupLoop.getResult(0);
+            mlir::Value isMiss = builder.create<mlir::CmpIOp>(loc, mlir::CmpIPredicate::eq, cachedSlot, noSlot);
+
+            auto ifOp = builder.create<mlir::scf::IfOp>(loc, mlir::TypeRange{ builder.getIndexType() }, isMiss, /*withElseRegion=*/true);
+            {
+                // On a miss, evict the least recently used slot (empty slots come first) and pack the target into it
+                auto thenBuilder = ifOp.getThenBodyBuilder();
+                mlir::Value oldestUse = thenBuilder.create<mlir::ConstantIntOp>(loc, std::numeric_limits<int64_t>::max(), i64Type);
+                auto evictLoop = thenBuilder.create<mlir::scf::ForOp>(loc, zero, slotCount, one, mlir::ValueRange{ zero, oldestUse }, [&](mlir::OpBuilder& b, mlir::Location loc, mlir::Value slot, mlir::ValueRange iterArgs) {
+                    mlir::Value slotLastUse = b.create<mlir::memref::LoadOp>(loc, lastUses, slot);
+                    mlir::Value isOlder = b.create<mlir::CmpIOp>(loc, mlir::CmpIPredicate::slt, slotLastUse, iterArgs[1]);
+                    mlir::Value victim = b.create<mlir::SelectOp>(loc, isOlder, slot, iterArgs[0]);
+                    mlir::Value victimLastUse = b.create<mlir::SelectOp>(loc, isOlder, slotLastUse, iterArgs[1]);
+                    b.create<mlir::scf::YieldOp>(loc, mlir::ValueRange{ victim, victimLastUse });
+                });
+                mlir::Value victim = evictLoop.getResult(0);
+
+                mlir::Value victimOffset = thenBuilder.create<mlir::MulIOp>(loc, victim, slotSize);
+                auto packedSlot = accera::ir::util::CreateByteBufferView(thenBuilder, loc, storage, victimOffset, _cacheInfo.cacheType);
+                thenBuilder.create<vir::LaunchFuncOp>(loc, packingFuncOp, mlir::ValueRange{ target, packedSlot });
+
+                thenBuilder.create<mlir::memref::StoreOp>(loc, key, keys, victim);
+                thenBuilder.create<mlir::memref::StoreOp>(loc, version, versions, victim);
+                thenBuilder.create<mlir::scf::YieldOp>(loc, victim);
+            }
+            {
+                auto elseBuilder = ifOp.getElseBodyBuilder();
+                elseBuilder.create<mlir::scf::YieldOp>(loc, cachedSlot);
+            }
+            mlir::Value slot = ifOp.getResult(0);
+            builder.create<mlir::memref::StoreOp>(loc, tick, lastUses, slot);
+
+            // Call the main function with the packed copy in place of the target
+            mlir::Value slotOffset = builder.create<mlir::MulIOp>(loc, slot, slotSize);
+            wrapperFnArgs[targetArgIdx] = accera::ir::util::CreateByteBufferView(builder, loc, storage, slotOffset, GetInputType());
+            auto launchFuncOp = builder.create<vir::LaunchFuncOp>(loc, scheduleFuncOp, wrapperFnArgs);
+
+            if (launchFuncOp.getNumResults() > 0)
+            {
+                builder.create<vir::ReturnOp>(loc, launchFuncOp.getResults());
+            }
+            else
+            {
+                builder.create<vir::ReturnOp>(loc);
+            }
+
+            // Now create the Raw pointer API function for this wrapper function
+            vir::CreateRawPointerAPIWrapperFunction(builder, wrappingFn, wrapperFnName);
+        }
+    };
+
     // Emit-time packed cache Implementation class
     class EmitTimePackedCacheImpl : public OfflineCacheImpl
     {
@@ -717,16 +931,7 @@ namespace value
 
             // Construct the arguments to the main function without the input that is being packed
             auto scheduleFuncOp = GetScheduleFuncOp();
-            auto targetArgIdx = 0u;
-            for (const auto& arg : scheduleFuncOp.getArguments())
-            {
-                if (arg == _mlirValueInput)
-                {
-                    break;
-                }
-                targetArgIdx++;
-            }
-            assert(targetArgIdx < scheduleFuncOp.getNumArguments());
+            auto targetArgIdx = GetInputArgumentIndex();
             auto argsWithTargetRemoved = scheduleFuncOp.getType().getInputs().vec();
             argsWithTargetRemoved.erase(argsWithTargetRemoved.begin() + targetArgIdx);
 
@@ -803,7 +1008,9 @@ namespace value
                  CacheAllocation allocation,
                  MemorySpace memorySpace,
                  MemorySpace doubleBufferMemorySpace,
-                 ExecutionTarget execTarget)
+                 ExecutionTarget execTarget,
+                 std::optional<ValueType> elementType,
+                 std::optional<int64_t> prefetchDistance)
     {
         std::optional<Index> keySlice;
         if (keySliceIndex.has_value())
@@ -830,7 +1037,9 @@ namespace value
                                                            allocation,
                                                            memorySpace,
                                                            doubleBufferMemorySpace,
-                                                           execTarget);
+                                                           execTarget,
+                                                           elementType,
+                                                           prefetchDistance);
         }
         else
         {
@@ -847,7 +1056,9 @@ namespace value
                                                            allocation,
                                                            memorySpace,
                                                            doubleBufferMemorySpace,
-                                                           execTarget);
+                                                           execTarget,
+                                                           elementType,
+                                                           prefetchDistance);
         }
     }
 
@@ -864,7 +1075,9 @@ namespace value
                  CacheAllocation allocation,
                  MemorySpace memorySpace,
                  MemorySpace doubleBufferMemorySpace,
-                 ExecutionTarget execTarget)
+                 ExecutionTarget execTarget,
+                 std::optional<ValueType> elementType,
+                 std::optional<int64_t> prefetchDistance)
     {
         std::optional<Index> keySlice;
         if (keySliceIndex.has_value())
@@ -892,7 +1105,9 @@ namespace value
                                                            allocation,
                                                            memorySpace,
                                                            doubleBufferMemorySpace,
-                                                           execTarget);
+                                                           execTarget,
+                                                           elementType,
+                                                           prefetchDistance);
         }
         else
         {
@@ -909,7 +1124,9 @@ namespace value
                                                            allocation,
                                                            memorySpace,
                                                            doubleBufferMemorySpace,
-                                                           execTarget);
+                                                           execTarget,
+                                                           elementType,
+                                                           prefetchDistance);
         }
     }
 
@@ -934,6 +1151,16 @@ namespace value
     {
     }
 
+    // Runtime memoized caching version
+    Cache::Cache(ScheduleOp schedule,
+                 ViewAdapter value,
+                 const std::string& wrapperFnName,
+                 int64_t maxCacheBytes,
+                 CacheIndexing mapping) :
+        _impl(std::make_unique<RuntimeMemoizedCacheImpl>(schedule, value, wrapperFnName, maxCacheBytes, mapping))
+    {
+    }
+
     Cache::Cache(Cache&& other) noexcept :
         _impl(std::move(other._impl))
     {}
@@ -27,6 +27,7 @@ namespace value
             .Case("CUDA", ExecutionRuntime::CUDA)
             .Case("None", ExecutionRuntime::NONE)
             .Case("OpenMP", ExecutionRuntime::OPENMP)
+            .Case("ThreadPool", ExecutionRuntime::THREAD_POOL)
             .Default(ExecutionRuntime::DEFAULT);
     }
 
@@ -57,6 +58,7 @@ namespace value
         vectorWidth = properties.GetOrParseEntry<int>("vectorWidth", vectorWidth);
         useBlas = properties.GetOrParseEntry<bool>("useBlas", useBlas);
         profile = properties.GetOrParseEntry<bool>("profile", profile);
+        profileTrace = properties.GetOrParseEntry<bool>("profileTrace", profileTrace);
         includeDiagnosticInfo = properties.GetOrParseEntry<bool>("includeDiagnosticInfo", includeDiagnosticInfo);
         useFastMath = properties.GetOrParseEntry<bool>("useFastMath", useFastMath);
         debug = properties.GetOrParseEntry<bool>("debug", debug);
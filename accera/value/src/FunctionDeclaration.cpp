@@ -141,6 +141,14 @@ namespace value
         return *this;
     }
 
+    FunctionDeclaration& FunctionDeclaration::Workspace(bool useWorkspace)
+    {
+        CheckNonEmpty();
+
+        _useWorkspace = useWorkspace;
+        return *this;
+    }
+
     FunctionDeclaration& FunctionDeclaration::OutputVerifiers(const std::vector<std::string>& functionNames)
     {
         CheckNonEmpty();
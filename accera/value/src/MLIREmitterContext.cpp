@@ -694,6 +694,8 @@ MLIRContext::MLIRContext(const std::string& moduleName, const CompilerOptions& o
 {
     setDataLayout(options);
     setDebugMode(options.debug);
+    setProfileMode(options.profile);
+    setProfileTraceMode(options.profileTrace);
     _localEmittables.push({});
 }
 
@@ -703,6 +705,8 @@ MLIRContext::MLIRContext(mlir::ModuleOp& existingModule, const CompilerOptions&
 {
     setDataLayout(options);
     setDebugMode(options.debug);
+    setProfileMode(options.profile);
+    setProfileTraceMode(options.profileTrace);
     _localEmittables.push({});
 }
 
@@ -808,6 +812,93 @@ void MLIRContext::setDebugMode(bool enable)
     }
 }
 
+void MLIRContext::setProfileMode(bool enable)
+{
+    auto& builder = _impl->builder;
+    auto valueModuleOp = _impl->_valueModuleOp;
+    if (!enable)
+    {
+        valueModuleOp->removeAttr(ir::ProfileModeAttrName);
+        return;
+    }
+    if (valueModuleOp->hasAttr(ir::ProfileModeAttrName))
+    {
+        return;
+    }
+    valueModuleOp->setAttr(ir::ProfileModeAttrName, builder.getUnitAttr());
+
+    // The entry points only hold placeholder ops here, the profile regions they cover aren't known until
+    // the module is lowered
+    auto loc = builder.getUnknownLoc();
+    auto moduleName = valueModuleOp.sym_name().str();
+    auto emitEntryPoint = [&](const std::string& name, mlir::FunctionType fnType) {
+        auto insertionGuard = _impl->CreateNewScope(_impl->getFunctionInsertPt());
+        ir::value::ValueFuncOp fnOp = builder.create<ir::value::ValueFuncOp>(loc, moduleName + name, fnType, ir::value::ExecutionTarget::CPU);
+        mlir::SymbolTable::setSymbolVisibility(fnOp, mlir::SymbolTable::Visibility::Public);
+        fnOp->setAttr(ir::RawPointerAPIAttrName, builder.getUnitAttr());
+        fnOp->setAttr(ir::HeaderDeclAttrName, builder.getUnitAttr());
+        fnOp->setAttr(ir::NoInlineAttrName, builder.getUnitAttr());
+        return &fnOp.body().back();
+    };
+
+    auto insertionGuard = _impl->CreateNewScope();
+
+    auto resetBlock = emitEntryPoint("_reset_profile_counters", builder.getFunctionType({}, {}));
+    builder.setInsertionPointToStart(resetBlock);
+    (void)builder.create<ir::value::ResetProfileCountersOp>(loc);
+    (void)builder.create<ir::value::ReturnOp>(loc);
+
+    auto bufferType = mlir::MemRefType::get({ mlir::ShapedType::kDynamicSize }, builder.getIntegerType(8));
+    auto getBlock = emitEntryPoint("_get_profile_counters", builder.getFunctionType({ bufferType, builder.getI64Type() }, { builder.getI64Type() }));
+    getBlock->getParentOp()->setAttr(ir::ProfileModeAttrName, builder.getUnitAttr());
+    builder.setInsertionPointToStart(getBlock);
+    auto numRegions = builder.create<ir::value::GetProfileCountersOp>(loc, getBlock->getArgument(0), getBlock->getArgument(1));
+    (void)builder.create<ir::value::ReturnOp>(loc, numRegions.getResult());
+}
+
+void MLIRContext::setProfileTraceMode(bool enable)
+{
+    auto& builder = _impl->builder;
+    auto valueModuleOp = _impl->_valueModuleOp;
+    if (!enable)
+    {
+        valueModuleOp->removeAttr(ir::ProfileTraceModeAttrName);
+        return;
+    }
+    if (valueModuleOp->hasAttr(ir::ProfileTraceModeAttrName))
+    {
+        return;
+    }
+    valueModuleOp->setAttr(ir::ProfileTraceModeAttrName, builder.getUnitAttr());
+
+    // The trace is kept by the CPU runtime library, so these only forward to it
+    auto loc = builder.getUnknownLoc();
+    auto moduleName = valueModuleOp.sym_name().str();
+    auto emitEntryPoint = [&](const std::string& name, mlir::FunctionType fnType) {
+        auto insertionGuard = _impl->CreateNewScope(_impl->getFunctionInsertPt());
+        ir::value::ValueFuncOp fnOp = builder.create<ir::value::ValueFuncOp>(loc, moduleName + name, fnType, ir::value::ExecutionTarget::CPU);
+        mlir::SymbolTable::setSymbolVisibility(fnOp, mlir::SymbolTable::Visibility::Public);
+        fnOp->setAttr(ir::RawPointerAPIAttrName, builder.getUnitAttr());
+        fnOp->setAttr(ir::HeaderDeclAttrName, builder.getUnitAttr());
+        fnOp->setAttr(ir::NoInlineAttrName, builder.getUnitAttr());
+        return &fnOp.body().back();
+    };
+
+    auto insertionGuard = _impl->CreateNewScope();
+
+    auto resetBlock = emitEntryPoint("_reset_profile_trace", builder.getFunctionType({}, {}));
+    builder.setInsertionPointToStart(resetBlock);
+    (void)builder.create<ir::value::ResetProfileTraceOp>(loc);
+    (void)builder.create<ir::value::ReturnOp>(loc);
+
+    auto pathType = mlir::MemRefType::get({ mlir::ShapedType::kDynamicSize }, builder.getIntegerType(8));
+    auto writeBlock = emitEntryPoint("_write_profile_trace", builder.getFunctionType({ pathType }, { builder.getI64Type() }));
+    writeBlock->getParentOp()->setAttr(ir::ProfileTraceModeAttrName, builder.getUnitAttr());
+    builder.setInsertionPointToStart(writeBlock);
+    auto numEvents = builder.create<ir::value::WriteProfileTraceOp>(loc, writeBlock->getArgument(0));
+    (void)builder.create<ir::value::ReturnOp>(loc, numEvents.getResult());
+}
+
 Scalar CreateGPUIndexOp(mlir::OpBuilder& builder, accera::ir::value::Processor idxType)
 {
     auto loc = builder.getUnknownLoc();
@@ -1022,6 +1113,19 @@ EmitterContext::DefinedFunction MLIRContext::CreateFunctionImpl(FunctionDeclarat
     const auto& fnName = decl.GetFunctionName();
     auto argValuesCopy = argValues;
     auto fnType = ToMLIRType(b, decl);
+    if (decl.UsesWorkspace())
+    {
+        if (isGpu)
+        {
+            throw InputException(InputExceptionErrors::invalidArgument, "Workspace functions are only supported for CPU targets");
+        }
+
+        // The workspace is appended after the declared parameters. Its size is only known once the caches
+        // in the function have been lowered, so it is a dynamically-sized byte buffer here
+        auto inputTypes = llvm::to_vector<4>(fnType.getInputs());
+        inputTypes.push_back(mlir::MemRefType::get({ mlir::ShapedType::kDynamicSize }, b.getIntegerType(8)));
+        fnType = b.getFunctionType(inputTypes, fnType.getResults());
+    }
 
     auto [fnOp, entryBlock] = std::visit(
         [&](auto target) {
@@ -1062,6 +1166,36 @@ EmitterContext::DefinedFunction MLIRContext::CreateFunctionImpl(FunctionDeclarat
             {
                 fnOp->setAttr(ir::NoInlineAttrName, b.getUnitAttr());
             }
+            if (decl.UsesWorkspace())
+            {
+                fnOp->setAttr(ir::WorkspaceAttrName, b.getUnitAttr());
+
+                // Emit the size query alongside the function. It returns 0 until the workspace allocation
+                // pass has laid out the function's scratch buffers and patched in the real byte count
+                ir::value::ValueFuncOp sizeFnOp = b.create<ir::value::ValueFuncOp>(loc,
+                                                                                   fnName + "_workspace_size",
+                                                                                   b.getFunctionType({}, { b.getI64Type() }),
+                                                                                   executionTarget);
+                mlir::SymbolTable::setSymbolVisibility(sizeFnOp, mlir::SymbolTable::getSymbolVisibility(fnOp));
+                sizeFnOp->setAttr(ir::WorkspaceSizeAttrName, b.getSymbolRefAttr(fnName));
+                if (decl.UseRawPointerAPI())
+                {
+                    sizeFnOp->setAttr(ir::RawPointerAPIAttrName, b.getUnitAttr());
+                }
+                if (decl.EmitsHeaderDecl())
+                {
+                    sizeFnOp->setAttr(ir::HeaderDeclAttrName, b.getUnitAttr());
+                }
+                if (auto baseName = decl.GetBaseName(); !baseName.empty())
+                {
+                    sizeFnOp->setAttr(ir::BaseNameAttrName, b.getStringAttr(baseName + "_workspace_size"));
+                }
+
+                mlir::OpBuilder::InsertionGuard sizeFnGuard(b);
+                b.setInsertionPointToStart(&sizeFnOp.body().back());
+                auto workspaceSize = b.create<mlir::ConstantIntOp>(loc, 0, 64);
+                (void)b.create<accera::ir::value::ReturnOp>(loc, workspaceSize.getResult());
+            }
             if (auto checkFunctions = decl.GetOutputVerifiers(); !checkFunctions.empty())
             {
                 // For each input_output parameter, set its check function
@@ -1635,7 +1769,7 @@ ViewAdapter MLIRContext::Reduce(Array a, std::vector<ViewAdapter> initArgs, std:
             builder.create<ir::value::YieldOp>(loc, ToMLIRValue(builder, result));
         });
 
-    ir::executionPlan::VectorizationInfo vecInfo{ 8, 16 };
+    ir::executionPlan::VectorizationInfo vecInfo{ ir::executionPlan::AVX2Alignment, 16 };
     auto vectorizationInfoIdentifier = builder.getIdentifier(ir::executionPlan::VectorizationInfoAttr::getKeyName());
     reduceOp->setAttr(vectorizationInfoIdentifier, ir::executionPlan::VectorizationInfoAttr::get(vecInfo, builder.getContext()));
     return Wrap(reduceOp.getResult());
@@ -1666,7 +1800,7 @@ ViewAdapter MLIRContext::MapReduce(Array a, std::vector<ViewAdapter> initArgs, s
             builder.create<ir::value::YieldOp>(loc, ToMLIRValue(builder, result));
         });
 
-    ir::executionPlan::VectorizationInfo vecInfo{ 8, 16 };
+    ir::executionPlan::VectorizationInfo vecInfo{ ir::executionPlan::AVX2Alignment, 16 };
     auto vectorizationInfoIdentifier = builder.getIdentifier(ir::executionPlan::VectorizationInfoAttr::getKeyName());
     mapReduceOp->setAttr(vectorizationInfoIdentifier, ir::executionPlan::VectorizationInfoAttr::get(vecInfo, builder.getContext()));
     return Wrap(mapReduceOp.getResult());
@@ -2042,8 +2176,6 @@ Scalar MLIRContext::CastImpl(Scalar value, ValueType type)
         return Wrap(mlirValue);
     }
 
-    auto doSignedCast = IsSignedType(type);
-
     return mlir::TypeSwitch<mlir::Type, Scalar>(fromType)
         .Case([&](mlir::IntegerType fromIntType) {
             auto signlessMlirValue = accera::ir::util::ToSignlessMLIRValue(builder, mlirValue);
@@ -2064,7 +2196,8 @@ Scalar MLIRContext::CastImpl(Scalar value, ValueType type)
                     }
                     else
                     {
-                        if (doSignedCast)
+                        // Widening preserves the value of the source, so its signedness picks the extension
+                        if (!fromIntType.isUnsigned() && fromIntType.getWidth() > 1)
                         {
                             signlessMlirValue = builder.create<mlir::SignExtendIOp>(loc, signlessMlirValue, toIntTypeSignless);
                         }
@@ -2342,7 +2475,37 @@ void MLIRContext::PrintProfileResults()
 
 void MLIRContext::PrefetchImpl(Value data, PrefetchType type, PrefetchLocality locality)
 {
-    throw utilities::LogicException(utilities::LogicExceptionErrors::notImplemented, __FILE__ " : " + std::to_string(__LINE__));
+    auto& builder = _impl->builder;
+    auto loc = builder.getUnknownLoc();
+    auto mem = ToMLIRValue(builder, data);
+    auto memType = mem.getType().dyn_cast<mlir::MemRefType>();
+    if (!memType)
+    {
+        throw InputException(InputExceptionErrors::invalidArgument, "Prefetch requires a value with a memref type");
+    }
+
+    bool isWrite = type == PrefetchType::Write;
+    auto localityHint = static_cast<uint32_t>(locality);
+    auto rank = memType.getRank();
+    if (rank == 0 || !memType.hasStaticShape())
+    {
+        // Only the first element's cache line is prefetched when the extent of the data isn't known
+        llvm::SmallVector<mlir::Value, 4> indices(rank, builder.create<mlir::ConstantIndexOp>(loc, 0));
+        (void)builder.create<mlir::memref::PrefetchOp>(loc, mem, indices, isWrite, localityHint, /*isDataCache=*/true);
+        return;
+    }
+
+    // Touch one element per cache line by stepping the innermost dimension by the number of elements in a line
+    auto elementType = memType.getElementType();
+    int64_t elementBytes = elementType.isIntOrFloat() ? std::max<int64_t>(1, elementType.getIntOrFloatBitWidth() / 8) : 1;
+    std::vector<int64_t> lbs(rank, 0);
+    std::vector<int64_t> ubs(memType.getShape().begin(), memType.getShape().end());
+    std::vector<int64_t> steps(rank, 1);
+    steps.back() = std::max<int64_t>(1, ir::executionPlan::CacheLineBytes / elementBytes);
+
+    mlir::buildAffineLoopNest(builder, loc, lbs, ubs, steps, [&](mlir::OpBuilder& nestBuilder, mlir::Location nestLoc, mlir::ValueRange IVs) {
+        (void)nestBuilder.create<mlir::memref::PrefetchOp>(nestLoc, mem, IVs, isWrite, localityHint, /*isDataCache=*/true);
+    });
 }
 
 void MLIRContext::PrintImpl(ViewAdapter value, bool toStderr)
@@ -2537,6 +2700,11 @@ mlir::Value UnwrapScalar(Scalar s)
     return ResolveMLIRScalar(GetMLIRContext().GetOpBuilder(), mlirVal);
 }
 
+mlir::Type ValueTypeToMLIRType(mlir::OpBuilder& builder, ValueType type)
+{
+    return ToMLIRType(builder, type);
+}
+
 ValueType MLIRTypeToValueType(mlir::Type ty)
 {
     assert(ty.isIntOrIndexOrFloat());
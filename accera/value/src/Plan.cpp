@@ -72,7 +72,7 @@ namespace value
                         nestOp.exec_targetAttr(execTargetAttr);
                         _execPlanOp.exec_targetAttr(execTargetAttr);
 
-                        if (_execRuntime != ExecutionRuntime::DEFAULT && _execRuntime != ExecutionRuntime::NONE && _execRuntime != ExecutionRuntime::OPENMP)
+                        if (_execRuntime != ExecutionRuntime::DEFAULT && _execRuntime != ExecutionRuntime::NONE && _execRuntime != ExecutionRuntime::OPENMP && _execRuntime != ExecutionRuntime::THREAD_POOL)
                         {
                             auto execRuntimeAttrName = ValueModuleOp::getExecRuntimeAttrName();
                             auto execRuntimeAttrValue = ir::value::ExecutionRuntimeAttr::get(
@@ -111,7 +111,9 @@ namespace value
                              CacheAllocation allocation,
                              MemorySpace memorySpace,
                              MemorySpace doubleBufferMemorySpace,
-                             const MemoryAffineCoefficients& memoryMap)
+                             const MemoryAffineCoefficients& memoryMap,
+                             std::optional<ValueType> elementType,
+                             std::optional<int64_t> prefetchDistance)
         {
             return { _scheduleOp,
                      target,
@@ -126,7 +128,9 @@ namespace value
                      allocation,
                      memorySpace,
                      doubleBufferMemorySpace,
-                     _execTarget };
+                     _execTarget,
+                     elementType,
+                     prefetchDistance };
         }
 
         Cache AddManualCache(std::variant<ViewAdapter, Cache*> target,
@@ -140,7 +144,9 @@ namespace value
                              CacheAllocation allocation,
                              MemorySpace memorySpace,
                              MemorySpace doubleBufferMemorySpace,
-                             const DimensionOrder& dimOrder)
+                             const DimensionOrder& dimOrder,
+                             std::optional<ValueType> elementType,
+                             std::optional<int64_t> prefetchDistance)
         {
             return { _scheduleOp,
                      target,
@@ -155,7 +161,9 @@ namespace value
                      allocation,
                      memorySpace,
                      doubleBufferMemorySpace,
-                     _execTarget };
+                     _execTarget,
+                     elementType,
+                     prefetchDistance };
         }
 
         Cache AddRuntimeInitCache(ViewAdapter target, const std::string& packingFnName, const std::string& packedBufferSizeFnName, CacheIndexing indexing)
@@ -168,13 +176,18 @@ namespace value
             return { _scheduleOp, target, constantData, wrapperFnName, packedBufferName, indexing };
         }
 
+        Cache AddRuntimeMemoizedCache(ViewAdapter target, const std::string& wrapperFnName, int64_t maxCacheBytes, CacheIndexing indexing)
+        {
+            return { _scheduleOp, target, wrapperFnName, maxCacheBytes, indexing };
+        }
+
         void Vectorize(ScalarIndex i, const VectorizationInformation& dslVectorizationInfo)
         {
             auto& builder = GetBuilder();
             auto symbolicIndexOp = GetIndexOp(i);
             auto index = symbolicIndexOp.getValue();
 
-            VectorizationInfo vectorizationInfo{ dslVectorizationInfo.vectorBytes, dslVectorizationInfo.vectorUnitCount, dslVectorizationInfo.unrollOnly };
+            VectorizationInfo vectorizationInfo{ dslVectorizationInfo.vectorBytes, dslVectorizationInfo.vectorUnitCount, dslVectorizationInfo.unrollOnly, dslVectorizationInfo.maskedTail };
             auto vectorizationInfoIdentifier = builder.getIdentifier(VectorizationInfoAttr::getKeyName());
             auto vectorizationInfoAttr = VectorizationInfoAttr::get(vectorizationInfo, builder.getContext());
             _scheduleOp.addLoopAttribute(index, vectorizationInfoIdentifier, vectorizationInfoAttr);
@@ -184,11 +197,16 @@ namespace value
             _execPlanOp->setAttr(vectorizationInfoIdentifier, vectorizationInfoAttr);
         }
 
-        void Parallelize(std::vector<ScalarIndex> indices, int64_t numThreads, ParallelizationPolicy policy)
+        void Parallelize(std::vector<ScalarIndex> indices, int64_t numThreads, ParallelizationPolicy policy, ParallelizationAffinity affinity, std::vector<int64_t> cores, bool numaFirstTouch)
         {
             auto& builder = GetBuilder();
 
-            ParallelizationInfo parallelizationInfo{ numThreads, policy == ParallelizationPolicy::Dynamic };
+            if (affinity == ParallelizationAffinity::Explicit && cores.empty())
+            {
+                throw InputException(InputExceptionErrors::invalidArgument, "Explicit thread affinity requires a non-empty list of cores");
+            }
+
+            ParallelizationInfo parallelizationInfo{ numThreads, policy == ParallelizationPolicy::Dynamic, static_cast<accera::ir::executionPlan::ParallelizationAffinity>(affinity), numaFirstTouch, cores };
             auto parallelizationInfoIdentifier = builder.getIdentifier(ParallelizationInfoAttr::getKeyName());
             auto parallelizationInfoAttr = ParallelizationInfoAttr::get(parallelizationInfo, builder.getContext());
 
@@ -202,11 +220,11 @@ namespace value
             }
         }
 
-        void Tensorize(std::vector<ScalarIndex> indices, MMAShape dims, int numTotalPasses, bool useStaticOffsets, int numFusedPasses, MMASchedulingPolicy schedulingPolicy, bool _useRocWMMA)
+        void Tensorize(std::vector<ScalarIndex> indices, MMAShape dims, int numTotalPasses, bool useStaticOffsets, int numFusedPasses, MMASchedulingPolicy schedulingPolicy, bool _useRocWMMA, MMAInstructionSet instructionSet = MMAInstructionSet::Generic)
         {
             auto& builder = GetBuilder();
 
-            TensorizationInfo tensorizationInfo{ static_cast<accera::ir::value::MMAShape>(dims), numTotalPasses, useStaticOffsets, numFusedPasses, static_cast<accera::ir::value::MMASchedulingPolicy>(schedulingPolicy), _useRocWMMA };
+            TensorizationInfo tensorizationInfo{ static_cast<accera::ir::value::MMAShape>(dims), numTotalPasses, useStaticOffsets, numFusedPasses, static_cast<accera::ir::value::MMASchedulingPolicy>(schedulingPolicy), _useRocWMMA, instructionSet };
             auto tensorizationInfoIdentifier = builder.getIdentifier(TensorizationInfoAttr::getKeyName());
             auto tensorizationInfoAttr = TensorizationInfoAttr::get(tensorizationInfo, builder.getContext());
 
@@ -318,27 +336,27 @@ namespace value
 
     Plan::~Plan() = default;
 
-    Cache Plan::AddCache(std::variant<ViewAdapter, Cache*> target, const ScalarIndex& outermostIncludedSplitIndex, const ScalarIndex& triggerIndex, const MemoryAffineCoefficients& memoryMap, bool thrifty, bool doubleBuffer, const std::optional<VectorizationInformation>& vectorizationInfo, CacheIndexing mapping, CacheAllocation allocation, MemorySpace memorySpace, MemorySpace doubleBufferMemorySpace)
+    Cache Plan::AddCache(std::variant<ViewAdapter, Cache*> target, const ScalarIndex& outermostIncludedSplitIndex, const ScalarIndex& triggerIndex, const MemoryAffineCoefficients& memoryMap, bool thrifty, bool doubleBuffer, const std::optional<VectorizationInformation>& vectorizationInfo, CacheIndexing mapping, CacheAllocation allocation, MemorySpace memorySpace, MemorySpace doubleBufferMemorySpace, std::optional<ValueType> elementType, std::optional<int64_t> prefetchDistance)
     {
-        return _impl->AddManualCache(target, outermostIncludedSplitIndex, triggerIndex, std::nullopt, thrifty, doubleBuffer, vectorizationInfo, mapping, allocation, memorySpace, doubleBufferMemorySpace, memoryMap);
+        return _impl->AddManualCache(target, outermostIncludedSplitIndex, triggerIndex, std::nullopt, thrifty, doubleBuffer, vectorizationInfo, mapping, allocation, memorySpace, doubleBufferMemorySpace, memoryMap, elementType, prefetchDistance);
     }
 
-    Cache Plan::AddCache(std::variant<ViewAdapter, Cache*> target, const ScalarIndex& outermostIncludedSplitIndex, const ScalarIndex& triggerIndex, const DimensionOrder& dimOrder, bool thrifty, bool doubleBuffer, const std::optional<VectorizationInformation>& vectorizationInfo, CacheIndexing mapping, CacheAllocation allocation, MemorySpace memorySpace, MemorySpace doubleBufferMemorySpace)
+    Cache Plan::AddCache(std::variant<ViewAdapter, Cache*> target, const ScalarIndex& outermostIncludedSplitIndex, const ScalarIndex& triggerIndex, const DimensionOrder& dimOrder, bool thrifty, bool doubleBuffer, const std::optional<VectorizationInformation>& vectorizationInfo, CacheIndexing mapping, CacheAllocation allocation, MemorySpace memorySpace, MemorySpace doubleBufferMemorySpace, std::optional<ValueType> elementType, std::optional<int64_t> prefetchDistance)
     {
-        return _impl->AddManualCache(target, outermostIncludedSplitIndex, triggerIndex, std::nullopt, thrifty, doubleBuffer, vectorizationInfo, mapping, allocation, memorySpace, doubleBufferMemorySpace, dimOrder);
+        return _impl->AddManualCache(target, outermostIncludedSplitIndex, triggerIndex, std::nullopt, thrifty, doubleBuffer, vectorizationInfo, mapping, allocation, memorySpace, doubleBufferMemorySpace, dimOrder, elementType, prefetchDistance);
     }
 
-    Cache Plan::AddCache(std::variant<ViewAdapter, Cache*> target, int64_t maxElements, const MemoryAffineCoefficients& memoryMap, bool thrifty, bool doubleBuffer, const std::optional<VectorizationInformation>& vectorizationInfo, CacheIndexing mapping, CacheAllocation allocation, MemorySpace memorySpace, MemorySpace doubleBufferMemorySpace)
+    Cache Plan::AddCache(std::variant<ViewAdapter, Cache*> target, int64_t maxElements, const MemoryAffineCoefficients& memoryMap, bool thrifty, bool doubleBuffer, const std::optional<VectorizationInformation>& vectorizationInfo, CacheIndexing mapping, CacheAllocation allocation, MemorySpace memorySpace, MemorySpace doubleBufferMemorySpace, std::optional<ValueType> elementType, std::optional<int64_t> prefetchDistance)
     {
-        return _impl->AddManualCache(target, std::nullopt, std::nullopt, maxElements, thrifty, doubleBuffer, vectorizationInfo, mapping, allocation, memorySpace, doubleBufferMemorySpace, memoryMap);
+        return _impl->AddManualCache(target, std::nullopt, std::nullopt, maxElements, thrifty, doubleBuffer, vectorizationInfo, mapping, allocation, memorySpace, doubleBufferMemorySpace, memoryMap, elementType, prefetchDistance);
     }
 
-    Cache Plan::AddCache(std::variant<ViewAdapter, Cache*> target, int64_t maxElements, const DimensionOrder& dimOrder, bool thrifty, bool doubleBuffer, const std::optional<VectorizationInformation>& vectorizationInfo, CacheIndexing mapping, CacheAllocation allocation, MemorySpace memorySpace, MemorySpace doubleBufferMemorySpace)
+    Cache Plan::AddCache(std::variant<ViewAdapter, Cache*> target, int64_t maxElements, const DimensionOrder& dimOrder, bool thrifty, bool doubleBuffer, const std::optional<VectorizationInformation>& vectorizationInfo, CacheIndexing mapping, CacheAllocation allocation, MemorySpace memorySpace, MemorySpace doubleBufferMemorySpace, std::optional<ValueType> elementType, std::optional<int64_t> prefetchDistance)
     {
-        return _impl->AddManualCache(target, std::nullopt, std::nullopt, maxElements, thrifty, doubleBuffer, vectorizationInfo, mapping, allocation, memorySpace, doubleBufferMemorySpace, dimOrder);
+        return _impl->AddManualCache(target, std::nullopt, std::nullopt, maxElements, thrifty, doubleBuffer, vectorizationInfo, mapping, allocation, memorySpace, doubleBufferMemorySpace, dimOrder, elementType, prefetchDistance);
     }
 
-    Cache Plan::AddCache(std::variant<ViewAdapter, Cache*> target, const ScalarIndex& outermostIncludedSplitIndex, bool thrifty, bool doubleBuffer, const std::optional<VectorizationInformation>& vectorizationInfo, CacheIndexing mapping, CacheAllocation allocation, MemorySpace memorySpace, MemorySpace doubleBufferMemorySpace)
+    Cache Plan::AddCache(std::variant<ViewAdapter, Cache*> target, const ScalarIndex& outermostIncludedSplitIndex, bool thrifty, bool doubleBuffer, const std::optional<VectorizationInformation>& vectorizationInfo, CacheIndexing mapping, CacheAllocation allocation, MemorySpace memorySpace, MemorySpace doubleBufferMemorySpace, std::optional<ValueType> elementType, std::optional<int64_t> prefetchDistance)
     {
         Value baseValue;
         if (std::holds_alternative<Cache*>(target))
@@ -353,10 +371,10 @@ namespace value
         }
         int64_t rank = baseValue.GetLayout().NumDimensions();
         DimensionOrder dimOrder(rank);
-        return _impl->AddManualCache(target, outermostIncludedSplitIndex, outermostIncludedSplitIndex, std::nullopt, thrifty, doubleBuffer, vectorizationInfo, mapping, allocation, memorySpace, doubleBufferMemorySpace, dimOrder);
+        return _impl->AddManualCache(target, outermostIncludedSplitIndex, outermostIncludedSplitIndex, std::nullopt, thrifty, doubleBuffer, vectorizationInfo, mapping, allocation, memorySpace, doubleBufferMemorySpace, dimOrder, elementType, prefetchDistance);
     }
 
-    Cache Plan::AddCache(std::variant<ViewAdapter, Cache*> target, int64_t maxElements, bool thrifty, bool doubleBuffer, const std::optional<VectorizationInformation>& vectorizationInfo, CacheIndexing mapping, CacheAllocation allocation, MemorySpace memorySpace, MemorySpace doubleBufferMemorySpace)
+    Cache Plan::AddCache(std::variant<ViewAdapter, Cache*> target, int64_t maxElements, bool thrifty, bool doubleBuffer, const std::optional<VectorizationInformation>& vectorizationInfo, CacheIndexing mapping, CacheAllocation allocation, MemorySpace memorySpace, MemorySpace doubleBufferMemorySpace, std::optional<ValueType> elementType, std::optional<int64_t> prefetchDistance)
     {
         Value baseValue;
         if (std::holds_alternative<Cache*>(target))
@@ -372,7 +390,7 @@ namespace value
         int64_t rank = baseValue.GetLayout().NumDimensions();
         DimensionOrder dimOrder(rank);
         auto viewAdapter = std::get<ViewAdapter>(target);
-        return _impl->AddManualCache(target, std::nullopt, std::nullopt, maxElements, thrifty, doubleBuffer, vectorizationInfo, mapping, allocation, memorySpace, doubleBufferMemorySpace, dimOrder);
+        return _impl->AddManualCache(target, std::nullopt, std::nullopt, maxElements, thrifty, doubleBuffer, vectorizationInfo, mapping, allocation, memorySpace, doubleBufferMemorySpace, dimOrder, elementType, prefetchDistance);
     }
 
     Cache Plan::EmitRuntimeInitPacking(ViewAdapter target, const std::string& packingFnName, const std::string& packedBufferSizeFnName, CacheIndexing indexing)
@@ -385,14 +403,32 @@ namespace value
         return _impl->PackAndEmbedBuffer(target, constantData, wrapperFnName, packedBufferName, indexing);
     }
 
+    Cache Plan::EmitRuntimeMemoizedPacking(ViewAdapter target, const std::string& wrapperFnName, int64_t maxCacheBytes, CacheIndexing indexing)
+    {
+        if (maxCacheBytes <= 0)
+        {
+            throw InputException(InputExceptionErrors::invalidArgument, "The packed cache budget must be positive");
+        }
+        return _impl->AddRuntimeMemoizedCache(target, wrapperFnName, maxCacheBytes, indexing);
+    }
+
     void Plan::Vectorize(ScalarIndex i, const VectorizationInformation& vectorizationInfo)
     {
         _impl->Vectorize(i, vectorizationInfo);
     }
 
-    void Plan::Parallelize(std::vector<ScalarIndex> indices, int64_t numThreads, ParallelizationPolicy policy)
+    void Plan::Parallelize(std::vector<ScalarIndex> indices, int64_t numThreads, ParallelizationPolicy policy, ParallelizationAffinity affinity, std::vector<int64_t> cores, bool numaFirstTouch)
+    {
+        _impl->Parallelize(indices, numThreads, policy, affinity, cores, numaFirstTouch);
+    }
+
+    void Plan::Tensorize(std::vector<ScalarIndex> indices, MMAShape dims, MMAInstructionSet instructionSet)
     {
-        _impl->Parallelize(indices, numThreads, policy);
+        if (!ir::value::IsCPUMMAShape(dims))
+        {
+            throw InputException(InputExceptionErrors::invalidArgument, "Only CPU MMA shapes can be tensorized on a CPU plan");
+        }
+        _impl->Tensorize(indices, dims, /*numTotalPasses=*/1, /*useStaticOffsets=*/false, /*numFusedPasses=*/-1, MMASchedulingPolicy::PassOrder, /*_useRocWMMA=*/false, instructionSet);
     }
 
     //
@@ -421,7 +457,7 @@ namespace value
 
     Cache GPUPlan::AddCache(std::variant<ViewAdapter, Cache*> target, const ScalarIndex& outermostIncludedSplitIndex, const value::ScalarIndex& triggerIndex, const DimensionOrder& dimOrder, bool thrifty, bool doubleBuffer, const std::optional<VectorizationInformation>& vectorizationInfo, CacheIndexing mapping, CacheAllocation allocation, MemorySpace memorySpace, MemorySpace doubleBufferMemorySpace)
     {
-        return _impl->AddManualCache(target, outermostIncludedSplitIndex, triggerIndex, std::nullopt, thrifty, doubleBuffer, vectorizationInfo, mapping, allocation, memorySpace, doubleBufferMemorySpace, dimOrder);
+        return _impl->AddManualCache(target, outermostIncludedSplitIndex, triggerIndex, std::nullopt, thrifty, doubleBuffer, vectorizationInfo, mapping, allocation, memorySpace, doubleBufferMemorySpace, dimOrder, std::nullopt, std::nullopt);
     }
 
     Cache GPUPlan::AddCache(ViewAdapter target, int64_t maxElements, MemorySpace memorySpace)
@@ -0,0 +1,298 @@
+#!/usr/bin/env python3
+####################################################################################################
+# Copyright (c) Microsoft Corporation. All rights reserved.
+# Licensed under the MIT License. See LICENSE in the project root for license information.
+####################################################################################################
+
+# Measures how long acc-opt takes to lower a fixed corpus of representative schedules, pass by pass.
+#
+# Each corpus entry is emitted to MLIR once, then lowered with `acc-opt --acc-to-llvm` a number of times.
+# acc-opt runs single-threaded and writes the wall time and peak resident set size after every pass run
+# (--acc-pass-timing-file), which are summarized per pass and written to compile_time_results.json.
+#
+# Usage:
+#   python compile_time_benchmark.py [--output_dir DIR] [--acc_opt PATH] [--repetitions N] [--filter NAME ...]
+#                                    [--baseline PREVIOUS_RESULTS.json] [--threshold 1.2]
+#
+# With --baseline, the script exits with a non-zero status if any corpus entry takes longer than
+# `threshold` times its baseline wall time.
+
+import argparse
+import json
+import os
+import statistics
+import subprocess
+import sys
+import time
+from typing import Callable, Dict, List
+
+import accera
+from accera import Array, Nest, Package, Scalar, ScalarType, fuse, accc, _lang_python
+from accera.samples import MatrixMultiplication
+
+CORPUS: Dict[str, Callable[[Package], None]] = {}
+
+
+def corpus_entry(fn):
+    CORPUS[fn.__name__] = fn
+    return fn
+
+
+def _gemm_args(M, N, K):
+    A = Array(role=Array.Role.INPUT, element_type=ScalarType.float32, shape=(M, K))
+    B = Array(role=Array.Role.INPUT, element_type=ScalarType.float32, shape=(K, N))
+    C = Array(role=Array.Role.INPUT_OUTPUT, element_type=ScalarType.float32, shape=(M, N))
+    return A, B, C
+
+
+def _gemm_schedule(A, B, C):
+    M, K = A.shape
+    _, N = B.shape
+    nest = Nest(shape=(M, N, K))
+    i, j, k = nest.get_indices()
+
+    @nest.iteration_logic
+    def _():
+        C[i, j] += A[i, k] * B[k, j]
+
+    return nest.create_schedule(), (i, j, k)
+
+
+@corpus_entry
+def mlas_gemm(package: Package):
+    "The MLAS-style GEMM sample, which fuses the bias and packs B, over square and skinny shapes"
+    opts = MatrixMultiplication.Options(UseAlphaScalingFusion=False)
+    for M, N, K in [(256, 256, 256), (1024, 1024, 1024), (49, 1024, 2304), (1, 4096, 1024)]:
+        A, B, C = _gemm_args(M, N, K)
+        package.add(
+            *MatrixMultiplication.MLAS(A, B, C, alpha=1.0, zero_C=True, opts=opts),
+            base_name=f"mlas_gemm_{M}_{N}_{K}"
+        )
+
+
+@corpus_entry
+def fused_gemm_relu(package: Package):
+    "A GEMM fused with an elementwise epilogue over a partially shared iteration space"
+    M, N, K = 512, 512, 512
+    A, B, C = _gemm_args(M, N, K)
+    schedule0, _ = _gemm_schedule(A, B, C)
+
+    nest1 = Nest(shape=(M, N))
+    i1, j1 = nest1.get_indices()
+
+    @nest1.iteration_logic
+    def _():
+        C[i1, j1] = accera.max(C[i1, j1], Scalar(0.0))
+
+    schedule = fuse((schedule0, nest1.create_schedule()), partial=2)
+    f, i, j, k = schedule.get_indices()
+    jj = schedule.split(j, 128)
+    kk = schedule.split(k, 128)
+    iii = schedule.split(i, 6)
+    jjj = schedule.split(jj, 16)
+    schedule.reorder(j, i, f, k, kk, iii, jjj)
+
+    plan = schedule.create_plan()
+    plan.unroll(iii)
+    plan.vectorize(jjj)
+    package.add(plan, args=(A, B, C), base_name="fused_gemm_relu")
+
+
+@corpus_entry
+def multi_cache_gemm(package: Package):
+    "A tiled GEMM that caches every operand, with a hierarchy of thrifty caches below the outer caches"
+    M, N, K = 512, 512, 512
+    A, B, C = _gemm_args(M, N, K)
+    schedule, (i, j, k) = _gemm_schedule(A, B, C)
+
+    ii = schedule.split(i, 128)
+    jj = schedule.split(j, 256)
+    kk = schedule.split(k, 128)
+    iii = schedule.split(ii, 6)
+    jjj = schedule.split(jj, 16)
+    kkk = schedule.split(kk, 4)
+    schedule.reorder(i, j, k, ii, jj, kk, iii, kkk, jjj)
+
+    plan = schedule.create_plan()
+    AA = plan.cache(A, index=ii)
+    BB = plan.cache(B, index=jj, layout=Array.Layout.FIRST_MAJOR)
+    plan.cache(AA, index=iii, thrifty=True)
+    plan.cache(BB, index=kkk, thrifty=True)
+    plan.cache(C, index=iii)
+    plan.unroll(kkk)
+    plan.vectorize(jjj)
+    package.add(plan, args=(A, B, C), base_name="multi_cache_gemm")
+
+
+@corpus_entry
+def deep_split(package: Package):
+    "Many kernels with deep, non-dividing splits, whose boundary cases the loop nest builder partitions"
+    for M, N, K in [(257, 255, 253), (131, 67, 517)]:
+        A, B, C = _gemm_args(M, N, K)
+        schedule, (i, j, k) = _gemm_schedule(A, B, C)
+
+        ii = schedule.split(i, 64)
+        iii = schedule.split(ii, 16)
+        iiii = schedule.split(iii, 3)
+        jj = schedule.split(j, 64)
+        jjj = schedule.split(jj, 8)
+        kk = schedule.split(k, 32)
+        kkk = schedule.split(kk, 5)
+        schedule.reorder(i, j, k, ii, jj, kk, iii, kkk, iiii, jjj)
+
+        plan = schedule.create_plan()
+        plan.unroll(iiii)
+        plan.unroll(kkk)
+        plan.vectorize(jjj)
+        package.add(plan, args=(A, B, C), base_name=f"deep_split_{M}_{N}_{K}")
+
+
+def emit_mlir(name: str, output_dir: str):
+    "Emits the corpus entry to MLIR, as the package build does before lowering it"
+    package = Package()
+    CORPUS[name](package)
+
+    target, _, compiler_options, _ = package._generate_target_options(Package.Platform.HOST, Package.Mode.RELEASE)
+    module = _lang_python._Module(name=name, options=compiler_options)
+    package._add_functions_to_module(module, fail_on_error=True)
+
+    mlir_path = os.path.join(output_dir, f"{name}.mlir")
+    module.Save(mlir_path)
+    return mlir_path, list(package._fns), target
+
+
+def summarize_passes(pass_timings: List[dict]):
+    "Sums the time of every pass across its runs, along with how much it grew the peak resident set size"
+    # The growth is measured from the end of the first pass run, since the process doesn't report its size before it
+    summary = {}
+    previous_peak = pass_timings[0]["peak_rss_bytes"] if pass_timings else 0
+    for timing in pass_timings:
+        entry = summary.setdefault(
+            timing["pass"], {
+                "pass": timing["pass"],
+                "count": 0,
+                "seconds": 0.0,
+                "peak_rss_bytes": 0,
+                "rss_growth_bytes": 0
+            }
+        )
+        entry["count"] += 1
+        entry["seconds"] += timing["seconds"]
+        entry["peak_rss_bytes"] = max(entry["peak_rss_bytes"], timing["peak_rss_bytes"])
+        entry["rss_growth_bytes"] += max(0, timing["peak_rss_bytes"] - previous_peak)
+        previous_peak = max(previous_peak, timing["peak_rss_bytes"])
+    return summary
+
+
+def run_benchmark(name: str, acc_opt: str, output_dir: str, repetitions: int):
+    mlir_path, functions, target = emit_mlir(name, output_dir)
+    pipeline_options = accc.get_acc_to_llvm_options(system_target=target._device_name, runtime=target.runtime.name)
+    timing_path = os.path.join(output_dir, f"{name}_pass_timings.json")
+
+    wall_seconds = []
+    runs = []
+    for _ in range(repetitions):
+        command = [
+            acc_opt,
+            "--verify-each=false",
+            "--mlir-disable-threading",
+            f"--acc-pass-timing-file={timing_path}",
+            f"--acc-to-llvm={pipeline_options}",
+            mlir_path,
+            "-o",
+            os.devnull,
+        ]
+        start = time.perf_counter()
+        subprocess.run(command, check=True)
+        wall_seconds.append(time.perf_counter() - start)
+
+        with open(timing_path) as f:
+            runs.append(summarize_passes(json.load(f)))
+
+    # The median run is reported for the whole benchmark and for each pass separately, which keeps a
+    # single noisy run from skewing the numbers
+    passes = []
+    for pass_name in runs[0]:
+        samples = [run[pass_name] for run in runs if pass_name in run]
+        passes.append({
+            "pass": pass_name,
+            "count": samples[0]["count"],
+            "seconds": statistics.median(sample["seconds"] for sample in samples),
+            "peak_rss_bytes": max(sample["peak_rss_bytes"] for sample in samples),
+            "rss_growth_bytes": statistics.median(sample["rss_growth_bytes"] for sample in samples),
+        })
+    passes.sort(key=lambda entry: entry["seconds"], reverse=True)
+
+    return {
+        "name": name,
+        "functions": functions,
+        "wall_seconds": statistics.median(wall_seconds),
+        "peak_rss_bytes": max(entry["peak_rss_bytes"] for entry in passes) if passes else 0,
+        "passes": passes,
+    }
+
+
+def print_result(result, num_passes=5):
+    print(
+        f"{result['name']}: {result['wall_seconds']:.2f}s, peak RSS {result['peak_rss_bytes'] / 2**20:.0f} MiB, "
+        f"{len(result['functions'])} function(s)"
+    )
+    for entry in result["passes"][:num_passes]:
+        print(
+            f"    {entry['seconds']:8.3f}s  +{entry['rss_growth_bytes'] / 2**20:6.1f} MiB  {entry['pass']} (x{entry['count']})"
+        )
+
+
+def compare_to_baseline(results, baseline_path, threshold):
+    with open(baseline_path) as f:
+        baseline = {result["name"]: result for result in json.load(f)["benchmarks"]}
+
+    regressions = []
+    for result in results:
+        previous = baseline.get(result["name"])
+        if previous and result["wall_seconds"] > threshold * previous["wall_seconds"]:
+            regressions.append(result["name"])
+            print(
+                f"REGRESSION: {result['name']} took {result['wall_seconds']:.2f}s, "
+                f"baseline {previous['wall_seconds']:.2f}s"
+            )
+    return regressions
+
+
+def main(args=[]):
+    parser = argparse.ArgumentParser(description="Accera compile-time benchmark")
+    parser.add_argument("--output_dir", type=str, default="compile_time_benchmark")
+    parser.add_argument("--acc_opt", type=str, default=None, help="Path to acc-opt, defaults to the one Accera builds with")
+    parser.add_argument("--repetitions", type=int, default=3)
+    parser.add_argument("--filter", type=str, nargs="*", default=None, help="Corpus entries to run, defaults to all")
+    parser.add_argument("--baseline", type=str, default=None, help="Results of an earlier run to compare against")
+    parser.add_argument(
+        "--threshold", type=float, default=1.2, help="Slowdown relative to the baseline that counts as a regression"
+    )
+    args = parser.parse_args(args)
+
+    acc_opt = os.path.abspath(args.acc_opt or accc.ACCCConfig.rc_opt)
+    os.makedirs(args.output_dir, exist_ok=True)
+
+    names = args.filter or list(CORPUS)
+    unknown = [name for name in names if name not in CORPUS]
+    if unknown:
+        parser.error(f"Unknown corpus entries {unknown}, choose from {list(CORPUS)}")
+
+    results = []
+    for name in names:
+        result = run_benchmark(name, acc_opt, args.output_dir, args.repetitions)
+        print_result(result)
+        results.append(result)
+
+    results_path = os.path.join(args.output_dir, "compile_time_results.json")
+    with open(results_path, "w") as f:
+        json.dump({"acc_opt": acc_opt, "repetitions": args.repetitions, "benchmarks": results}, f, indent=2)
+    print(f"Results written to {results_path}")
+
+    if args.baseline and compare_to_baseline(results, args.baseline, args.threshold):
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main(sys.argv[1:])